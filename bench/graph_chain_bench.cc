@@ -0,0 +1,79 @@
+// Measures the overhead of the graph construction and the execution with a
+// long chain of small functions.
+//
+// Usage:
+//   graph_chain_bench [chain_length (default: 100000)] [num_trials (default: 5)]
+
+#include <config.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <primitiv/primitiv.h>
+
+using namespace std;
+using namespace primitiv;
+namespace F = primitiv::operators;
+
+namespace {
+
+// Returns elapsed milliseconds from `start`.
+double elapsed_ms(const chrono::steady_clock::time_point &start) {
+  return chrono::duration_cast<chrono::microseconds>(
+      chrono::steady_clock::now() - start).count() / 1000.;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const unsigned chain_length = argc > 1 ? std::atoi(argv[1]) : 100000;
+  const unsigned num_trials = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  devices::Naive dev;
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+
+  cout << "chain_length: " << chain_length << endl;
+  cout << "trial\tbuild[ms]\tforward[ms]\tbackward[ms]\tforward(retain=false)[ms]" << endl;
+
+  for (unsigned trial = 0; trial < num_trials; ++trial) {
+    // Builds a chain: y = ((x + 1) * 1) + 1 ...
+    auto start = chrono::steady_clock::now();
+    g.clear();
+    Node y = F::input<Node>({}, {0});
+    for (unsigned i = 0; i < chain_length; ++i) {
+      y = i & 1 ? y * 1 : y + 1;
+    }
+    const double build_ms = elapsed_ms(start);
+
+    start = chrono::steady_clock::now();
+    const float y_val = g.forward(y).to_float();
+    const double forward_ms = elapsed_ms(start);
+
+    start = chrono::steady_clock::now();
+    g.backward(y);
+    const double backward_ms = elapsed_ms(start);
+
+    // Builds the same chain again and calculates it without storing
+    // intermediate values.
+    g.clear();
+    y = F::input<Node>({}, {0});
+    for (unsigned i = 0; i < chain_length; ++i) {
+      y = i & 1 ? y * 1 : y + 1;
+    }
+    start = chrono::steady_clock::now();
+    const float y_val2 = g.forward(y, false).to_float();
+    const double forward_nr_ms = elapsed_ms(start);
+
+    if (y_val != y_val2) {
+      cerr << "Mismatched results: " << y_val << " != " << y_val2 << endl;
+      return 1;
+    }
+
+    cout << trial << '\t' << build_ms << '\t' << forward_ms << '\t'
+         << backward_ms << '\t' << forward_nr_ms << endl;
+  }
+
+  return 0;
+}
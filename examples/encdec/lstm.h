@@ -2,10 +2,11 @@
 #define PRIMITIV_EXAMPLE_ENCDEC_LSTM_H_
 
 #include <string>
+#include <tuple>
 
 #include <primitiv/primitiv.h>
 
-// Hand-written LSTM with input/forget/output gates and no peepholes.
+// LSTM with input/forget/output gates and no peepholes.
 // Formulation:
 //   i = sigmoid(W_xi . x[t] + W_hi . h[t-1] + b_i)
 //   f = sigmoid(W_xf . x[t] + W_hf . h[t-1] + b_f)
@@ -66,13 +67,7 @@ public:
   // One step forwarding.
   Var forward(const Var &x) {
     namespace F = primitiv::operators;
-    const auto u = F::matmul(wxh_, x) + F::matmul(whh_, h_) + bh_;
-    const auto i = F::sigmoid(F::slice(u, 0, 0, out_size_));
-    const auto f = F::sigmoid(F::slice(u, 0, out_size_, 2 * out_size_));
-    const auto o = F::sigmoid(F::slice(u, 0, 2 * out_size_, 3 * out_size_));
-    const auto j = F::tanh(F::slice(u, 0, 3 * out_size_, 4 * out_size_));
-    c_ = i * j + f * c_;
-    h_ = o * F::tanh(c_);
+    std::tie(h_, c_) = F::lstm_cell(x, h_, c_, wxh_, whh_, bh_);
     return h_;
   }
 
@@ -17,6 +17,7 @@
 #include <random>
 #include <sstream>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -169,15 +170,10 @@ public:
     h_ = c_ = F::zeros<Var>({out_size_});
   }
 
-  // Forward one step.
-  Var forward(const Var &x) {
-    const Var u = F::matmul(wxh_, x) + F::matmul(whh_, h_) + bh_;
-    const Var i = F::sigmoid(F::slice(u, 0, 0, out_size_));
-    const Var f = F::sigmoid(F::slice(u, 0, out_size_, 2 * out_size_));
-    const Var o = F::sigmoid(F::slice(u, 0, 2 * out_size_, 3 * out_size_));
-    const Var j = F::tanh(F::slice(u, 0, 3 * out_size_, 4 * out_size_));
-    c_ = i * j + f * c_;
-    h_ = o * F::tanh(c_);
+  // Forward all steps.
+  // Each column of `xs` is the input of each step.
+  Var forward(const Var &xs) {
+    std::tie(h_, c_) = F::lstm(xs, h_, c_, wxh_, whh_, bh_);
     return h_;
   }
 };
@@ -215,15 +211,17 @@ public:
     rnn2_.init();
     hy_.init();
 
+    vector<Var> xs;
+    for (unsigned i = 0; i < inputs.size() - 1; ++i) {
+      xs.emplace_back(F::pick(lookup, inputs[i], 1));
+    }
+    Var x = F::dropout(F::concat(xs, 1), DROPOUT_RATE, train);
+    Var h1 = F::dropout(rnn1_.forward(x), DROPOUT_RATE, train);
+    Var h2 = F::dropout(rnn2_.forward(h1), DROPOUT_RATE, train);
+
     vector<Var> outputs;
     for (unsigned i = 0; i < inputs.size() - 1; ++i) {
-      Var x = F::pick(lookup, inputs[i], 1);
-      x = F::dropout(x, DROPOUT_RATE, train);
-      Var h1 = rnn1_.forward(x);
-      h1 = F::dropout(h1, DROPOUT_RATE, train);
-      Var h2 = rnn2_.forward(h1);
-      h2 = F::dropout(h2, DROPOUT_RATE, train);
-      outputs.emplace_back(hy_.forward(h2));
+      outputs.emplace_back(hy_.forward(F::slice(h2, 1, i, i + 1)));
     }
     return outputs;
   }
@@ -0,0 +1,212 @@
+#include <config.h>
+
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <primitiv/cpu_memory_pool.h>
+#include <primitiv/error.h>
+
+using std::make_pair;
+
+namespace {
+
+// Number of size classes in each power of two.
+const unsigned CLASSES_PER_SCALE = 8;
+
+// Blocks larger than this value are managed by their scales.
+const std::uint64_t MAX_LINEAR_SIZE
+  = primitiv::CPUMemoryPool::ALIGNMENT * CLASSES_PER_SCALE;
+
+// Granularity of large blocks.
+const std::uint64_t LARGE_BLOCK_UNIT = 1ull << 12;
+
+// Returns the floor of log2(x).
+unsigned floor_log2(std::uint64_t x) {
+  unsigned ret = 0;
+  while (x >>= 1) ++ret;
+  return ret;
+}
+
+// Returns the smallest multiple of `unit` which is not less than `x`.
+std::uint64_t round_up(std::uint64_t x, std::uint64_t unit) {
+  return (x + unit - 1) / unit * unit;
+}
+
+// Calculates the size class of the given size.
+// `size` is replaced by the actual size of the class.
+unsigned get_small_class(std::uint64_t &size) {
+  if (size <= MAX_LINEAR_SIZE) {
+    size = size > 0
+      ? round_up(size, primitiv::CPUMemoryPool::ALIGNMENT)
+      : primitiv::CPUMemoryPool::ALIGNMENT;
+    return size / primitiv::CPUMemoryPool::ALIGNMENT - 1;
+  }
+  // 2^scale < size <= 2^(scale + 1)
+  const unsigned scale = floor_log2(size - 1);
+  const std::uint64_t step = (1ull << scale) / CLASSES_PER_SCALE;
+  size = round_up(size, step);
+  const unsigned base_scale = floor_log2(MAX_LINEAR_SIZE);
+  return CLASSES_PER_SCALE * (scale - base_scale + 1)
+    + ((size - (1ull << scale)) / step - 1);
+}
+
+// Allocates an aligned memory block from the system.
+void *allocate_aligned(std::uint64_t size) {
+  void *ptr;
+  if (::posix_memalign(&ptr, primitiv::CPUMemoryPool::ALIGNMENT, size) != 0) {
+    return nullptr;
+  }
+  return ptr;
+}
+
+}  // namespace
+
+namespace primitiv {
+
+struct CPUMemoryPool::State {
+  State() : closed(false), reserved_size(0), in_use_size(0), peak_size(0) {}
+
+  // Returns the block to the cache, or to the system if the pool was already
+  // destroyed or the cache could not store it.
+  void free(void *ptr) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = supplied.find(ptr);
+    // Unknown pointers are never given because only blocks supplied by this
+    // state have the deleter.
+    if (it == supplied.end()) return;
+
+    std::uint64_t size = it->second;
+    in_use_size -= size;
+    supplied.erase(it);
+    if (!closed) {
+      // This function is called by the deleter and must not throw. If the
+      // cache could not store the block, it is released to the system.
+      try {
+        if (size <= MAX_SMALL_SIZE) {
+          small_reserved[::get_small_class(size)].emplace_back(ptr);
+        } else {
+          large_reserved.insert(make_pair(size, ptr));
+        }
+        return;
+      } catch (...) {}
+    }
+    std::free(ptr);
+    reserved_size -= size;
+  }
+
+  // Releases all cached memory blocks without locking.
+  void release_reserved() {
+    for (auto &ptrs : small_reserved) {
+      for (void *ptr : ptrs) std::free(ptr);
+      ptrs.clear();
+    }
+    for (auto &kv : large_reserved) {
+      std::free(kv.second);
+    }
+    large_reserved.clear();
+    reserved_size = in_use_size;
+  }
+
+  mutable std::mutex mutex;
+  bool closed;
+  std::vector<std::vector<void *>> small_reserved;
+  std::multimap<std::uint64_t, void *> large_reserved;
+  std::unordered_map<void *, std::uint64_t> supplied;
+  std::uint64_t reserved_size;
+  std::uint64_t in_use_size;
+  std::uint64_t peak_size;
+};
+
+const std::uint64_t CPUMemoryPool::ALIGNMENT;
+const std::uint64_t CPUMemoryPool::MAX_SMALL_SIZE;
+
+std::atomic<std::uint64_t> CPUMemoryPool::next_pool_id_(0);
+
+CPUMemoryPool::CPUMemoryPool()
+: pool_id_(next_pool_id_++)
+, state_(std::make_shared<State>()) {
+  std::uint64_t max_size = MAX_SMALL_SIZE;
+  state_->small_reserved.resize(::get_small_class(max_size) + 1);
+}
+
+CPUMemoryPool::~CPUMemoryPool() {
+  // Blocks which are still used are released by their deleters.
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->closed = true;
+  state_->release_reserved();
+}
+
+std::shared_ptr<void> CPUMemoryPool::allocate(std::uint64_t size) {
+  State &st = *state_;
+  std::lock_guard<std::mutex> lock(st.mutex);
+  void *ptr = nullptr;
+
+  if (size <= MAX_SMALL_SIZE) {
+    const unsigned cls = ::get_small_class(size);
+    std::vector<void *> &ptrs = st.small_reserved[cls];
+    if (!ptrs.empty()) {
+      // Returns an existing block.
+      ptr = ptrs.back();
+      ptrs.pop_back();
+    }
+  } else {
+    size = ::round_up(size, ::LARGE_BLOCK_UNIT);
+    // Finds the smallest reserved block which does not waste more than 1/8 of
+    // its size.
+    auto it = st.large_reserved.lower_bound(size);
+    if (it != st.large_reserved.end() && it->first <= size + size / 8) {
+      size = it->first;
+      ptr = it->second;
+      st.large_reserved.erase(it);
+    }
+  }
+
+  if (!ptr) {
+    // Allocates a new block.
+    ptr = ::allocate_aligned(size);
+    if (!ptr) {
+      // Maybe out-of-memory.
+      // Release other blocks and try allocation again.
+      st.release_reserved();
+      ptr = ::allocate_aligned(size);
+      if (!ptr) {
+        THROW_ERROR("Memory allocation failed. Requested size: " << size);
+      }
+    }
+    st.reserved_size += size;
+  }
+
+  st.supplied.insert(make_pair(ptr, size));
+  st.in_use_size += size;
+  if (st.in_use_size > st.peak_size) st.peak_size = st.in_use_size;
+
+  return std::shared_ptr<void>(ptr, CPUMemoryDeleter(state_));
+}
+
+void CPUMemoryPool::release_reserved() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->release_reserved();
+}
+
+std::uint64_t CPUMemoryPool::reserved_size() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->reserved_size;
+}
+
+std::uint64_t CPUMemoryPool::in_use_size() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->in_use_size;
+}
+
+std::uint64_t CPUMemoryPool::peak_size() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->peak_size;
+}
+
+void CPUMemoryDeleter::operator()(void *ptr) noexcept {
+  state_->free(ptr);
+}
+
+}  // namespace primitiv
@@ -0,0 +1,112 @@
+#ifndef PRIMITIV_CPU_MEMORY_POOL_H_
+#define PRIMITIV_CPU_MEMORY_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include <primitiv/mixins.h>
+
+namespace primitiv {
+
+class CPUMemoryDeleter;
+
+/**
+ * Memory manager on the host memory.
+ * @remarks Small blocks are cached by size classes whose sizes are spaced
+ *          by 1/8 of each power of two, and large blocks are cached as-is and
+ *          reused by the best-fit strategy.
+ *          All blocks are aligned to `ALIGNMENT` bytes.
+ *          All member functions are thread-safe, and each pool is guarded by
+ *          its own lock.
+ *          Supplied blocks keep the internal state of the pool alive, and
+ *          blocks released after destroying the pool are returned to the
+ *          system directly.
+ */
+class CPUMemoryPool : mixins::Nonmovable<CPUMemoryPool> {
+  friend CPUMemoryDeleter;
+
+public:
+  /**
+   * Alignment of every memory block in bytes.
+   */
+  static const std::uint64_t ALIGNMENT = 64;
+
+  /**
+   * Maximum size of blocks managed by size classes.
+   */
+  static const std::uint64_t MAX_SMALL_SIZE = 1ull << 20;
+
+  /**
+   * Creates a memory pool.
+   */
+  CPUMemoryPool();
+
+  ~CPUMemoryPool();
+
+  /**
+   * Allocates a memory.
+   * @param size Size of the resulting memory.
+   * @return Shared pointer of the allocated memory.
+   * @throw primitiv::Error Memory allocation failed.
+   */
+  std::shared_ptr<void> allocate(std::uint64_t size);
+
+  /**
+   * Releases all memory blocks which are not used currently.
+   */
+  void release_reserved();
+
+  /**
+   * Retrieves the total size of memory blocks held by this pool.
+   * @return Number of bytes of used and cached memory blocks.
+   */
+  std::uint64_t reserved_size() const;
+
+  /**
+   * Retrieves the total size of memory blocks currently used.
+   * @return Number of bytes of used memory blocks.
+   */
+  std::uint64_t in_use_size() const;
+
+  /**
+   * Retrieves the peak of `in_use_size()`.
+   * @return Maximum number of bytes used at the same time.
+   */
+  std::uint64_t peak_size() const;
+
+  /**
+   * Retrieves pool ID.
+   * @return pool ID.
+   */
+  std::uint64_t get_pool_id() const { return pool_id_; }
+
+private:
+  /**
+   * Internal state of the pool, which is shared with all deleters of supplied
+   * blocks.
+   */
+  struct State;
+
+  static std::atomic<std::uint64_t> next_pool_id_;
+
+  std::uint64_t pool_id_;
+  std::shared_ptr<State> state_;
+};
+
+/**
+ * Custom deleter class for host memories.
+ */
+class CPUMemoryDeleter {
+  CPUMemoryDeleter() = delete;
+public:
+  explicit CPUMemoryDeleter(const std::shared_ptr<CPUMemoryPool::State> &state)
+    : state_(state) {}
+  void operator()(void *ptr) noexcept;
+private:
+  std::shared_ptr<CPUMemoryPool::State> state_;
+};
+
+}  // namespace primitiv
+
+#endif  // PRIMITIV_CPU_MEMORY_POOL_H_
@@ -75,6 +75,25 @@ __global__ void pick_bw_dev(
   if (t < sy) ::atomicAdd(pgx + ox + (t / wy) * wx + (t % wy), pgy[oy + t]);
 }
 
+__global__ void pick_assign_dev(
+    const float *px, const unsigned *pi,
+    unsigned wy, unsigned wx, unsigned sy, unsigned si, unsigned sx,
+    float *py) {
+  const unsigned t = IDX;
+  const unsigned oy = blockIdx.y * sy + pi[blockIdx.y * si] * wx;
+  const unsigned ox = blockIdx.y * sx;
+  if (t < sx) py[oy + (t / wx) * wy + (t % wx)] = px[ox + t];
+}
+
+__global__ void pick_reset_dev(
+    float k, const unsigned *pi,
+    unsigned wx, unsigned wy, unsigned sx, unsigned si, unsigned sy,
+    float *px) {
+  const unsigned t = IDX;
+  const unsigned ox = blockIdx.y * sx + pi[blockIdx.y * si] * wy;
+  if (t < sy) px[ox + (t / wy) * wx + (t % wy)] = k;
+}
+
 __global__ void slice_bw_dev(
     const float *pgy, unsigned wx, unsigned wy, unsigned nx, unsigned ny,
     float *pgx) {
@@ -442,6 +461,238 @@ __global__ void batch_sum_fw_dev(
   }
 }
 
+template<unsigned BLOCK_SIZE>
+__device__ void reduce_max_dev(float *temp, unsigned tid) {
+#define REDUCE(k) \
+  if (BLOCK_SIZE >= k << 1) { \
+    if (tid < k) temp[tid] = ::fmaxf(temp[tid], temp[tid + k]); \
+    __syncthreads(); \
+  }
+  REDUCE(512)
+  REDUCE(256)
+  REDUCE(128)
+  REDUCE(64)
+  REDUCE(32)
+  REDUCE(16)
+  REDUCE(8)
+  REDUCE(4)
+  REDUCE(2)
+  REDUCE(1)
+#undef REDUCE
+}
+
+template<unsigned BLOCK_SIZE>
+__device__ void reduce_sum_dev(float *temp, unsigned tid) {
+#define REDUCE(k) \
+  if (BLOCK_SIZE >= k << 1) { \
+    if (tid < k) temp[tid] += temp[tid + k]; \
+    __syncthreads(); \
+  }
+  REDUCE(512)
+  REDUCE(256)
+  REDUCE(128)
+  REDUCE(64)
+  REDUCE(32)
+  REDUCE(16)
+  REDUCE(8)
+  REDUCE(4)
+  REDUCE(2)
+  REDUCE(1)
+#undef REDUCE
+}
+
+// Calculates the maximum value and the sum of exp(x - max) of each row.
+template<unsigned BLOCK_SIZE>
+__device__ void max_sumexp_dev(
+    const float *px, unsigned skip, unsigned n, float *temp, unsigned tid,
+    float &max_val, float &sum_val) {
+  temp[tid] = -1e38;  // Near the minimum of the float.
+  for (unsigned i = tid; i < n; i += BLOCK_SIZE) {
+    temp[tid] = ::fmaxf(temp[tid], px[i * skip]);
+  }
+  __syncthreads();
+  ::reduce_max_dev<BLOCK_SIZE>(temp, tid);
+  max_val = temp[0];
+  __syncthreads();
+  temp[tid] = 0;
+  for (unsigned i = tid; i < n; i += BLOCK_SIZE) {
+    temp[tid] += ::expf(px[i * skip] - max_val);
+  }
+  __syncthreads();
+  ::reduce_sum_dev<BLOCK_SIZE>(temp, tid);
+  sum_val = temp[0];
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void softmax_fw_dev(
+    const float *px, unsigned skip, unsigned n, float *py) {
+  __shared__ float temp[BLOCK_SIZE];
+  const unsigned bid = blockIdx.x;
+  const unsigned tid = threadIdx.x;
+  const unsigned offset = bid % skip + (bid / skip) * skip * n;
+  px += offset;
+  py += offset;
+  float max_val, sum_val;
+  ::max_sumexp_dev<BLOCK_SIZE>(px, skip, n, temp, tid, max_val, sum_val);
+  for (unsigned i = tid; i < n; i += BLOCK_SIZE) {
+    py[i * skip] = ::expf(px[i * skip] - max_val) / sum_val;
+  }
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void log_softmax_fw_dev(
+    const float *px, unsigned skip, unsigned n, float *py) {
+  __shared__ float temp[BLOCK_SIZE];
+  const unsigned bid = blockIdx.x;
+  const unsigned tid = threadIdx.x;
+  const unsigned offset = bid % skip + (bid / skip) * skip * n;
+  px += offset;
+  py += offset;
+  float max_val, sum_val;
+  ::max_sumexp_dev<BLOCK_SIZE>(px, skip, n, temp, tid, max_val, sum_val);
+  const float log_sum = ::logf(sum_val);
+  for (unsigned i = tid; i < n; i += BLOCK_SIZE) {
+    py[i * skip] = (px[i * skip] - max_val) - log_sum;
+  }
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void softmax_bw_dev(
+    const float *py, const float *pgy, unsigned skip, unsigned n,
+    float *pgx) {
+  __shared__ float temp[BLOCK_SIZE];
+  const unsigned bid = blockIdx.x;
+  const unsigned tid = threadIdx.x;
+  const unsigned offset = bid % skip + (bid / skip) * skip * n;
+  py += offset;
+  pgy += offset;
+  pgx += offset;
+  temp[tid] = 0;
+  for (unsigned i = tid; i < n; i += BLOCK_SIZE) {
+    temp[tid] += pgy[i * skip] * py[i * skip];
+  }
+  __syncthreads();
+  ::reduce_sum_dev<BLOCK_SIZE>(temp, tid);
+  const float sum_val = temp[0];
+  for (unsigned i = tid; i < n; i += BLOCK_SIZE) {
+    pgx[i * skip] += py[i * skip] * (pgy[i * skip] - sum_val);
+  }
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void log_softmax_bw_dev(
+    const float *py, const float *pgy, unsigned skip, unsigned n,
+    float *pgx) {
+  __shared__ float temp[BLOCK_SIZE];
+  const unsigned bid = blockIdx.x;
+  const unsigned tid = threadIdx.x;
+  const unsigned offset = bid % skip + (bid / skip) * skip * n;
+  py += offset;
+  pgy += offset;
+  pgx += offset;
+  temp[tid] = 0;
+  for (unsigned i = tid; i < n; i += BLOCK_SIZE) {
+    temp[tid] += pgy[i * skip];
+  }
+  __syncthreads();
+  ::reduce_sum_dev<BLOCK_SIZE>(temp, tid);
+  const float sum_val = temp[0];
+  for (unsigned i = tid; i < n; i += BLOCK_SIZE) {
+    pgx[i * skip] += pgy[i * skip] - ::expf(py[i * skip]) * sum_val;
+  }
+}
+
+__global__ void sparse_softmax_cross_entropy_fw_dev(
+    const float *px, const float *pl, const unsigned *pi,
+    unsigned n, unsigned skip, unsigned sx, unsigned sl, unsigned si,
+    unsigned size, float *py) {
+  const unsigned i = IDX;
+  if (i < size) {
+    const unsigned b = i / sl;
+    const unsigned r = i % sl;
+    py[i] = pl[b * (sx > 0) * sl + r]
+      - px[b * sx + r % skip + (r / skip * n + pi[b * si]) * skip];
+  }
+}
+
+__global__ void sparse_softmax_cross_entropy_bw_dev(
+    const float *px, const float *pl, const unsigned *pi, const float *pgy,
+    unsigned n, unsigned skip, unsigned sx, unsigned sl, unsigned si,
+    unsigned bs, unsigned size, float *pgx) {
+  const unsigned i = IDX;
+  if (i < size) {
+    // If `x` has no minibatch, every minibatch of `gy` is accumulated into
+    // the same element of `gx`.
+    const unsigned xb = i / sx;
+    const unsigned t = i % sx;
+    const unsigned j = t / skip % n;
+    const unsigned r = t % skip + t / (skip * n) * skip;
+    const float sm = ::expf(px[i] - pl[xb * sl + r]);
+    const unsigned b_begin = size > sx ? xb : 0;
+    const unsigned b_end = size > sx ? xb + 1 : bs;
+    float g = 0;
+    for (unsigned b = b_begin; b < b_end; ++b) {
+      g += pgy[b * sl + r] * (sm - (j == pi[b * si]));
+    }
+    pgx[i] += g;
+  }
+}
+
+__global__ void lstm_cell_fw_dev(
+    const float *pu, const float *pc, unsigned n, unsigned su, unsigned sc,
+    unsigned vol, unsigned size, float *pg, float *py) {
+  const unsigned i = IDX;
+  if (i < size) {
+    const unsigned b = i / vol;
+    const unsigned r = i % vol;
+    const unsigned ou = b * su + 3 * (r - r % n) + r;
+    const float vi = .5f + .5f * ::tanhf(.5f * pu[ou]);
+    const float vf = .5f + .5f * ::tanhf(.5f * pu[ou + n]);
+    const float vo = .5f + .5f * ::tanhf(.5f * pu[ou + 2 * n]);
+    const float vj = ::tanhf(pu[ou + 3 * n]);
+    const float vc = vi * vj + vf * pc[b * sc + r];
+    // If `u` has no minibatch, its gates are written only by the first
+    // minibatch to avoid data races.
+    if (su || !b) {
+      pg[ou] = vi;
+      pg[ou + n] = vf;
+      pg[ou + 2 * n] = vo;
+      pg[ou + 3 * n] = vj;
+    }
+    const unsigned oy = b * 2 * vol + r + (r - r % n);
+    py[oy] = vo * ::tanhf(vc);
+    py[oy + n] = vc;
+  }
+}
+
+__global__ void lstm_cell_bw_dev(
+    const float *pc, const float *pg, const float *py, const float *pgy,
+    unsigned n, unsigned su, unsigned sc, unsigned bs, unsigned vol,
+    float *pgu, float *pgc) {
+  const unsigned r = IDX;
+  if (r < vol) {
+    // Each thread processes all minibatches of the same element so that the
+    // gradients of the broadcasted arguments are accumulated without atomics.
+    for (unsigned b = 0; b < bs; ++b) {
+      const unsigned ou = b * su + 3 * (r - r % n) + r;
+      const unsigned oc = b * sc + r;
+      const unsigned oy = b * 2 * vol + r + (r - r % n);
+      const float vi = pg[ou];
+      const float vf = pg[ou + n];
+      const float vo = pg[ou + 2 * n];
+      const float vj = pg[ou + 3 * n];
+      const float tc = ::tanhf(py[oy + n]);
+      const float gh = pgy[oy];
+      const float dc = pgy[oy + n] + gh * vo * (1.f - tc * tc);
+      pgu[ou] += dc * vj * vi * (1.f - vi);
+      pgu[ou + n] += dc * pc[oc] * vf * (1.f - vf);
+      pgu[ou + 2 * n] += gh * tc * vo * (1.f - vo);
+      pgu[ou + 3 * n] += dc * vi * (1.f - vj * vj);
+      pgc[oc] += dc * vf;
+    }
+  }
+}
+
 __global__ void inplace_multiply_const_dev(
     float k, unsigned size, float *px) {
   const unsigned i = IDX;
@@ -462,6 +713,103 @@ __global__ void inplace_subtract_dev(
   if (i < size) ::atomicAdd(py + i + mby * shift, -px[i + mbx * shift]);
 }
 
+template<unsigned BLOCK_SIZE>
+__global__ void squared_norm_dev(const float *px, unsigned size, float *py) {
+  __shared__ float temp[BLOCK_SIZE];
+  const unsigned tid = threadIdx.x;
+  temp[tid] = 0;
+  for (unsigned i = IDX; i < size; i += gridDim.x * BLOCK_SIZE) {
+    temp[tid] += px[i] * px[i];
+  }
+  __syncthreads();
+#define REDUCE(k) \
+  if (BLOCK_SIZE >= k << 1) { \
+    if (tid < k) temp[tid] += temp[tid + k]; \
+    __syncthreads(); \
+  }
+  REDUCE(512)
+  REDUCE(256)
+  REDUCE(128)
+  REDUCE(64)
+  REDUCE(32)
+  REDUCE(16)
+  REDUCE(8)
+  REDUCE(4)
+  REDUCE(2)
+  REDUCE(1)
+#undef REDUCE
+  if (tid == 0) ::atomicAdd(py, temp[0]);
+}
+
+__global__ void sgd_update_dev(
+    float eta, const float *pg, unsigned size, float *px) {
+  const unsigned i = IDX;
+  if (i < size) px[i] -= eta * pg[i];
+}
+
+__global__ void momentum_sgd_update_dev(
+    float eta, float momentum, const float *pg, unsigned size,
+    float *pm, float *px) {
+  const unsigned i = IDX;
+  if (i < size) {
+    const float mi = momentum * pm[i] - eta * pg[i];
+    pm[i] = mi;
+    px[i] += mi;
+  }
+}
+
+__global__ void adagrad_update_dev(
+    float eta, float eps, const float *pg, unsigned size,
+    float *pm, float *px) {
+  const unsigned i = IDX;
+  if (i < size) {
+    const float gi = pg[i];
+    const float mi = pm[i] + gi * gi;
+    pm[i] = mi;
+    px[i] -= eta * gi / (::__fsqrt_rn(mi) + eps);
+  }
+}
+
+__global__ void rmsprop_update_dev(
+    float eta, float alpha, float eps, const float *pg, unsigned size,
+    float *pm, float *px) {
+  const unsigned i = IDX;
+  if (i < size) {
+    const float gi = pg[i];
+    const float mi = alpha * pm[i] + (1 - alpha) * gi * gi;
+    pm[i] = mi;
+    px[i] -= eta * gi / (::__fsqrt_rn(mi) + eps);
+  }
+}
+
+__global__ void adadelta_update_dev(
+    float scale, float rho, float eps, const float *pg, unsigned size,
+    float *pm1, float *pm2, float *px) {
+  const unsigned i = IDX;
+  if (i < size) {
+    const float gi = pg[i];
+    const float mi2 = rho * pm2[i] + (1 - rho) * gi * gi;
+    const float dx = ::__fsqrt_rn((pm1[i] + eps) / (mi2 + eps)) * gi;
+    pm1[i] = rho * pm1[i] + (1 - rho) * dx * dx;
+    pm2[i] = mi2;
+    px[i] -= scale * dx;
+  }
+}
+
+__global__ void adam_update_dev(
+    float alpha, float beta1, float beta2, float eps, float bias1, float bias2,
+    const float *pg, unsigned size, float *pm1, float *pm2, float *px) {
+  const unsigned i = IDX;
+  if (i < size) {
+    const float gi = pg[i];
+    const float mi1 = beta1 * pm1[i] + (1 - beta1) * gi;
+    const float mi2 = beta2 * pm2[i] + (1 - beta2) * gi * gi;
+    pm1[i] = mi1;
+    pm2[i] = mi2;
+    px[i] -= alpha * (mi1 / bias1) / (::__fsqrt_rn(mi2 / bias2) + eps);
+  }
+}
+
 #undef IDX
 #undef IDY
 
@@ -630,6 +978,11 @@ void CUDA::dump_description() const {
   */
 }
 
+void CUDA::synchronize() {
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  CUDA_CALL(::cudaDeviceSynchronize());
+}
+
 std::shared_ptr<void> CUDA::new_handle(const Shape &shape) {
   return pool_.allocate(sizeof(float) * shape.size());
 }
@@ -1167,6 +1520,168 @@ void CUDA::batch_sum_fw_impl(const Tensor &x, Tensor &y) {
       CDATA(x), size, x.shape().batch(), DATA(y));
 }
 
+void CUDA::softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned r = x.shape().size() / n;
+  const unsigned s = x.shape().lower_volume(dim);
+  unsigned block_size = dim1_x_;
+  while (block_size >> 1 >= n) block_size >>= 1;
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  switch (block_size) {
+#define CASE(k) \
+    case k: ::softmax_fw_dev<k><<<r, k>>>(CDATA(x), s, n, DATA(y)); break
+    CASE(1024);
+    CASE(512);
+    CASE(256);
+    CASE(128);
+    CASE(64);
+    CASE(32);
+    CASE(16);
+    CASE(8);
+    CASE(4);
+    CASE(2);
+    CASE(1);
+#undef CASE
+  }
+}
+
+void CUDA::log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned r = x.shape().size() / n;
+  const unsigned s = x.shape().lower_volume(dim);
+  unsigned block_size = dim1_x_;
+  while (block_size >> 1 >= n) block_size >>= 1;
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  switch (block_size) {
+#define CASE(k) \
+    case k: ::log_softmax_fw_dev<k><<<r, k>>>(CDATA(x), s, n, DATA(y)); break
+    CASE(1024);
+    CASE(512);
+    CASE(256);
+    CASE(128);
+    CASE(64);
+    CASE(32);
+    CASE(16);
+    CASE(8);
+    CASE(4);
+    CASE(2);
+    CASE(1);
+#undef CASE
+  }
+}
+
+void CUDA::softmax_bw_impl(
+    const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  const unsigned n = x.shape()[dim];
+  const unsigned r = x.shape().size() / n;
+  const unsigned s = x.shape().lower_volume(dim);
+  unsigned block_size = dim1_x_;
+  while (block_size >> 1 >= n) block_size >>= 1;
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  switch (block_size) {
+#define CASE(k) \
+    case k: ::softmax_bw_dev<k><<<r, k>>>( \
+        CDATA(y), CDATA(gy), s, n, DATA(gx)); break
+    CASE(1024);
+    CASE(512);
+    CASE(256);
+    CASE(128);
+    CASE(64);
+    CASE(32);
+    CASE(16);
+    CASE(8);
+    CASE(4);
+    CASE(2);
+    CASE(1);
+#undef CASE
+  }
+}
+
+void CUDA::log_softmax_bw_impl(
+    const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  const unsigned n = x.shape()[dim];
+  const unsigned r = x.shape().size() / n;
+  const unsigned s = x.shape().lower_volume(dim);
+  unsigned block_size = dim1_x_;
+  while (block_size >> 1 >= n) block_size >>= 1;
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  switch (block_size) {
+#define CASE(k) \
+    case k: ::log_softmax_bw_dev<k><<<r, k>>>( \
+        CDATA(y), CDATA(gy), s, n, DATA(gx)); break
+    CASE(1024);
+    CASE(512);
+    CASE(256);
+    CASE(128);
+    CASE(64);
+    CASE(32);
+    CASE(16);
+    CASE(8);
+    CASE(4);
+    CASE(2);
+    CASE(1);
+#undef CASE
+  }
+}
+
+void CUDA::sparse_softmax_cross_entropy_fw_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &lse, Tensor &y) {
+  logsumexp_fw_impl(x, dim, lse);
+  const unsigned size = y.shape().size();
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  CUDA_CALL(::cudaMemcpy(
+        ids_ptr_.get(), ids.data(), sizeof(unsigned) * ids.size(),
+        cudaMemcpyHostToDevice));
+  ::sparse_softmax_cross_entropy_fw_dev<<<g1, dim1_x_>>>(
+      CDATA(x), CDATA(lse), static_cast<const unsigned *>(ids_ptr_.get()),
+      x.shape()[dim], x.shape().lower_volume(dim),
+      x.shape().has_batch() * x.shape().volume(), y.shape().volume(),
+      ids.size() > 1, size, DATA(y));
+}
+
+void CUDA::sparse_softmax_cross_entropy_bw_impl(
+    const Tensor &x, const Tensor &lse, const std::vector<unsigned> &ids,
+    const Tensor &gy, unsigned dim, Tensor &gx) {
+  const unsigned size = x.shape().size();
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  CUDA_CALL(::cudaMemcpy(
+        ids_ptr_.get(), ids.data(), sizeof(unsigned) * ids.size(),
+        cudaMemcpyHostToDevice));
+  ::sparse_softmax_cross_entropy_bw_dev<<<g1, dim1_x_>>>(
+      CDATA(x), CDATA(lse), static_cast<const unsigned *>(ids_ptr_.get()),
+      CDATA(gy), x.shape()[dim], x.shape().lower_volume(dim),
+      x.shape().volume(), gy.shape().volume(), ids.size() > 1,
+      gy.shape().batch(), size, DATA(gx));
+}
+
+void CUDA::lstm_cell_fw_impl(
+    const Tensor &u, const Tensor &c, Tensor &gates, Tensor &y) {
+  const unsigned vol = c.shape().volume();
+  const unsigned size = y.shape().size() / 2;
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  ::lstm_cell_fw_dev<<<g1, dim1_x_>>>(
+      CDATA(u), CDATA(c), c.shape()[0], u.shape().has_batch() * 4 * vol,
+      c.shape().has_batch() * vol, vol, size, DATA(gates), DATA(y));
+}
+
+void CUDA::lstm_cell_bw_impl(
+    const Tensor &c, const Tensor &gates, const Tensor &y, const Tensor &gy,
+    Tensor &gu, Tensor &gc) {
+  const unsigned vol = c.shape().volume();
+  const unsigned g1 = GRID_SIZE(vol, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  ::lstm_cell_bw_dev<<<g1, dim1_x_>>>(
+      CDATA(c), CDATA(gates), CDATA(y), CDATA(gy), c.shape()[0],
+      gates.shape().has_batch() * 4 * vol, c.shape().has_batch() * vol,
+      y.shape().batch(), vol, DATA(gu), DATA(gc));
+}
+
 void CUDA::inplace_multiply_const_impl(float k, Tensor &x) {
   const unsigned size = x.shape().size();
   const unsigned g1 = GRID_SIZE(size, dim1_x_);
@@ -1192,5 +1707,158 @@ void CUDA::inplace_subtract_impl(const Tensor &x, Tensor &y) {
       CDATA(x), size, x.shape().has_batch(), y.shape().has_batch(), DATA(y));
 }
 
+void CUDA::inplace_matmul_add_impl(
+    const Tensor &a, const Tensor &b, Tensor &y) {
+  const unsigned di = a.shape()[0];
+  const unsigned dj = a.shape()[1];
+  const unsigned dk = b.shape()[1];
+  float alpha = 1.;
+  float beta = 1.;
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  if (a.shape().has_batch()) {
+    const unsigned a_skip = di * dj;
+    const unsigned b_skip = b.shape().has_batch() * dj * dk;
+    const unsigned y_skip = di * dk;
+    const unsigned bs = a.shape().batch();
+    for (unsigned n = 0; n < bs; ++n) {
+      CUBLAS_CALL(::cublasSgemm(
+            state_->cublas.get(), ::CUBLAS_OP_N, ::CUBLAS_OP_N,
+            di, dk, dj,
+            &alpha, CDATA(a) + n * a_skip, di, CDATA(b) + n * b_skip, dj,
+            &beta, DATA(y) + n * y_skip, di));
+    }
+  } else {
+    CUBLAS_CALL(::cublasSgemm(
+          state_->cublas.get(), ::CUBLAS_OP_N, ::CUBLAS_OP_N,
+          di, dk * b.shape().batch(), dj,
+          &alpha, CDATA(a), di, CDATA(b), dj,
+          &beta, DATA(y), di));
+  }
+}
+
+void CUDA::inplace_pick_assign_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  const unsigned wx = x.shape().lower_volume(dim);
+  const unsigned sx = x.shape().volume();
+  const unsigned g1 = GRID_SIZE(sx, dim1_x_);
+  const unsigned bs = x.shape().batch();
+
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  CUDA_CALL(::cudaMemcpy(
+        ids_ptr_.get(), ids.data(), sizeof(unsigned) * ids.size(),
+        cudaMemcpyHostToDevice));
+  ::pick_assign_dev<<<dim3(g1, bs), dim1_x_>>>(
+      CDATA(x), static_cast<const unsigned *>(ids_ptr_.get()),
+      wx * y.shape()[dim], wx,
+      y.shape().has_batch() * y.shape().volume(), ids.size() > 1, sx,
+      DATA(y));
+}
+
+void CUDA::inplace_pick_reset_impl(
+    float k, const std::vector<unsigned> &ids, unsigned dim, Tensor &x) {
+  const unsigned wy = x.shape().lower_volume(dim);
+  const unsigned sy = x.shape().volume() / x.shape()[dim];
+  const unsigned g1 = GRID_SIZE(sy, dim1_x_);
+  const unsigned bs = std::max<unsigned>(x.shape().batch(), ids.size());
+
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  CUDA_CALL(::cudaMemcpy(
+        ids_ptr_.get(), ids.data(), sizeof(unsigned) * ids.size(),
+        cudaMemcpyHostToDevice));
+  ::pick_reset_dev<<<dim3(g1, bs), dim1_x_>>>(
+      k, static_cast<const unsigned *>(ids_ptr_.get()),
+      wy * x.shape()[dim], wy,
+      x.shape().has_batch() * x.shape().volume(), ids.size() > 1, sy,
+      DATA(x));
+}
+
+float CUDA::squared_norm_impl(const std::vector<const Tensor *> &xs) {
+  // Each block accumulates its partial sum to one device memory, and the
+  // result is transferred to the host only once.
+  std::shared_ptr<void> py = pool_.allocate(sizeof(float));
+  float *py_ptr = static_cast<float *>(py.get());
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  CUDA_CALL(::cudaMemset(py_ptr, 0, sizeof(float)));
+  for (const Tensor *x : xs) {
+    const unsigned size = x->shape().size();
+    const unsigned g1 = std::min(GRID_SIZE(size, dim1_x_), dim1_x_);
+    switch (dim1_x_) {
+#define CASE(k) \
+      case k: ::squared_norm_dev<k><<<g1, k>>>(CDATA(*x), size, py_ptr); break
+      CASE(1024);
+      CASE(512);
+      CASE(256);
+      CASE(128);
+      CASE(64);
+      CASE(32);
+      CASE(16);
+      CASE(8);
+      CASE(4);
+      CASE(2);
+      CASE(1);
+#undef CASE
+    }
+  }
+  float ret;
+  CUDA_CALL(::cudaMemcpy(&ret, py_ptr, sizeof(float), cudaMemcpyDeviceToHost));
+  return ret;
+}
+
+void CUDA::sgd_update_impl(float eta, const Tensor &g, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  ::sgd_update_dev<<<g1, dim1_x_>>>(eta, CDATA(g), size, DATA(x));
+}
+
+void CUDA::momentum_sgd_update_impl(
+    float eta, float momentum, const Tensor &g, Tensor &m, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  ::momentum_sgd_update_dev<<<g1, dim1_x_>>>(
+      eta, momentum, CDATA(g), size, DATA(m), DATA(x));
+}
+
+void CUDA::adagrad_update_impl(
+    float eta, float eps, const Tensor &g, Tensor &m, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  ::adagrad_update_dev<<<g1, dim1_x_>>>(
+      eta, eps, CDATA(g), size, DATA(m), DATA(x));
+}
+
+void CUDA::rmsprop_update_impl(
+    float eta, float alpha, float eps, const Tensor &g, Tensor &m, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  ::rmsprop_update_dev<<<g1, dim1_x_>>>(
+      eta, alpha, eps, CDATA(g), size, DATA(m), DATA(x));
+}
+
+void CUDA::adadelta_update_impl(
+    float scale, float rho, float eps, const Tensor &g,
+    Tensor &m1, Tensor &m2, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  ::adadelta_update_dev<<<g1, dim1_x_>>>(
+      scale, rho, eps, CDATA(g), size, DATA(m1), DATA(m2), DATA(x));
+}
+
+void CUDA::adam_update_impl(
+    float alpha, float beta1, float beta2, float eps, float bias1, float bias2,
+    const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  ::adam_update_dev<<<g1, dim1_x_>>>(
+      alpha, beta1, beta2, eps, bias1, bias2,
+      CDATA(g), size, DATA(m1), DATA(m2), DATA(x));
+}
+
 }  // namespace devices
 }  // namespace primitiv
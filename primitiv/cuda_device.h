@@ -44,6 +44,8 @@ public:
   Device::DeviceType type() const override { return Device::DEVICE_TYPE_CUDA; }
 
 private:
+  void synchronize() override;
+
   std::shared_ptr<void> new_handle(const Shape &shape) override;
 
   std::vector<float> tensor_to_vector_impl(const Tensor &x) override;
@@ -144,10 +146,34 @@ private:
   void broadcast_fw_impl(const Tensor &x, unsigned dim, unsigned size, Tensor &y) override;
   void batch_sum_fw_impl(const Tensor &x, Tensor &y) override;
 
+  void softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+  void log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+
+  void softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+  void log_softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+
+  void sparse_softmax_cross_entropy_fw_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &lse, Tensor &y) override;
+  void sparse_softmax_cross_entropy_bw_impl(const Tensor &x, const Tensor &lse, const std::vector<unsigned> &ids, const Tensor &gy, unsigned dim, Tensor &gx) override;
+
+  void lstm_cell_fw_impl(const Tensor &u, const Tensor &c, Tensor &gates, Tensor &y) override;
+  void lstm_cell_bw_impl(const Tensor &c, const Tensor &gates, const Tensor &y, const Tensor &gy, Tensor &gu, Tensor &gc) override;
+
   void inplace_multiply_const_impl(float k, Tensor &x) override;
 
   void inplace_add_impl(const Tensor &x, Tensor &y) override;
   void inplace_subtract_impl(const Tensor &x, Tensor &y) override;
+  void inplace_matmul_add_impl(const Tensor &a, const Tensor &b, Tensor &y) override;
+  void inplace_pick_assign_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) override;
+  void inplace_pick_reset_impl(float k, const std::vector<unsigned> &ids, unsigned dim, Tensor &x) override;
+
+  float squared_norm_impl(const std::vector<const Tensor *> &xs) override;
+
+  void sgd_update_impl(float eta, const Tensor &g, Tensor &x) override;
+  void momentum_sgd_update_impl(float eta, float momentum, const Tensor &g, Tensor &m, Tensor &x) override;
+  void adagrad_update_impl(float eta, float eps, const Tensor &g, Tensor &m, Tensor &x) override;
+  void rmsprop_update_impl(float eta, float alpha, float eps, const Tensor &g, Tensor &m, Tensor &x) override;
+  void adadelta_update_impl(float scale, float rho, float eps, const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) override;
+  void adam_update_impl(float alpha, float beta1, float beta2, float eps, float bias1, float bias2, const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) override;
 
 private:
   unsigned dev_id_;
@@ -1,9 +1,16 @@
 #include <config.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
 #include <primitiv/device.h>
 #include <primitiv/error.h>
 #include <primitiv/shape_ops.h>
 
+using std::cerr;
+using std::endl;
 using std::vector;
 
 #ifdef PRIMITIV_NEED_EXPLICIT_STATIC_SYMBOLS
@@ -15,6 +22,47 @@ Device *DefaultSettable<Device>::default_obj_ = nullptr;
 }  // namespace primitiv
 #endif  // PRIMITIV_NEED_EXPLICIT_STATIC_SYMBOLS
 
+namespace {
+
+// Memory reserved for the next tensor on each thread.
+struct Reservation {
+  primitiv::Device *device;
+  unsigned size;
+  std::shared_ptr<void> handle;
+};
+thread_local Reservation reservation;
+
+// Total size of tensors allocated on each thread.
+thread_local std::uint64_t total_allocated = 0;
+
+// Joins string representations of shapes.
+std::string shape_strings(const std::vector<const primitiv::Shape *> &shapes) {
+  std::string ret;
+  for (const primitiv::Shape *s : shapes) {
+    if (!ret.empty()) ret += ", ";
+    ret += s->to_string();
+  }
+  return ret;
+}
+
+// Number of elements of the tensor.
+std::uint64_t num_elements(const primitiv::Tensor &x) {
+  return x.shape().size();
+}
+
+// Deleter which keeps the whole memory of another tensor alive instead of
+// deleting the reserved range.
+class KeepAliveDeleter {
+public:
+  explicit KeepAliveDeleter(const std::shared_ptr<void> &owner)
+    : owner_(owner) {}
+  void operator()(void *) {}
+private:
+  std::shared_ptr<void> owner_;
+};
+
+}  // namespace
+
 // NOTE(odashi): This source only checks shape prerequisites of each operation.
 
 #define CHECK_DEVICE(x) \
@@ -24,48 +72,215 @@ Device *DefaultSettable<Device>::default_obj_ = nullptr;
         << " != this: " << this); \
   }
 
+// Measures the operation until the end of the scope if the profiler is
+// enabled. `elements` is the number of elements read or written by the
+// operation. Arguments are evaluated only if the profiler is enabled.
+#define PROFILE(name, shapes, elements, flops) \
+  ProfileScope profile_scope_; \
+  if (profiling_) { \
+    profile_scope_.start( \
+        *this, name, shapes, sizeof(float) * (elements), flops); \
+  }
+
 namespace primitiv {
 
+class Device::ProfileScope {
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+public:
+  ProfileScope() : dev_(nullptr) {}
+
+  ~ProfileScope() {
+    if (!dev_) return;
+    try {
+      dev_->synchronize();
+      const double elapsed = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start_).count();
+      std::lock_guard<std::mutex> lock(dev_->profile_mutex_);
+      auto it = dev_->profile_.find(key_);
+      if (it == dev_->profile_.end()) {
+        it = dev_->profile_.emplace(
+            key_, ProfileEntry { key_.first, key_.second, 0, 0, 0, 0 }).first;
+      }
+      ProfileEntry &entry = it->second;
+      ++entry.count;
+      entry.total_time += elapsed;
+      entry.bytes += bytes_;
+      entry.flops += flops_;
+    } catch (...) {
+      // Errors of the device are reported by the next operation.
+    }
+  }
+
+  void start(
+      Device &dev, const char *name, std::string &&shapes,
+      std::uint64_t bytes, std::uint64_t flops) {
+    dev.synchronize();
+    dev_ = &dev;
+    key_ = std::make_pair(std::string(name), std::move(shapes));
+    bytes_ = bytes;
+    flops_ = flops;
+    start_ = std::chrono::steady_clock::now();
+  }
+
+private:
+  Device *dev_;
+  std::pair<std::string, std::string> key_;
+  std::uint64_t bytes_;
+  std::uint64_t flops_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+std::vector<Device::ProfileEntry> Device::get_profile() const {
+  vector<ProfileEntry> ret;
+  {
+    std::lock_guard<std::mutex> lock(profile_mutex_);
+    ret.reserve(profile_.size());
+    for (const auto &kv : profile_) ret.emplace_back(kv.second);
+  }
+  std::stable_sort(
+      ret.begin(), ret.end(), [](const ProfileEntry &a, const ProfileEntry &b) {
+        return a.total_time > b.total_time;
+      });
+  return ret;
+}
+
+void Device::reset_profile() {
+  std::lock_guard<std::mutex> lock(profile_mutex_);
+  profile_.clear();
+}
+
+void Device::dump_profile() const {
+  const vector<ProfileEntry> entries = get_profile();
+  double total_time = 0;
+  for (const ProfileEntry &e : entries) total_time += e.total_time;
+
+  const std::ios::fmtflags flags = cerr.flags();
+  const std::streamsize precision = cerr.precision();
+  cerr << "Profile of device " << this << ':' << endl;
+  cerr << std::setw(10) << "Time[ms]" << std::setw(8) << "%"
+       << std::setw(10) << "Calls" << std::setw(12) << "Avg[us]"
+       << std::setw(12) << "MB" << std::setw(10) << "GFLOPS"
+       << "  Operation (shapes)" << endl;
+  for (const ProfileEntry &e : entries) {
+    cerr << std::fixed
+         << std::setw(10) << std::setprecision(3) << e.total_time * 1e3
+         << std::setw(8) << std::setprecision(2)
+         << (total_time > 0 ? 100 * e.total_time / total_time : 0)
+         << std::setw(10) << e.count
+         << std::setw(12) << std::setprecision(3)
+         << e.total_time * 1e6 / e.count
+         << std::setw(12) << std::setprecision(3) << e.bytes / 1e6
+         << std::setw(10) << std::setprecision(3)
+         << (e.total_time > 0 ? e.flops / e.total_time / 1e9 : 0)
+         << "  " << e.name << " (" << e.shapes << ')' << endl;
+  }
+  cerr.flags(flags);
+  cerr.precision(precision);
+}
+
 Tensor Device::new_raw_tensor(const Shape &shape) {
-  return Tensor(shape, *this, new_handle(shape));
+  return Tensor(shape, *this, get_handle(shape));
+}
+
+Tensor Device::new_view(const Tensor &x, const Shape &shape, unsigned offset) {
+  // The aliasing constructor shares the ownership of the original memory.
+  return Tensor(
+      shape, *this,
+      std::shared_ptr<void>(
+        x.data_, static_cast<float *>(x.data_.get()) + offset));
+}
+
+void Device::reserve_range(const Tensor &x, unsigned offset, unsigned size) {
+  CHECK_DEVICE(x);
+  // The next tensor holds the memory through another reference counter to
+  // allow writing while `x` is alive.
+  ::reservation.device = this;
+  ::reservation.size = size;
+  ::reservation.handle = std::shared_ptr<void>(
+      static_cast<float *>(x.data_.get()) + offset,
+      ::KeepAliveDeleter(x.data_));
+}
+
+void Device::cancel_reservation() {
+  ::reservation.handle.reset();
+}
+
+bool Device::has_reservation() const {
+  return ::reservation.handle && ::reservation.device == this;
+}
+
+bool Device::has_unique_memory(const Tensor &x) {
+  return x.data_.use_count() == 1;
+}
+
+bool Device::reserve_unique_handle(const Tensor &x) {
+  if (&x.device() != this || ::reservation.handle || !has_unique_memory(x)) {
+    return false;
+  }
+  reserve_range(x, 0, x.shape().size());
+  return true;
+}
+
+std::uint64_t Device::allocated_bytes() {
+  return ::total_allocated;
+}
+
+std::shared_ptr<void> Device::get_handle(const Shape &shape) {
+  PROFILE("allocate", shape.to_string(), shape.size(), 0);
+  ::total_allocated += sizeof(float) * shape.size();
+  if (::reservation.handle &&
+      ::reservation.device == this &&
+      ::reservation.size == shape.size()) {
+    // The reservation is moved to the tensor to keep its reference count 1.
+    return std::move(::reservation.handle);
+  }
+  return new_handle(shape);
 }
 
 Tensor Device::new_tensor_by_constant(const Shape &shape, float k) {
-  Tensor ret(shape, *this, new_handle(shape));
+  Tensor ret(shape, *this, get_handle(shape));
   reset_tensor(k, ret);
   return ret;
 }
 
 Tensor Device::new_tensor_by_array(const Shape &shape, const float values[]) {
-  Tensor ret(shape, *this, new_handle(shape));
+  Tensor ret(shape, *this, get_handle(shape));
   reset_tensor_by_array(values, ret);
   return ret;
 }
 
 Tensor Device::new_tensor_by_vector(
     const Shape &shape, const vector<float> &values) {
-  Tensor ret(shape, *this, new_handle(shape));
+  Tensor ret(shape, *this, get_handle(shape));
   reset_tensor_by_vector(values, ret);
   return ret;
 }
 
 vector<float> Device::tensor_to_vector(const Tensor &x) {
   CHECK_DEVICE(x);
+  PROFILE("tensor_to_vector", x.shape().to_string(), ::num_elements(x), 0);
   return tensor_to_vector_impl(x);
 }
 
 vector<unsigned> Device::argmax(const Tensor &x, unsigned dim) {
   CHECK_DEVICE(x);
+  PROFILE(
+      "argmax", x.shape().to_string(), ::num_elements(x), ::num_elements(x));
   return argmax_impl(x, dim);
 }
 
 vector<unsigned> Device::argmin(const Tensor &x, unsigned dim) {
   CHECK_DEVICE(x);
+  PROFILE(
+      "argmin", x.shape().to_string(), ::num_elements(x), ::num_elements(x));
   return argmin_impl(x, dim);
 }
 
 void Device::reset_tensor(float k, Tensor &x) {
   CHECK_DEVICE(x);
+  PROFILE("reset_tensor", x.shape().to_string(), ::num_elements(x), 0);
   reset_tensor_impl(k, x);
 }
 
@@ -73,6 +288,9 @@ void Device::reset_tensor_by_array(const float values[], Tensor &x) {
   // NOTE(odashi):
   // There is no method to guarantee the size of the array for now.
   CHECK_DEVICE(x);
+  PROFILE(
+      "reset_tensor_by_array", x.shape().to_string(),
+      2 * ::num_elements(x), 0);
   reset_tensor_by_array_impl(values, x);
 }
 
@@ -84,6 +302,9 @@ void Device::reset_tensor_by_vector(const vector<float> &values, Tensor &x) {
         << " (shape: " << x.shape().to_string() << ") != actual: "
         << values.size());
   }
+  PROFILE(
+      "reset_tensor_by_array", x.shape().to_string(),
+      2 * ::num_elements(x), 0);
   reset_tensor_by_array_impl(values.data(), x);
 }
 
@@ -92,6 +313,7 @@ Tensor Device::copy_tensor(const Tensor &x) {
   // This function should return always different memory with x.
   if (!x.valid()) THROW_ERROR("Attempted to copy an invalid tensor.");
   Tensor y = new_raw_tensor(x.shape());
+  PROFILE("copy_tensor", x.shape().to_string(), 2 * ::num_elements(x), 0);
   copy_tensor_impl(x, y);
   return y;
 }
@@ -101,69 +323,157 @@ Tensor Device::identity(unsigned size) {
     THROW_ERROR("Invalid size of the identity matrix: " << size);
   }
   Tensor y = new_raw_tensor({size, size});
+  PROFILE("identity", y.shape().to_string(), ::num_elements(y), 0);
   identity_impl(y);
   return y;
 }
 
 Tensor Device::random_bernoulli(const Shape &shape, float p) {
+  Tensor y = new_raw_tensor(shape);
+  random_bernoulli_into(p, y);
+  return y;
+}
+
+void Device::random_bernoulli_into(float p, Tensor &y) {
+  CHECK_DEVICE(y);
   if (p < 0 || p > 1) {
     THROW_ERROR("Invalid Bernoulli probability: " << p);
   }
-  Tensor y = new_raw_tensor(shape);
+  PROFILE(
+      "random_bernoulli", y.shape().to_string(),
+      y.shape().size(), y.shape().size());
   random_bernoulli_impl(p, y);
+}
+
+Tensor Device::random_uniform(const Shape &shape, float lower, float upper) {
+  Tensor y = new_raw_tensor(shape);
+  random_uniform_into(lower, upper, y);
   return y;
 }
 
-Tensor Device::random_uniform(
-    const Shape &shape, float lower, float upper) {
+void Device::random_uniform_into(float lower, float upper, Tensor &y) {
+  CHECK_DEVICE(y);
   if (upper < lower) {
     THROW_ERROR(
         "Invalid parameter of the uniform distribution. lower: " << lower
         << ", upper: " << upper);
   }
-  Tensor y = new_raw_tensor(shape);
+  PROFILE(
+      "random_uniform", y.shape().to_string(),
+      y.shape().size(), y.shape().size());
   random_uniform_impl(lower, upper, y);
-  return y;
 }
 
 Tensor Device::random_normal(const Shape &shape, float mean, float sd) {
+  Tensor y = new_raw_tensor(shape);
+  random_normal_into(mean, sd, y);
+  return y;
+}
+
+void Device::random_normal_into(float mean, float sd, Tensor &y) {
+  CHECK_DEVICE(y);
   if (sd <= 0) {
     THROW_ERROR(
         "Invalid parameter of the normal distribution. mean: " << mean
         << ", SD: " << sd);
   }
-  Tensor y = new_raw_tensor(shape);
+  PROFILE(
+      "random_normal", y.shape().to_string(),
+      y.shape().size(), y.shape().size());
   random_normal_impl(mean, sd, y);
-  return y;
 }
 
 Tensor Device::random_log_normal(const Shape &shape, float mean, float sd) {
+  Tensor y = new_raw_tensor(shape);
+  random_log_normal_into(mean, sd, y);
+  return y;
+}
+
+void Device::random_log_normal_into(float mean, float sd, Tensor &y) {
+  CHECK_DEVICE(y);
   if (sd <= 0) {
     THROW_ERROR(
         "Invalid parameter of the log-normal distribution. mean: " << mean
         << ", SD: " << sd);
   }
-  Tensor y = new_raw_tensor(shape);
+  PROFILE(
+      "random_log_normal", y.shape().to_string(),
+      y.shape().size(), y.shape().size());
   random_log_normal_impl(mean, sd, y);
-  return y;
 }
 
+// Checks the shape of the output tensor of `*_into` functions.
+#define CHECK_OUTPUT(name, y, expected) { \
+  const Shape &s_ = (expected); \
+  if ((y).shape() != s_) { \
+    THROW_ERROR( \
+        "Shape mismatched at " #name ". " #y ".shape: " \
+        << (y).shape().to_string() \
+        << " != expected: " << s_.to_string()); \
+  } \
+}
+
+// Checks that the output tensor is not an argument of non-elementwise
+// operations.
+#define CHECK_NOT_ALIASED(name, x, y) \
+  if (&(x) == &(y)) { \
+    THROW_ERROR("The output of " #name " should not be an argument."); \
+  }
+
 Tensor Device::pick_fw(
     const Tensor &x, const vector<unsigned> &ids, unsigned dim) {
   CHECK_DEVICE(x);
-  Tensor y = new_raw_tensor(shape_ops::pick(x.shape(), ids, dim));
-  pick_fw_impl(x, ids, dim, y);
+  const Shape &s = x.shape();
+  const Shape ys = shape_ops::pick(s, ids, dim);
+  if (ids.size() == 1 && s.batch() == 1 &&
+      s.volume() == s.lower_volume(dim + 1)) {
+    // The picked range is contiguous.
+    return new_view(x, ys, ids[0] * s.lower_volume(dim));
+  }
+  Tensor y = new_raw_tensor(ys);
+  pick_fw_into(x, ids, dim, y);
   return y;
 }
 
+void Device::pick_fw_into(
+    const Tensor &x, const vector<unsigned> &ids, unsigned dim, Tensor &y) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(y);
+  CHECK_OUTPUT(pick_fw_into, y, shape_ops::pick(x.shape(), ids, dim));
+  CHECK_NOT_ALIASED(pick_fw_into, x, y);
+  PROFILE(
+      "pick_fw", x.shape().to_string(), 2 * ::num_elements(y), 0);
+  pick_fw_impl(x, ids, dim, y);
+}
+
 Tensor Device::slice_fw(
     const Tensor &x, unsigned dim, unsigned lower, unsigned upper) {
   CHECK_DEVICE(x);
-  Tensor y = new_raw_tensor(shape_ops::slice(x.shape(), dim, lower, upper));
-  slice_fw_impl(x, dim, lower, y);
+  const Shape &s = x.shape();
+  const Shape ys = shape_ops::slice(s, dim, lower, upper);
+  if (s.volume() == s.lower_volume(dim + 1) &&
+      (s.batch() == 1 || ys.volume() == s.volume())) {
+    // The sliced range is contiguous.
+    return new_view(x, ys, lower * s.lower_volume(dim));
+  }
+  Tensor y = new_raw_tensor(ys);
+  slice_fw_into(x, dim, lower, upper, y);
   return y;
 }
 
+void Device::slice_fw_into(
+    const Tensor &x, unsigned dim, unsigned lower, unsigned upper,
+    Tensor &y) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(y);
+  CHECK_OUTPUT(
+      slice_fw_into, y, shape_ops::slice(x.shape(), dim, lower, upper));
+  CHECK_NOT_ALIASED(slice_fw_into, x, y);
+  PROFILE(
+      "slice_fw", x.shape().to_string(), 2 * ::num_elements(y), 0);
+  slice_fw_impl(x, dim, lower, y);
+}
+
 Tensor Device::concat_fw(const vector<const Tensor *> &xs, unsigned dim) {
   if (xs.empty()) THROW_ERROR("No tensors to concat.");
   vector<const Shape *> shapes(xs.size());
@@ -172,10 +482,26 @@ Tensor Device::concat_fw(const vector<const Tensor *> &xs, unsigned dim) {
     shapes[i] = &xs[i]->shape();
   }
   Tensor y = new_raw_tensor(shape_ops::concat(shapes, dim));
-  concat_fw_impl(xs, dim, y);
+  concat_fw_into(xs, dim, y);
   return y;
 }
 
+void Device::concat_fw_into(
+    const vector<const Tensor *> &xs, unsigned dim, Tensor &y) {
+  if (xs.empty()) THROW_ERROR("No tensors to concat.");
+  CHECK_DEVICE(y);
+  vector<const Shape *> shapes(xs.size());
+  for (unsigned i = 0; i < xs.size(); ++i) {
+    CHECK_DEVICE(*xs[i]);
+    CHECK_NOT_ALIASED(concat_fw_into, *xs[i], y);
+    shapes[i] = &xs[i]->shape();
+  }
+  CHECK_OUTPUT(concat_fw_into, y, shape_ops::concat(shapes, dim));
+  PROFILE(
+      "concat_fw", ::shape_strings(shapes), 2 * ::num_elements(y), 0);
+  concat_fw_impl(xs, dim, y);
+}
+
 void Device::pick_bw(
     const Tensor &gy, const std::vector<unsigned> &ids, unsigned dim,
     Tensor &gx) {
@@ -187,6 +513,9 @@ void Device::pick_bw(
         "Shape mismatched. gy.shape(): " << gy.shape().to_string()
         << " != expected shape: " << sy.to_string());
   }
+  PROFILE(
+      "pick_bw", gx.shape().to_string(),
+      3 * ::num_elements(gy), ::num_elements(gy));
   pick_bw_impl(gy, ids, dim, gx);
 }
 
@@ -203,16 +532,31 @@ void Device::slice_bw(
         << sy.to_string() << ", dim " << dim << ", offset " << offset
         << " to shape" << sx.to_string() << '.');
   }
+  PROFILE(
+      "slice_bw", sx.to_string(), 3 * ::num_elements(gy), ::num_elements(gy));
   if (dim >= sx.depth()) inplace_add_impl(gy, gx);
   else slice_bw_impl(gy, dim, offset, gx);
 }
 
+// Estimated numbers of floating point operations.
+#define ELEMENTWISE_FLOPS(a, y) ::num_elements(y)
+#define MATMUL_FLOPS(a, y) (2 * ::num_elements(y) * (a).shape()[1])
+
 #define DEV_FW_X(name, sop) \
 Tensor Device::name##_fw(const Tensor &x) { \
   CHECK_DEVICE(x); \
   Tensor y = new_raw_tensor(sop(x.shape())); \
-  name##_fw_impl(x, y); \
+  name##_fw_into(x, y); \
   return y; \
+} \
+void Device::name##_fw_into(const Tensor &x, Tensor &y) { \
+  CHECK_DEVICE(x); \
+  CHECK_DEVICE(y); \
+  CHECK_OUTPUT(name##_fw_into, y, sop(x.shape())); \
+  PROFILE( \
+      #name "_fw", x.shape().to_string(), \
+      ::num_elements(x) + ::num_elements(y), ::num_elements(y)); \
+  name##_fw_impl(x, y); \
 }
 
 #define DEV_BW_X(name, sop) \
@@ -232,6 +576,10 @@ void Device::name##_bw( \
         << ", gy.shape: " << gy.shape().to_string() \
         << ", gx.shape: " << gx.shape().to_string()); \
   } \
+  PROFILE( \
+      #name "_bw", x.shape().to_string(), \
+      ::num_elements(x) + 2 * ::num_elements(y) + 2 * ::num_elements(gx), \
+      2 * ::num_elements(gx)); \
   name##_bw_impl(x, y, gy, gx); \
 }
 
@@ -239,8 +587,17 @@ void Device::name##_bw( \
 Tensor Device::name##_fw(const Tensor &x, float k) { \
   CHECK_DEVICE(x); \
   Tensor y = new_raw_tensor(x.shape()); \
-  name##_fw_impl(x, k, y); \
+  name##_fw_into(x, k, y); \
   return y; \
+} \
+void Device::name##_fw_into(const Tensor &x, float k, Tensor &y) { \
+  CHECK_DEVICE(x); \
+  CHECK_DEVICE(y); \
+  CHECK_OUTPUT(name##_fw_into, y, x.shape()); \
+  PROFILE( \
+      #name "_fw", x.shape().to_string(), \
+      2 * ::num_elements(x), ::num_elements(x)); \
+  name##_fw_impl(x, k, y); \
 }
 
 #define DEV_BW_X_CONST(name) \
@@ -259,19 +616,37 @@ void Device::name##_bw( \
         << ", gy.shape: " << gy.shape().to_string() \
         << ", gx.shape: " << gx.shape().to_string()); \
   } \
+  PROFILE( \
+      #name "_bw", s.to_string(), 5 * ::num_elements(x), \
+      2 * ::num_elements(x)); \
   name##_bw_impl(x, y, gy, k, gx); \
 }
 
-#define DEV_FW_AB(name, sop) \
+#define DEV_FW_AB(name, sop, fop, elementwise) \
 Tensor Device::name##_fw(const Tensor &a, const Tensor &b) { \
   CHECK_DEVICE(a); \
   CHECK_DEVICE(b); \
   Tensor y = new_raw_tensor(sop(a.shape(), b.shape())); \
-  name##_fw_impl(a, b, y); \
+  name##_fw_into(a, b, y); \
   return y; \
+} \
+void Device::name##_fw_into(const Tensor &a, const Tensor &b, Tensor &y) { \
+  CHECK_DEVICE(a); \
+  CHECK_DEVICE(b); \
+  CHECK_DEVICE(y); \
+  CHECK_OUTPUT(name##_fw_into, y, sop(a.shape(), b.shape())); \
+  if (!elementwise) { \
+    CHECK_NOT_ALIASED(name##_fw_into, a, y); \
+    CHECK_NOT_ALIASED(name##_fw_into, b, y); \
+  } \
+  PROFILE( \
+      #name "_fw", a.shape().to_string() + ", " + b.shape().to_string(), \
+      ::num_elements(a) + ::num_elements(b) + ::num_elements(y), \
+      fop(a, y)); \
+  name##_fw_impl(a, b, y); \
 }
 
-#define DEV_BW_AB(name, sop) \
+#define DEV_BW_AB(name, sop, fop) \
 void Device::name##_bw( \
     const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy, \
     Tensor &ga, Tensor &gb) { \
@@ -294,6 +669,11 @@ void Device::name##_bw( \
         << ", ga.shape: " << ga.shape().to_string() \
         << ", gb.shape: " << gb.shape().to_string()); \
   } \
+  PROFILE( \
+      #name "_bw", a.shape().to_string() + ", " + b.shape().to_string(), \
+      3 * ::num_elements(a) + 3 * ::num_elements(b) \
+      + 2 * ::num_elements(y), \
+      2 * fop(a, y)); \
   name##_bw_impl(a, b, y, gy, ga, gb); \
 }
 
@@ -307,7 +687,29 @@ DEV_FW_X(softplus, static_cast<const Shape &>);
 DEV_FW_X(sin, static_cast<const Shape &>);
 DEV_FW_X(cos, static_cast<const Shape &>);
 DEV_FW_X(tan, static_cast<const Shape &>);
-DEV_FW_X(transpose, shape_ops::transpose);
+
+Tensor Device::transpose_fw(const Tensor &x) {
+  CHECK_DEVICE(x);
+  const Shape ys = shape_ops::transpose(x.shape());
+  if (ys[0] == 1 || ys[1] == 1) {
+    // Transposing vectors does not change the memory layout.
+    return new_view(x, ys, 0);
+  }
+  Tensor y = new_raw_tensor(ys);
+  transpose_fw_into(x, y);
+  return y;
+}
+
+void Device::transpose_fw_into(const Tensor &x, Tensor &y) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(y);
+  CHECK_OUTPUT(transpose_fw_into, y, shape_ops::transpose(x.shape()));
+  CHECK_NOT_ALIASED(transpose_fw_into, x, y);
+  PROFILE(
+      "transpose_fw", x.shape().to_string(),
+      ::num_elements(x) + ::num_elements(y), ::num_elements(y));
+  transpose_fw_impl(x, y);
+}
 
 DEV_BW_X(sqrt, static_cast<const Shape &>);
 DEV_BW_X(exp, static_cast<const Shape &>);
@@ -338,24 +740,24 @@ DEV_BW_X_CONST(divide_const_l);
 DEV_BW_X_CONST(prelu);
 DEV_BW_X_CONST(elu);
 
-DEV_FW_AB(add_scalar, shape_ops::scalar_op);
-DEV_FW_AB(subtract_scalar_r, shape_ops::scalar_op);
-DEV_FW_AB(subtract_scalar_l, shape_ops::scalar_op);
-DEV_FW_AB(multiply_scalar, shape_ops::scalar_op);
-DEV_FW_AB(divide_scalar_r, shape_ops::scalar_op);
-DEV_FW_AB(divide_scalar_l, shape_ops::scalar_op);
-
-DEV_FW_AB(add, shape_ops::elementwise);
-DEV_FW_AB(subtract, shape_ops::elementwise);
-DEV_FW_AB(multiply, shape_ops::elementwise);
-DEV_FW_AB(divide, shape_ops::elementwise);
-DEV_FW_AB(matmul, shape_ops::matmul);
-
-DEV_BW_AB(add, shape_ops::elementwise);
-DEV_BW_AB(subtract, shape_ops::elementwise);
-DEV_BW_AB(multiply, shape_ops::elementwise);
-DEV_BW_AB(divide, shape_ops::elementwise);
-DEV_BW_AB(matmul, shape_ops::matmul);
+DEV_FW_AB(add_scalar, shape_ops::scalar_op, ELEMENTWISE_FLOPS, true);
+DEV_FW_AB(subtract_scalar_r, shape_ops::scalar_op, ELEMENTWISE_FLOPS, true);
+DEV_FW_AB(subtract_scalar_l, shape_ops::scalar_op, ELEMENTWISE_FLOPS, true);
+DEV_FW_AB(multiply_scalar, shape_ops::scalar_op, ELEMENTWISE_FLOPS, true);
+DEV_FW_AB(divide_scalar_r, shape_ops::scalar_op, ELEMENTWISE_FLOPS, true);
+DEV_FW_AB(divide_scalar_l, shape_ops::scalar_op, ELEMENTWISE_FLOPS, true);
+
+DEV_FW_AB(add, shape_ops::elementwise, ELEMENTWISE_FLOPS, true);
+DEV_FW_AB(subtract, shape_ops::elementwise, ELEMENTWISE_FLOPS, true);
+DEV_FW_AB(multiply, shape_ops::elementwise, ELEMENTWISE_FLOPS, true);
+DEV_FW_AB(divide, shape_ops::elementwise, ELEMENTWISE_FLOPS, true);
+DEV_FW_AB(matmul, shape_ops::matmul, MATMUL_FLOPS, false);
+
+DEV_BW_AB(add, shape_ops::elementwise, ELEMENTWISE_FLOPS);
+DEV_BW_AB(subtract, shape_ops::elementwise, ELEMENTWISE_FLOPS);
+DEV_BW_AB(multiply, shape_ops::elementwise, ELEMENTWISE_FLOPS);
+DEV_BW_AB(divide, shape_ops::elementwise, ELEMENTWISE_FLOPS);
+DEV_BW_AB(matmul, shape_ops::matmul, MATMUL_FLOPS);
 
 #undef DEV_FW_X
 #undef DEV_BW_X
@@ -363,37 +765,249 @@ DEV_BW_AB(matmul, shape_ops::matmul);
 #undef DEV_BW_X_CONST
 #undef DEV_FW_AB
 #undef DEV_BW_AB
+#undef ELEMENTWISE_FLOPS
+#undef MATMUL_FLOPS
 
 Tensor Device::sum_fw(const Tensor &x, unsigned dim) {
   CHECK_DEVICE(x);
   Tensor y = new_raw_tensor(x.shape().resize_dim(dim, 1));
-  sum_fw_impl(x, dim, y);
+  sum_fw_into(x, dim, y);
   return y;
 }
 
+void Device::sum_fw_into(const Tensor &x, unsigned dim, Tensor &y) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(y);
+  CHECK_OUTPUT(sum_fw_into, y, x.shape().resize_dim(dim, 1));
+  CHECK_NOT_ALIASED(sum_fw_into, x, y);
+  PROFILE(
+      "sum_fw", x.shape().to_string(),
+      ::num_elements(x) + ::num_elements(y), ::num_elements(x));
+  sum_fw_impl(x, dim, y);
+}
+
 Tensor Device::logsumexp_fw(const Tensor &x, unsigned dim) {
   CHECK_DEVICE(x);
   Tensor y = new_raw_tensor(x.shape().resize_dim(dim, 1));
-  logsumexp_fw_impl(x, dim, y);
+  logsumexp_fw_into(x, dim, y);
   return y;
 }
 
+void Device::logsumexp_fw_into(const Tensor &x, unsigned dim, Tensor &y) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(y);
+  CHECK_OUTPUT(logsumexp_fw_into, y, x.shape().resize_dim(dim, 1));
+  CHECK_NOT_ALIASED(logsumexp_fw_into, x, y);
+  PROFILE(
+      "logsumexp_fw", x.shape().to_string(),
+      ::num_elements(x) + ::num_elements(y), ::num_elements(x));
+  logsumexp_fw_impl(x, dim, y);
+}
+
 Tensor Device::broadcast_fw(const Tensor &x, unsigned dim, unsigned size) {
   CHECK_DEVICE(x);
   Tensor y = new_raw_tensor(shape_ops::broadcast(x.shape(), dim, size));
-  broadcast_fw_impl(x, dim, size, y);
+  broadcast_fw_into(x, dim, size, y);
   return y;
 }
 
+void Device::broadcast_fw_into(
+    const Tensor &x, unsigned dim, unsigned size, Tensor &y) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(y);
+  CHECK_OUTPUT(
+      broadcast_fw_into, y, shape_ops::broadcast(x.shape(), dim, size));
+  CHECK_NOT_ALIASED(broadcast_fw_into, x, y);
+  PROFILE(
+      "broadcast_fw", x.shape().to_string(),
+      ::num_elements(x) + ::num_elements(y), 0);
+  broadcast_fw_impl(x, dim, size, y);
+}
+
 Tensor Device::batch_sum_fw(const Tensor &x) {
   CHECK_DEVICE(x);
   Tensor y = new_raw_tensor(x.shape().resize_batch(1));
+  PROFILE(
+      "batch_sum_fw", x.shape().to_string(),
+      ::num_elements(x) + ::num_elements(y), ::num_elements(x));
   batch_sum_fw_impl(x, y);
   return y;
 }
 
+Tensor Device::batch_to_columns_fw(const Tensor &x) {
+  CHECK_DEVICE(x);
+  return new_view(x, shape_ops::batch_to_columns(x.shape()), 0);
+}
+
+void Device::batch_to_columns_bw(const Tensor &gy, Tensor &gx) {
+  CHECK_DEVICE(gy);
+  CHECK_DEVICE(gx);
+  const Shape sy = shape_ops::batch_to_columns(gx.shape());
+  if (gy.shape() != sy) {
+    THROW_ERROR(
+        "Shape mismatched. gy.shape(): " << gy.shape().to_string()
+        << " != expected shape: " << sy.to_string());
+  }
+  inplace_add(new_view(gy, gx.shape(), 0), gx);
+}
+
+#define DEV_FW_DIM(name) \
+Tensor Device::name##_fw(const Tensor &x, unsigned dim) { \
+  CHECK_DEVICE(x); \
+  Tensor y = new_raw_tensor(x.shape()); \
+  name##_fw_into(x, dim, y); \
+  return y; \
+} \
+void Device::name##_fw_into(const Tensor &x, unsigned dim, Tensor &y) { \
+  CHECK_DEVICE(x); \
+  CHECK_DEVICE(y); \
+  CHECK_OUTPUT(name##_fw_into, y, x.shape()); \
+  CHECK_NOT_ALIASED(name##_fw_into, x, y); \
+  PROFILE( \
+      #name "_fw", x.shape().to_string(), \
+      2 * ::num_elements(x), 4 * ::num_elements(x)); \
+  name##_fw_impl(x, dim, y); \
+}
+
+#define DEV_BW_DIM(name) \
+void Device::name##_bw( \
+    const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, \
+    Tensor &gx) { \
+  CHECK_DEVICE(x); \
+  CHECK_DEVICE(y); \
+  CHECK_DEVICE(gy); \
+  CHECK_DEVICE(gx); \
+  if (x.shape() != gx.shape() || \
+      y.shape() != gy.shape() || \
+      y.shape() != x.shape()) { \
+    THROW_ERROR( \
+        "Shape mismatched at " #name "_bw" \
+        << ". x.shape: " << x.shape().to_string() \
+        << ", y.shape: " << y.shape().to_string() \
+        << ", gy.shape: " << gy.shape().to_string() \
+        << ", gx.shape: " << gx.shape().to_string()); \
+  } \
+  PROFILE( \
+      #name "_bw", x.shape().to_string(), \
+      2 * ::num_elements(y) + 2 * ::num_elements(gx), \
+      4 * ::num_elements(gx)); \
+  name##_bw_impl(x, y, gy, dim, gx); \
+}
+
+DEV_FW_DIM(softmax);
+DEV_FW_DIM(log_softmax);
+
+DEV_BW_DIM(softmax);
+DEV_BW_DIM(log_softmax);
+
+#undef DEV_FW_DIM
+#undef DEV_BW_DIM
+
+Tensor Device::sparse_softmax_cross_entropy_fw(
+    const Tensor &x, const vector<unsigned> &ids, unsigned dim, Tensor &lse) {
+  CHECK_DEVICE(x);
+  Tensor y = new_raw_tensor(shape_ops::pick(x.shape(), ids, dim));
+  lse = new_raw_tensor(x.shape().resize_dim(dim, 1));
+  PROFILE(
+      "sparse_softmax_cross_entropy_fw", x.shape().to_string(),
+      ::num_elements(x) + ::num_elements(lse) + ::num_elements(y),
+      3 * ::num_elements(x));
+  sparse_softmax_cross_entropy_fw_impl(x, ids, dim, lse, y);
+  return y;
+}
+
+void Device::sparse_softmax_cross_entropy_bw(
+    const Tensor &x, const Tensor &lse, const vector<unsigned> &ids,
+    const Tensor &gy, unsigned dim, Tensor &gx) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(lse);
+  CHECK_DEVICE(gy);
+  CHECK_DEVICE(gx);
+  if (x.shape() != gx.shape() ||
+      lse.shape() != x.shape().resize_dim(dim, 1) ||
+      gy.shape() != shape_ops::pick(x.shape(), ids, dim)) {
+    THROW_ERROR(
+        "Shape mismatched at sparse_softmax_cross_entropy_bw"
+        << ". x.shape: " << x.shape().to_string()
+        << ", lse.shape: " << lse.shape().to_string()
+        << ", gy.shape: " << gy.shape().to_string()
+        << ", gx.shape: " << gx.shape().to_string()
+        << ", ids.size(): " << ids.size());
+  }
+  PROFILE(
+      "sparse_softmax_cross_entropy_bw", x.shape().to_string(),
+      2 * ::num_elements(x) + ::num_elements(lse) + ::num_elements(gy)
+      + ::num_elements(gx), 4 * ::num_elements(x));
+  sparse_softmax_cross_entropy_bw_impl(x, lse, ids, gy, dim, gx);
+}
+
+Tensor Device::lstm_cell_fw(const Tensor &u, const Tensor &c, Tensor &gates) {
+  CHECK_DEVICE(u);
+  CHECK_DEVICE(c);
+  Tensor y = new_raw_tensor(shape_ops::lstm_cell(u.shape(), c.shape()));
+  gates = new_raw_tensor(u.shape());
+  lstm_cell_fw_into(u, c, gates, y);
+  return y;
+}
+
+void Device::lstm_cell_fw_into(
+    const Tensor &u, const Tensor &c, Tensor &gates, Tensor &y) {
+  CHECK_DEVICE(u);
+  CHECK_DEVICE(c);
+  CHECK_DEVICE(gates);
+  CHECK_DEVICE(y);
+  CHECK_OUTPUT(
+      lstm_cell_fw_into, y, shape_ops::lstm_cell(u.shape(), c.shape()));
+  CHECK_OUTPUT(lstm_cell_fw_into, gates, u.shape());
+  CHECK_NOT_ALIASED(lstm_cell_fw_into, u, gates);
+  CHECK_NOT_ALIASED(lstm_cell_fw_into, c, gates);
+  CHECK_NOT_ALIASED(lstm_cell_fw_into, u, y);
+  CHECK_NOT_ALIASED(lstm_cell_fw_into, c, y);
+  CHECK_NOT_ALIASED(lstm_cell_fw_into, gates, y);
+  PROFILE(
+      "lstm_cell_fw", u.shape().to_string() + ", " + c.shape().to_string(),
+      ::num_elements(u) + ::num_elements(c) + ::num_elements(gates)
+      + ::num_elements(y), 3 * ::num_elements(u));
+  lstm_cell_fw_impl(u, c, gates, y);
+}
+
+#undef CHECK_NOT_ALIASED
+#undef CHECK_OUTPUT
+
+void Device::lstm_cell_bw(
+    const Tensor &c, const Tensor &gates, const Tensor &y, const Tensor &gy,
+    Tensor &gu, Tensor &gc) {
+  CHECK_DEVICE(c);
+  CHECK_DEVICE(gates);
+  CHECK_DEVICE(y);
+  CHECK_DEVICE(gy);
+  CHECK_DEVICE(gu);
+  CHECK_DEVICE(gc);
+  if (gates.shape() != gu.shape() || c.shape() != gc.shape() ||
+      y.shape() != gy.shape() ||
+      y.shape() != shape_ops::lstm_cell(gates.shape(), c.shape())) {
+    THROW_ERROR(
+        "Shape mismatched at lstm_cell_bw"
+        << ". c.shape: " << c.shape().to_string()
+        << ", gates.shape: " << gates.shape().to_string()
+        << ", y.shape: " << y.shape().to_string()
+        << ", gy.shape: " << gy.shape().to_string()
+        << ", gu.shape: " << gu.shape().to_string()
+        << ", gc.shape: " << gc.shape().to_string());
+  }
+  PROFILE(
+      "lstm_cell_bw", gates.shape().to_string() + ", " + c.shape().to_string(),
+      ::num_elements(c) + ::num_elements(gates) + ::num_elements(y)
+      + ::num_elements(gy) + 2 * ::num_elements(gu) + 2 * ::num_elements(gc),
+      4 * ::num_elements(gu));
+  lstm_cell_bw_impl(c, gates, y, gy, gu, gc);
+}
+
 void Device::inplace_multiply_const(float k, Tensor &x) {
   CHECK_DEVICE(x);
+  PROFILE(
+      "inplace_multiply_const", x.shape().to_string(),
+      2 * ::num_elements(x), ::num_elements(x));
   inplace_multiply_const_impl(k, x);
 }
 
@@ -407,6 +1021,10 @@ void Device::inplace_add(const Tensor &x, Tensor &y) {
         "Attempted to add values of shape "
         << sx.to_string() << " to " << sy.to_string() << '.');
   }
+  PROFILE(
+      "inplace_add", sx.to_string() + ", " + sy.to_string(),
+      ::num_elements(x) + 2 * ::num_elements(y),
+      std::max(::num_elements(x), ::num_elements(y)));
   inplace_add_impl(x, y);
 }
 
@@ -420,7 +1038,160 @@ void Device::inplace_subtract(const Tensor &x, Tensor &y) {
         "Attempted to subtract values of shape "
         << sx.to_string() << " from " << sy.to_string() << '.');
   }
+  PROFILE(
+      "inplace_subtract", sx.to_string() + ", " + sy.to_string(),
+      ::num_elements(x) + 2 * ::num_elements(y),
+      std::max(::num_elements(x), ::num_elements(y)));
   inplace_subtract_impl(x, y);
 }
 
+void Device::inplace_matmul_add(const Tensor &a, const Tensor &b, Tensor &y) {
+  CHECK_DEVICE(a);
+  CHECK_DEVICE(b);
+  CHECK_DEVICE(y);
+  const Shape sy = shape_ops::matmul(a.shape(), b.shape());
+  if (y.shape() != sy) {
+    THROW_ERROR(
+        "Shape mismatched. y.shape(): " << y.shape().to_string()
+        << " != expected shape: " << sy.to_string());
+  }
+  PROFILE(
+      "inplace_matmul_add",
+      a.shape().to_string() + ", " + b.shape().to_string(),
+      ::num_elements(a) + ::num_elements(b) + 2 * ::num_elements(y),
+      2 * ::num_elements(y) * a.shape()[1]);
+  inplace_matmul_add_impl(a, b, y);
+}
+
+void Device::inplace_pick_assign(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(y);
+  const Shape sx = shape_ops::pick(y.shape(), ids, dim);
+  if (x.shape() != sx) {
+    THROW_ERROR(
+        "Shape mismatched. x.shape(): " << x.shape().to_string()
+        << " != expected shape: " << sx.to_string());
+  }
+  PROFILE(
+      "inplace_pick_assign", y.shape().to_string(),
+      2 * ::num_elements(x), 0);
+  inplace_pick_assign_impl(x, ids, dim, y);
+}
+
+void Device::inplace_pick_reset(
+    float k, const std::vector<unsigned> &ids, unsigned dim, Tensor &x) {
+  CHECK_DEVICE(x);
+  const Shape sy = shape_ops::pick(x.shape(), ids, dim);
+  PROFILE("inplace_pick_reset", x.shape().to_string(), sy.size(), 0);
+  inplace_pick_reset_impl(k, ids, dim, x);
+}
+
+float Device::squared_norm(const vector<const Tensor *> &xs) {
+  if (xs.empty()) return 0;
+  vector<const Shape *> shapes(xs.size());
+  std::uint64_t size = 0;
+  for (unsigned i = 0; i < xs.size(); ++i) {
+    CHECK_DEVICE(*xs[i]);
+    shapes[i] = &xs[i]->shape();
+    size += ::num_elements(*xs[i]);
+  }
+  PROFILE("squared_norm", ::shape_strings(shapes), size, 2 * size);
+  return squared_norm_impl(xs);
+}
+
+#define CHECK_SAME_SHAPE(x, y) \
+  if ((x).shape() != (y).shape()) { \
+    THROW_ERROR( \
+        "Shape mismatched. " #x ".shape(): " << (x).shape().to_string() \
+        << " != " #y ".shape(): " << (y).shape().to_string()); \
+  }
+
+void Device::sgd_update(float eta, const Tensor &g, Tensor &x) {
+  CHECK_DEVICE(g);
+  CHECK_DEVICE(x);
+  CHECK_SAME_SHAPE(g, x);
+  PROFILE(
+      "sgd_update", x.shape().to_string(),
+      3 * ::num_elements(x), 2 * ::num_elements(x));
+  sgd_update_impl(eta, g, x);
+}
+
+void Device::momentum_sgd_update(
+    float eta, float momentum, const Tensor &g, Tensor &m, Tensor &x) {
+  CHECK_DEVICE(g);
+  CHECK_DEVICE(m);
+  CHECK_DEVICE(x);
+  CHECK_SAME_SHAPE(g, x);
+  CHECK_SAME_SHAPE(m, x);
+  PROFILE(
+      "momentum_sgd_update", x.shape().to_string(),
+      5 * ::num_elements(x), 4 * ::num_elements(x));
+  momentum_sgd_update_impl(eta, momentum, g, m, x);
+}
+
+void Device::adagrad_update(
+    float eta, float eps, const Tensor &g, Tensor &m, Tensor &x) {
+  CHECK_DEVICE(g);
+  CHECK_DEVICE(m);
+  CHECK_DEVICE(x);
+  CHECK_SAME_SHAPE(g, x);
+  CHECK_SAME_SHAPE(m, x);
+  PROFILE(
+      "adagrad_update", x.shape().to_string(),
+      5 * ::num_elements(x), 7 * ::num_elements(x));
+  adagrad_update_impl(eta, eps, g, m, x);
+}
+
+void Device::rmsprop_update(
+    float eta, float alpha, float eps, const Tensor &g, Tensor &m, Tensor &x) {
+  CHECK_DEVICE(g);
+  CHECK_DEVICE(m);
+  CHECK_DEVICE(x);
+  CHECK_SAME_SHAPE(g, x);
+  CHECK_SAME_SHAPE(m, x);
+  PROFILE(
+      "rmsprop_update", x.shape().to_string(),
+      5 * ::num_elements(x), 9 * ::num_elements(x));
+  rmsprop_update_impl(eta, alpha, eps, g, m, x);
+}
+
+void Device::adadelta_update(
+    float scale, float rho, float eps, const Tensor &g,
+    Tensor &m1, Tensor &m2, Tensor &x) {
+  CHECK_DEVICE(g);
+  CHECK_DEVICE(m1);
+  CHECK_DEVICE(m2);
+  CHECK_DEVICE(x);
+  CHECK_SAME_SHAPE(g, x);
+  CHECK_SAME_SHAPE(m1, x);
+  CHECK_SAME_SHAPE(m2, x);
+  PROFILE(
+      "adadelta_update", x.shape().to_string(),
+      7 * ::num_elements(x), 16 * ::num_elements(x));
+  adadelta_update_impl(scale, rho, eps, g, m1, m2, x);
+}
+
+void Device::adam_update(
+    float alpha, float beta1, float beta2, float eps, unsigned step,
+    const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) {
+  CHECK_DEVICE(g);
+  CHECK_DEVICE(m1);
+  CHECK_DEVICE(m2);
+  CHECK_DEVICE(x);
+  CHECK_SAME_SHAPE(g, x);
+  CHECK_SAME_SHAPE(m1, x);
+  CHECK_SAME_SHAPE(m2, x);
+  if (step == 0) THROW_ERROR("Invalid step of the Adam update: " << step);
+  const float bias1 = 1 - std::pow(beta1, step);
+  const float bias2 = 1 - std::pow(beta2, step);
+  PROFILE(
+      "adam_update", x.shape().to_string(),
+      7 * ::num_elements(x), 14 * ::num_elements(x));
+  adam_update_impl(alpha, beta1, beta2, eps, bias1, bias2, g, m1, m2, x);
+}
+
+#undef CHECK_SAME_SHAPE
+
 }  // namespace primitiv
@@ -1,20 +1,32 @@
 #ifndef PRIMITIV_DEVICE_H_
 #define PRIMITIV_DEVICE_H_
 
+#include <atomic>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 #include <primitiv/mixins.h>
 #include <primitiv/shape.h>
 #include <primitiv/tensor.h>
 
 namespace primitiv {
 
+class Graph;
+class Trainer;
+
 /**
  * Interface of the Tensor provider.
  */
 class Device
     : public mixins::DefaultSettable<Device>
     , mixins::Nonmovable<Device> {
+  friend Graph;
   friend Tensor;
+  friend Trainer;
 
 public:
   /**
@@ -25,7 +37,19 @@ public:
     DEVICE_TYPE_CUDA = 0x10000,
   };
 
-  Device() = default;
+  /**
+   * Statistics of an operation measured by the profiler.
+   */
+  struct ProfileEntry {
+    std::string name;  // Name of the operation.
+    std::string shapes;  // Shapes of operands.
+    std::uint64_t count;  // Number of calls.
+    double total_time;  // Total elapsed time in seconds.
+    std::uint64_t bytes;  // Total number of bytes read or written.
+    std::uint64_t flops;  // Total number of floating point operations.
+  };
+
+  Device() : profiling_(false) {}
   virtual ~Device() = default;
 
   /**
@@ -39,7 +63,57 @@ public:
    */
   virtual DeviceType type() const = 0;
 
+  /**
+   * Enables or disables the profiler.
+   * @param enabled Whether the profiler is enabled or not.
+   * @remarks If enabled, every public operation of the device (and the memory
+   *          allocation) records its elapsed time, the number of bytes of its
+   *          operands and the estimated number of floating point operations,
+   *          for each combination of the operation and the shapes of its
+   *          operands.
+   *          Each operation waits for the completion of the previous
+   *          operations while profiling so that asynchronous devices report
+   *          actual elapsed time.
+   *          The profiler is disabled by default, and costs only one flag
+   *          check for each operation while disabled.
+   */
+  void set_profiling(bool enabled) { profiling_ = enabled; }
+
+  /**
+   * Retrieves whether the profiler is enabled or not.
+   * @return true if the profiler is enabled, false otherwise.
+   */
+  bool profiling() const { return profiling_; }
+
+  /**
+   * Retrieves the statistics recorded by the profiler.
+   * @return List of statistics in the descending order of `total_time`.
+   */
+  std::vector<ProfileEntry> get_profile() const;
+
+  /**
+   * Discards all statistics recorded by the profiler.
+   */
+  void reset_profile();
+
+  /**
+   * Prints the statistics recorded by the profiler to stderr.
+   */
+  void dump_profile() const;
+
 private:
+  /**
+   * Scoped timer which records the statistics of one operation.
+   */
+  class ProfileScope;
+
+  /**
+   * Waits for the completion of all operations issued to the device.
+   * @remarks The default implementation does nothing, and devices which
+   *          calculate asynchronously should override this function.
+   */
+  virtual void synchronize() {}
+
   /**
    * Provides a new Tensor object on the device.
    * @param shape Shape of the tensor.
@@ -47,6 +121,77 @@ private:
    */
   Tensor new_raw_tensor(const Shape &shape);
 
+  /**
+   * Provides a new Tensor object which shares a contiguous range of the
+   * memory of another tensor.
+   * @param x Tensor which holds the memory.
+   * @param shape Shape of the new tensor.
+   * @param offset Number of elements before the range.
+   * @return A new Tensor object.
+   * @remarks The whole memory of `x` is kept until the new tensor is disposed,
+   *          and `Tensor::data()` duplicates the memory before modifying it.
+   */
+  Tensor new_view(const Tensor &x, const Shape &shape, unsigned offset);
+
+  /**
+   * Reserves a contiguous range of the memory of another tensor for the next
+   * tensor allocated on the calling thread.
+   * @param x Tensor which holds the memory.
+   * @param offset Number of elements before the range.
+   * @param size Number of elements of the next tensor.
+   * @remarks The reservation is used only if the number of elements of the
+   *          next tensor is equal to `size`, and it is cancelled by
+   *          `cancel_reservation()`.
+   *          Each thread has at most one reservation.
+   *          The whole memory of `x` is kept until the next tensor is
+   *          disposed. Unlike `new_view()`, the next tensor counts its own
+   *          references and can be modified without the duplication.
+   */
+  void reserve_range(const Tensor &x, unsigned offset, unsigned size);
+
+  /**
+   * Cancels the reservation made by `reserve_range()`.
+   */
+  void cancel_reservation();
+
+  /**
+   * Checks whether the reservation made by `reserve_range()` is still
+   * available on the calling thread or not.
+   * @return true if the reservation is not yet used, false otherwise.
+   */
+  bool has_reservation() const;
+
+  /**
+   * Checks whether the tensor is the only object which refers its memory.
+   * @param x A valid tensor.
+   * @return true if no other tensors share the memory with `x`, false
+   *         otherwise.
+   */
+  static bool has_unique_memory(const Tensor &x);
+
+  /**
+   * Reserves the memory of the tensor for the next tensor allocated on the
+   * calling thread.
+   * @param x A tensor which is not modified until the next tensor is disposed.
+   * @return true if the memory is reserved, false if `x` shares the memory
+   *         with other objects or other memory is already reserved.
+   */
+  bool reserve_unique_handle(const Tensor &x);
+
+  /**
+   * Retrieves the total size of tensors allocated on the calling thread.
+   * @return Number of bytes of all tensors allocated by any device on the
+   *         calling thread since the thread started.
+   */
+  static std::uint64_t allocated_bytes();
+
+  /**
+   * Retrieves the memory for a new tensor.
+   * @param shape Shape of the tensor.
+   * @return The reserved memory if available, or a new memory otherwise.
+   */
+  std::shared_ptr<void> get_handle(const Shape &shape);
+
 public:
   /**
    * Provides a new Tensor object with same-value elements.
@@ -83,6 +228,35 @@ public:
    */
   Tensor copy_tensor(const Tensor &x);
 
+  /**
+   * Calculates a new tensor with reusing the memory of a temporary tensor.
+   * @param x A temporary tensor which is not used after this function.
+   * @param op Function object without arguments which calculates the new
+   *           tensor. `op` may read `x`.
+   * @return The result of `op()`.
+   * @remarks The memory of `x` is moved to the result if `x` uniquely holds
+   *          the memory, the result has the same number of elements as `x`,
+   *          and no other memory is reserved on the calling thread.
+   *          In this case `x` becomes invalid after this function.
+   *          `op` should allocate only the result, and each element of the
+   *          result should depend only on the same element of `x`.
+   */
+  template<typename Op>
+  Tensor reuse_tensor(Tensor &x, Op op) {
+    if (!reserve_unique_handle(x)) return op();
+    try {
+      Tensor y = op();
+      // The reservation is used by `y`, which becomes the only owner of the
+      // memory.
+      if (!has_reservation()) x = Tensor();
+      cancel_reservation();
+      return y;
+    } catch (...) {
+      cancel_reservation();
+      throw;
+    }
+  }
+
   // Provides an identity matrix.
   Tensor identity(unsigned size);
 
@@ -92,11 +266,25 @@ public:
   Tensor random_normal(const Shape &shape, float mean, float sd);
   Tensor random_log_normal(const Shape &shape, float mean, float sd);
 
+  // Functions with the suffix `_into` write the results into the existing
+  // tensor `y` instead of allocating new tensors. `y` should have the same
+  // shape as the result of the corresponding function, and should uniquely
+  // hold its memory to avoid the duplication by `Tensor::data()`.
+  // `y` can be an argument of elementwise operations.
+  void random_bernoulli_into(float p, Tensor &y);
+  void random_uniform_into(float lower, float upper, Tensor &y);
+  void random_normal_into(float mean, float sd, Tensor &y);
+  void random_log_normal_into(float mean, float sd, Tensor &y);
+
   // Tensor manipulations.
   Tensor pick_fw(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim);
   Tensor slice_fw(const Tensor &x, unsigned dim, unsigned lower, unsigned upper);
   Tensor concat_fw(const std::vector<const Tensor *> &xs, unsigned dim);
 
+  void pick_fw_into(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y);
+  void slice_fw_into(const Tensor &x, unsigned dim, unsigned lower, unsigned upper, Tensor &y);
+  void concat_fw_into(const std::vector<const Tensor *> &xs, unsigned dim, Tensor &y);
+
   void pick_bw(const Tensor &gy, const std::vector<unsigned> &ids, unsigned dim, Tensor &gx);
   void slice_bw(const Tensor &gy, unsigned dim, unsigned offset, Tensor &gx);
 
@@ -113,6 +301,18 @@ public:
   Tensor tan_fw(const Tensor &x);
   Tensor transpose_fw(const Tensor &x);
 
+  void negate_fw_into(const Tensor &x, Tensor &y);
+  void sqrt_fw_into(const Tensor &x, Tensor &y);
+  void exp_fw_into(const Tensor &x, Tensor &y);
+  void log_fw_into(const Tensor &x, Tensor &y);
+  void tanh_fw_into(const Tensor &x, Tensor &y);
+  void sigmoid_fw_into(const Tensor &x, Tensor &y);
+  void softplus_fw_into(const Tensor &x, Tensor &y);
+  void sin_fw_into(const Tensor &x, Tensor &y);
+  void cos_fw_into(const Tensor &x, Tensor &y);
+  void tan_fw_into(const Tensor &x, Tensor &y);
+  void transpose_fw_into(const Tensor &x, Tensor &y);
+
   void sqrt_bw(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx);
   void exp_bw(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx);
   void log_bw(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx);
@@ -134,6 +334,15 @@ public:
   Tensor prelu_fw(const Tensor &x, float k);
   Tensor elu_fw(const Tensor &x, float k);
 
+  void add_const_fw_into(const Tensor &x, float k, Tensor &y);
+  void subtract_const_r_fw_into(const Tensor &x, float k, Tensor &y);
+  void subtract_const_l_fw_into(const Tensor &x, float k, Tensor &y);
+  void multiply_const_fw_into(const Tensor &x, float k, Tensor &y);
+  void divide_const_r_fw_into(const Tensor &x, float k, Tensor &y);
+  void divide_const_l_fw_into(const Tensor &x, float k, Tensor &y);
+  void prelu_fw_into(const Tensor &x, float k, Tensor &y);
+  void elu_fw_into(const Tensor &x, float k, Tensor &y);
+
   void add_const_bw(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx);
   void subtract_const_r_bw(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx);
   void subtract_const_l_bw(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx);
@@ -151,6 +360,13 @@ public:
   Tensor divide_scalar_r_fw(const Tensor &x, const Tensor &k);
   Tensor divide_scalar_l_fw(const Tensor &x, const Tensor &k);
 
+  void add_scalar_fw_into(const Tensor &x, const Tensor &k, Tensor &y);
+  void subtract_scalar_r_fw_into(const Tensor &x, const Tensor &k, Tensor &y);
+  void subtract_scalar_l_fw_into(const Tensor &x, const Tensor &k, Tensor &y);
+  void multiply_scalar_fw_into(const Tensor &x, const Tensor &k, Tensor &y);
+  void divide_scalar_r_fw_into(const Tensor &x, const Tensor &k, Tensor &y);
+  void divide_scalar_l_fw_into(const Tensor &x, const Tensor &k, Tensor &y);
+
   // Binary operations.
   Tensor add_fw(const Tensor &a, const Tensor &b);
   Tensor subtract_fw(const Tensor &a, const Tensor &b);
@@ -158,6 +374,12 @@ public:
   Tensor divide_fw(const Tensor &a, const Tensor &b);
   Tensor matmul_fw(const Tensor &a, const Tensor &b);
 
+  void add_fw_into(const Tensor &a, const Tensor &b, Tensor &y);
+  void subtract_fw_into(const Tensor &a, const Tensor &b, Tensor &y);
+  void multiply_fw_into(const Tensor &a, const Tensor &b, Tensor &y);
+  void divide_fw_into(const Tensor &a, const Tensor &b, Tensor &y);
+  void matmul_fw_into(const Tensor &a, const Tensor &b, Tensor &y);
+
   void add_bw(
       const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy,
       Tensor &ga, Tensor &gb);
@@ -180,6 +402,107 @@ public:
   Tensor broadcast_fw(const Tensor &x, unsigned dim, unsigned size);
   Tensor batch_sum_fw(const Tensor &x);
 
+  void sum_fw_into(const Tensor &x, unsigned dim, Tensor &y);
+  void logsumexp_fw_into(const Tensor &x, unsigned dim, Tensor &y);
+  void broadcast_fw_into(const Tensor &x, unsigned dim, unsigned size, Tensor &y);
+
+  /**
+   * Arranges minibatches of the tensor as columns of a matrix.
+   * @param x Input tensor.
+   * @return A matrix whose `i`-th column is the flattened `i`-th minibatch
+   *         of `x`.
+   * @remarks The result shares the memory of `x` because both tensors have
+   *          the same memory layout.
+   */
+  Tensor batch_to_columns_fw(const Tensor &x);
+
+  /**
+   * Calculates the gradient of `batch_to_columns_fw`.
+   * @param gy Gradient of the result.
+   * @param gx Gradient tensor of `x` to be updated.
+   */
+  void batch_to_columns_bw(const Tensor &gy, Tensor &gx);
+
+  // Normalizing operations along a dimension.
+  Tensor softmax_fw(const Tensor &x, unsigned dim);
+  Tensor log_softmax_fw(const Tensor &x, unsigned dim);
+
+  void softmax_fw_into(const Tensor &x, unsigned dim, Tensor &y);
+  void log_softmax_fw_into(const Tensor &x, unsigned dim, Tensor &y);
+
+  void softmax_bw(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx);
+  void log_softmax_bw(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx);
+
+  /**
+   * Calculates the softmax cross entropy with integer labels.
+   * @param x Input tensor.
+   * @param ids List of label IDs.
+   * @param dim Dimension of the softmax.
+   * @param lse Output tensor to store `logsumexp(x, dim)`, which is required
+   *            by `sparse_softmax_cross_entropy_bw`.
+   * @return `pick(-log_softmax(x, dim), ids, dim)`.
+   * @remarks This function does not allocate any temporary tensors with the
+   *          same size as `x`.
+   */
+  Tensor sparse_softmax_cross_entropy_fw(
+      const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+      Tensor &lse);
+
+  /**
+   * Calculates the gradient of the softmax cross entropy with integer labels.
+   * @param x Input tensor of the forward calculation.
+   * @param lse `logsumexp(x, dim)` calculated by
+   *            `sparse_softmax_cross_entropy_fw`.
+   * @param ids List of label IDs.
+   * @param gy Gradient of the loss.
+   * @param dim Dimension of the softmax.
+   * @param gx Gradient tensor of `x` to be updated by
+   *           `gy * (softmax(x, dim) - onehot(ids))`.
+   */
+  void sparse_softmax_cross_entropy_bw(
+      const Tensor &x, const Tensor &lse, const std::vector<unsigned> &ids,
+      const Tensor &gy, unsigned dim, Tensor &gx);
+
+  /**
+   * Calculates the LSTM cell from the gate pre-activations.
+   * @param u Pre-activations of the input, forget, output gates and the
+   *          candidate value, stacked along the first dimension.
+   * @param c Previous cell state.
+   * @param gates Output tensor to store the activated gates, which is required
+   *              by `lstm_cell_bw`.
+   * @return The new output and cell state, stacked along the first dimension.
+   * @remarks All gates and states are calculated in a single pass without
+   *          allocating any other temporary tensors.
+   */
+  Tensor lstm_cell_fw(const Tensor &u, const Tensor &c, Tensor &gates);
+
+  /**
+   * Calculates the LSTM cell into existing tensors.
+   * @param u Pre-activations of the gates.
+   * @param c Previous cell state.
+   * @param gates Tensor to store the activated gates, with the same shape as
+   *              `u`.
+   * @param y Tensor to store the new output and cell state, with the same
+   *          shape as the result of `lstm_cell_fw`.
+   * @throw primitiv::Error Shapes are mismatched, or `gates` or `y` is one
+   *                        of the arguments.
+   */
+  void lstm_cell_fw_into(
+      const Tensor &u, const Tensor &c, Tensor &gates, Tensor &y);
+
+  /**
+   * Calculates the gradients of the LSTM cell.
+   * @param c Previous cell state.
+   * @param gates Activated gates calculated by `lstm_cell_fw`.
+   * @param y Output of `lstm_cell_fw`.
+   * @param gy Gradient of `y`.
+   * @param gu Gradient tensor of the pre-activations to be updated.
+   * @param gc Gradient tensor of the previous cell state to be updated.
+   */
+  void lstm_cell_bw(
+      const Tensor &c, const Tensor &gates, const Tensor &y, const Tensor &gy,
+      Tensor &gu, Tensor &gc);
+
   /**
    * Directly multiplies all elements by a constant.
    * @param k A constant to multiply.
@@ -209,6 +532,148 @@ public:
    */
   void inplace_subtract(const Tensor &x, Tensor &y);
 
+  /**
+   * Directly adds the matrix product to the third tensor.
+   * @param a Left-hand side of the product.
+   * @param b Right-hand side of the product.
+   * @param y A tensor to be updated. `y.shape()` should be equal to
+   *          `matmul(a, b).shape()`.
+   * @remarks This method calculates `y += matmul(a, b)` by one accumulating
+   *          matrix product without any temporary tensors.
+   */
+  void inplace_matmul_add(const Tensor &a, const Tensor &b, Tensor &y);
+
+  /**
+   * Directly overwrites the picked columns of the second tensor.
+   * @param x Values of the columns. `x.shape()` should be equal to
+   *          `pick(y, ids, dim).shape()`.
+   * @param ids List of indices to overwrite.
+   * @param dim Dimension of the columns.
+   * @param y A tensor to be updated.
+   * @remarks This method calculates `pick(y, ids, dim) = x` without any
+   *          temporary tensors. If `ids` has duplicated indices, the column
+   *          is overwritten by one of the corresponding values.
+   */
+  void inplace_pick_assign(
+      const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+      Tensor &y);
+
+  /**
+   * Directly sets a constant to the picked columns.
+   * @param k A constant to set.
+   * @param ids List of indices to set.
+   * @param dim Dimension of the columns.
+   * @param x A tensor to be updated.
+   */
+  void inplace_pick_reset(
+      float k, const std::vector<unsigned> &ids, unsigned dim, Tensor &x);
+
+  /**
+   * Calculates the sum of squares of all elements in given tensors.
+   * @param xs List of tensors.
+   * @return Sum of `sum(x * x)` over all `x` in `xs`, or 0 if `xs` is empty.
+   * @remarks This function accumulates all values on the device without
+   *          allocating any temporary tensors, and transfers only the resulting
+   *          value to the host.
+   */
+  float squared_norm(const std::vector<const Tensor *> &xs);
+
+  /**
+   * Updates the parameter by the SGD rule.
+   * @param eta Learning rate.
+   * @param g Gradient of the parameter.
+   * @param x Parameter to be updated.
+   * @remarks This function calculates: `x -= eta * g`.
+   *          Every optimizer update (`*_update()`) updates all tensors in one
+   *          pass without allocating any temporary tensors, and all tensors
+   *          should have the same shape.
+   */
+  void sgd_update(float eta, const Tensor &g, Tensor &x);
+
+  /**
+   * Updates the parameter by the momentum SGD rule.
+   * @param eta Learning rate.
+   * @param momentum Decay factor of the momentum.
+   * @param g Gradient of the parameter.
+   * @param m Momentum to be updated.
+   * @param x Parameter to be updated.
+   * @remarks This function calculates:
+   *            m = momentum * m - eta * g
+   *            x += m
+   */
+  void momentum_sgd_update(
+      float eta, float momentum, const Tensor &g, Tensor &m, Tensor &x);
+
+  /**
+   * Updates the parameter by the AdaGrad rule.
+   * @param eta Learning rate.
+   * @param eps Bias of the denominator.
+   * @param g Gradient of the parameter.
+   * @param m Sum of squared gradients to be updated.
+   * @param x Parameter to be updated.
+   * @remarks This function calculates:
+   *            m += g * g
+   *            x -= eta * g / (sqrt(m) + eps)
+   */
+  void adagrad_update(
+      float eta, float eps, const Tensor &g, Tensor &m, Tensor &x);
+
+  /**
+   * Updates the parameter by the RMSProp rule.
+   * @param eta Learning rate.
+   * @param alpha Decay factor of the moment.
+   * @param eps Bias of the denominator.
+   * @param g Gradient of the parameter.
+   * @param m Moment of squared gradients to be updated.
+   * @param x Parameter to be updated.
+   * @remarks This function calculates:
+   *            m = alpha * m + (1 - alpha) * g * g
+   *            x -= eta * g / (sqrt(m) + eps)
+   */
+  void rmsprop_update(
+      float eta, float alpha, float eps, const Tensor &g, Tensor &m, Tensor &x);
+
+  /**
+   * Updates the parameter by the AdaDelta rule.
+   * @param scale Scaling factor of the update.
+   * @param rho Decay factor of moments.
+   * @param eps Bias of the square roots.
+   * @param g Gradient of the parameter.
+   * @param m1 Moment of squared updates to be updated.
+   * @param m2 Moment of squared gradients to be updated.
+   * @param x Parameter to be updated.
+   * @remarks This function calculates:
+   *            m2 = rho * m2 + (1 - rho) * g * g
+   *            d = sqrt((m1 + eps) / (m2 + eps)) * g
+   *            m1 = rho * m1 + (1 - rho) * d * d
+   *            x -= scale * d
+   */
+  void adadelta_update(
+      float scale, float rho, float eps, const Tensor &g,
+      Tensor &m1, Tensor &m2, Tensor &x);
+
+  /**
+   * Updates the parameter by the Adam rule.
+   * @param alpha Learning rate.
+   * @param beta1 Decay factor of the first moment.
+   * @param beta2 Decay factor of the second moment.
+   * @param eps Bias of the denominator.
+   * @param step Number of updates including this update.
+   * @param g Gradient of the parameter.
+   * @param m1 First moment to be updated.
+   * @param m2 Second moment to be updated.
+   * @param x Parameter to be updated.
+   * @throw primitiv::Error `step` is 0.
+   * @remarks This function calculates:
+   *            m1 = beta1 * m1 + (1 - beta1) * g
+   *            m2 = beta2 * m2 + (1 - beta2) * g * g
+   *            x -= alpha * (m1 / (1 - beta1^step))
+   *                 / (sqrt(m2 / (1 - beta2^step)) + eps)
+   */
+  void adam_update(
+      float alpha, float beta1, float beta2, float eps, unsigned step,
+      const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x);
+
 private:
   /**
    * Retrieves internal values of the tensor as a vector.
@@ -366,10 +831,39 @@ private:
   virtual void broadcast_fw_impl(const Tensor &x, unsigned dim, unsigned size, Tensor &y) = 0;
   virtual void batch_sum_fw_impl(const Tensor &x, Tensor &y) = 0;
 
+  virtual void softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) = 0;
+  virtual void log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) = 0;
+
+  virtual void softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) = 0;
+  virtual void log_softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) = 0;
+
+  virtual void sparse_softmax_cross_entropy_fw_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &lse, Tensor &y) = 0;
+  virtual void sparse_softmax_cross_entropy_bw_impl(const Tensor &x, const Tensor &lse, const std::vector<unsigned> &ids, const Tensor &gy, unsigned dim, Tensor &gx) = 0;
+
+  virtual void lstm_cell_fw_impl(const Tensor &u, const Tensor &c, Tensor &gates, Tensor &y) = 0;
+  virtual void lstm_cell_bw_impl(const Tensor &c, const Tensor &gates, const Tensor &y, const Tensor &gy, Tensor &gu, Tensor &gc) = 0;
+
   virtual void inplace_multiply_const_impl(float k, Tensor &x) = 0;
 
   virtual void inplace_add_impl(const Tensor &x, Tensor &y) = 0;
   virtual void inplace_subtract_impl(const Tensor &x, Tensor &y) = 0;
+  virtual void inplace_matmul_add_impl(const Tensor &a, const Tensor &b, Tensor &y) = 0;
+  virtual void inplace_pick_assign_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) = 0;
+  virtual void inplace_pick_reset_impl(float k, const std::vector<unsigned> &ids, unsigned dim, Tensor &x) = 0;
+
+  virtual float squared_norm_impl(const std::vector<const Tensor *> &xs) = 0;
+
+  virtual void sgd_update_impl(float eta, const Tensor &g, Tensor &x) = 0;
+  virtual void momentum_sgd_update_impl(float eta, float momentum, const Tensor &g, Tensor &m, Tensor &x) = 0;
+  virtual void adagrad_update_impl(float eta, float eps, const Tensor &g, Tensor &m, Tensor &x) = 0;
+  virtual void rmsprop_update_impl(float eta, float alpha, float eps, const Tensor &g, Tensor &m, Tensor &x) = 0;
+  virtual void adadelta_update_impl(float scale, float rho, float eps, const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) = 0;
+  virtual void adam_update_impl(float alpha, float beta1, float beta2, float eps, float bias1, float bias2, const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) = 0;
+
+private:
+  std::atomic<bool> profiling_;
+  std::map<std::pair<std::string, std::string>, ProfileEntry> profile_;
+  mutable std::mutex profile_mutex_;
 };
 
 }  // namespace primitiv
@@ -0,0 +1,958 @@
+#include <config.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <Eigen/Eigen>
+#include <primitiv/eigen_device.h>
+#include <primitiv/error.h>
+
+using std::cerr;
+using std::endl;
+
+namespace {
+
+// The class name `primitiv::devices::Eigen` hides the namespace `::Eigen` in
+// the following implementations.
+using EArrayMap = ::Eigen::Map<::Eigen::ArrayXf>;
+using EConstArrayMap = ::Eigen::Map<const ::Eigen::ArrayXf>;
+using EMatrixMap = ::Eigen::Map<::Eigen::MatrixXf>;
+using EConstMatrixMap = ::Eigen::Map<const ::Eigen::MatrixXf>;
+
+}  // namespace
+
+namespace primitiv {
+namespace devices {
+
+void Eigen::dump_description() const {
+  cerr << "Device " << this << ':' << endl;
+  cerr << "  Type: Eigen" << endl;
+}
+
+std::shared_ptr<void> Eigen::new_handle(const Shape &shape) {
+  return mem_pool_.allocate(sizeof(float) * shape.size());
+}
+
+#define DATA(x) static_cast<float *>((x).data())
+#define CDATA(x) static_cast<const float *>((x).data())
+
+#define EMAP(x) EArrayMap(DATA(x), (x).shape().size())
+#define ECMAP(x) EConstArrayMap(CDATA(x), (x).shape().size())
+
+std::vector<float> Eigen::tensor_to_vector_impl(const Tensor &x) {
+  const unsigned num_elements = x.shape().size();
+  std::vector<float> ret(num_elements);
+  std::memcpy(&ret[0], x.data(), sizeof(float) * num_elements);
+  return ret;
+}
+
+std::vector<unsigned> Eigen::argmax_impl(const Tensor &x, unsigned dim) {
+  const Shape &s = x.shape();
+  const unsigned n = s[dim];
+  const unsigned repeat = s.size() / n;
+  const unsigned skip1 = s.lower_volume(dim);
+  const unsigned skip2 = skip1 * n;
+  const float *src = CDATA(x);
+  std::vector<unsigned> ret;
+  ret.reserve(repeat);
+  for (unsigned i = 0; i < repeat; ++i) {
+    unsigned offset = i % skip1 + (i / skip1) * skip2;
+    float max_val = src[offset];
+    unsigned argmax_val = 0;
+    for (unsigned j = 1; j < n; ++j) {
+      offset += skip1;
+      if (src[offset] > max_val) {
+        max_val = src[offset];
+        argmax_val = j;
+      }
+    }
+    ret.emplace_back(argmax_val);
+  }
+  return ret;
+}
+
+std::vector<unsigned> Eigen::argmin_impl(const Tensor &x, unsigned dim) {
+  const Shape &s = x.shape();
+  const unsigned n = s[dim];
+  const unsigned repeat = s.size() / n;
+  const unsigned skip1 = s.lower_volume(dim);
+  const unsigned skip2 = skip1 * n;
+  const float *src = CDATA(x);
+  std::vector<unsigned> ret;
+  ret.reserve(repeat);
+  for (unsigned i = 0; i < repeat; ++i) {
+    unsigned offset = i % skip1 + (i / skip1) * skip2;
+    float min_val = src[offset];
+    unsigned argmin_val = 0;
+    for (unsigned j = 1; j < n; ++j) {
+      offset += skip1;
+      if (src[offset] < min_val) {
+        min_val = src[offset];
+        argmin_val = j;
+      }
+    }
+    ret.emplace_back(argmin_val);
+  }
+  return ret;
+}
+
+void Eigen::reset_tensor_impl(float k, Tensor &x) {
+  EMAP(x).setConstant(k);
+}
+
+void Eigen::reset_tensor_by_array_impl(const float values[], Tensor &x) {
+  std::memcpy(x.data(), values, sizeof(float) * x.shape().size());
+}
+
+void Eigen::copy_tensor_impl(const Tensor &x, Tensor &y) {
+  switch (x.device().type()) {
+    case Device::DEVICE_TYPE_CPU:
+      reset_tensor_by_array(CDATA(x), y);
+      break;
+    default:
+      reset_tensor_by_vector(x.to_vector(), y);
+  }
+}
+
+void Eigen::identity_impl(Tensor &y) {
+  const unsigned size = y.shape()[0];
+  EMatrixMap(DATA(y), size, size).setIdentity();
+}
+
+void Eigen::random_bernoulli_impl(float p, Tensor &y) {
+  std::bernoulli_distribution dist(p);
+  std::lock_guard<std::mutex> lock(rng_mutex_);
+  float *dest = DATA(y);
+  const unsigned size = y.shape().size();
+  for (unsigned i = 0; i < size; ++i) {
+    dest[i] = dist(rng_);
+  }
+}
+
+void Eigen::random_uniform_impl(float lower, float upper, Tensor &y) {
+  std::uniform_real_distribution<float> dist(lower, upper);
+  std::lock_guard<std::mutex> lock(rng_mutex_);
+  float *dest = DATA(y);
+  const unsigned size = y.shape().size();
+  for (unsigned i = 0; i < size; ++i) {
+    const float x = dist(rng_);
+    dest[i] = x == lower ? upper : x;
+  }
+}
+
+void Eigen::random_normal_impl(float mean, float sd, Tensor &y) {
+  std::normal_distribution<float> dist(mean, sd);
+  std::lock_guard<std::mutex> lock(rng_mutex_);
+  float *dest = DATA(y);
+  const unsigned size = y.shape().size();
+  for (unsigned i = 0; i < size; ++i) {
+    dest[i] = dist(rng_);
+  }
+}
+
+void Eigen::random_log_normal_impl(float mean, float sd, Tensor &y) {
+  std::lognormal_distribution<float> dist(mean, sd);
+  std::lock_guard<std::mutex> lock(rng_mutex_);
+  float *dest = DATA(y);
+  const unsigned size = y.shape().size();
+  for (unsigned i = 0; i < size; ++i) {
+    dest[i] = dist(rng_);
+  }
+}
+
+void Eigen::pick_fw_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  const unsigned bs = y.shape().batch();
+  const unsigned skip_x = x.shape().has_batch() * x.shape().volume();
+  const unsigned skip_i = ids.size() > 1;
+  const unsigned base = y.shape().lower_volume(dim);
+  const unsigned skip = base * x.shape()[dim];
+  const unsigned repeat = y.shape().volume() / base;
+
+  float *dest = DATA(y);
+  for (unsigned batch = 0; batch < bs; ++batch) {
+    const float *src = CDATA(x) + batch * skip_x + base * ids[batch * skip_i];
+    ::Eigen::Map<::Eigen::MatrixXf>(dest, base, repeat)
+      = ::Eigen::Map<const ::Eigen::MatrixXf, 0, ::Eigen::OuterStride<>>(
+          src, base, repeat, ::Eigen::OuterStride<>(skip));
+    dest += base * repeat;
+  }
+}
+
+void Eigen::slice_fw_impl(
+    const Tensor &x, unsigned dim, unsigned offset, Tensor &y) {
+  const unsigned base = y.shape().lower_volume(dim);
+  const unsigned span = base * y.shape()[dim];
+  const unsigned skip = base * x.shape()[dim];
+  const unsigned repeat = y.shape().size() / span;
+
+  EMatrixMap(DATA(y), span, repeat)
+    = ::Eigen::Map<const ::Eigen::MatrixXf, 0, ::Eigen::OuterStride<>>(
+        CDATA(x) + base * offset, span, repeat, ::Eigen::OuterStride<>(skip));
+}
+
+void Eigen::concat_fw_impl(
+    const std::vector<const Tensor *> &xs, unsigned dim, Tensor &y) {
+  const unsigned new_bs = y.shape().batch();
+  const unsigned base = y.shape().lower_volume(dim);
+  const unsigned skip = base * y.shape()[dim];
+  const unsigned repeat = y.shape().volume() / skip;
+
+  unsigned offset = 0;
+  for (const Tensor *x : xs) {
+    const unsigned span = base * x->shape()[dim];
+    const unsigned b_skip = x->shape().has_batch() * span * repeat;
+    float *dest = DATA(y) + offset;
+    const float *src = CDATA(*x);
+    for (unsigned batch = 0; batch < new_bs; ++batch) {
+      ::Eigen::Map<::Eigen::MatrixXf, 0, ::Eigen::OuterStride<>>(
+          dest, span, repeat, ::Eigen::OuterStride<>(skip))
+        = EConstMatrixMap(src, span, repeat);
+      dest += skip * repeat;
+      src += b_skip;
+    }
+    offset += span;
+  }
+}
+
+void Eigen::pick_bw_impl(
+    const Tensor &gy, const std::vector<unsigned>& ids, unsigned dim,
+    Tensor &gx) {
+  const unsigned bs = gy.shape().batch();
+  const unsigned skip_x = gx.shape().has_batch() * gx.shape().volume();
+  const unsigned skip_i = ids.size() > 1;
+  const unsigned base = gy.shape().lower_volume(dim);
+  const unsigned skip = base * gx.shape()[dim];
+  const unsigned repeat = gy.shape().volume() / base;
+  const float *src = CDATA(gy);
+  for (unsigned batch = 0; batch < bs; ++batch) {
+    float *dest = DATA(gx) + batch * skip_x + base * ids[batch * skip_i];
+    ::Eigen::Map<::Eigen::MatrixXf, 0, ::Eigen::OuterStride<>>(
+        dest, base, repeat, ::Eigen::OuterStride<>(skip))
+      += EConstMatrixMap(src, base, repeat);
+    src += base * repeat;
+  }
+}
+
+void Eigen::slice_bw_impl(
+    const Tensor &gy, unsigned dim, unsigned offset, Tensor &gx) {
+  const Shape &sy = gy.shape();
+  const Shape &sx = gx.shape();
+  const unsigned base = sx.lower_volume(dim);
+  const unsigned span = base * sy[dim];
+  const unsigned skip = base * sx[dim];
+  const unsigned repeat = sx.volume() / skip;
+  const unsigned bs = std::max(sx.batch(), sy.batch());
+  const unsigned b_skip_d = sx.has_batch() * sx.volume();
+  const unsigned b_skip_s = sy.has_batch() * sy.volume();
+  float *dest = DATA(gx) + base * offset;
+  const float *src = CDATA(gy);
+  for (unsigned batch = 0; batch < bs; ++batch) {
+    ::Eigen::Map<::Eigen::MatrixXf, 0, ::Eigen::OuterStride<>>(
+        dest, span, repeat, ::Eigen::OuterStride<>(skip))
+      += EConstMatrixMap(src, span, repeat);
+    dest += b_skip_d;
+    src += b_skip_s;
+  }
+}
+
+#define EIGDEV_FW_X(name, op) \
+void Eigen::name##_fw_impl(const Tensor &x, Tensor &y) { \
+  const EConstArrayMap src = ECMAP(x); \
+  EArrayMap dest = EMAP(y); \
+  dest = (op); \
+}
+
+#define EIGDEV_BW_X(name, op) \
+void Eigen::name##_bw_impl( \
+    const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) { \
+  const EConstArrayMap px = ECMAP(x); static_cast<void>(px); \
+  const EConstArrayMap py = ECMAP(y); static_cast<void>(py); \
+  const EConstArrayMap pgy = ECMAP(gy); \
+  EArrayMap pgx = EMAP(gx); \
+  pgx += (op); \
+}
+
+#define EIGDEV_FW_X_CONST(name, op) \
+void Eigen::name##_fw_impl(const Tensor &x, float k, Tensor &y) { \
+  const EConstArrayMap src = ECMAP(x); \
+  EArrayMap dest = EMAP(y); \
+  dest = (op); \
+}
+
+#define EIGDEV_BW_X_CONST(name, op) \
+void Eigen::name##_bw_impl( \
+    const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx) { \
+  const EConstArrayMap px = ECMAP(x); static_cast<void>(px); \
+  const EConstArrayMap py = ECMAP(y); static_cast<void>(py); \
+  const EConstArrayMap pgy = ECMAP(gy); \
+  EArrayMap pgx = EMAP(gx); \
+  pgx += (op); \
+}
+
+#define EIGDEV_FW_X_SCALAR(name, op) \
+void Eigen::name##_fw_impl(const Tensor &x, const Tensor &k, Tensor &y) { \
+  const unsigned size = y.shape().volume(); \
+  const unsigned bs = y.shape().batch(); \
+  const unsigned skip_x = x.shape().has_batch() * size; \
+  const unsigned skip_k = k.shape().has_batch(); \
+  float *dest = DATA(y); \
+  const float *src_x = CDATA(x); \
+  const float *src_k = CDATA(k); \
+  for (unsigned batch = 0; batch < bs; ++batch) { \
+    const EConstArrayMap src(src_x, size); \
+    const float kk = *src_k; \
+    EArrayMap(dest, size) = (op); \
+    dest += size; \
+    src_x += skip_x; \
+    src_k += skip_k; \
+  } \
+}
+
+#define EIGDEV_FW_AB(name, op) \
+void Eigen::name##_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) { \
+  const unsigned size = y.shape().volume(); \
+  const unsigned bs = y.shape().batch(); \
+  const unsigned skip_a = a.shape().has_batch() * size; \
+  const unsigned skip_b = b.shape().has_batch() * size; \
+  float *dest = DATA(y); \
+  const float *src_a = CDATA(a); \
+  const float *src_b = CDATA(b); \
+  for (unsigned batch = 0; batch < bs; ++batch) { \
+    const EConstArrayMap pa(src_a, size); \
+    const EConstArrayMap pb(src_b, size); \
+    EArrayMap(dest, size) = (op); \
+    dest += size; \
+    src_a += skip_a; \
+    src_b += skip_b; \
+  } \
+}
+
+EIGDEV_FW_X(negate, -src);
+EIGDEV_FW_X(sqrt, src.sqrt());
+EIGDEV_FW_X(exp, src.exp());
+EIGDEV_FW_X(log, src.log());
+EIGDEV_FW_X(tanh, src.tanh());
+// sigmoid is calculated with double precision because `sigmoid_bw` amplifies
+// the rounding error of `y` through `1 - y`.
+EIGDEV_FW_X(
+    sigmoid, (1. / (1. + (-src.cast<double>()).exp())).cast<float>());
+EIGDEV_FW_X(
+    softplus, (src > 0).select(
+      src + (1.f + (-src).exp()).log(),
+      (1.f + src.exp()).log()));
+EIGDEV_FW_X(sin, src.sin());
+EIGDEV_FW_X(cos, src.cos());
+EIGDEV_FW_X(tan, src.tan());
+
+EIGDEV_BW_X(sqrt, .5f * pgy / py);
+EIGDEV_BW_X(exp, py * pgy);
+EIGDEV_BW_X(log, pgy / px);
+EIGDEV_BW_X(tanh, (1.f - py * py) * pgy);
+EIGDEV_BW_X(sigmoid, py * (1.f - py) * pgy);
+EIGDEV_BW_X(softplus, pgy / (1.f + (-px).exp()));
+EIGDEV_BW_X(sin, px.cos() * pgy);
+EIGDEV_BW_X(cos, -px.sin() * pgy);
+EIGDEV_BW_X(tan, (1.f + py * py) * pgy);
+
+EIGDEV_FW_X_CONST(add_const, src + k);
+EIGDEV_FW_X_CONST(subtract_const_r, src - k);
+EIGDEV_FW_X_CONST(subtract_const_l, k - src);
+EIGDEV_FW_X_CONST(multiply_const, src * k);
+EIGDEV_FW_X_CONST(divide_const_r, src / k);
+EIGDEV_FW_X_CONST(divide_const_l, k / src);
+EIGDEV_FW_X_CONST(prelu, (src > 0).select(src, k * src));
+EIGDEV_FW_X_CONST(elu, (src > 0).select(src, k * (src.exp() - 1.f)));
+
+EIGDEV_BW_X_CONST(add_const, pgy);
+EIGDEV_BW_X_CONST(subtract_const_r, pgy);
+EIGDEV_BW_X_CONST(subtract_const_l, -pgy);
+EIGDEV_BW_X_CONST(multiply_const, k * pgy);
+EIGDEV_BW_X_CONST(divide_const_r, pgy / k);
+EIGDEV_BW_X_CONST(divide_const_l, -py * pgy / px);
+EIGDEV_BW_X_CONST(prelu, (px > 0).select(pgy, k * pgy));
+EIGDEV_BW_X_CONST(elu, (px > 0).select(pgy, (py + k) * pgy));
+
+EIGDEV_FW_X_SCALAR(add_scalar, src + kk);
+EIGDEV_FW_X_SCALAR(subtract_scalar_r, src - kk);
+EIGDEV_FW_X_SCALAR(subtract_scalar_l, kk - src);
+EIGDEV_FW_X_SCALAR(multiply_scalar, src * kk);
+EIGDEV_FW_X_SCALAR(divide_scalar_r, src / kk);
+EIGDEV_FW_X_SCALAR(divide_scalar_l, kk / src);
+
+EIGDEV_FW_AB(add, pa + pb);
+EIGDEV_FW_AB(subtract, pa - pb);
+EIGDEV_FW_AB(multiply, pa * pb);
+EIGDEV_FW_AB(divide, pa / pb);
+
+#undef EIGDEV_FW_X
+#undef EIGDEV_BW_X
+#undef EIGDEV_FW_X_CONST
+#undef EIGDEV_BW_X_CONST
+#undef EIGDEV_FW_X_SCALAR
+#undef EIGDEV_FW_AB
+
+#define EIGDEV_BW_AB(name, op_a, op_b) \
+void Eigen::name##_bw_impl( \
+    const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy, \
+    Tensor &ga, Tensor &gb) { \
+  const unsigned size = gy.shape().volume(); \
+  const unsigned bs = gy.shape().batch(); \
+  const unsigned skip_a = ga.shape().has_batch() * size; \
+  const unsigned skip_b = gb.shape().has_batch() * size; \
+  const float *src_a = CDATA(a); static_cast<void>(src_a); \
+  const float *src_b = CDATA(b); static_cast<void>(src_b); \
+  const float *src_y = CDATA(y); static_cast<void>(src_y); \
+  const float *src_gy = CDATA(gy); \
+  float *dest_a = DATA(ga); \
+  float *dest_b = DATA(gb); \
+  for (unsigned batch = 0; batch < bs; ++batch) { \
+    const EConstArrayMap pa(src_a, size); static_cast<void>(pa); \
+    const EConstArrayMap pb(src_b, size); static_cast<void>(pb); \
+    const EConstArrayMap py(src_y, size); static_cast<void>(py); \
+    const EConstArrayMap pgy(src_gy, size); \
+    EArrayMap(dest_a, size) += (op_a); \
+    EArrayMap(dest_b, size) += (op_b); \
+    src_a += skip_a; \
+    src_b += skip_b; \
+    src_y += size; \
+    src_gy += size; \
+    dest_a += skip_a; \
+    dest_b += skip_b; \
+  } \
+}
+
+EIGDEV_BW_AB(add, pgy, pgy);
+EIGDEV_BW_AB(subtract, pgy, -pgy);
+EIGDEV_BW_AB(multiply, pgy * pb, pgy * pa);
+EIGDEV_BW_AB(divide, pgy / pb, -(pgy / pb) * py);
+
+#undef EIGDEV_BW_AB
+
+void Eigen::transpose_fw_impl(const Tensor &x, Tensor &y) {
+  const unsigned d1 = x.shape()[0];
+  const unsigned d2 = x.shape()[1];
+  const unsigned ms = d1 * d2;
+  const unsigned bs = y.shape().batch();
+  float *dest = DATA(y);
+  const float *src = CDATA(x);
+  for (unsigned batch = 0; batch < bs; ++batch) {
+    EMatrixMap(dest, d2, d1) = EConstMatrixMap(src, d1, d2).transpose();
+    dest += ms;
+    src += ms;
+  }
+}
+
+void Eigen::matmul_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) {
+  const unsigned d1 = a.shape()[0];
+  const unsigned d2 = a.shape()[1];
+  const unsigned d3 = b.shape()[1];
+  const unsigned bs = y.shape().batch();
+  float *dest = DATA(y);
+  const float *src_a = CDATA(a);
+  const float *src_b = CDATA(b);
+
+  if (a.shape().has_batch()) {
+    // Do multiplication multiple times.
+    const unsigned a_skip = d1 * d2;
+    const unsigned b_skip = b.shape().has_batch() * d2 * d3;
+    const unsigned y_skip = d1 * d3;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      EMatrixMap(dest, d1, d3).noalias()
+        = EConstMatrixMap(src_a, d1, d2) * EConstMatrixMap(src_b, d2, d3);
+      dest += y_skip;
+      src_a += a_skip;
+      src_b += b_skip;
+    }
+  } else {
+    // Do multiplication only once using a combined matrix.
+    EMatrixMap(dest, d1, d3 * bs).noalias()
+      = EConstMatrixMap(src_a, d1, d2) * EConstMatrixMap(src_b, d2, d3 * bs);
+  }
+}
+
+void Eigen::transpose_bw_impl(
+    const Tensor &, const Tensor &, const Tensor &gy, Tensor &gx) {
+  const unsigned d1 = gx.shape()[0];
+  const unsigned d2 = gx.shape()[1];
+  const unsigned ms = d1 * d2;
+  const unsigned bs = gx.shape().batch();
+  float *dest = DATA(gx);
+  const float *src = CDATA(gy);
+  for (unsigned batch = 0; batch < bs; ++batch) {
+    EMatrixMap(dest, d1, d2) += EConstMatrixMap(src, d2, d1).transpose();
+    dest += ms;
+    src += ms;
+  }
+}
+
+void Eigen::matmul_bw_impl(
+    const Tensor &a, const Tensor &b, const Tensor &, const Tensor &gy,
+    Tensor &ga, Tensor &gb) {
+  const unsigned d1 = a.shape()[0];
+  const unsigned d2 = a.shape()[1];
+  const unsigned d3 = b.shape()[1];
+  const unsigned bs = gy.shape().batch();
+  const float *src_a = CDATA(a);
+  const float *src_b = CDATA(b);
+  const float *src_gy = CDATA(gy);
+  float *dest_a = DATA(ga);
+  float *dest_b = DATA(gb);
+
+  if (a.shape().has_batch()) {
+    // Do multiplication multiple times.
+    const unsigned a_skip = d1 * d2;
+    const unsigned b_skip = b.shape().has_batch() * d2 * d3;
+    const unsigned y_skip = d1 * d3;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      const EConstMatrixMap pa(src_a, d1, d2);
+      const EConstMatrixMap pb(src_b, d2, d3);
+      const EConstMatrixMap pgy(src_gy, d1, d3);
+      EMatrixMap(dest_a, d1, d2).noalias() += pgy * pb.transpose();
+      EMatrixMap(dest_b, d2, d3).noalias() += pa.transpose() * pgy;
+      src_a += a_skip;
+      src_b += b_skip;
+      src_gy += y_skip;
+      dest_a += a_skip;
+      dest_b += b_skip;
+    }
+  } else {
+    // Do multiplication only once using a combined matrix.
+    const EConstMatrixMap pa(src_a, d1, d2);
+    const EConstMatrixMap pgy(src_gy, d1, d3 * bs);
+    if (b.shape().has_batch()) {
+      const EConstMatrixMap pb(src_b, d2, d3 * bs);
+      EMatrixMap(dest_a, d1, d2).noalias() += pgy * pb.transpose();
+      EMatrixMap(dest_b, d2, d3 * bs).noalias() += pa.transpose() * pgy;
+    } else {
+      const EConstMatrixMap pb(src_b, d2, d3);
+      EMatrixMap(dest_a, d1, d2).noalias() += pgy * pb.transpose();
+      EMatrixMap(dest_b, d2, d3).noalias() += pa.transpose() * pgy;
+    }
+  }
+}
+
+void Eigen::sum_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned base = y.shape().lower_volume(dim);
+  const unsigned repeat = y.shape().size() / base;
+  float *dest = DATA(y);
+  const float *src = CDATA(x);
+  for (unsigned i = 0; i < repeat; ++i) {
+    EMatrixMap(dest, base, 1) = EConstMatrixMap(src, base, n).rowwise().sum();
+    dest += base;
+    src += base * n;
+  }
+}
+
+void Eigen::logsumexp_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned base = y.shape().lower_volume(dim);
+  const unsigned repeat = y.shape().size() / base;
+  float *dest = DATA(y);
+  const float *src = CDATA(x);
+  for (unsigned i = 0; i < repeat; ++i) {
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> px(src, base, n);
+    const ::Eigen::ArrayXf m = px.rowwise().maxCoeff();
+    EArrayMap(dest, base)
+      = m + (px.colwise() - m).exp().rowwise().sum().log();
+    dest += base;
+    src += base * n;
+  }
+}
+
+void Eigen::broadcast_fw_impl(
+    const Tensor &x, unsigned dim, unsigned size, Tensor &y) {
+  const unsigned base = y.shape().lower_volume(dim);
+  const unsigned repeat = x.shape().size() / base;
+  float *dest = DATA(y);
+  const float *src = CDATA(x);
+  for (unsigned i = 0; i < repeat; ++i) {
+    EMatrixMap(dest, base, size).colwise()
+      = EConstMatrixMap(src, base, 1).col(0);
+    dest += base * size;
+    src += base;
+  }
+}
+
+void Eigen::batch_sum_fw_impl(const Tensor &x, Tensor &y) {
+  const unsigned bs = x.shape().batch();
+  const unsigned size = y.shape().size();
+  EMatrixMap(DATA(y), size, 1)
+    = EConstMatrixMap(CDATA(x), size, bs).rowwise().sum();
+}
+
+void Eigen::softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned base = x.shape().lower_volume(dim);
+  const unsigned repeat = x.shape().size() / (base * n);
+  float *dest = DATA(y);
+  const float *src = CDATA(x);
+  for (unsigned i = 0; i < repeat; ++i) {
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> px(src, base, n);
+    ::Eigen::Map<::Eigen::ArrayXXf> py(dest, base, n);
+    const ::Eigen::ArrayXf m = px.rowwise().maxCoeff();
+    py = (px.colwise() - m).exp();
+    const ::Eigen::ArrayXf s = py.rowwise().sum().inverse();
+    py.colwise() *= s;
+    dest += base * n;
+    src += base * n;
+  }
+}
+
+void Eigen::log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned base = x.shape().lower_volume(dim);
+  const unsigned repeat = x.shape().size() / (base * n);
+  float *dest = DATA(y);
+  const float *src = CDATA(x);
+  for (unsigned i = 0; i < repeat; ++i) {
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> px(src, base, n);
+    const ::Eigen::ArrayXf m = px.rowwise().maxCoeff();
+    const ::Eigen::ArrayXXf d = px.colwise() - m;
+    const ::Eigen::ArrayXf s = d.exp().rowwise().sum().log();
+    ::Eigen::Map<::Eigen::ArrayXXf>(dest, base, n) = d.colwise() - s;
+    dest += base * n;
+    src += base * n;
+  }
+}
+
+void Eigen::softmax_bw_impl(
+    const Tensor &, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  const unsigned n = y.shape()[dim];
+  const unsigned base = y.shape().lower_volume(dim);
+  const unsigned repeat = y.shape().size() / (base * n);
+  const float *py = CDATA(y);
+  const float *pgy = CDATA(gy);
+  float *pgx = DATA(gx);
+  for (unsigned i = 0; i < repeat; ++i) {
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> ey(py, base, n);
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> egy(pgy, base, n);
+    const ::Eigen::ArrayXf s = (egy * ey).rowwise().sum();
+    ::Eigen::Map<::Eigen::ArrayXXf>(pgx, base, n) += ey * (egy.colwise() - s);
+    py += base * n;
+    pgy += base * n;
+    pgx += base * n;
+  }
+}
+
+void Eigen::log_softmax_bw_impl(
+    const Tensor &, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  const unsigned n = y.shape()[dim];
+  const unsigned base = y.shape().lower_volume(dim);
+  const unsigned repeat = y.shape().size() / (base * n);
+  const float *py = CDATA(y);
+  const float *pgy = CDATA(gy);
+  float *pgx = DATA(gx);
+  for (unsigned i = 0; i < repeat; ++i) {
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> ey(py, base, n);
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> egy(pgy, base, n);
+    const ::Eigen::ArrayXf s = egy.rowwise().sum();
+    ::Eigen::Map<::Eigen::ArrayXXf>(pgx, base, n)
+      += egy - ey.exp().colwise() * s;
+    py += base * n;
+    pgy += base * n;
+    pgx += base * n;
+  }
+}
+
+void Eigen::sparse_softmax_cross_entropy_fw_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &lse, Tensor &y) {
+  logsumexp_fw_impl(x, dim, lse);
+  const unsigned n = x.shape()[dim];
+  const unsigned skip1 = x.shape().lower_volume(dim);
+  const unsigned size = y.shape().volume();
+  const unsigned bs = y.shape().batch();
+  const unsigned skip_x = x.shape().has_batch() * x.shape().volume();
+  const unsigned skip_l = x.shape().has_batch() * size;
+  const unsigned skip_i = ids.size() > 1;
+  const float *px = CDATA(x);
+  const float *pl = CDATA(lse);
+  float *py = DATA(y);
+  for (unsigned b = 0; b < bs; ++b) {
+    const float *src = px + b * skip_x + ids[b * skip_i] * skip1;
+    for (unsigned r = 0; r < size; r += skip1) {
+      EArrayMap(py + b * size + r, skip1)
+        = EConstArrayMap(pl + b * skip_l + r, skip1)
+        - EConstArrayMap(src + r * n, skip1);
+    }
+  }
+}
+
+void Eigen::sparse_softmax_cross_entropy_bw_impl(
+    const Tensor &x, const Tensor &lse, const std::vector<unsigned> &ids,
+    const Tensor &gy, unsigned dim, Tensor &gx) {
+  const unsigned n = x.shape()[dim];
+  const unsigned base = x.shape().lower_volume(dim);
+  const unsigned size = gy.shape().volume();
+  const unsigned bs = gy.shape().batch();
+  const bool has_batch = x.shape().has_batch();
+  const unsigned skip_i = ids.size() > 1;
+  const float *px = CDATA(x);
+  const float *pl = CDATA(lse);
+  const float *pgy = CDATA(gy);
+  float *pgx = DATA(gx);
+  for (unsigned xb = 0; xb < x.shape().batch(); ++xb) {
+    // If `x` has no minibatch, every minibatch of `gy` is accumulated into
+    // the same rows of `gx`.
+    const unsigned b_begin = has_batch ? xb : 0;
+    const unsigned b_end = has_batch ? xb + 1 : bs;
+    ::Eigen::ArrayXf g = ::Eigen::ArrayXf::Zero(size);
+    for (unsigned b = b_begin; b < b_end; ++b) {
+      g += EConstArrayMap(pgy + b * size, size);
+    }
+    for (unsigned r = 0; r < size; r += base) {
+      const ::Eigen::Map<const ::Eigen::ArrayXXf> ex(px + r * n, base, n);
+      ::Eigen::Map<::Eigen::ArrayXXf>(pgx + r * n, base, n)
+        += (ex.colwise() - EConstArrayMap(pl + r, base)).exp().colwise()
+        * g.segment(r, base);
+    }
+    for (unsigned b = b_begin; b < b_end; ++b) {
+      const unsigned o = ids[b * skip_i] * base;
+      for (unsigned r = 0; r < size; r += base) {
+        EArrayMap(pgx + r * n + o, base)
+          -= EConstArrayMap(pgy + b * size + r, base);
+      }
+    }
+    px += size * n;
+    pl += size;
+    pgx += size * n;
+  }
+}
+
+void Eigen::lstm_cell_fw_impl(
+    const Tensor &u, const Tensor &c, Tensor &gates, Tensor &y) {
+  const unsigned n = c.shape()[0];
+  const unsigned m = c.shape()[1];
+  const unsigned size = c.shape().volume();
+  const unsigned bs = y.shape().batch();
+  const unsigned skip_u = u.shape().has_batch() * 4 * size;
+  const unsigned skip_c = c.shape().has_batch() * size;
+  const float *pu = CDATA(u);
+  const float *pc = CDATA(c);
+  float *pg = DATA(gates);
+  float *py = DATA(y);
+  for (unsigned b = 0; b < u.shape().batch(); ++b) {
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> eu(pu + b * skip_u, 4 * n, m);
+    ::Eigen::Map<::Eigen::ArrayXXf> eg(pg + b * skip_u, 4 * n, m);
+    // Gates are calculated with double precision for the same reason as
+    // `sigmoid_fw_impl`.
+    eg.topRows(3 * n)
+      = (1. / (1. + (-eu.topRows(3 * n).cast<double>()).exp())).cast<float>();
+    eg.bottomRows(n) = eu.bottomRows(n).tanh();
+  }
+  for (unsigned b = 0; b < bs; ++b) {
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> eg(pg + b * skip_u, 4 * n, m);
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> ec(pc + b * skip_c, n, m);
+    ::Eigen::Map<::Eigen::ArrayXXf> ey(py + b * 2 * size, 2 * n, m);
+    ey.bottomRows(n)
+      = eg.topRows(n) * eg.bottomRows(n) + eg.middleRows(n, n) * ec;
+    ey.topRows(n) = eg.middleRows(2 * n, n) * ey.bottomRows(n).tanh();
+  }
+}
+
+void Eigen::lstm_cell_bw_impl(
+    const Tensor &c, const Tensor &gates, const Tensor &y, const Tensor &gy,
+    Tensor &gu, Tensor &gc) {
+  const unsigned n = c.shape()[0];
+  const unsigned m = c.shape()[1];
+  const unsigned size = c.shape().volume();
+  const unsigned bs = y.shape().batch();
+  const unsigned skip_u = gates.shape().has_batch() * 4 * size;
+  const unsigned skip_c = c.shape().has_batch() * size;
+  const float *pc = CDATA(c);
+  const float *pg = CDATA(gates);
+  const float *py = CDATA(y);
+  const float *pgy = CDATA(gy);
+  float *pgu = DATA(gu);
+  float *pgc = DATA(gc);
+  for (unsigned b = 0; b < bs; ++b) {
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> ec(pc + b * skip_c, n, m);
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> eg(pg + b * skip_u, 4 * n, m);
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> ey(py + b * 2 * size, 2 * n, m);
+    const ::Eigen::Map<const ::Eigen::ArrayXXf> egy(
+        pgy + b * 2 * size, 2 * n, m);
+    ::Eigen::Map<::Eigen::ArrayXXf> egu(pgu + b * skip_u, 4 * n, m);
+    const auto vi = eg.topRows(n);
+    const auto vf = eg.middleRows(n, n);
+    const auto vo = eg.middleRows(2 * n, n);
+    const auto vj = eg.bottomRows(n);
+    const auto gh = egy.topRows(n);
+    const ::Eigen::ArrayXXf tc = ey.bottomRows(n).tanh();
+    const ::Eigen::ArrayXXf dc
+      = egy.bottomRows(n) + gh * vo * (1.f - tc.square());
+    egu.topRows(n) += dc * vj * vi * (1.f - vi);
+    egu.middleRows(n, n) += dc * ec * vf * (1.f - vf);
+    egu.middleRows(2 * n, n) += gh * tc * vo * (1.f - vo);
+    egu.bottomRows(n) += dc * vi * (1.f - vj.square());
+    ::Eigen::Map<::Eigen::ArrayXXf>(pgc + b * skip_c, n, m) += dc * vf;
+  }
+}
+
+void Eigen::inplace_multiply_const_impl(float k, Tensor &x) {
+  EMAP(x) *= k;
+}
+
+void Eigen::inplace_add_impl(const Tensor &x, Tensor &y) {
+  const Shape &sx = x.shape();
+  const Shape &sy = y.shape();
+  const unsigned size = sy.volume();
+  if (sx.batch() == sy.batch()) {
+    EMAP(y) += ECMAP(x);
+  } else if (sy.batch() == 1) {
+    EMatrixMap(DATA(y), size, 1)
+      += EConstMatrixMap(CDATA(x), size, sx.batch()).rowwise().sum();
+  } else {
+    EMatrixMap(DATA(y), size, sy.batch()).colwise()
+      += EConstMatrixMap(CDATA(x), size, 1).col(0);
+  }
+}
+
+void Eigen::inplace_subtract_impl(const Tensor &x, Tensor &y) {
+  const Shape &sx = x.shape();
+  const Shape &sy = y.shape();
+  const unsigned size = sy.volume();
+  if (sx.batch() == sy.batch()) {
+    EMAP(y) -= ECMAP(x);
+  } else if (sy.batch() == 1) {
+    EMatrixMap(DATA(y), size, 1)
+      -= EConstMatrixMap(CDATA(x), size, sx.batch()).rowwise().sum();
+  } else {
+    EMatrixMap(DATA(y), size, sy.batch()).colwise()
+      -= EConstMatrixMap(CDATA(x), size, 1).col(0);
+  }
+}
+
+void Eigen::inplace_matmul_add_impl(
+    const Tensor &a, const Tensor &b, Tensor &y) {
+  const unsigned d1 = a.shape()[0];
+  const unsigned d2 = a.shape()[1];
+  const unsigned d3 = b.shape()[1];
+  const unsigned bs = y.shape().batch();
+  float *dest = DATA(y);
+  const float *src_a = CDATA(a);
+  const float *src_b = CDATA(b);
+
+  if (a.shape().has_batch()) {
+    const unsigned a_skip = d1 * d2;
+    const unsigned b_skip = b.shape().has_batch() * d2 * d3;
+    const unsigned y_skip = d1 * d3;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      EMatrixMap(dest, d1, d3).noalias()
+        += EConstMatrixMap(src_a, d1, d2) * EConstMatrixMap(src_b, d2, d3);
+      dest += y_skip;
+      src_a += a_skip;
+      src_b += b_skip;
+    }
+  } else {
+    EMatrixMap(dest, d1, d3 * bs).noalias()
+      += EConstMatrixMap(src_a, d1, d2) * EConstMatrixMap(src_b, d2, d3 * bs);
+  }
+}
+
+void Eigen::inplace_pick_assign_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  const unsigned bs = x.shape().batch();
+  const unsigned skip_y = y.shape().has_batch() * y.shape().volume();
+  const unsigned skip_i = ids.size() > 1;
+  const unsigned base = x.shape().lower_volume(dim);
+  const unsigned skip = base * y.shape()[dim];
+  const unsigned repeat = x.shape().volume() / base;
+  const float *src = CDATA(x);
+  for (unsigned batch = 0; batch < bs; ++batch) {
+    float *dest = DATA(y) + batch * skip_y + base * ids[batch * skip_i];
+    ::Eigen::Map<::Eigen::MatrixXf, 0, ::Eigen::OuterStride<>>(
+        dest, base, repeat, ::Eigen::OuterStride<>(skip))
+      = EConstMatrixMap(src, base, repeat);
+    src += base * repeat;
+  }
+}
+
+void Eigen::inplace_pick_reset_impl(
+    float k, const std::vector<unsigned> &ids, unsigned dim, Tensor &x) {
+  const unsigned bs = std::max<unsigned>(x.shape().batch(), ids.size());
+  const unsigned skip_x = x.shape().has_batch() * x.shape().volume();
+  const unsigned skip_i = ids.size() > 1;
+  const unsigned base = x.shape().lower_volume(dim);
+  const unsigned skip = base * x.shape()[dim];
+  const unsigned repeat = x.shape().volume() / skip;
+  for (unsigned batch = 0; batch < bs; ++batch) {
+    float *dest = DATA(x) + batch * skip_x + base * ids[batch * skip_i];
+    ::Eigen::Map<::Eigen::MatrixXf, 0, ::Eigen::OuterStride<>>(
+        dest, base, repeat, ::Eigen::OuterStride<>(skip)).setConstant(k);
+  }
+}
+
+float Eigen::squared_norm_impl(const std::vector<const Tensor *> &xs) {
+  float ret = 0;
+  for (const Tensor *x : xs) {
+    ret += ECMAP(*x).square().sum();
+  }
+  return ret;
+}
+
+void Eigen::sgd_update_impl(float eta, const Tensor &g, Tensor &x) {
+  EMAP(x) -= eta * ECMAP(g);
+}
+
+void Eigen::momentum_sgd_update_impl(
+    float eta, float momentum, const Tensor &g, Tensor &m, Tensor &x) {
+  EArrayMap pm = EMAP(m);
+  pm = momentum * pm - eta * ECMAP(g);
+  EMAP(x) += pm;
+}
+
+void Eigen::adagrad_update_impl(
+    float eta, float eps, const Tensor &g, Tensor &m, Tensor &x) {
+  const EConstArrayMap pg = ECMAP(g);
+  EArrayMap pm = EMAP(m);
+  pm += pg * pg;
+  EMAP(x) -= eta * pg / (pm.sqrt() + eps);
+}
+
+void Eigen::rmsprop_update_impl(
+    float eta, float alpha, float eps, const Tensor &g, Tensor &m, Tensor &x) {
+  const EConstArrayMap pg = ECMAP(g);
+  EArrayMap pm = EMAP(m);
+  pm = alpha * pm + (1 - alpha) * pg * pg;
+  EMAP(x) -= eta * pg / (pm.sqrt() + eps);
+}
+
+void Eigen::adadelta_update_impl(
+    float scale, float rho, float eps, const Tensor &g,
+    Tensor &m1, Tensor &m2, Tensor &x) {
+  const float k = 1 - rho;
+  const float *pg = CDATA(g);
+  float *pm1 = DATA(m1);
+  float *pm2 = DATA(m2);
+  float *px = DATA(x);
+  const unsigned size = x.shape().size();
+  for (unsigned i = 0; i < size; ++i) {
+    const float gi = pg[i];
+    pm2[i] = rho * pm2[i] + k * gi * gi;
+    const float dx = std::sqrt((pm1[i] + eps) / (pm2[i] + eps)) * gi;
+    pm1[i] = rho * pm1[i] + k * dx * dx;
+    px[i] -= scale * dx;
+  }
+}
+
+void Eigen::adam_update_impl(
+    float alpha, float beta1, float beta2, float eps, float bias1, float bias2,
+    const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) {
+  const EConstArrayMap pg = ECMAP(g);
+  EArrayMap pm1 = EMAP(m1);
+  EArrayMap pm2 = EMAP(m2);
+  pm1 = beta1 * pm1 + (1 - beta1) * pg;
+  pm2 = beta2 * pm2 + (1 - beta2) * pg * pg;
+  EMAP(x) -= alpha * (pm1 / bias1) / ((pm2 / bias2).sqrt() + eps);
+}
+
+}  // namespace devices
+}  // namespace primitiv
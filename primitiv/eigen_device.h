@@ -0,0 +1,189 @@
+#ifndef PRIMITIV_EIGEN_DEVICE_H_
+#define PRIMITIV_EIGEN_DEVICE_H_
+
+#include <mutex>
+#include <random>
+#include <primitiv/cpu_memory_pool.h>
+#include <primitiv/device.h>
+
+namespace primitiv {
+namespace devices {
+
+/**
+ * Device class for the CPU function implementations using Eigen.
+ * @remarks The internal memory of each tensor is directly mapped to Eigen's
+ *          matrices and arrays, and all operations are computed by Eigen's
+ *          vectorized kernels.
+ */
+class Eigen : public Device {
+public:
+  /**
+   * Creates a Eigen object.
+   * @remarks The internal random number generator is initialized by
+   *          `std::random_device`.
+   */
+  Eigen() : rng_(std::random_device()()) {}
+
+  /**
+   * Creates a Eigen object.
+   * @param rng_seed The seed value of internal random number generator.
+   */
+  explicit Eigen(unsigned rng_seed) : rng_(rng_seed) {}
+
+  ~Eigen() override = default;
+
+  void dump_description() const override;
+  Device::DeviceType type() const override { return Device::DEVICE_TYPE_CPU; }
+
+  /**
+   * Retrieves the memory pool which holds all tensors on this device.
+   * @return Reference of the memory pool.
+   */
+  CPUMemoryPool &memory_pool() { return mem_pool_; }
+
+  /**
+   * Retrieves the memory pool which holds all tensors on this device.
+   * @return Const reference of the memory pool.
+   */
+  const CPUMemoryPool &memory_pool() const { return mem_pool_; }
+
+private:
+  std::shared_ptr<void> new_handle(const Shape &shape) override;
+
+  std::vector<float> tensor_to_vector_impl(const Tensor &x) override;
+  std::vector<unsigned> argmax_impl(const Tensor &x, unsigned dim) override;
+  std::vector<unsigned> argmin_impl(const Tensor &x, unsigned dim) override;
+
+  void reset_tensor_impl(float k, Tensor &x) override;
+  void reset_tensor_by_array_impl(const float values[], Tensor &x) override;
+
+  void copy_tensor_impl(const Tensor &x, Tensor &y) override;
+
+  void identity_impl(Tensor &y) override;
+
+  void random_bernoulli_impl(float p, Tensor &y) override;
+  void random_uniform_impl(float lower, float upper, Tensor &y) override;
+  void random_normal_impl(float mean, float sd, Tensor &y) override;
+  void random_log_normal_impl(float mean, float sd, Tensor &y) override;
+
+  void pick_fw_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) override;
+  void slice_fw_impl(const Tensor &x, unsigned dim, unsigned offset, Tensor &y) override;
+  void concat_fw_impl(const std::vector<const Tensor *> &xs, unsigned dim, Tensor &y) override;
+
+  void pick_bw_impl(const Tensor &gy, const std::vector<unsigned> &ids, unsigned dim, Tensor &gx) override;
+  void slice_bw_impl(const Tensor &gy, unsigned dim, unsigned offset, Tensor &gx) override;
+
+  void negate_fw_impl(const Tensor &x, Tensor &y) override;
+  void sqrt_fw_impl(const Tensor &x, Tensor &y) override;
+  void exp_fw_impl(const Tensor &x, Tensor &y) override;
+  void log_fw_impl(const Tensor &x, Tensor &y) override;
+  void tanh_fw_impl(const Tensor &x, Tensor &y) override;
+  void sigmoid_fw_impl(const Tensor &x, Tensor &y) override;
+  void softplus_fw_impl(const Tensor &x, Tensor &y) override;
+  void sin_fw_impl(const Tensor &x, Tensor &y) override;
+  void cos_fw_impl(const Tensor &x, Tensor &y) override;
+  void tan_fw_impl(const Tensor &x, Tensor &y) override;
+  void transpose_fw_impl(const Tensor &x, Tensor &y) override;
+
+  void sqrt_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) override;
+  void exp_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) override;
+  void log_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) override;
+  void tanh_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) override;
+  void sigmoid_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) override;
+  void softplus_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) override;
+  void sin_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) override;
+  void cos_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) override;
+  void tan_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) override;
+  void transpose_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) override;
+
+  void add_const_fw_impl(const Tensor &x, float k, Tensor &y) override;
+  void subtract_const_r_fw_impl(const Tensor &x, float k, Tensor &y) override;
+  void subtract_const_l_fw_impl(const Tensor &x, float k, Tensor &y) override;
+  void multiply_const_fw_impl(const Tensor &x, float k, Tensor &y) override;
+  void divide_const_r_fw_impl(const Tensor &x, float k, Tensor &y) override;
+  void divide_const_l_fw_impl(const Tensor &x, float k, Tensor &y) override;
+  void prelu_fw_impl(const Tensor &x, float k, Tensor &y) override;
+  void elu_fw_impl(const Tensor &x, float k, Tensor &y) override;
+
+  void add_const_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx) override;
+  void subtract_const_r_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx) override;
+  void subtract_const_l_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx) override;
+  void multiply_const_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx) override;
+  void divide_const_r_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx) override;
+  void divide_const_l_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx) override;
+  void prelu_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx) override;
+  void elu_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx) override;
+
+  void add_scalar_fw_impl(const Tensor &x, const Tensor &k, Tensor &y) override;
+  void subtract_scalar_r_fw_impl(const Tensor &x, const Tensor &k, Tensor &y) override;
+  void subtract_scalar_l_fw_impl(const Tensor &x, const Tensor &k, Tensor &y) override;
+  void multiply_scalar_fw_impl(const Tensor &x, const Tensor &k, Tensor &y) override;
+  void divide_scalar_r_fw_impl(const Tensor &x, const Tensor &k, Tensor &y) override;
+  void divide_scalar_l_fw_impl(const Tensor &x, const Tensor &k, Tensor &y) override;
+
+  void add_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) override;
+  void subtract_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) override;
+  void multiply_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) override;
+  void divide_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) override;
+  void matmul_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) override;
+
+  void add_bw_impl(
+      const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy,
+      Tensor &ga, Tensor &gb) override;
+  void subtract_bw_impl(
+      const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy,
+      Tensor &ga, Tensor &gb) override;
+  void multiply_bw_impl(
+      const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy,
+      Tensor &ga, Tensor &gb) override;
+  void divide_bw_impl(
+      const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy,
+      Tensor &ga, Tensor &gb) override;
+  void matmul_bw_impl(
+      const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy,
+      Tensor &ga, Tensor &gb) override;
+
+  void sum_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+  void logsumexp_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+  void broadcast_fw_impl(const Tensor &x, unsigned dim, unsigned size, Tensor &y) override;
+  void batch_sum_fw_impl(const Tensor &x, Tensor &y) override;
+
+  void softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+  void log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+
+  void softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+  void log_softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+
+  void sparse_softmax_cross_entropy_fw_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &lse, Tensor &y) override;
+  void sparse_softmax_cross_entropy_bw_impl(const Tensor &x, const Tensor &lse, const std::vector<unsigned> &ids, const Tensor &gy, unsigned dim, Tensor &gx) override;
+
+  void lstm_cell_fw_impl(const Tensor &u, const Tensor &c, Tensor &gates, Tensor &y) override;
+  void lstm_cell_bw_impl(const Tensor &c, const Tensor &gates, const Tensor &y, const Tensor &gy, Tensor &gu, Tensor &gc) override;
+
+  void inplace_multiply_const_impl(float k, Tensor &x) override;
+
+  void inplace_add_impl(const Tensor &x, Tensor &y) override;
+  void inplace_subtract_impl(const Tensor &x, Tensor &y) override;
+  void inplace_matmul_add_impl(const Tensor &a, const Tensor &b, Tensor &y) override;
+  void inplace_pick_assign_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) override;
+  void inplace_pick_reset_impl(float k, const std::vector<unsigned> &ids, unsigned dim, Tensor &x) override;
+
+  float squared_norm_impl(const std::vector<const Tensor *> &xs) override;
+
+  void sgd_update_impl(float eta, const Tensor &g, Tensor &x) override;
+  void momentum_sgd_update_impl(float eta, float momentum, const Tensor &g, Tensor &m, Tensor &x) override;
+  void adagrad_update_impl(float eta, float eps, const Tensor &g, Tensor &m, Tensor &x) override;
+  void rmsprop_update_impl(float eta, float alpha, float eps, const Tensor &g, Tensor &m, Tensor &x) override;
+  void adadelta_update_impl(float scale, float rho, float eps, const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) override;
+  void adam_update_impl(float alpha, float beta1, float beta2, float eps, float bias1, float bias2, const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) override;
+
+private:
+  std::mt19937 rng_;
+  std::mutex rng_mutex_;
+  CPUMemoryPool mem_pool_;
+};
+
+}  // namespace devices
+}  // namespace primitiv
+
+#endif  // PRIMITIV_EIGEN_DEVICE_H_
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <primitiv/error.h>
 #include <primitiv/mixins.h>
 #include <primitiv/shape.h>
 #include <primitiv/tensor.h>
@@ -10,6 +11,7 @@
 namespace primitiv {
 
 class Device;
+class Parameter;
 
 /**
  * Interface of the function on the computation graph.
@@ -27,6 +29,19 @@ public:
   virtual Shape forward_shape(
       const std::vector<const Shape *> &args) const = 0;
 
+  /**
+   * Calculates only the resulting shapes of all values.
+   * @param args Shapes of argument values.
+   * @return Shapes of the resulting values.
+   * @remarks Functions with multiple resulting values should override this
+   *          method, `forward_multi()` and `backward_multi()`.
+   *          The default implementation returns `{forward_shape(args)}`.
+   */
+  virtual std::vector<Shape> forward_shapes(
+      const std::vector<const Shape *> &args) const {
+    return { forward_shape(args) };
+  }
+
   /**
    * Returns the device object if the class holds it.
    * @return A pointer of the Device object if the class holds it, or nullptr
@@ -43,6 +58,14 @@ public:
    */
   virtual const Tensor *get_inner_value() const { return nullptr; }
 
+  /**
+   * Returns the parameter whose sparse gradient is enabled if the class holds
+   * it.
+   * @return A pointer of the Parameter object which has the sparse gradient,
+   *         or nullptr otherwise.
+   */
+  virtual Parameter *get_sparse_parameter() const { return nullptr; }
+
   /**
    * Calculates the forward path.
    * @param args argument tensors.
@@ -52,6 +75,18 @@ public:
    */
   virtual Tensor forward(const std::vector<const Tensor *> &args) = 0;
 
+  /**
+   * Calculates the forward path of all resulting values.
+   * @param args argument tensors.
+   * @return Resulting tensors, which have shapes calculated by
+   *         `forward_shapes()`.
+   * @remarks The default implementation returns `{forward(args)}`.
+   */
+  virtual std::vector<Tensor> forward_multi(
+      const std::vector<const Tensor *> &args) {
+    return { forward(args) };
+  }
+
   /**
    * Calculates the backward path.
    * @param cur_value The value of the current node.
@@ -66,6 +101,61 @@ public:
       const std::vector<const Tensor *> &arg_values,
       const std::vector<Tensor *> &arg_grads) const = 0;
 
+  /**
+   * Calculates the backward path of all resulting values.
+   * @param cur_values Values of all resulting nodes.
+   * @param cur_grads Gradients of all resulting nodes, or nullptr for nodes
+   *                  which received no gradients.
+   * @param arg_values Values of the argument nodes.
+   * @param arg_grads Gradients of the argument nodes. These values are updated
+   *                  by this method.
+   * @remarks The default implementation calls `backward()` with the first
+   *          value and gradient if it exists.
+   */
+  virtual void backward_multi(
+      const std::vector<const Tensor *> &cur_values,
+      const std::vector<const Tensor *> &cur_grads,
+      const std::vector<const Tensor *> &arg_values,
+      const std::vector<Tensor *> &arg_grads) const {
+    if (cur_grads[0]) {
+      backward(*cur_values[0], *cur_grads[0], arg_values, arg_grads);
+    }
+  }
+
+  /**
+   * Calculates the backward path directly into the sparse gradient of the
+   * argument parameter.
+   * @param cur_grad The gradient of the current node.
+   * @param param The parameter of the only argument node, which has the sparse
+   *              gradient.
+   * @return true if the gradient is propagated, false if the function requires
+   *         the dense gradient of the argument node.
+   */
+  virtual bool backward_sparse(
+      const Tensor &cur_grad, Parameter &param) const { return false; }
+
+  /**
+   * Replaces the input data held by the function.
+   * @param data New data.
+   * @throw primitiv::Error The function holds no input data, or the size of
+   *                        `data` mismatched.
+   * @remarks This function never changes the resulting shape.
+   */
+  virtual void reset_data(const std::vector<float> &data) {
+    THROW_ERROR("Function '" << name() << "' holds no input data.");
+  }
+
+  /**
+   * Replaces the IDs held by the function.
+   * @param ids New IDs.
+   * @throw primitiv::Error The function holds no IDs, or the number of `ids`
+   *                        mismatched.
+   * @remarks This function never changes the resulting shape.
+   */
+  virtual void reset_ids(const std::vector<unsigned> &ids) {
+    THROW_ERROR("Function '" << name() << "' holds no IDs.");
+  }
+
   /**
    * Returns the name of the function.
    * @return Name of the function.
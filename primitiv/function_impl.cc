@@ -1,6 +1,7 @@
 #include <config.h>
 
 #include <algorithm>
+#include <utility>
 #include <primitiv/error.h>
 #include <primitiv/function_impl.h>
 #include <primitiv/operators.h>
@@ -34,6 +35,17 @@ Input::Input(const Shape &shape, const vector<float> &data, Device &device)
   }
 }
 
+void Input::reset_data(const vector<float> &data) {
+  if (data.size() != shape_.size()) {
+    THROW_ERROR(
+        "Data sizes mismatched."
+        << " function: Input"
+        << ", required: " << shape_.size() << " (" << shape_.to_string() << ")"
+        << ", actual: " << data.size());
+  }
+  data_ = data;
+}
+
 Shape Input::forward_shape(const vector<const Shape *> &args) const {
   CHECK_ARGNUM(args, 0);
   return shape_;
@@ -178,6 +190,20 @@ void RandomLogNormal::backward(
   // Nothing to do.
 }
 
+#define CHECK_IDS(ids) \
+  if ((ids).size() != ids_.size()) { \
+    THROW_ERROR( \
+        "Number of IDs mismatched." \
+        << " function: " << name() \
+        << ", required: " << ids_.size() \
+        << " != actual: " << (ids).size()); \
+  }
+
+void Pick::reset_ids(const vector<unsigned> &ids) {
+  CHECK_IDS(ids);
+  ids_ = ids;
+}
+
 Shape Pick::forward_shape(const vector<const Shape *> &args) const {
   CHECK_ARGNUM(args, 1);
   return shape_ops::pick(*args[0], ids_, dim_);
@@ -194,6 +220,12 @@ void Pick::backward(
   gy.device().pick_bw(gy, ids_, dim_, *gx[0]);
 }
 
+bool Pick::backward_sparse(const Tensor &gy, Parameter &param) const {
+  if (dim_ != param.sparse_dim()) return false;
+  param.add_sparse_gradient(ids_, gy);
+  return true;
+}
+
 Shape Slice::forward_shape(const vector<const Shape *> &args) const {
   CHECK_ARGNUM(args, 1);
   return shape_ops::slice(*args[0], dim_, lower_, upper_);
@@ -229,6 +261,49 @@ void Concat::backward(
   }
 }
 
+Shape Split::forward_shape(const vector<const Shape *> &args) const {
+  return forward_shapes(args)[0];
+}
+
+vector<Shape> Split::forward_shapes(const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 1);
+  const Shape &s = *args[0];
+  if (n_ == 0 || s[dim_] % n_ != 0) {
+    THROW_ERROR(
+        "Invalid split operation. shape: " << s.to_string()
+        << ", dim: " << dim_ << ", n: " << n_);
+  }
+  const unsigned span = s[dim_] / n_;
+  return vector<Shape>(n_, s.resize_dim(dim_, span));
+}
+
+Tensor Split::forward(const std::vector<const Tensor *> &args) {
+  CHECK_ARGNUM(args, 1);
+  const unsigned span = args[0]->shape()[dim_] / n_;
+  return operators::slice(*args[0], dim_, 0, span);
+}
+
+vector<Tensor> Split::forward_multi(const std::vector<const Tensor *> &args) {
+  CHECK_ARGNUM(args, 1);
+  return operators::split(*args[0], dim_, n_);
+}
+
+void Split::backward(
+    const Tensor &y, const Tensor &gy,
+    const vector<const Tensor *> &x, const vector<Tensor *> &gx) const {
+  gy.device().slice_bw(gy, dim_, 0, *gx[0]);
+}
+
+void Split::backward_multi(
+    const vector<const Tensor *> &ys, const vector<const Tensor *> &gys,
+    const vector<const Tensor *> &x, const vector<Tensor *> &gx) const {
+  // Each gradient is added to its own range of gx without temporaries.
+  const unsigned span = x[0]->shape()[dim_] / n_;
+  for (unsigned i = 0; i < gys.size(); ++i) {
+    if (gys[i]) gys[i]->device().slice_bw(*gys[i], dim_, i * span, *gx[0]);
+  }
+}
+
 Shape Reshape::forward_shape(const vector<const Shape *> &args) const {
   CHECK_ARGNUM(args, 1);
   return shape_ops::reshape(*args[0], shape_);
@@ -312,6 +387,16 @@ Shape LogSumExp::forward_shape(const vector<const Shape *> &args) const {
   return args[0]->resize_dim(dim_, 1);
 }
 
+Shape Softmax::forward_shape(const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 1);
+  return *args[0];
+}
+
+Shape LogSoftmax::forward_shape(const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 1);
+  return *args[0];
+}
+
 Shape Broadcast::forward_shape(const vector<const Shape *> &args) const {
   CHECK_ARGNUM(args, 1);
   return shape_ops::broadcast(*args[0], dim_, size_);
@@ -322,6 +407,11 @@ Shape BatchSum::forward_shape(const vector<const Shape *> &args) const {
   return args[0]->resize_batch(1);
 }
 
+Shape BatchToColumns::forward_shape(const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 1);
+  return shape_ops::batch_to_columns(*args[0]);
+}
+
 Shape SoftmaxCrossEntropy::forward_shape(
     const vector<const Shape *> &args) const {
   CHECK_ARGNUM(args, 2);
@@ -330,12 +420,141 @@ Shape SoftmaxCrossEntropy::forward_shape(
   return y;
 }
 
+void SparseSoftmaxCrossEntropy::reset_ids(const vector<unsigned> &ids) {
+  CHECK_IDS(ids);
+  ids_ = ids;
+}
+
 Shape SparseSoftmaxCrossEntropy::forward_shape(
     const vector<const Shape *> &args) const {
   CHECK_ARGNUM(args, 1);
   return shape_ops::pick(*args[0], ids_, dim_);
 }
 
+void ChunkedSoftmaxCrossEntropy::reset_ids(const vector<unsigned> &ids) {
+  CHECK_IDS(ids);
+  ids_ = ids;
+}
+
+Shape ChunkedSoftmaxCrossEntropy::forward_shape(
+    const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 3);
+  if (chunk_size_ == 0) {
+    THROW_ERROR("chunk_size should be greater than 0.");
+  }
+  return shape_ops::pick(
+      shape_ops::elementwise(shape_ops::matmul(*args[1], *args[0]), *args[2]),
+      ids_, 0);
+}
+
+namespace {
+
+// Calculates the shape of the gates of LSTMCell.
+Shape lstm_cell_gates(const vector<const Shape *> &args) {
+  return shape_ops::elementwise(
+      shape_ops::elementwise(
+        shape_ops::matmul(*args[3], *args[0]),
+        shape_ops::matmul(*args[4], *args[1])),
+      *args[5]);
+}
+
+// Calculates the shape of the gates of each step of LSTM.
+Shape lstm_step_gates(const vector<const Shape *> &args) {
+  const Shape &x = *args[0], &h = *args[1], &c = *args[2];
+  if (!x.is_matrix() || h[0] != c[0]) {
+    THROW_ERROR(
+        "Invalid shapes to calculate the LSTM: "
+        << x.to_string() << ", " << h.to_string() << ", " << c.to_string());
+  }
+  const Shape u = shape_ops::elementwise(
+      shape_ops::matmul(*args[3], x),
+      shape_ops::broadcast(*args[5], 1, x[1]));
+  return shape_ops::elementwise(
+      u.resize_dim(1, 1), shape_ops::matmul(*args[4], h));
+}
+
+}  // namespace
+
+Shape LSTMCell::forward_shape(const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 6);
+  return shape_ops::lstm_cell(lstm_cell_gates(args), *args[2]);
+}
+
+vector<Shape> LSTMCell::forward_shapes(
+    const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 6);
+  const Shape gates = lstm_cell_gates(args);
+  return { shape_ops::lstm_cell(gates, *args[2]), gates };
+}
+
+Shape LSTM::forward_shape(const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 6);
+  const unsigned len = (*args[0])[1];
+  return shape_ops::lstm_cell(
+      lstm_step_gates(args), *args[2]).resize_dim(1, len);
+}
+
+vector<Shape> LSTM::forward_shapes(const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 6);
+  const unsigned len = (*args[0])[1];
+  const Shape gates = lstm_step_gates(args);
+  return {
+    shape_ops::lstm_cell(gates, *args[2]).resize_dim(1, len),
+    gates.resize_dim(1, len),
+  };
+}
+
+namespace {
+
+// Calculates `y + matmul(a, b)`. The product is accumulated directly into `y`
+// if it has the same shape as `y`.
+Tensor matmul_add(const Tensor &a, const Tensor &b, Tensor &&y) {
+  Device &dev = y.device();
+  if (shape_ops::matmul(a.shape(), b.shape()) != y.shape()) {
+    return dev.add_fw(y, dev.matmul_fw(a, b));
+  }
+  dev.inplace_matmul_add(a, b, y);
+  return std::move(y);
+}
+
+// Calculates LSTMCell and its activated gates.
+Tensor lstm_cell_fw(const vector<const Tensor *> &x, Tensor &gates) {
+  // u = matmul(wx, x) + matmul(wh, h) + b
+  Device &dev = x[0]->device();
+  Tensor u = matmul_add(*x[4], *x[1], dev.matmul_fw(*x[3], *x[0]));
+  if (x[5]->shape().batch() > u.shape().batch()) u = dev.add_fw(u, *x[5]);
+  else dev.inplace_add(*x[5], u);
+  return dev.lstm_cell_fw(u, *x[2], gates);
+}
+
+// Calculates LSTM and the activated gates of all steps, which are
+// concatenated along the second dimension.
+Tensor lstm_fw(const vector<const Tensor *> &x, Tensor &gates) {
+  // The input projection of all steps is calculated by one matrix product,
+  // and only the recurrent part is calculated step by step.
+  Device &dev = x[0]->device();
+  const unsigned n = x[2]->shape()[0];
+  const unsigned len = x[0]->shape()[1];
+  const Tensor u = dev.add_fw(
+      dev.matmul_fw(*x[3], *x[0]), dev.broadcast_fw(*x[5], 1, len));
+  vector<Tensor> ys(len), gs(len);
+  vector<const Tensor *> pys(len), pgs(len);
+  Tensor h, c;
+  for (unsigned t = 0; t < len; ++t) {
+    ys[t] = dev.lstm_cell_fw(
+        matmul_add(*x[4], t ? h : *x[1], dev.slice_fw(u, 1, t, t + 1)),
+        t ? c : *x[2], gs[t]);
+    pys[t] = &ys[t];
+    pgs[t] = &gs[t];
+    h = dev.slice_fw(ys[t], 0, 0, n);
+    c = dev.slice_fw(ys[t], 0, n, 2 * n);
+  }
+  gates = dev.concat_fw(pgs, 1);
+  return dev.concat_fw(pys, 1);
+}
+
+}  // namespace
+
 #define FORWARD(name) \
     Tensor name::forward(const vector<const Tensor *> &x)
 
@@ -382,24 +601,101 @@ FORWARD(MatrixMultiply) { return operators::matmul(*x[0], *x[1]); }
 
 FORWARD(Sum) { return operators::sum(*x[0], dim_); }
 FORWARD(LogSumExp) { return operators::logsumexp(*x[0], dim_); }
+FORWARD(Softmax) { return operators::softmax(*x[0], dim_); }
+FORWARD(LogSoftmax) { return operators::log_softmax(*x[0], dim_); }
 FORWARD(Broadcast) { return operators::broadcast(*x[0], dim_, size_); }
 
 FORWARD(BatchSum) { return operators::batch::sum(*x[0]); }
+FORWARD(BatchToColumns) { return operators::batch::to_columns(*x[0]); }
 
 FORWARD(SoftmaxCrossEntropy) {
   return operators::softmax_cross_entropy(*x[0], *x[1], dim_);
 }
 FORWARD(SparseSoftmaxCrossEntropy) {
-#ifdef PRIMITIV_USE_CACHE
-  log_softmax_x_ = operators::log_softmax(*x[0], dim_);
-  return operators::pick(-log_softmax_x_, ids_, dim_);
-#else
-  return operators::softmax_cross_entropy(*x[0], ids_, dim_);
-#endif  // PRIMITIV_USE_CACHE
+  return x[0]->device().sparse_softmax_cross_entropy_fw(*x[0], ids_, dim_, lse_);
+}
+FORWARD(ChunkedSoftmaxCrossEntropy) {
+  return operators::chunked_softmax_cross_entropy(
+      *x[0], *x[1], *x[2], ids_, chunk_size_);
+}
+FORWARD(LSTMCell) {
+  Tensor gates;
+  return lstm_cell_fw(x, gates);
+}
+FORWARD(LSTM) {
+  Tensor gates;
+  return lstm_fw(x, gates);
 }
 
 #undef FORWARD
 
+namespace {
+
+// Accumulates the gradients of `matmul(a, b)` from `gy`.
+// Minibatches of `gy` are summed if the product itself has no minibatch.
+void matmul_bw_from(
+    const Tensor &a, const Tensor &b, const Tensor &gy, Tensor &ga, Tensor &gb) {
+  Device &dev = gy.device();
+  const Shape s = shape_ops::matmul(a.shape(), b.shape());
+  const Tensor g = s.batch() == gy.shape().batch() ? gy : dev.batch_sum_fw(gy);
+  // `matmul_bw` does not use the value of the product.
+  dev.matmul_bw(a, b, g, g, ga, gb);
+}
+
+// Calculates the gradients of LSTMCell from the activated gates.
+void lstm_cell_bw(
+    const vector<const Tensor *> &x, const Tensor &gates,
+    const Tensor &y, const Tensor &gy, const vector<Tensor *> &gx) {
+  Device &dev = gy.device();
+  Tensor gu = dev.new_tensor_by_constant(gates.shape(), 0);
+  dev.lstm_cell_bw(*x[2], gates, y, gy, gu, *gx[2]);
+  matmul_bw_from(*x[3], *x[0], gu, *gx[3], *gx[0]);
+  matmul_bw_from(*x[4], *x[1], gu, *gx[4], *gx[1]);
+  dev.inplace_add(gu, *gx[5]);
+}
+
+// Calculates the gradients of LSTM from the activated gates of all steps.
+void lstm_bw(
+    const vector<const Tensor *> &x, const Tensor &gates,
+    const Tensor &y, const Tensor &gy, const vector<Tensor *> &gx) {
+  // Gradients are propagated through time in the reverse order, and those of
+  // the input projection are calculated by one matrix product at the end.
+  Device &dev = gy.device();
+  const Tensor &in = *x[0], &wh = *x[4];
+  const unsigned n = x[2]->shape()[0];
+  const unsigned len = in.shape()[1];
+  Tensor gu = dev.new_tensor_by_constant(
+      shape_ops::elementwise(
+        shape_ops::matmul(x[3]->shape(), in.shape()),
+        shape_ops::broadcast(x[5]->shape(), 1, len)), 0);
+  Tensor g_next;  // Gradient of the output and cell state from the next step.
+  for (unsigned t = len; t-- > 0; ) {
+    const Tensor yt = dev.slice_fw(y, 1, t, t + 1);
+    const Tensor gates_t = dev.slice_fw(gates, 1, t, t + 1);
+    Tensor gyt = dev.slice_fw(gy, 1, t, t + 1);
+    if (t + 1 < len) dev.inplace_add(g_next, gyt);
+    Tensor gut = dev.new_tensor_by_constant(gates_t.shape(), 0);
+    if (t > 0) {
+      const Tensor yp = dev.slice_fw(y, 1, t - 1, t);
+      const Tensor hp = dev.slice_fw(yp, 0, 0, n);
+      const Tensor cp = dev.slice_fw(yp, 0, n, 2 * n);
+      Tensor ghp = dev.new_tensor_by_constant(hp.shape(), 0);
+      Tensor gcp = dev.new_tensor_by_constant(cp.shape(), 0);
+      dev.lstm_cell_bw(cp, gates_t, yt, gyt, gut, gcp);
+      matmul_bw_from(wh, hp, gut, *gx[4], ghp);
+      g_next = dev.concat_fw({&ghp, &gcp}, 0);
+    } else {
+      dev.lstm_cell_bw(*x[2], gates_t, yt, gyt, gut, *gx[2]);
+      matmul_bw_from(wh, *x[1], gut, *gx[4], *gx[1]);
+    }
+    dev.slice_bw(gut, 1, t, gu);
+  }
+  matmul_bw_from(*x[3], in, gu, *gx[3], *gx[0]);
+  dev.inplace_add(dev.sum_fw(gu, 1), *gx[5]);
+}
+
+}  // namespace
+
 #define BACKWARD(name) \
   void name::backward( \
       const Tensor &y, \
@@ -475,9 +771,16 @@ BACKWARD(LogSumExp) {
   *gx[0] +=
     operators::exp(*x[0] - operators::broadcast(y, dim_, n)) * operators::broadcast(gy, dim_, n);
 }
+BACKWARD(Softmax) {
+  gy.device().softmax_bw(*x[0], y, gy, dim_, *gx[0]);
+}
+BACKWARD(LogSoftmax) {
+  gy.device().log_softmax_bw(*x[0], y, gy, dim_, *gx[0]);
+}
 BACKWARD(Broadcast) { *gx[0] += operators::sum(gy, dim_); }
 
 BACKWARD(BatchSum) { *gx[0] += gy; }
+BACKWARD(BatchToColumns) { gy.device().batch_to_columns_bw(gy, *gx[0]); }
 
 BACKWARD(SoftmaxCrossEntropy) {
   const Tensor log_softmax_x = operators::log_softmax(*x[0], dim_);
@@ -488,18 +791,89 @@ BACKWARD(SoftmaxCrossEntropy) {
 
 BACKWARD(SparseSoftmaxCrossEntropy) {
   // dE/dx = gy * (softmax(x) - delta(x, i))
-  //       = gy * softmax(x) - gy * delta(x, i)
-#ifdef PRIMITIV_USE_CACHE
-  *gx[0] +=
-    operators::exp(log_softmax_x_) * operators::broadcast(gy, dim_, x[0]->shape()[dim_]);
-#else
-  *gx[0] +=
-    operators::softmax(*x[0], dim_) * operators::broadcast(gy, dim_, x[0]->shape()[dim_]);
-#endif  // PRIMITIV_USE_CACHE
-  gy.device().pick_bw(-gy, ids_, dim_, *gx[0]);
+  gy.device().sparse_softmax_cross_entropy_bw(
+      *x[0], lse_, ids_, gy, dim_, *gx[0]);
+}
+BACKWARD(ChunkedSoftmaxCrossEntropy) {
+  // dE/dz = gy * (softmax(z) - delta(z, i)), z = matmul(w, x) + b
+  // Logits are recalculated for each chunk.
+  Device &dev = gy.device();
+  const Tensor &in = *x[0], &w = *x[1], &b = *x[2];
+  const Tensor tw = dev.pick_fw(w, ids_, 0);
+  const Tensor tz = dev.matmul_fw(tw, in);
+  const Tensor neg_gy = dev.negate_fw(gy);
+  const Tensor lse = dev.add_fw(y, dev.add_fw(tz, dev.pick_fw(b, ids_, 0)));
+  const unsigned n = w.shape()[0];
+  for (unsigned lower = 0; lower < n; lower += chunk_size_) {
+    const unsigned upper = std::min(n, lower + chunk_size_);
+    const unsigned size = upper - lower;
+    const Tensor cw = dev.slice_fw(w, 0, lower, upper);
+    const Tensor cz = dev.matmul_fw(cw, in);
+    const Tensor cg = dev.multiply_fw(
+        dev.exp_fw(dev.subtract_fw(
+            dev.add_fw(cz, dev.slice_fw(b, 0, lower, upper)),
+            dev.broadcast_fw(lse, 0, size))),
+        dev.broadcast_fw(gy, 0, size));
+    const Tensor cgx = in.shape().has_batch() ? cg : dev.batch_sum_fw(cg);
+    Tensor gcw = dev.new_tensor_by_constant(cw.shape(), 0);
+    dev.matmul_bw(cw, in, cz, cgx, gcw, *gx[0]);
+    dev.slice_bw(gcw, 0, lower, *gx[1]);
+    dev.slice_bw(cg, 0, lower, *gx[2]);
+  }
+  Tensor gtw = dev.new_tensor_by_constant(tw.shape(), 0);
+  dev.matmul_bw(tw, in, tz, neg_gy, gtw, *gx[0]);
+  // If only one ID is given, all minibatches are picked from the same row.
+  if (ids_.size() == 1) {
+    dev.pick_bw(dev.batch_sum_fw(gtw), ids_, 0, *gx[1]);
+    dev.pick_bw(dev.batch_sum_fw(neg_gy), ids_, 0, *gx[2]);
+  } else {
+    dev.pick_bw(gtw, ids_, 0, *gx[1]);
+    dev.pick_bw(neg_gy, ids_, 0, *gx[2]);
+  }
+}
+
+BACKWARD(LSTMCell) {
+  // The gates are recalculated because they are not given.
+  Tensor gates;
+  lstm_cell_fw(x, gates);
+  lstm_cell_bw(x, gates, y, gy, gx);
+}
+
+BACKWARD(LSTM) {
+  // The gates are recalculated because they are not given.
+  Tensor gates;
+  lstm_fw(x, gates);
+  lstm_bw(x, gates, y, gy, gx);
 }
 
 #undef BACKWARD
 
+vector<Tensor> LSTMCell::forward_multi(const vector<const Tensor *> &args) {
+  CHECK_ARGNUM(args, 6);
+  Tensor gates;
+  Tensor y = lstm_cell_fw(args, gates);
+  return { std::move(y), std::move(gates) };
+}
+
+void LSTMCell::backward_multi(
+    const vector<const Tensor *> &ys, const vector<const Tensor *> &gys,
+    const vector<const Tensor *> &x, const vector<Tensor *> &gx) const {
+  // The gates have no gradient because they are used only in this function.
+  if (gys[0]) lstm_cell_bw(x, *ys[1], *ys[0], *gys[0], gx);
+}
+
+vector<Tensor> LSTM::forward_multi(const vector<const Tensor *> &args) {
+  CHECK_ARGNUM(args, 6);
+  Tensor gates;
+  Tensor y = lstm_fw(args, gates);
+  return { std::move(y), std::move(gates) };
+}
+
+void LSTM::backward_multi(
+    const vector<const Tensor *> &ys, const vector<const Tensor *> &gys,
+    const vector<const Tensor *> &x, const vector<Tensor *> &gx) const {
+  if (gys[0]) lstm_bw(x, *ys[1], *ys[0], *gys[0], gx);
+}
+
 }  // namespace functions
 }  // namespace primitive
@@ -31,6 +31,7 @@ class Input : public primitiv::Function {
 public:
   Input(const Shape &shape, const std::vector<float> &data, Device &device);
   Device *get_device() const override { return &device_; }
+  void reset_data(const std::vector<float> &data) override;
   std::string name() const override { return "Input"; }
 private:
   Shape shape_;
@@ -44,6 +45,9 @@ public:
   explicit ParameterInput(Parameter &param) : param_(param) {}
   Device *get_device() const override { return &param_.device(); }
   const Tensor *get_inner_value() const override { return &param_.value(); }
+  Parameter *get_sparse_parameter() const override {
+    return param_.sparse_gradient() ? &param_ : nullptr;
+  }
   std::string name() const override { return "ParameterInput"; }
 private:
   primitiv::Parameter &param_;
@@ -162,6 +166,9 @@ class Pick : public primitiv::Function {
 public:
   Pick(const std::vector<unsigned> &ids, unsigned dim)
     : ids_(ids), dim_(dim) {}
+  void reset_ids(const std::vector<unsigned> &ids) override;
+  bool backward_sparse(
+      const Tensor &cur_grad, Parameter &param) const override;
   std::string name() const override {
     return "Pick(" + std::to_string(dim_) + ')';
   };
@@ -196,6 +203,27 @@ private:
   unsigned dim_;
 };
 
+class Split : public primitiv::Function {
+  NO_CTOR_CLASS_DECL(Split);
+public:
+  Split(unsigned dim, unsigned n) : dim_(dim), n_(n) {}
+  std::vector<Shape> forward_shapes(
+      const std::vector<const Shape *> &args) const override;
+  std::vector<Tensor> forward_multi(
+      const std::vector<const Tensor *> &args) override;
+  void backward_multi(
+      const std::vector<const Tensor *> &cur_values,
+      const std::vector<const Tensor *> &cur_grads,
+      const std::vector<const Tensor *> &arg_values,
+      const std::vector<Tensor *> &arg_grads) const override;
+  std::string name() const override {
+    return "Split(" + std::to_string(dim_) + ',' + std::to_string(n_) + ')';
+  }
+private:
+  unsigned dim_;
+  unsigned n_;
+};
+
 class Reshape : public primitiv::Function {
   NO_CTOR_CLASS_DECL(Reshape);
 public:
@@ -229,6 +257,28 @@ private:
   unsigned dim_;
 };
 
+class Softmax : public Function {
+  NO_CTOR_CLASS_DECL(Softmax);
+public:
+  explicit Softmax(unsigned dim) : dim_(dim) {}
+  std::string name() const override {
+    return "Softmax(" + std::to_string(dim_) + ')';
+  }
+private:
+  unsigned dim_;
+};
+
+class LogSoftmax : public Function {
+  NO_CTOR_CLASS_DECL(LogSoftmax);
+public:
+  explicit LogSoftmax(unsigned dim) : dim_(dim) {}
+  std::string name() const override {
+    return "LogSoftmax(" + std::to_string(dim_) + ')';
+  }
+private:
+  unsigned dim_;
+};
+
 class Broadcast : public Function {
   NO_CTOR_CLASS_DECL(Broadcast);
 public:
@@ -258,15 +308,55 @@ class SparseSoftmaxCrossEntropy : public Function {
 public:
   explicit SparseSoftmaxCrossEntropy(
       const std::vector<unsigned> ids, unsigned dim) : ids_(ids), dim_(dim) {}
+  void reset_ids(const std::vector<unsigned> &ids) override;
   std::string name() const override {
     return "SparseSoftmaxCrossEntropy(" + std::to_string(dim_) + ')';
   }
 private:
   std::vector<unsigned> ids_;
   unsigned dim_;
-  Tensor log_softmax_x_;  // Only used when PRIMITIV_USE_CACHE=ON
+  Tensor lse_;  // logsumexp(x, dim_) calculated by forward()
+};
+
+class ChunkedSoftmaxCrossEntropy : public Function {
+  NO_CTOR_CLASS_DECL(ChunkedSoftmaxCrossEntropy);
+public:
+  ChunkedSoftmaxCrossEntropy(
+      const std::vector<unsigned> ids, unsigned chunk_size)
+    : ids_(ids), chunk_size_(chunk_size) {}
+  void reset_ids(const std::vector<unsigned> &ids) override;
+  std::string name() const override {
+    return "ChunkedSoftmaxCrossEntropy(" + std::to_string(chunk_size_) + ')';
+  }
+private:
+  std::vector<unsigned> ids_;
+  unsigned chunk_size_;
 };
 
+// The activated gates are returned as the second value, which is discarded by
+// the graph together with the output. `backward()` recalculates them.
+#define DECL_LSTM_FUNC(name_) \
+  class name_ : public Function { \
+    DEFAULT_CLASS_DECL(name_); \
+  public: \
+    name_() {} \
+    std::vector<Shape> forward_shapes( \
+        const std::vector<const Shape *> &args) const override; \
+    std::vector<Tensor> forward_multi( \
+        const std::vector<const Tensor *> &args) override; \
+    void backward_multi( \
+        const std::vector<const Tensor *> &cur_values, \
+        const std::vector<const Tensor *> &cur_grads, \
+        const std::vector<const Tensor *> &arg_values, \
+        const std::vector<Tensor *> &arg_grads) const override; \
+    std::string name() const override { return #name_; } \
+  }
+
+DECL_LSTM_FUNC(LSTMCell);
+DECL_LSTM_FUNC(LSTM);
+
+#undef DECL_LSTM_FUNC
+
 // Function with no parameter.
 #define DECL_FUNC(name_) \
   class name_ : public Function { \
@@ -331,6 +421,7 @@ DECL_FUNC(ReLU);
 DECL_FUNC(LReLU);
 
 DECL_FUNC(BatchSum);
+DECL_FUNC(BatchToColumns);
 
 #undef DECL_FUNC
 #undef DECL_FUNC_K
@@ -1,15 +1,24 @@
 /*
  * NOTE(odashi):
- * Inner structure of Graph is designed to handle multivalued functions for
- * future extensions, but for now this code handels only one results of each
- * function.
+ * Each function may have multiple resulting values. They are calculated and
+ * discarded together, and their gradients are propagated together.
+ * Values of multivalued functions are not managed by the memory planning.
  */
 
 #include <config.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
 #include <sstream>
 #include <utility>
 #include <primitiv/error.h>
@@ -32,10 +41,283 @@ Graph *DefaultSettable<Graph>::default_obj_ = nullptr;
 }  // namespace primitiv
 #endif  // PRIMITIV_NEED_EXPLICIT_STATIC_SYMBOLS
 
+namespace {
+
+/**
+ * Set of task queues owned by each worker thread.
+ * Each worker takes tasks from the back of its own queue, and steals tasks
+ * from the front of other queues if its own queue is empty.
+ */
+class TaskQueues {
+public:
+  TaskQueues(unsigned num_queues, unsigned num_tasks)
+    : queues_(num_queues)
+    , queue_mutexes_(new std::mutex[num_queues])
+    , num_queued_(0)
+    , num_rest_(num_tasks)
+    , aborted_(false) {}
+
+  // Adds a ready task to the queue of the worker.
+  void push(unsigned worker, unsigned task) {
+    {
+      std::lock_guard<std::mutex> lock(queue_mutexes_[worker]);
+      queues_[worker].emplace_back(task);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++num_queued_;
+    }
+    cv_.notify_one();
+  }
+
+  // Takes a ready task. Returns false if no more task is available.
+  bool pop(unsigned worker, unsigned &task) {
+    while (true) {
+      if (try_pop(worker, task)) return true;
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] {
+          return num_queued_ > 0 || num_rest_ == 0 || aborted_;
+      });
+      if (num_rest_ == 0 || aborted_) return false;
+    }
+  }
+
+  // Notifies that a task is finished.
+  void finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--num_rest_ == 0) cv_.notify_all();
+  }
+
+  // Stops all workers.
+  void abort() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    aborted_ = true;
+    cv_.notify_all();
+  }
+
+private:
+  bool try_pop(unsigned worker, unsigned &task) {
+    const unsigned n = queues_.size();
+    for (unsigned k = 0; k < n; ++k) {
+      const unsigned q = (worker + k) % n;
+      {
+        std::lock_guard<std::mutex> lock(queue_mutexes_[q]);
+        std::deque<unsigned> &queue = queues_[q];
+        if (queue.empty()) continue;
+        if (k == 0) {
+          task = queue.back();
+          queue.pop_back();
+        } else {
+          task = queue.front();
+          queue.pop_front();
+        }
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      --num_queued_;
+      return true;
+    }
+    return false;
+  }
+
+  std::vector<std::deque<unsigned>> queues_;
+  std::unique_ptr<std::mutex[]> queue_mutexes_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  unsigned num_queued_;
+  unsigned num_rest_;
+  bool aborted_;
+};
+
+/**
+ * Runs tasks with dependencies on the thread pool.
+ * @param pool ThreadPool object.
+ * @param num_tasks Number of tasks to be processed.
+ * @param ready Tasks which can be processed first.
+ * @param fn Function to process a task. The second argument receives tasks
+ *           which become ready by processing the task.
+ */
+void run_tasks(
+    primitiv::ThreadPool &pool, unsigned num_tasks,
+    const std::vector<unsigned> &ready,
+    const std::function<void(unsigned, std::vector<unsigned> &)> &fn) {
+  if (num_tasks == 0) return;
+  const unsigned num_workers = pool.num_threads();
+  TaskQueues queues(num_workers, num_tasks);
+  for (unsigned i = 0; i < ready.size(); ++i) {
+    queues.push(i % num_workers, ready[i]);
+  }
+
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  pool.parallel_for(num_workers, 1, [&](unsigned begin, unsigned end) {
+    for (unsigned worker = begin; worker < end; ++worker) {
+      unsigned task;
+      vector<unsigned> next;
+      while (queues.pop(worker, task)) {
+        try {
+          next.clear();
+          fn(task, next);
+          for (unsigned t : next) queues.push(worker, t);
+          queues.finish();
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error) error = std::current_exception();
+          queues.abort();
+        }
+      }
+    }
+  });
+
+  if (error) std::rethrow_exception(error);
+}
+
+// Granularity of buffers in the planned memory.
+const std::uint64_t PLAN_UNIT = 256;
+
+// Offset of buffers which are not planned.
+const std::uint64_t NO_OFFSET = std::numeric_limits<std::uint64_t>::max();
+
+/**
+ * Buffer of a value or a gradient in the memory planning.
+ */
+struct PlanBuffer {
+  unsigned fid;
+  bool grad;
+  primitiv::Device *device;
+  std::uint64_t size;
+  unsigned begin;  // First step using the buffer.
+  unsigned end;  // Last step using the buffer.
+  std::uint64_t offset;
+};
+
+/**
+ * Assigns offsets to buffers so that buffers on the same device alive at the
+ * same time never overlap.
+ * @param buffers List of buffers. `offset` of each buffer is overwritten.
+ * @return Required size of the memory on each device.
+ * @remarks Buffers are placed greedily from the largest one at the lowest
+ *          offset which does not conflict with already-placed buffers.
+ */
+std::unordered_map<primitiv::Device *, std::uint64_t> assign_offsets(
+    std::vector<PlanBuffer> &buffers) {
+  vector<unsigned> order(buffers.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+      const PlanBuffer &ba = buffers[a], &bb = buffers[b];
+      return ba.size != bb.size ? ba.size > bb.size : ba.begin < bb.begin;
+  });
+
+  std::unordered_map<primitiv::Device *, std::uint64_t> sizes;
+  vector<unsigned> placed;
+  vector<std::pair<std::uint64_t, std::uint64_t>> used;
+  for (unsigned i : order) {
+    PlanBuffer &cur = buffers[i];
+    used.clear();
+    for (unsigned j : placed) {
+      const PlanBuffer &other = buffers[j];
+      if (other.device == cur.device &&
+          other.begin <= cur.end && cur.begin <= other.end) {
+        used.emplace_back(other.offset, other.offset + other.size);
+      }
+    }
+    std::sort(used.begin(), used.end());
+    std::uint64_t offset = 0;
+    for (const auto &range : used) {
+      if (offset + cur.size <= range.first) break;
+      offset = std::max(offset, range.second);
+    }
+    cur.offset = offset;
+    placed.emplace_back(i);
+    std::uint64_t &size = sizes[cur.device];
+    size = std::max(size, offset + cur.size);
+  }
+  return sizes;
+}
+
+/**
+ * Escapes the string to be embedded in JSON.
+ * @param str A string.
+ * @return Escaped string with surrounding double quotes.
+ */
+std::string json_string(const std::string &str) {
+  std::string ret = "\"";
+  for (const char c : str) {
+    if (c == '"' || c == '\\') ret += '\\';
+    ret += c;
+  }
+  return ret + '"';
+}
+
+}  // namespace
+
 namespace primitiv {
 
+class Graph::TraceScope {
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+public:
+  TraceScope(Graph &g, unsigned fid, bool backward)
+    : g_(g.tracing_ ? &g : nullptr), fid_(fid), backward_(backward) {
+    if (!g_) return;
+    g.funcs_[fid].rets[0].device.synchronize();
+    allocated_ = Device::allocated_bytes();
+    begin_ = std::chrono::steady_clock::now();
+  }
+
+  ~TraceScope() {
+    if (!g_) return;
+    try {
+      const FunctionInfo &f = g_->funcs_[fid_];
+      const NodeInfo &n = f.rets[0];
+      n.device.synchronize();
+      const auto end = std::chrono::steady_clock::now();
+      std::stringstream arg_shapes, device;
+      for (unsigned i = 0; i < f.args.size(); ++i) {
+        if (i > 0) arg_shapes << ", ";
+        arg_shapes << g_->funcs_[f.args[i].fid].rets[f.args[i].vid].shape
+          .to_string();
+      }
+      device << &n.device;
+      g_->add_trace_event(TraceEvent {
+          f.func->name(), arg_shapes.str(), n.shape.to_string(), device.str(),
+          fid_, backward_, 0, 0, 0, Device::allocated_bytes() - allocated_,
+      }, begin_, end);
+    } catch (...) {
+      // Errors while tracing are ignored not to hide the original error.
+    }
+  }
+
+private:
+  Graph *g_;
+  unsigned fid_;
+  bool backward_;
+  std::uint64_t allocated_;
+  std::chrono::steady_clock::time_point begin_;
+};
+
 void Graph::clear() {
   funcs_.clear();
+  schedules_.clear();
+  plan_.reset();
+  frozen_ = false;
+}
+
+void Graph::freeze() {
+  // Existing schedules may omit functions which already have values, and they
+  // can not be used after `rewind()`.
+  schedules_.clear();
+  frozen_ = true;
+}
+
+void Graph::rewind() {
+  for (FunctionInfo &f : funcs_) {
+    for (NodeInfo &n : f.rets) {
+      n.value = Tensor();
+      n.grad = Tensor();
+    }
+  }
+  if (!frozen_) schedules_.clear();
 }
 
 #define CHECK_NODE(n) { \
@@ -58,8 +340,29 @@ void Graph::clear() {
 
 #define ACCESS(n) (funcs_[n.fid_].rets[n.vid_])
 
+void Graph::set_data(const Node &node, const std::vector<float> &data) {
+  CHECK_NODE(node);
+  funcs_[node.fid_].func->reset_data(data);
+  rewind();
+}
+
+void Graph::set_ids(const Node &node, const std::vector<unsigned> &ids) {
+  CHECK_NODE(node);
+  funcs_[node.fid_].func->reset_ids(ids);
+  rewind();
+}
+
 Node Graph::add_function(
     std::unique_ptr<Function> &&func, const std::vector<Node> &args) {
+  return add_multivalued_function(move(func), args)[0];
+}
+
+std::vector<Node> Graph::add_multivalued_function(
+    std::unique_ptr<Function> &&func, const std::vector<Node> &args) {
+  if (frozen_) {
+    THROW_ERROR("Attempted to add a function to the frozen graph.");
+  }
+
   // Gathers information of args.
   vector<Address> arg_addrs(args.size());
   vector<const Shape *> arg_shapes(args.size());
@@ -70,9 +373,12 @@ Node Graph::add_function(
     arg_shapes[i] = &ACCESS(arg).shape;
   }
 
-  // Calculates the shape of the resulting value.
+  // Calculates the shapes of the resulting values.
   // This may throw an exception when trying an invalid operation.
-  Shape ret_shape = func->forward_shape(arg_shapes);
+  vector<Shape> ret_shapes = func->forward_shapes(arg_shapes);
+  if (ret_shapes.empty()) {
+    THROW_ERROR("Function '" << func->name() << "' has no resulting value.");
+  }
 
   // Retrieves the device object which manages return values itself.
   Device *ret_device = func->get_device();
@@ -87,49 +393,264 @@ Node Graph::add_function(
   }
 
   // Makes nodes of return values.
+  const unsigned ret_fid = funcs_.size();
   vector<NodeInfo> rets;
-  rets.emplace_back(NodeInfo {
-      move(ret_shape), *ret_device, Tensor(), Tensor(), vector<unsigned>(),
-  });
+  vector<Node> ret_nodes;
+  rets.reserve(ret_shapes.size());
+  ret_nodes.reserve(ret_shapes.size());
+  for (Shape &ret_shape : ret_shapes) {
+    ret_nodes.emplace_back(Node(*this, ret_fid, rets.size()));
+    rets.emplace_back(NodeInfo {
+        move(ret_shape), *ret_device, Tensor(), Tensor(), vector<unsigned>(),
+    });
+  }
 
   // Updates the graph.
-  const unsigned ret_fid = funcs_.size();
   for (const Address &arg_addr : arg_addrs) {
     funcs_[arg_addr.fid].rets[arg_addr.vid].sinks.emplace_back(ret_fid);
   }
   funcs_.emplace_back(FunctionInfo { move(func), move(arg_addrs), move(rets) });
 
-  return Node(*this, ret_fid, 0);
+  return ret_nodes;
 }
 
 const Tensor &Graph::forward(const Node &node) {
+  return forward(node, true);
+}
+
+const Tensor &Graph::forward(const Node &node, bool retain) {
   CHECK_NODE(node);
+  forward_inner({ node.fid_ }, retain);
+  return get_value(node.fid_, node.vid_);
+}
+
+std::vector<const Tensor *> Graph::forward(const std::vector<Node> &nodes) {
+  return forward(nodes, true);
+}
+
+std::vector<const Tensor *> Graph::forward(
+    const std::vector<Node> &nodes, bool retain) {
+  vector<unsigned> fids;
+  fids.reserve(nodes.size());
+  for (const Node &node : nodes) {
+    CHECK_NODE(node);
+    fids.emplace_back(node.fid_);
+  }
+  forward_inner(fids, retain);
+  vector<const Tensor *> values;
+  values.reserve(nodes.size());
+  for (const Node &node : nodes) {
+    values.emplace_back(&get_value(node.fid_, node.vid_));
+  }
+  return values;
+}
 
-  std::function<const Tensor *(unsigned)> forward_recursive = [&](
-      unsigned fid) -> const Tensor * {
-    FunctionInfo &cur_f = funcs_[fid];
-    NodeInfo &cur_n = cur_f.rets[0];
+const Tensor &Graph::get_value(unsigned fid, unsigned vid) const {
+  const FunctionInfo &f = funcs_[fid];
+  const Tensor *inner_v = f.func->get_inner_value();
+  return inner_v ? *inner_v : f.rets[vid].value;
+}
 
-    // Try to get the inner value of the function.
-    const Tensor *inner_v = cur_f.func->get_inner_value();
-    if (inner_v) return inner_v;
+bool Graph::has_value(unsigned fid) const {
+  const FunctionInfo &f = funcs_[fid];
+  return f.rets[0].value.valid() || f.func->get_inner_value();
+}
 
-    if (!cur_n.value.valid()) {
-      // Gathers arguments.
-      vector<const Tensor *> arg_values;
-      arg_values.reserve(cur_f.args.size());
-      for (const Address &arg : cur_f.args) {
-        arg_values.emplace_back(forward_recursive(arg.fid));
+bool Graph::has_grad(unsigned fid) const {
+  for (const NodeInfo &n : funcs_[fid].rets) {
+    if (n.grad.valid()) return true;
+  }
+  return false;
+}
+
+const std::vector<unsigned> &Graph::get_schedule(unsigned fid) {
+  auto it = schedules_.find(fid);
+  if (it != schedules_.end()) return it->second;
+
+  // Finds functions which have no value and are required by the target.
+  // Values which already exist are never discarded until `clear()` or
+  // `rewind()`, so that the schedule can be re-used by future calculation.
+  vector<unsigned> &schedule = schedules_[fid];
+  vector<bool> visited(fid + 1, false);
+  vector<unsigned> stack { fid };
+  visited[fid] = true;
+  while (!stack.empty()) {
+    const unsigned cur = stack.back();
+    stack.pop_back();
+    if (frozen_
+        ? !!funcs_[cur].func->get_inner_value()
+        : has_value(cur)) continue;
+    schedule.emplace_back(cur);
+    for (const Address &arg : funcs_[cur].args) {
+      if (!visited[arg.fid]) {
+        visited[arg.fid] = true;
+        stack.emplace_back(arg.fid);
       }
+    }
+  }
 
-      // Calculates the value.
-      cur_n.value = cur_f.func->forward(arg_values);
+  // In the current implementation, the function ID corresponds to the
+  // topological order of the computation graph.
+  std::sort(schedule.begin(), schedule.end());
+  return schedule;
+}
+
+void Graph::forward_inner(const std::vector<unsigned> &fids, bool retain) {
+  // Makes the calculation schedule of all targets.
+  vector<unsigned> merged;
+  const vector<unsigned> *schedule = &merged;
+  vector<unsigned> targets;
+  for (unsigned fid : fids) {
+    if (!has_value(fid)) targets.emplace_back(fid);
+  }
+  if (targets.empty()) return;
+  if (targets.size() == 1) {
+    schedule = &get_schedule(targets[0]);
+  } else {
+    for (unsigned fid : targets) {
+      const vector<unsigned> &s = get_schedule(fid);
+      merged.insert(merged.end(), s.begin(), s.end());
     }
+    std::sort(merged.begin(), merged.end());
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+  }
 
-    return &cur_n.value;
+  // Position of the function in the schedule, or -1 if it is not scheduled.
+  auto find_pos = [schedule](unsigned fid) -> int {
+    auto it = std::lower_bound(schedule->begin(), schedule->end(), fid);
+    return it != schedule->end() && *it == fid ? it - schedule->begin() : -1;
   };
 
-  return *forward_recursive(node.fid_);
+  // Functions to be calculated in this call.
+  const unsigned num_funcs = schedule->size();
+  vector<bool> calc(num_funcs);
+  for (unsigned i = 0; i < num_funcs; ++i) {
+    calc[i] = !has_value((*schedule)[i]);
+  }
+
+  // Counts the number of consumers of each value in this call.
+  vector<std::atomic<unsigned>> num_rest(retain ? 0 : num_funcs);
+  if (!retain) {
+    for (unsigned i = 0; i < num_funcs; ++i) num_rest[i] = 0;
+    for (unsigned i = 0; i < num_funcs; ++i) {
+      if (!calc[i]) continue;
+      for (const Address &arg : funcs_[(*schedule)[i]].args) {
+        const int pos = find_pos(arg.fid);
+        if (pos >= 0) ++num_rest[pos];
+      }
+    }
+    // Targets are never discarded.
+    for (unsigned fid : targets) ++num_rest[find_pos(fid)];
+  }
+
+  // Calculates the value of the i-th function in the schedule.
+  auto calc_one = [&](unsigned i) {
+    const FunctionInfo &cur_f = funcs_[(*schedule)[i]];
+    forward_function((*schedule)[i]);
+    if (!retain) {
+      // Discards arguments which are no longer used.
+      for (const Address &arg : cur_f.args) {
+        const int pos = find_pos(arg.fid);
+        if (pos >= 0 && calc[pos] && --num_rest[pos] == 0) {
+          for (NodeInfo &n : funcs_[arg.fid].rets) n.value = Tensor();
+        }
+      }
+    }
+  };
+
+  if (!pool_) {
+    for (unsigned i = 0; i < num_funcs; ++i) {
+      if (calc[i]) calc_one(i);
+    }
+    return;
+  }
+
+  // Counts the number of arguments which are not yet calculated.
+  vector<std::atomic<unsigned>> num_deps(num_funcs);
+  vector<unsigned> ready;
+  unsigned num_tasks = 0;
+  for (unsigned i = 0; i < num_funcs; ++i) {
+    num_deps[i] = 0;
+    if (!calc[i]) continue;
+    ++num_tasks;
+    for (const Address &arg : funcs_[(*schedule)[i]].args) {
+      const int pos = find_pos(arg.fid);
+      if (pos >= 0 && calc[pos]) ++num_deps[i];
+    }
+    if (num_deps[i] == 0) ready.emplace_back(i);
+  }
+
+  ::run_tasks(
+      *pool_, num_tasks, ready, [&](unsigned i, vector<unsigned> &next) {
+    calc_one(i);
+    // Sinks which received all arguments become ready.
+    for (const NodeInfo &n : funcs_[(*schedule)[i]].rets) {
+      for (unsigned sink : n.sinks) {
+        const int pos = find_pos(sink);
+        if (pos >= 0 && calc[pos] && --num_deps[pos] == 0) {
+          next.emplace_back(pos);
+        }
+      }
+    }
+  });
+}
+
+void Graph::forward_function(unsigned fid) {
+  TraceScope trace(*this, fid, false);
+  FunctionInfo &cur_f = funcs_[fid];
+
+  // Gathers arguments.
+  vector<const Tensor *> arg_values;
+  arg_values.reserve(cur_f.args.size());
+  for (const Address &arg : cur_f.args) {
+    arg_values.emplace_back(&get_value(arg.fid, arg.vid));
+  }
+
+  // Calculates all values of the multivalued function.
+  if (cur_f.rets.size() > 1) {
+    vector<Tensor> values = cur_f.func->forward_multi(arg_values);
+    if (values.size() != cur_f.rets.size()) {
+      THROW_ERROR(
+          "Function '" << cur_f.func->name() << "' returned "
+          << values.size() << " value(s), but " << cur_f.rets.size()
+          << " value(s) are required.");
+    }
+    for (unsigned i = 0; i < values.size(); ++i) {
+      cur_f.rets[i].value = move(values[i]);
+    }
+    return;
+  }
+
+  // Calculates the value.
+  NodeInfo &cur_n = cur_f.rets[0];
+  if (!reserve_memory(fid, false)) {
+    cur_n.value = cur_f.func->forward(arg_values);
+    return;
+  }
+  try {
+    cur_n.value = cur_f.func->forward(arg_values);
+    if (cur_n.device.has_reservation()) {
+      // The function made no new tensor (e.g., reshape() shares the memory of
+      // its argument). The value is moved to the planned memory because the
+      // lifetime of the original memory may be shorter.
+      cur_n.value = cur_n.device.copy_tensor(cur_n.value);
+    }
+  } catch (...) {
+    cur_n.device.cancel_reservation();
+    throw;
+  }
+  cur_n.device.cancel_reservation();
+}
+
+bool Graph::reserve_memory(unsigned fid, bool grad) {
+  if (!plan_ || fid > plan_->last_fid) return false;
+  const std::uint64_t offset
+    = grad ? plan_->grad_offsets[fid] : plan_->value_offsets[fid];
+  if (offset == ::NO_OFFSET) return false;
+  NodeInfo &n = funcs_[fid].rets[0];
+  n.device.reserve_range(
+      plan_->arenas.at(&n.device), offset / sizeof(float), n.shape.size());
+  return true;
 }
 
 void Graph::backward(const Node &node) {
@@ -153,49 +674,291 @@ void Graph::backward(const Node &node) {
     }
   }
 
-  // Makes the identity gradient (dx/dx = 1) at the last node.
-  last_n.grad = operators::ones<Tensor>(last_v->shape(), last_n.device);
+  if (!plan_ || plan_->last_fid != node.fid_) {
+    // Makes the identity gradient (dx/dx = 1) at the last node.
+    last_n.grad = operators::ones<Tensor>(last_v->shape(), last_n.device);
+
+    if (pool_) {
+      backward_parallel(node.fid_);
+      return;
+    }
+
+    // Performs backpropagation.
+    // In the current implementation, the node ID corresponds to the inverse
+    // topological order of the computation graph.
+    for (int fid = node.fid_; fid >= 0; --fid) {
+      // If the gradient is invalid, this function is out of the forward path.
+      if (!has_grad(fid)) continue;
+      backward_function(fid, false);
+    }
+    return;
+  }
+
+  // Performs backpropagation using the planned memory.
+  try {
+    reserve_memory(node.fid_, true);
+    last_n.grad = operators::ones<Tensor>(last_v->shape(), last_n.device);
+    last_n.device.cancel_reservation();
+    for (int fid = node.fid_; fid >= 0; --fid) {
+      if (!has_grad(fid)) continue;
+      backward_function(fid, true);
+    }
+  } catch (...) {
+    // Remaining values and gradients may conflict with the planned memory of
+    // the next calculation.
+    last_n.device.cancel_reservation();
+    rewind();
+    throw;
+  }
+}
+
+void Graph::backward_parallel(unsigned last_fid) {
+  // Finds functions on the forward path of the last node.
+  vector<bool> visited(last_fid + 1, false);
+  vector<unsigned> fids;
+  vector<unsigned> stack { last_fid };
+  visited[last_fid] = true;
+  while (!stack.empty()) {
+    const unsigned cur = stack.back();
+    stack.pop_back();
+    fids.emplace_back(cur);
+    for (const Address &arg : funcs_[cur].args) {
+      if (!visited[arg.fid]) {
+        visited[arg.fid] = true;
+        stack.emplace_back(arg.fid);
+      }
+    }
+  }
+  std::sort(fids.begin(), fids.end());
+  const unsigned num_funcs = fids.size();
+  auto find_pos = [&fids](unsigned fid) {
+    return std::lower_bound(fids.begin(), fids.end(), fid) - fids.begin();
+  };
+
+  // Counts the number of sinks which are not yet backpropagated.
+  vector<std::atomic<unsigned>> num_deps(num_funcs);
+  for (unsigned i = 0; i < num_funcs; ++i) num_deps[i] = 0;
+  for (unsigned fid : fids) {
+    for (const Address &arg : funcs_[fid].args) {
+      ++num_deps[find_pos(arg.fid)];
+    }
+  }
 
-  // Performs backpropagation.
   // NOTE(odashi):
-  // In the current implementation, the node ID corresponds to the inverse
-  // topological order of the computation graph.
-  for (int fid = node.fid_; fid >= 0; --fid) {
-    FunctionInfo &cur_f = funcs_[fid];
-    NodeInfo &cur_n = cur_f.rets[0];
-    const Tensor *cur_v = cur_n.value.valid()
-      ? &cur_n.value
-      : cur_f.func->get_inner_value();
-
-    // If the gradient is invalid, this function is out of the forward path.
-    if (!cur_n.grad.valid()) continue;
-
-    // Gathers argument value/gradient tensors.
-    const unsigned arg_size = cur_f.args.size();
-    vector<const Tensor *> arg_values;
-    vector<Tensor *> arg_grads;
-    arg_values.reserve(arg_size);
-    arg_grads.reserve(arg_size);
-    for (unsigned i = 0; i < arg_size; ++i) {
-      const Address &arg = cur_f.args[i];
-      FunctionInfo &arg_f = funcs_[arg.fid];
-      NodeInfo &arg_n = arg_f.rets[arg.vid];
-      const Tensor *arg_v = arg_n.value.valid()
-        ? &arg_n.value
-        : arg_f.func->get_inner_value();
-      if (!arg_n.grad.valid()) {
-        arg_n.grad = operators::zeros<Tensor>(arg_v->shape(), arg_n.device);
+  // Gradients of arguments are updated under their own locks, and the locks
+  // are acquired in the order of function IDs to avoid deadlocks.
+  // Functions without arguments (e.g., ParameterInput) may update the data
+  // outside the graph, and they are always serialized.
+  std::unique_ptr<std::mutex[]> grad_mutexes(new std::mutex[num_funcs]);
+  std::mutex source_mutex;
+
+  ::run_tasks(
+      *pool_, num_funcs, { num_funcs - 1 },
+      [&](unsigned i, vector<unsigned> &next) {
+    const FunctionInfo &cur_f = funcs_[fids[i]];
+    // All sinks were already processed, and the gradient is not changed by
+    // other threads. The gradient may be invalid if all sinks propagated
+    // their gradients to sparse gradients of the parameter.
+    if (has_grad(fids[i])) {
+      vector<unsigned> lock_ids;
+      for (const Address &arg : cur_f.args) {
+        lock_ids.emplace_back(find_pos(arg.fid));
       }
-      arg_values.emplace_back(arg_v);
-      arg_grads.emplace_back(&arg_n.grad);
+      std::sort(lock_ids.begin(), lock_ids.end());
+      lock_ids.erase(
+          std::unique(lock_ids.begin(), lock_ids.end()), lock_ids.end());
+      vector<std::unique_lock<std::mutex>> locks;
+      if (lock_ids.empty()) locks.emplace_back(source_mutex);
+      for (unsigned pos : lock_ids) locks.emplace_back(grad_mutexes[pos]);
+      backward_function(fids[i], false);
+    }
+    // Arguments which received all gradients become ready.
+    for (const Address &arg : cur_f.args) {
+      const unsigned pos = find_pos(arg.fid);
+      if (--num_deps[pos] == 0) next.emplace_back(pos);
+    }
+  });
+}
+
+void Graph::backward_function(unsigned fid, bool planned) {
+  TraceScope trace(*this, fid, true);
+  FunctionInfo &cur_f = funcs_[fid];
+  NodeInfo &cur_n = cur_f.rets[0];
+  const Tensor *cur_v = cur_n.value.valid()
+    ? &cur_n.value
+    : cur_f.func->get_inner_value();
+
+  // Propagates the gradient directly to the sparse gradient of a parameter.
+  // The gradient of the parameter node is not required in this case, and
+  // multiple nodes of the same parameter are serialized by the lock.
+  if (cur_f.args.size() == 1 && cur_f.rets.size() == 1) {
+    Parameter *param = funcs_[cur_f.args[0].fid].func->get_sparse_parameter();
+    if (param) {
+      std::lock_guard<std::mutex> lock(sparse_mutex_);
+      if (cur_f.func->backward_sparse(cur_n.grad, *param)) {
+        cur_n.grad = Tensor();
+        if (planned && fid != plan_->last_fid) cur_n.value = Tensor();
+        return;
+      }
+    }
+  }
+
+  // Gathers argument value/gradient tensors.
+  const unsigned arg_size = cur_f.args.size();
+  vector<const Tensor *> arg_values;
+  vector<Tensor *> arg_grads;
+  arg_values.reserve(arg_size);
+  arg_grads.reserve(arg_size);
+  for (unsigned i = 0; i < arg_size; ++i) {
+    const Address &arg = cur_f.args[i];
+    FunctionInfo &arg_f = funcs_[arg.fid];
+    NodeInfo &arg_n = arg_f.rets[arg.vid];
+    const Tensor *arg_v = arg_n.value.valid()
+      ? &arg_n.value
+      : arg_f.func->get_inner_value();
+    if (!arg_v) {
+      THROW_ERROR(
+          "The node [fid=" << arg.fid << ", vid=" << arg.vid
+          << "] has no value. The value might be discarded by "
+          "forward(node, false).");
     }
+    if (!arg_n.grad.valid()) {
+      const bool reserved = planned && reserve_memory(arg.fid, true);
+      arg_n.grad = operators::zeros<Tensor>(arg_v->shape(), arg_n.device);
+      if (reserved) arg_n.device.cancel_reservation();
+    }
+    arg_values.emplace_back(arg_v);
+    arg_grads.emplace_back(&arg_n.grad);
+  }
+
+  if (cur_f.rets.size() > 1) {
+    // Gathers all values/gradients of the multivalued function.
+    // Values which are not used by the output node are passed without
+    // gradients.
+    vector<const Tensor *> cur_values;
+    vector<const Tensor *> cur_grads;
+    cur_values.reserve(cur_f.rets.size());
+    cur_grads.reserve(cur_f.rets.size());
+    for (NodeInfo &n : cur_f.rets) {
+      cur_values.emplace_back(&n.value);
+      cur_grads.emplace_back(n.grad.valid() ? &n.grad : nullptr);
+    }
+
+    // Propagetes the gradients from all values.
+    cur_f.func->backward_multi(cur_values, cur_grads, arg_values, arg_grads);
 
-    // Propagetes the gradient from this node.
-    cur_f.func->backward(*cur_v, cur_n.grad, arg_values, arg_grads);
+    // Deletes current gradients to suppress memory.
+    for (NodeInfo &n : cur_f.rets) n.grad = Tensor();
+    return;
+  }
+
+  // Propagetes the gradient from this node.
+  cur_f.func->backward(*cur_v, cur_n.grad, arg_values, arg_grads);
+
+  // Deletes current gradient to suppress memory.
+  cur_n.grad = Tensor();
+
+  // The planned memory of the value may be re-used by other gradients.
+  if (planned && fid != plan_->last_fid) cur_n.value = Tensor();
+}
+
+void Graph::set_num_threads(unsigned num_threads) {
+  if (num_threads == 0) {
+    THROW_ERROR("Number of threads should be greater than 0.");
+  }
+  if (num_threads == this->num_threads()) return;
+  pool_.reset(num_threads > 1 ? new ThreadPool(num_threads) : nullptr);
+  if (pool_) plan_.reset();
+}
+
+void Graph::plan_memory(const Node &node) {
+  CHECK_NODE(node);
+  if (!frozen_) {
+    THROW_ERROR("Memory can be planned only for the frozen graph.");
+  }
+  if (pool_) {
+    THROW_ERROR("Memory can not be planned with multiple threads.");
+  }
+  plan_.reset();
+  const unsigned last_fid = node.fid_;
+
+  // Forward steps: values are calculated in the order of the schedule.
+  const vector<unsigned> &schedule = get_schedule(last_fid);
+
+  // Backward steps: gradients are propagated from the output node to all its
+  // ancestors in the inverse order of function IDs.
+  vector<bool> required(last_fid + 1, false);
+  required[last_fid] = true;
+  vector<unsigned> bw_steps(last_fid + 1, 0);
+  unsigned num_steps = schedule.size();
+  for (int fid = last_fid; fid >= 0; --fid) {
+    if (!required[fid]) continue;
+    bw_steps[fid] = num_steps++;
+    for (const Address &arg : funcs_[fid].args) required[arg.fid] = true;
+  }
+
+  // Calculates lifetimes of values and gradients.
+  // Each value is used until the backward step of the function itself, and
+  // each gradient is used from the backward step of the first sink.
+  // Values and gradients of multivalued functions are allocated by the device
+  // as usual.
+  vector<::PlanBuffer> buffers;
+  auto add_buffer = [&](unsigned fid, bool grad, unsigned begin, unsigned end) {
+    if (funcs_[fid].rets.size() > 1) return;
+    const NodeInfo &n = funcs_[fid].rets[0];
+    const std::uint64_t size
+      = (n.shape.size() * sizeof(float) + ::PLAN_UNIT - 1)
+      / ::PLAN_UNIT * ::PLAN_UNIT;
+    buffers.emplace_back(
+        ::PlanBuffer { fid, grad, &n.device, size, begin, end, 0 });
+  };
+  for (unsigned i = 0; i < schedule.size(); ++i) {
+    const unsigned fid = schedule[i];
+    add_buffer(
+        fid, false, i, fid == last_fid ? num_steps - 1 : bw_steps[fid]);
+  }
+  for (unsigned fid = 0; fid <= last_fid; ++fid) {
+    if (!required[fid]) continue;
+    unsigned begin = bw_steps[fid];
+    for (unsigned sink : funcs_[fid].rets[0].sinks) {
+      if (sink <= last_fid && required[sink]) {
+        begin = std::min(begin, bw_steps[sink]);
+      }
+    }
+    add_buffer(fid, true, begin, bw_steps[fid]);
+  }
 
-    // Deletes current gradient to suppress memory.
-    cur_n.grad = Tensor();
+  // Makes the plan.
+  std::unique_ptr<MemoryPlan> plan(new MemoryPlan {
+      last_fid,
+      vector<std::uint64_t>(last_fid + 1, ::NO_OFFSET),
+      vector<std::uint64_t>(last_fid + 1, ::NO_OFFSET),
+      std::unordered_map<Device *, Tensor>(),
+      0,
+      0,
+  });
+  for (const auto &kv : ::assign_offsets(buffers)) {
+    Device &dev = *kv.first;
+    plan->arenas.emplace(
+        &dev, dev.new_raw_tensor(Shape({
+            static_cast<unsigned>(kv.second / sizeof(float))})));
+    plan->planned_size += kv.second;
   }
+  for (const ::PlanBuffer &b : buffers) {
+    (b.grad ? plan->grad_offsets : plan->value_offsets)[b.fid] = b.offset;
+    plan->naive_size += b.size;
+  }
+  plan_ = move(plan);
+}
+
+std::uint64_t Graph::planned_memory_size() const {
+  if (!plan_) THROW_ERROR("Memory is not planned.");
+  return plan_->planned_size;
+}
+
+std::uint64_t Graph::naive_memory_size() const {
+  if (!plan_) THROW_ERROR("Memory is not planned.");
+  return plan_->naive_size;
 }
 
 const Shape &Graph::get_shape(const Node &node) const {
@@ -208,6 +971,85 @@ Device &Graph::get_device(const Node &node) const {
   return ACCESS(node).device;
 }
 
+void Graph::set_tracing(bool enabled) {
+  std::lock_guard<std::mutex> lock(trace_mutex_);
+  if (enabled && !tracing_ && trace_.empty()) {
+    trace_origin_ = std::chrono::steady_clock::now();
+  }
+  tracing_ = enabled;
+}
+
+void Graph::clear_trace() {
+  std::lock_guard<std::mutex> lock(trace_mutex_);
+  trace_.clear();
+  trace_threads_.clear();
+  trace_origin_ = std::chrono::steady_clock::now();
+}
+
+void Graph::add_trace_event(
+    TraceEvent &&event,
+    const std::chrono::steady_clock::time_point &begin,
+    const std::chrono::steady_clock::time_point &end) {
+  std::lock_guard<std::mutex> lock(trace_mutex_);
+  const auto it = trace_threads_.emplace(
+      std::this_thread::get_id(), trace_threads_.size()).first;
+  event.thread = it->second;
+  event.begin = std::chrono::duration<double, std::micro>(
+      begin - trace_origin_).count();
+  event.end = std::chrono::duration<double, std::micro>(
+      end - trace_origin_).count();
+  trace_.emplace_back(move(event));
+}
+
+std::string Graph::dump_trace() const {
+  std::lock_guard<std::mutex> lock(trace_mutex_);
+  std::stringstream ss;
+  ss << std::fixed;
+  ss.precision(3);
+  ss << "{\"traceEvents\":[";
+
+  // Each device is shown as a process.
+  std::unordered_map<std::string, unsigned> pids;
+  for (const TraceEvent &e : trace_) {
+    if (pids.find(e.device) != pids.end()) continue;
+    const unsigned pid = pids.size();
+    pids.emplace(e.device, pid);
+    ss << (pid > 0 ? ",\n" : "\n")
+       << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+       << ",\"args\":{\"name\":" << ::json_string("Device " + e.device)
+       << "}}";
+  }
+
+  for (const TraceEvent &e : trace_) {
+    ss << ",\n{\"name\":" << ::json_string(e.name)
+       << ",\"cat\":\"" << (e.backward ? "backward" : "forward")
+       << "\",\"ph\":\"X\",\"ts\":" << e.begin
+       << ",\"dur\":" << e.end - e.begin
+       << ",\"pid\":" << pids.at(e.device)
+       << ",\"tid\":" << e.thread
+       << ",\"args\":{\"fid\":" << e.fid
+       << ",\"args\":" << ::json_string(e.arg_shapes)
+       << ",\"shape\":" << ::json_string(e.shape)
+       << ",\"device\":" << ::json_string(e.device)
+       << ",\"allocated_bytes\":" << e.allocated
+       << "}}";
+  }
+
+  ss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return ss.str();
+}
+
+void Graph::save_trace(const std::string &path) const {
+  std::ofstream ofs(path);
+  if (!ofs.is_open()) {
+    THROW_ERROR("Could not open file: " << path);
+  }
+  ofs << dump_trace();
+  if (!ofs) {
+    THROW_ERROR("Failed to write the trace: " << path);
+  }
+}
+
 std::string Graph::dump(const std::string &format) const {
   if (format != "dot") THROW_ERROR("Unknown format: " << format);
 
@@ -1,11 +1,18 @@
 #ifndef PRIMITIV_GRAPH_H_
 #define PRIMITIV_GRAPH_H_
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <primitiv/function.h>
 #include <primitiv/mixins.h>
 #include <primitiv/shape.h>
+#include <primitiv/thread_pool.h>
 
 namespace primitiv {
 
@@ -141,7 +148,7 @@ class Graph
     : public mixins::DefaultSettable<Graph>
     , mixins::Nonmovable<Graph> {
 public:
-  Graph() = default;
+  Graph() : frozen_(false), tracing_(false) {}
   ~Graph() = default;
 
   /**
@@ -151,28 +158,127 @@ public:
    */
   void clear();
 
+  /**
+   * Fixes the structure of the graph to calculate it repeatedly.
+   * @remarks After calling this method, `add_function()` throws an exception
+   *          until `clear()` is called.
+   *          The graph can be calculated again with new data by calling
+   *          `set_data()`, `set_ids()` or `rewind()`, and the calculation
+   *          schedules are re-used.
+   */
+  void freeze();
+
+  /**
+   * Returns whether the graph is frozen or not.
+   * @return true if the graph is frozen, false otherwise.
+   */
+  bool frozen() const { return frozen_; }
+
+  /**
+   * Discards all values and gradients calculated in the graph.
+   * @remarks All functions are kept, and their values are calculated again by
+   *          the next `forward()`.
+   */
+  void rewind();
+
+  /**
+   * Replaces the data of the input node.
+   * @param node Node object created by `operators::input()`.
+   * @param data New data which has the same size as the node.
+   * @throw primitiv::Error The node is not an input, or the size of `data`
+   *                        mismatched.
+   * @remarks This function implicitly calls `rewind()`.
+   */
+  void set_data(const Node &node, const std::vector<float> &data);
+
+  /**
+   * Replaces the IDs used by the node.
+   * @param node Node object created by `operators::pick()` or
+   *             `operators::softmax_cross_entropy()` with IDs.
+   * @param ids New IDs which have the same number as the previous IDs.
+   * @throw primitiv::Error The node holds no IDs, or the number of `ids`
+   *                        mismatched.
+   * @remarks This function implicitly calls `rewind()`.
+   */
+  void set_ids(const Node &node, const std::vector<unsigned> &ids);
+
   /**
    * Adds a function subgraph.
    * @param func Interface of the new function.
    * @param args List of arguments. Each node should point a node in the same
    *        computation graph.
    * @return A new Node object of the resulting value.
+   * @throw primitiv::Error The graph is frozen.
    */
   Node add_function(
       std::unique_ptr<Function> &&func, const std::vector<Node> &args);
 
+  /**
+   * Adds a function subgraph which has multiple resulting values.
+   * @param func Interface of the new function.
+   * @param args List of arguments. Each node should point a node in the same
+   *        computation graph.
+   * @return New Node objects of all resulting values, in the order of
+   *         `Function::forward_shapes()`.
+   * @throw primitiv::Error The graph is frozen.
+   * @remarks All resulting values are calculated by one `forward()`, and
+   *          their gradients are propagated by one `backward()`. Gradients of
+   *          values which are not used by the output node are treated as 0.
+   */
+  std::vector<Node> add_multivalued_function(
+      std::unique_ptr<Function> &&func, const std::vector<Node> &args);
+
   /**
    * Calculates the value of given node.
    * @param node Node object specifying the target node.
    * @return Calculated value.
    * @remarks This function calculates only the subgraph which is required to
-   *          calculate the target node. Each intermediate result is stored to
+   *          calculate the target node, by the iterative traversal in the
+   *          topological order. Each intermediate result is stored to
    *          the corresponding node in the subgraph and they are re-used for
    *          future calculation. I.e., each node is calculated only once while
    *          the lifetime of the Graph object.
    */
   const Tensor &forward(const Node &node);
 
+  /**
+   * Calculates the value of given node.
+   * @param node Node object specifying the target node.
+   * @param retain Whether the intermediate results are stored or not.
+   * @return Calculated value.
+   * @remarks If `retain` is true, this function behaves as same as
+   *          `forward(node)`.
+   *          Otherwise, each intermediate result calculated in this call is
+   *          discarded as soon as all functions consuming it in this call
+   *          are calculated, and only the value of the target node is stored.
+   *          Results calculated before this call are always stored, so that
+   *          values required by future calculation (e.g., recurrent states)
+   *          should be calculated before.
+   *          Discarded values are calculated again if required by future
+   *          calculation, and `backward()` throws an exception if it requires
+   *          them.
+   */
+  const Tensor &forward(const Node &node, bool retain);
+
+  /**
+   * Calculates the values of given nodes at once.
+   * @param nodes List of Node objects specifying the target nodes.
+   * @return List of pointers to the calculated values.
+   * @remarks Each function required by any target is calculated only once.
+   */
+  std::vector<const Tensor *> forward(const std::vector<Node> &nodes);
+
+  /**
+   * Calculates the values of given nodes at once.
+   * @param nodes List of Node objects specifying the target nodes.
+   * @param retain Whether the intermediate results are stored or not.
+   * @return List of pointers to the calculated values.
+   * @remarks This function behaves as same as `forward(node, retain)` except
+   *          that all targets are stored.
+   */
+  std::vector<const Tensor *> forward(
+      const std::vector<Node> &nodes, bool retain);
+
   /**
    * Calculates the backpropagation.
    * @param node Node object specifying the output node.
@@ -209,6 +315,108 @@ public:
    */
   unsigned num_functions() const { return funcs_.size(); }
 
+  /**
+   * Sets the number of threads to calculate independent functions
+   * concurrently.
+   * @param num_threads Number of threads. 1 disables the parallelism.
+   * @throw primitiv::Error `num_threads` is 0.
+   * @remarks If `num_threads` is greater than 1, `forward()` and `backward()`
+   *          dispatch every function whose arguments (or sinks in the
+   *          backward calculation) are already calculated to a pool of
+   *          threads.
+   *          All devices used in the graph should accept concurrent
+   *          operations. CPU devices satisfy this, but the order of random
+   *          numbers used by different functions becomes nondeterministic.
+   */
+  void set_num_threads(unsigned num_threads);
+
+  /**
+   * Retrieves the number of threads to calculate functions.
+   * @return Number of threads.
+   */
+  unsigned num_threads() const { return pool_ ? pool_->num_threads() : 1; }
+
+  /**
+   * Plans the memory of values and gradients used to calculate the node.
+   * @param node Node object specifying the output node.
+   * @throw primitiv::Error The graph is not frozen, or the graph uses
+   *                        multiple threads.
+   * @remarks This function calculates the lifetime of each value and gradient
+   *          in `forward(node)` and the following `backward(node)`, and
+   *          assigns them to offsets in one memory block on each device so
+   *          that buffers which are alive at the same time never overlap.
+   *          After calling this method, values calculated by `forward()` and
+   *          gradients calculated by `backward(node)` are stored in the
+   *          planned memory, and `backward(node)` discards each intermediate
+   *          value as soon as its gradient is propagated.
+   *          Tensors obtained from the graph share the planned memory, and
+   *          they should not be used after the next `backward(node)`.
+   *          Temporary tensors used inside each function are not planned.
+   *          The plan is kept by `rewind()`, and discarded by `clear()` or
+   *          `set_num_threads()` with more than 1 thread.
+   */
+  void plan_memory(const Node &node);
+
+  /**
+   * Retrieves the size of the memory planned by `plan_memory()`.
+   * @return Total number of bytes of the memory blocks on all devices.
+   * @throw primitiv::Error The memory is not planned.
+   */
+  std::uint64_t planned_memory_size() const;
+
+  /**
+   * Retrieves the size of the memory required without sharing.
+   * @return Total number of bytes of all values and gradients planned by
+   *         `plan_memory()`, when each of them is allocated separately.
+   * @throw primitiv::Error The memory is not planned.
+   * @remarks Sizes of buffers are rounded in the same way as
+   *          `planned_memory_size()`.
+   */
+  std::uint64_t naive_memory_size() const;
+
+  /**
+   * Enables or disables tracing of the calculation.
+   * @param enabled Whether the tracing is enabled or not.
+   * @remarks If enabled, each invocation of `Function::forward()` and
+   *          `Function::backward()` by the graph is recorded with its
+   *          elapsed time, thread, device, shapes and the number of bytes of
+   *          tensors allocated in it.
+   *          Each invocation waits for the completion of operations on the
+   *          device of the function so that asynchronous devices report
+   *          actual elapsed time.
+   *          Recorded events are kept until `clear_trace()`, even if the
+   *          graph is cleared.
+   */
+  void set_tracing(bool enabled);
+
+  /**
+   * Retrieves whether the tracing is enabled or not.
+   * @return true if the tracing is enabled, false otherwise.
+   */
+  bool tracing() const { return tracing_; }
+
+  /**
+   * Discards all recorded events and resets the origin of timestamps.
+   */
+  void clear_trace();
+
+  /**
+   * Dumps recorded events.
+   * @return A string of the Trace Event Format (JSON), which can be loaded by
+   *         chrome://tracing or Perfetto.
+   * @remarks Each device is shown as a process, and each thread which called
+   *          functions is shown as a thread of the process.
+   */
+  std::string dump_trace() const;
+
+  /**
+   * Saves recorded events to a file.
+   * @param path Path of the file.
+   * @throw primitiv::Error Could not write the file.
+   * @remarks The format of the file is same as `dump_trace()`.
+   */
+  void save_trace(const std::string &path) const;
+
 private:
   /**
    * Tuple of values to determine the location of the node.
@@ -239,8 +447,132 @@ private:
     std::vector<NodeInfo> rets;
   };
 
+  /**
+   * Result of the memory planning.
+   */
+  struct MemoryPlan {
+    unsigned last_fid;
+    std::vector<std::uint64_t> value_offsets;
+    std::vector<std::uint64_t> grad_offsets;
+    std::unordered_map<Device *, Tensor> arenas;
+    std::uint64_t planned_size;
+    std::uint64_t naive_size;
+  };
+
+  /**
+   * Record of a function invoked while tracing.
+   */
+  struct TraceEvent {
+    std::string name;
+    std::string arg_shapes;
+    std::string shape;
+    std::string device;
+    unsigned fid;
+    bool backward;
+    unsigned thread;
+    double begin;  // Microseconds from the origin.
+    double end;  // Microseconds from the origin.
+    std::uint64_t allocated;
+  };
+
+  /**
+   * Scoped timer which records a function invoked while tracing.
+   */
+  class TraceScope;
+
+  /**
+   * Adds an event to the trace.
+   * @param event Event object. `thread`, `begin` and `end` are overwritten.
+   * @param begin Time when the function started.
+   * @param end Time when the function finished.
+   */
+  void add_trace_event(
+      TraceEvent &&event,
+      const std::chrono::steady_clock::time_point &begin,
+      const std::chrono::steady_clock::time_point &end);
+
+  /**
+   * Retrieves the value of the node.
+   * @param fid Function ID.
+   * @param vid Value ID.
+   * @return Stored value of the node, or the inner value of the function.
+   */
+  const Tensor &get_value(unsigned fid, unsigned vid) const;
+
+  /**
+   * Checks whether the function already has its value or not.
+   * @param fid Function ID.
+   * @return true if the value is available, false otherwise.
+   */
+  bool has_value(unsigned fid) const;
+
+  /**
+   * Checks whether some values of the function have gradients or not.
+   * @param fid Function ID.
+   * @return true if the gradient is available, false otherwise.
+   */
+  bool has_grad(unsigned fid) const;
+
+  /**
+   * Retrieves the calculation schedule of the function.
+   * @param fid Function ID.
+   * @return List of function IDs in the topological order, which should be
+   *         calculated to obtain the value of the function.
+   * @remarks The schedule is made at the first call and cached until
+   *          `clear()`.
+   *          If the graph is frozen, the schedule contains all required
+   *          functions regardless of their values, and it is kept by
+   *          `rewind()`.
+   */
+  const std::vector<unsigned> &get_schedule(unsigned fid);
+
+  /**
+   * Calculates the values of given functions.
+   * @param fids List of function IDs.
+   * @param retain Whether the intermediate results are stored or not.
+   */
+  void forward_inner(const std::vector<unsigned> &fids, bool retain);
+
+  /**
+   * Calculates the value of the function using values of its arguments.
+   * @param fid Function ID.
+   */
+  void forward_function(unsigned fid);
+
+  /**
+   * Propagates the gradient of the function to its arguments.
+   * @param fid Function ID.
+   * @param planned Whether the planned memory is used or not.
+   */
+  void backward_function(unsigned fid, bool planned);
+
+  /**
+   * Reserves the planned memory for the next tensor on the device of the
+   * function.
+   * @param fid Function ID.
+   * @param grad Whether the gradient or the value is reserved.
+   * @return true if the memory is reserved, false if the memory is not planned.
+   */
+  bool reserve_memory(unsigned fid, bool grad);
+
+  /**
+   * Performs the backpropagation on multiple threads.
+   * @param last_fid Function ID of the output node.
+   */
+  void backward_parallel(unsigned last_fid);
+
   static Graph *default_obj_;
   std::vector<FunctionInfo> funcs_;
+  std::unordered_map<unsigned, std::vector<unsigned>> schedules_;
+  std::unique_ptr<ThreadPool> pool_;
+  std::unique_ptr<MemoryPlan> plan_;
+  bool frozen_;
+  bool tracing_;
+  std::vector<TraceEvent> trace_;
+  std::unordered_map<std::thread::id, unsigned> trace_threads_;
+  std::chrono::steady_clock::time_point trace_origin_;
+  mutable std::mutex trace_mutex_;
+  std::mutex sparse_mutex_;
 };
 
 inline const Shape &Node::shape() const {
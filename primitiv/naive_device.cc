@@ -4,6 +4,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <functional>
 #include <iostream>
 #include <primitiv/naive_device.h>
 #include <primitiv/error.h>
@@ -17,15 +18,11 @@ namespace devices {
 void Naive::dump_description() const {
   cerr << "Device " << this << ':' << endl;
   cerr << "  Type: Naive" << endl;
+  cerr << "  Threads: " << pool_.num_threads() << endl;
 }
 
 std::shared_ptr<void> Naive::new_handle(const Shape &shape) {
-  const unsigned mem_size = sizeof(float) * shape.size();
-  void *data = std::malloc(mem_size);
-  if (!data) {
-    THROW_ERROR("Memory allocation failed. Requested size: " << mem_size);
-  }
-  return std::shared_ptr<void>(data, std::free);
+  return mem_pool_.allocate(sizeof(float) * shape.size());
 }
 
 #define DATA(x) static_cast<float *>((x).data())
@@ -34,6 +31,47 @@ std::shared_ptr<void> Naive::new_handle(const Shape &shape) {
 #define REPEAT_OP(i, n, op) \
   for (unsigned (i) = 0; (i) < (n); ++(i)) { (op); }
 
+// Runs the loop on the thread pool if the loop is large enough.
+#define PARALLEL_REPEAT_OP(i, n, op) \
+  pool_.parallel_for((n), GRAIN_SIZE, [&](unsigned begin_, unsigned end_) { \
+    for (unsigned i = begin_; i < end_; ++i) { (op); } \
+  })
+
+namespace {
+
+// Minimum number of scalar operations processed by one thread.
+const unsigned GRAIN_SIZE = 1 << 14;
+
+// Calculates the grain size of the loop whose each iteration performs
+// `work` scalar operations.
+inline unsigned grain_of(unsigned work) {
+  return work >= GRAIN_SIZE ? 1 : GRAIN_SIZE / (work + !work);
+}
+
+// Maximum number of rows processed together by `parallel_for_rows`.
+const unsigned ROW_BLOCK_SIZE = 256;
+
+// Calls `fn(i, offset, width)` on the thread pool for each block of adjacent
+// rows along a dimension, where `i` is the index of the first row, `offset` is
+// the position of its first element, and `width` is the number of rows.
+// Elements of the rows in a block are contiguous at every position of the
+// dimension, and the innermost loop over `width` can be vectorized.
+void parallel_for_rows(
+    ThreadPool &pool, unsigned repeat, unsigned n, unsigned skip1,
+    const std::function<void(unsigned, unsigned, unsigned)> &fn) {
+  pool.parallel_for(repeat, grain_of(n), [&](unsigned begin, unsigned end) {
+    while (begin < end) {
+      const unsigned k = begin % skip1;
+      const unsigned width = std::min(
+          ROW_BLOCK_SIZE, std::min(skip1 - k, end - begin));
+      fn(begin, k + (begin / skip1) * skip1 * n, width);
+      begin += width;
+    }
+  });
+}
+
+}  // namespace
+
 std::vector<float> Naive::tensor_to_vector_impl(const Tensor &x) {
   const unsigned num_elements = x.shape().size();
   std::vector<float> ret(num_elements);
@@ -48,21 +86,22 @@ std::vector<unsigned> Naive::argmax_impl(const Tensor &x, unsigned dim) {
   const unsigned skip1 = s.lower_volume(dim);
   const unsigned skip2 = skip1 * n;
   const float *src = CDATA(x);
-  std::vector<unsigned> ret;
-  ret.reserve(repeat);
-  for (unsigned i = 0; i < repeat; ++i) {
-    unsigned offset = i % skip1 + (i / skip1) * skip2;
-    float max_val = src[offset];
-    unsigned argmax_val = 0;
-    for (unsigned j = 1; j < n; ++j) {
-      offset += skip1;
-      if (src[offset] > max_val) {
-        max_val = src[offset];
-        argmax_val = j;
+  std::vector<unsigned> ret(repeat);
+  pool_.parallel_for(repeat, grain_of(n), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      unsigned offset = i % skip1 + (i / skip1) * skip2;
+      float max_val = src[offset];
+      unsigned argmax_val = 0;
+      for (unsigned j = 1; j < n; ++j) {
+        offset += skip1;
+        if (src[offset] > max_val) {
+          max_val = src[offset];
+          argmax_val = j;
+        }
       }
+      ret[i] = argmax_val;
     }
-    ret.emplace_back(argmax_val);
-  }
+  });
   return ret;
 }
 
@@ -73,28 +112,29 @@ std::vector<unsigned> Naive::argmin_impl(const Tensor &x, unsigned dim) {
   const unsigned skip1 = s.lower_volume(dim);
   const unsigned skip2 = skip1 * n;
   const float *src = CDATA(x);
-  std::vector<unsigned> ret;
-  ret.reserve(repeat);
-  for (unsigned i = 0; i < repeat; ++i) {
-    unsigned offset = i % skip1 + (i / skip1) * skip2;
-    float max_val = src[offset];
-    unsigned argmax_val = 0;
-    for (unsigned j = 1; j < n; ++j) {
-      offset += skip1;
-      if (src[offset] < max_val) {
-        max_val = src[offset];
-        argmax_val = j;
+  std::vector<unsigned> ret(repeat);
+  pool_.parallel_for(repeat, grain_of(n), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      unsigned offset = i % skip1 + (i / skip1) * skip2;
+      float max_val = src[offset];
+      unsigned argmax_val = 0;
+      for (unsigned j = 1; j < n; ++j) {
+        offset += skip1;
+        if (src[offset] < max_val) {
+          max_val = src[offset];
+          argmax_val = j;
+        }
       }
+      ret[i] = argmax_val;
     }
-    ret.emplace_back(argmax_val);
-  }
+  });
   return ret;
 }
 
 void Naive::reset_tensor_impl(float k, Tensor &x) {
   float *dest = DATA(x);
   const unsigned size = x.shape().size();
-  REPEAT_OP(i, size, dest[i] = k);
+  PARALLEL_REPEAT_OP(i, size, dest[i] = k);
 }
 
 void Naive::reset_tensor_by_array_impl(const float values[], Tensor &x) {
@@ -120,6 +160,7 @@ void Naive::identity_impl(Tensor &y) {
 
 void Naive::random_bernoulli_impl(float p, Tensor &y) {
   std::bernoulli_distribution dist(p);
+  std::lock_guard<std::mutex> lock(rng_mutex_);
   float *dest = DATA(y);
   const unsigned size = y.shape().size();
   REPEAT_OP(i, size, dest[i] = dist(rng_));
@@ -127,6 +168,7 @@ void Naive::random_bernoulli_impl(float p, Tensor &y) {
 
 void Naive::random_uniform_impl(float lower, float upper, Tensor &y) {
   std::uniform_real_distribution<float> dist(lower, upper);
+  std::lock_guard<std::mutex> lock(rng_mutex_);
   float *dest = DATA(y);
   const unsigned size = y.shape().size();
   for (unsigned i = 0; i < size; ++i) {
@@ -137,6 +179,7 @@ void Naive::random_uniform_impl(float lower, float upper, Tensor &y) {
 
 void Naive::random_normal_impl(float mean, float sd, Tensor &y) {
   std::normal_distribution<float> dist(mean, sd);
+  std::lock_guard<std::mutex> lock(rng_mutex_);
   float *dest = DATA(y);
   const unsigned size = y.shape().size();
   REPEAT_OP(i, size, dest[i] = dist(rng_));
@@ -144,6 +187,7 @@ void Naive::random_normal_impl(float mean, float sd, Tensor &y) {
 
 void Naive::random_log_normal_impl(float mean, float sd, Tensor &y) {
   std::lognormal_distribution<float> dist(mean, sd);
+  std::lock_guard<std::mutex> lock(rng_mutex_);
   float *dest = DATA(y);
   const unsigned size = y.shape().size();
   REPEAT_OP(i, size, dest[i] = dist(rng_));
@@ -158,16 +202,22 @@ void Naive::pick_fw_impl(
   const unsigned base = y.shape().lower_volume(dim);
   const unsigned skip = base * x.shape()[dim];
   const unsigned repeat = y.shape().volume() / base;
+  const unsigned skip_y = y.shape().volume();
 
-  float *dest = DATA(y);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    const float *src = CDATA(x) + batch * skip_x + base * ids[batch * skip_i];
-    for (unsigned i = 0; i < repeat; ++i) {
-      const float *sp = src;
-      REPEAT_OP(j, base, *dest++ = *sp++);
-      src += skip;
+  float *dest_base = DATA(y);
+  const float *src_base = CDATA(x);
+  pool_.parallel_for(bs, grain_of(skip_y), [&](unsigned begin, unsigned end) {
+    for (unsigned batch = begin; batch < end; ++batch) {
+      float *dest = dest_base + batch * skip_y;
+      const float *src
+        = src_base + batch * skip_x + base * ids[batch * skip_i];
+      for (unsigned i = 0; i < repeat; ++i) {
+        const float *sp = src;
+        REPEAT_OP(j, base, *dest++ = *sp++);
+        src += skip;
+      }
     }
-  }
+  });
 }
 
 void Naive::slice_fw_impl(
@@ -179,11 +229,13 @@ void Naive::slice_fw_impl(
 
   float *dest = DATA(y);
   const float *src = CDATA(x) + base * offset;
-  for (unsigned i = 0; i < repeat; ++i) {
-    const float *sp = src;
-    REPEAT_OP(j, span, *dest++ = *sp++);
-    src += skip;
-  }
+  pool_.parallel_for(repeat, grain_of(span), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      float *dp = dest + i * span;
+      const float *sp = src + i * skip;
+      REPEAT_OP(j, span, *dp++ = *sp++);
+    }
+  });
 }
 
 void Naive::concat_fw_impl(
@@ -193,22 +245,26 @@ void Naive::concat_fw_impl(
   const unsigned skip = base * y.shape()[dim];
   const unsigned repeat = y.shape().volume() / skip;
 
+  float *dest_base = DATA(y);
   unsigned offset = 0;
   for (const Tensor *x : xs) {
     const unsigned src_dim = x->shape()[dim];
     const unsigned span = base * src_dim;
     const unsigned b_skip = x->shape().has_batch() * span * repeat;
-    float *dest = DATA(y) + offset;
+    float *dest = dest_base + offset;
     const float *src = CDATA(*x);
-    for (unsigned batch = 0; batch < new_bs; ++batch) {
-      const float *sp = src;
-      for (unsigned i = 0; i < repeat; ++i) {
-        float *dp = dest;
-        REPEAT_OP(j, span, *dp++ = *sp++);
-        dest += skip;
+    pool_.parallel_for(
+        new_bs, grain_of(span * repeat), [&](unsigned begin, unsigned end) {
+      for (unsigned batch = begin; batch < end; ++batch) {
+        float *dp = dest + batch * skip * repeat;
+        const float *sp = src + batch * b_skip;
+        for (unsigned i = 0; i < repeat; ++i) {
+          float *ddp = dp;
+          REPEAT_OP(j, span, *ddp++ = *sp++);
+          dp += skip;
+        }
       }
-      src += b_skip;
-    }
+    });
     offset += span;
   }
 }
@@ -246,17 +302,18 @@ void Naive::slice_bw_impl(
   const unsigned b_skip_s = sy.has_batch() * sy.volume();
   float *dest = DATA(gx) + base * offset;
   const float *src = CDATA(gy);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    float *dp = dest;
-    const float *sp = src;
-    for (unsigned i = 0; i < repeat; ++i) {
-      float *ddp = dp;
-      REPEAT_OP(j, span, *ddp++ += *sp++);
-      dp += skip;
+  // Each thread processes different rows through all minibatches because
+  // `gx` may be shared by multiple minibatches of `gy`.
+  pool_.parallel_for(
+      repeat, grain_of(span * bs), [&](unsigned begin, unsigned end) {
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) {
+        float *ddp = dest + batch * b_skip_d + i * skip;
+        const float *sp = src + batch * b_skip_s + i * span;
+        REPEAT_OP(j, span, *ddp++ += *sp++);
+      }
     }
-    dest += b_skip_d;
-    src += b_skip_s;
-  }
+  });
 }
 
 #define CPUDEV_FW_X(name, op) \
@@ -264,7 +321,7 @@ void Naive::name##_fw_impl(const Tensor &x, Tensor &y) { \
   float *dest = DATA(y); \
   const float *src = CDATA(x); \
   const unsigned size = x.shape().size(); \
-  REPEAT_OP(i, size, dest[i] = (op)); \
+  PARALLEL_REPEAT_OP(i, size, dest[i] = (op)); \
 }
 
 #define CPUDEV_BW_X(name, op) \
@@ -275,7 +332,7 @@ void Naive::name##_bw_impl( \
   const float *pgy = CDATA(gy); \
   float *pgx = DATA(gx); \
   const unsigned size = x.shape().size(); \
-  REPEAT_OP(i, size, pgx[i] += (op)); \
+  PARALLEL_REPEAT_OP(i, size, pgx[i] += (op)); \
 }
 
 #define CPUDEV_FW_X_CONST(name, op) \
@@ -283,7 +340,7 @@ void Naive::name##_fw_impl(const Tensor &x, float k, Tensor &y) { \
   float *dest = DATA(y); \
   const float *src = CDATA(x); \
   const unsigned size = x.shape().size(); \
-  REPEAT_OP(i, size, dest[i] = (op)); \
+  PARALLEL_REPEAT_OP(i, size, dest[i] = (op)); \
 }
 
 #define CPUDEV_BW_X_CONST(name, op) \
@@ -294,7 +351,7 @@ void Naive::name##_bw_impl( \
   const float *pgy = CDATA(gy); \
   float *pgx = DATA(gx); \
   const unsigned size = x.shape().size(); \
-  REPEAT_OP(i, size, pgx[i] += (op)); \
+  PARALLEL_REPEAT_OP(i, size, pgx[i] += (op)); \
 }
 
 #define CPUDEV_FW_X_SCALAR(name, op) \
@@ -303,15 +360,20 @@ void Naive::name##_fw_impl(const Tensor &x, const Tensor &k, Tensor &y) { \
   const unsigned bs = y.shape().batch(); \
   const unsigned skip_x = x.shape().has_batch() * size; \
   const unsigned skip_k = k.shape().has_batch(); \
-  float *dest = DATA(y); \
-  const float *src_x = CDATA(x); \
-  const float *src_k = CDATA(k); \
-  for (unsigned batch = 0; batch < bs; ++batch) { \
-    REPEAT_OP(i, size, dest[i] = (op)); \
-    dest += size; \
-    src_x += skip_x; \
-    src_k += skip_k; \
-  } \
+  float *dest_base = DATA(y); \
+  const float *src_x_base = CDATA(x); \
+  const float *src_k_base = CDATA(k); \
+  pool_.parallel_for(size, grain_of(bs), [&](unsigned begin, unsigned end) { \
+    float *dest = dest_base; \
+    const float *src_x = src_x_base; \
+    const float *src_k = src_k_base; \
+    for (unsigned batch = 0; batch < bs; ++batch) { \
+      for (unsigned i = begin; i < end; ++i) { dest[i] = (op); } \
+      dest += size; \
+      src_x += skip_x; \
+      src_k += skip_k; \
+    } \
+  }); \
 }
 
 #define CPUDEV_FW_AB(name, op) \
@@ -320,15 +382,20 @@ void Naive::name##_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) { \
   const unsigned bs = y.shape().batch(); \
   const unsigned skip_a = a.shape().has_batch() * size; \
   const unsigned skip_b = b.shape().has_batch() * size; \
-  float *dest = DATA(y); \
-  const float *src_a = CDATA(a); \
-  const float *src_b = CDATA(b); \
-  for (unsigned batch = 0; batch < bs; ++batch) { \
-    REPEAT_OP(i, size, dest[i] = (op)); \
-    dest += size; \
-    src_a += skip_a; \
-    src_b += skip_b; \
-  } \
+  float *dest_base = DATA(y); \
+  const float *src_a_base = CDATA(a); \
+  const float *src_b_base = CDATA(b); \
+  pool_.parallel_for(size, grain_of(bs), [&](unsigned begin, unsigned end) { \
+    float *dest = dest_base; \
+    const float *src_a = src_a_base; \
+    const float *src_b = src_b_base; \
+    for (unsigned batch = 0; batch < bs; ++batch) { \
+      for (unsigned i = begin; i < end; ++i) { dest[i] = (op); } \
+      dest += size; \
+      src_a += skip_a; \
+      src_b += skip_b; \
+    } \
+  }); \
 }
 
 CPUDEV_FW_X(negate, -src[i]);
@@ -400,19 +467,24 @@ void Naive::add_bw_impl(
   const unsigned bs = gy.shape().batch();
   const unsigned skip_a = ga.shape().has_batch() * size;
   const unsigned skip_b = gb.shape().has_batch() * size;
-  const float *pgy = CDATA(gy);
-  float *pga = DATA(ga);
-  float *pgb = DATA(gb);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    for (unsigned i = 0; i < size; ++i) {
-      const float k = pgy[i];
-      pga[i] += k;
-      pgb[i] += k;
-    }
-    pgy += size;
-    pga += skip_a;
-    pgb += skip_b;
-  }
+  const float *pgy_base = CDATA(gy);
+  float *pga_base = DATA(ga);
+  float *pgb_base = DATA(gb);
+  pool_.parallel_for(size, grain_of(bs), [&](unsigned begin, unsigned end) {
+    const float *pgy = pgy_base;
+    float *pga = pga_base;
+    float *pgb = pgb_base;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) {
+        const float k = pgy[i];
+        pga[i] += k;
+        pgb[i] += k;
+      }
+      pgy += size;
+      pga += skip_a;
+      pgb += skip_b;
+    }
+  });
 }
 
 void Naive::subtract_bw_impl(
@@ -422,19 +494,24 @@ void Naive::subtract_bw_impl(
   const unsigned bs = gy.shape().batch();
   const unsigned skip_a = ga.shape().has_batch() * size;
   const unsigned skip_b = gb.shape().has_batch() * size;
-  const float *pgy = CDATA(gy);
-  float *pga = DATA(ga);
-  float *pgb = DATA(gb);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    for (unsigned i = 0; i < size; ++i) {
-      const float k = pgy[i];
-      pga[i] += k;
-      pgb[i] -= k;
-    }
-    pgy += size;
-    pga += skip_a;
-    pgb += skip_b;
-  }
+  const float *pgy_base = CDATA(gy);
+  float *pga_base = DATA(ga);
+  float *pgb_base = DATA(gb);
+  pool_.parallel_for(size, grain_of(bs), [&](unsigned begin, unsigned end) {
+    const float *pgy = pgy_base;
+    float *pga = pga_base;
+    float *pgb = pgb_base;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) {
+        const float k = pgy[i];
+        pga[i] += k;
+        pgb[i] -= k;
+      }
+      pgy += size;
+      pga += skip_a;
+      pgb += skip_b;
+    }
+  });
 }
 
 void Naive::multiply_bw_impl(
@@ -444,23 +521,30 @@ void Naive::multiply_bw_impl(
   const unsigned bs = gy.shape().batch();
   const unsigned skip_a = ga.shape().has_batch() * size;
   const unsigned skip_b = gb.shape().has_batch() * size;
-  const float *pa = CDATA(a);
-  const float *pb = CDATA(b);
-  const float *pgy = CDATA(gy);
-  float *pga = DATA(ga);
-  float *pgb = DATA(gb);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    for (unsigned i = 0; i < size; ++i) {
-      const float k = pgy[i];
-      pga[i] += k * pb[i];
-      pgb[i] += k * pa[i];
-    }
-    pa += skip_a;
-    pb += skip_b;
-    pgy += size;
-    pga += skip_a;
-    pgb += skip_b;
-  }
+  const float *pa_base = CDATA(a);
+  const float *pb_base = CDATA(b);
+  const float *pgy_base = CDATA(gy);
+  float *pga_base = DATA(ga);
+  float *pgb_base = DATA(gb);
+  pool_.parallel_for(size, grain_of(bs), [&](unsigned begin, unsigned end) {
+    const float *pa = pa_base;
+    const float *pb = pb_base;
+    const float *pgy = pgy_base;
+    float *pga = pga_base;
+    float *pgb = pgb_base;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) {
+        const float k = pgy[i];
+        pga[i] += k * pb[i];
+        pgb[i] += k * pa[i];
+      }
+      pa += skip_a;
+      pb += skip_b;
+      pgy += size;
+      pga += skip_a;
+      pgb += skip_b;
+    }
+  });
 }
 
 void Naive::divide_bw_impl(
@@ -470,23 +554,30 @@ void Naive::divide_bw_impl(
   const unsigned bs = gy.shape().batch();
   const unsigned skip_a = ga.shape().has_batch() * size;
   const unsigned skip_b = gb.shape().has_batch() * size;
-  const float *pb = CDATA(b);
-  const float *py = CDATA(y);
-  const float *pgy = CDATA(gy);
-  float *pga = DATA(ga);
-  float *pgb = DATA(gb);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    for (unsigned i = 0; i < size; ++i) {
-      const float k = pgy[i] / pb[i];
-      pga[i] += k;
-      pgb[i] -= k * py[i];
-    }
-    pb += skip_b;
-    py += size;
-    pgy += size;
-    pga += skip_a;
-    pgb += skip_b;
-  }
+  const float *pb_base = CDATA(b);
+  const float *py_base = CDATA(y);
+  const float *pgy_base = CDATA(gy);
+  float *pga_base = DATA(ga);
+  float *pgb_base = DATA(gb);
+  pool_.parallel_for(size, grain_of(bs), [&](unsigned begin, unsigned end) {
+    const float *pb = pb_base;
+    const float *py = py_base;
+    const float *pgy = pgy_base;
+    float *pga = pga_base;
+    float *pgb = pgb_base;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) {
+        const float k = pgy[i] / pb[i];
+        pga[i] += k;
+        pgb[i] -= k * py[i];
+      }
+      pb += skip_b;
+      py += size;
+      pgy += size;
+      pga += skip_a;
+      pgb += skip_b;
+    }
+  });
 }
 
 void Naive::transpose_fw_impl(const Tensor &x, Tensor &y) {
@@ -497,17 +588,75 @@ void Naive::transpose_fw_impl(const Tensor &x, Tensor &y) {
   float *dest = DATA(y);
   const float *src = CDATA(x);
 
-  for (unsigned k = 0; k < bs; ++k) {
-    float *pd = dest;
-    for (unsigned j = 0; j < d2; ++j) {
-      float *ppd = pd;
+  pool_.parallel_for(bs * d2, grain_of(d1), [&](unsigned begin, unsigned end) {
+    for (unsigned c = begin; c < end; ++c) {
+      const unsigned k = c / d2;
+      const unsigned j = c % d2;
+      float *ppd = dest + k * ms + j;
+      const float *ps = src + k * ms + j * d1;
       for (unsigned i = 0; i < d1; ++i) {
-        *ppd = *src++;
+        *ppd = *ps++;
         ppd += d2;
       }
-      ++pd;
     }
-    dest += ms;
+  });
+}
+
+void Naive::gemm(
+    bool trans_a, bool trans_b, unsigned m, unsigned n, unsigned k,
+    const float *a, const float *b, bool accumulate, float *c,
+    unsigned batch, unsigned a_skip, unsigned b_skip, unsigned c_skip) {
+  // j-th column of op(B) is accessed by `pb[l * skip]`.
+  const unsigned skip = trans_b ? n : 1;
+  auto column = [&](unsigned j, const float *pa, const float *pb, float *pc) {
+    if (trans_a) {
+      // C[i, j] += A[:, i] . op(B)[:, j]
+      for (unsigned i = 0; i < m; ++i) {
+        float tmp = 0;
+        REPEAT_OP(l, k, tmp += pa[l] * pb[l * skip]);
+        pc[i] += tmp;
+        pa += k;
+      }
+    } else {
+      // C[:, j] += sum_l A[:, l] * op(B)[l, j]
+      for (unsigned l = 0; l < k; ++l) {
+        const float bl = pb[l * skip];
+        REPEAT_OP(i, m, pc[i] += pa[i] * bl);
+        pa += m;
+      }
+    }
+  };
+  auto offset_b = [&](unsigned j) { return trans_b ? j : j * k; };
+
+  if (c_skip > 0 || batch == 1) {
+    // Each thread calculates different columns of different `C`s.
+    pool_.parallel_for(
+        batch * n, grain_of(m * k), [&](unsigned begin, unsigned end) {
+      for (unsigned q = begin; q < end; ++q) {
+        const unsigned bi = q / n;
+        const unsigned j = q % n;
+        float *pc = c + bi * c_skip + j * m;
+        if (!accumulate) {
+          REPEAT_OP(i, m, pc[i] = 0);
+        }
+        column(j, a + bi * a_skip, b + bi * b_skip + offset_b(j), pc);
+      }
+    });
+  } else {
+    // All products are accumulated into the same `C`, and each thread
+    // calculates different columns through all products.
+    pool_.parallel_for(
+        n, grain_of(batch * m * k), [&](unsigned begin, unsigned end) {
+      for (unsigned j = begin; j < end; ++j) {
+        float *pc = c + j * m;
+        if (!accumulate) {
+          REPEAT_OP(i, m, pc[i] = 0);
+        }
+        for (unsigned bi = 0; bi < batch; ++bi) {
+          column(j, a + bi * a_skip, b + bi * b_skip + offset_b(j), pc);
+        }
+      }
+    });
   }
 }
 
@@ -516,41 +665,78 @@ void Naive::matmul_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) {
   const unsigned d2 = a.shape()[1];
   const unsigned d3 = b.shape()[1];
   const unsigned bs = y.shape().batch();
-  const unsigned dest_shift = d1 * d3;
-  const unsigned src_a_shift = a.shape().has_batch() * d1 * d2;
-  const unsigned src_b_shift = b.shape().has_batch() * d2 * d3;
-
   float *dest = DATA(y);
   const float *src_a = CDATA(a);
   const float *src_b = CDATA(b);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    for (unsigned i = 0; i < d1; ++i) {
-      for (unsigned ky = 0, kb = 0; ky < dest_shift; ky += d1, kb += d2) {
-        float tmp = 0;
-        for (unsigned ja = 0, jb = 0; jb < d2; ja += d1, ++jb) {
-          tmp += src_a[i + ja] * src_b[jb + kb];
-        }
-        dest[i + ky] = tmp;
-      }
-    }
-    dest += dest_shift;
-    src_a += src_a_shift;
-    src_b += src_b_shift;
+
+  if (a.shape().has_batch()) {
+    // Do multiplication multiple times.
+    const unsigned b_skip = b.shape().has_batch() * d2 * d3;
+    gemm(
+        false, false, d1, d3, d2, src_a, src_b, false, dest,
+        bs, d1 * d2, b_skip, d1 * d3);
+  } else {
+    // Do multiplication only once using a combined matrix.
+    gemm(false, false, d1, d3 * bs, d2, src_a, src_b, false, dest);
   }
 }
 
 void Naive::transpose_bw_impl(
     const Tensor &, const Tensor &, const Tensor &gy, Tensor &gx) {
-  // TODO(odashi): This code could be slow and requires memory. Fix this.
-  inplace_add_impl(transpose_fw(gy), gx);
+  const unsigned d1 = gx.shape()[0];
+  const unsigned d2 = gx.shape()[1];
+  const unsigned ms = d1 * d2;
+  const unsigned bs = gx.shape().batch();
+  float *dest = DATA(gx);
+  const float *src = CDATA(gy);
+
+  pool_.parallel_for(bs * d2, grain_of(d1), [&](unsigned begin, unsigned end) {
+    for (unsigned c = begin; c < end; ++c) {
+      const unsigned k = c / d2;
+      const unsigned j = c % d2;
+      float *pd = dest + k * ms + j * d1;
+      const float *ps = src + k * ms + j;
+      for (unsigned i = 0; i < d1; ++i) {
+        pd[i] += *ps;
+        ps += d2;
+      }
+    }
+  });
 }
 
 void Naive::matmul_bw_impl(
     const Tensor &a, const Tensor &b, const Tensor &, const Tensor &gy,
     Tensor &ga, Tensor &gb) {
-  // TODO(odashi): This code could be slow and requires memory. Fix this.
-  inplace_add_impl(matmul_fw(gy, transpose_fw(b)), ga);
-  inplace_add_impl(matmul_fw(transpose_fw(a), gy), gb);
+  // ga += gy . b^T
+  // gb += a^T . gy
+  const unsigned d1 = a.shape()[0];
+  const unsigned d2 = a.shape()[1];
+  const unsigned d3 = b.shape()[1];
+  const unsigned bs = gy.shape().batch();
+  const float *src_a = CDATA(a);
+  const float *src_b = CDATA(b);
+  const float *src_gy = CDATA(gy);
+  float *dest_a = DATA(ga);
+  float *dest_b = DATA(gb);
+
+  if (a.shape().has_batch()) {
+    // Do multiplication multiple times.
+    const unsigned a_skip = d1 * d2;
+    const unsigned b_skip = b.shape().has_batch() * d2 * d3;
+    const unsigned y_skip = d1 * d3;
+    gemm(
+        false, true, d1, d2, d3, src_gy, src_b, true, dest_a,
+        bs, y_skip, b_skip, a_skip);
+    gemm(
+        true, false, d2, d3, d1, src_a, src_gy, true, dest_b,
+        bs, a_skip, y_skip, b_skip);
+  } else {
+    // Do multiplication only once using a combined matrix.
+    // If `b` has no minibatch, the following calculation is also correct
+    // because `bs` is 1.
+    gemm(false, true, d1, d2, d3 * bs, src_gy, src_b, true, dest_a);
+    gemm(true, false, d2, d3 * bs, d1, src_a, src_gy, true, dest_b);
+  }
 }
 
 void Naive::sum_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
@@ -560,37 +746,40 @@ void Naive::sum_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
   const unsigned skip2 = skip1 * n;
   float *dest = DATA(y);
   const float *src = CDATA(x);
-  for (unsigned i = 0; i < repeat; ++i) {
-    unsigned offset = i % skip1 + (i / skip1) * skip2;
-    float tmp = 0;
-    for (unsigned j = 0; j < n; ++j) {
-      tmp += src[offset];
-      offset += skip1;
+  pool_.parallel_for(repeat, grain_of(n), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      unsigned offset = i % skip1 + (i / skip1) * skip2;
+      float tmp = 0;
+      for (unsigned j = 0; j < n; ++j) {
+        tmp += src[offset];
+        offset += skip1;
+      }
+      dest[i] = tmp;
     }
-    dest[i] = tmp;
-  }
+  });
 }
 
 void Naive::logsumexp_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
   const unsigned n = x.shape()[dim];
   const unsigned repeat = y.shape().size();
   const unsigned skip1 = y.shape().lower_volume(dim);
-  const unsigned skip2 = skip1 * n;
   float *dest = DATA(y);
   const float *src = CDATA(x);
-  for (unsigned i = 0; i < repeat; ++i) {
-    // TODO(odashi): This calculation might generate large errors.
-    unsigned offset = i % skip1 + (i / skip1) * skip2;
-    float tmp = src[offset];
+  parallel_for_rows(pool_, repeat, n, skip1,
+      [&](unsigned i, unsigned offset, unsigned width) {
+    const float *px = src + offset;
+    float m[ROW_BLOCK_SIZE], s[ROW_BLOCK_SIZE];
+    for (unsigned k = 0; k < width; ++k) m[k] = px[k], s[k] = 0;
     for (unsigned j = 1; j < n; ++j) {
-      offset += skip1;
-      float arg = src[offset];
-      tmp = tmp > arg
-        ? tmp + std::log(1. + std::exp(arg - tmp))
-        : arg + std::log(1. + std::exp(tmp - arg));
+      const float *pj = px + j * skip1;
+      for (unsigned k = 0; k < width; ++k) m[k] = std::max(m[k], pj[k]);
     }
-    dest[i] = tmp;
-  }
+    for (unsigned j = 0; j < n; ++j) {
+      const float *pj = px + j * skip1;
+      for (unsigned k = 0; k < width; ++k) s[k] += std::exp(pj[k] - m[k]);
+    }
+    for (unsigned k = 0; k < width; ++k) dest[i + k] = m[k] + std::log(s[k]);
+  });
 }
 
 void Naive::broadcast_fw_impl(
@@ -600,14 +789,16 @@ void Naive::broadcast_fw_impl(
   const unsigned skip2 = skip1 * size;
   float *dest = DATA(y);
   const float *src = CDATA(x);
-  for (unsigned i = 0; i < repeat; ++i) {
-    unsigned offset = i % skip1 + (i / skip1) * skip2;
-    float tmp = src[i];
-    for (unsigned j = 0; j < size; ++j) {
-      dest[offset] = tmp;
-      offset += skip1;
+  pool_.parallel_for(repeat, grain_of(size), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      unsigned offset = i % skip1 + (i / skip1) * skip2;
+      float tmp = src[i];
+      for (unsigned j = 0; j < size; ++j) {
+        dest[offset] = tmp;
+        offset += skip1;
+      }
     }
-  }
+  });
 }
 
 void Naive::batch_sum_fw_impl(const Tensor &x, Tensor &y) {
@@ -615,19 +806,274 @@ void Naive::batch_sum_fw_impl(const Tensor &x, Tensor &y) {
   const float *src = CDATA(x);
   const unsigned bs = x.shape().batch();
   const unsigned size = y.shape().size();
-  for (unsigned i = 0; i < size; ++i) {
-    float temp = 0;
-    for (unsigned batch = 0, pos = i; batch < bs; ++batch, pos += size) {
-      temp += src[pos];
+  pool_.parallel_for(size, grain_of(bs), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      float temp = 0;
+      for (unsigned batch = 0, pos = i; batch < bs; ++batch, pos += size) {
+        temp += src[pos];
+      }
+      dest[i] = temp;
     }
-    dest[i] = temp;
-  }
+  });
+}
+
+void Naive::softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned skip1 = x.shape().lower_volume(dim);
+  const unsigned repeat = x.shape().size() / n;
+  float *dest = DATA(y);
+  const float *src = CDATA(x);
+  parallel_for_rows(pool_, repeat, n, skip1,
+      [&](unsigned, unsigned offset, unsigned width) {
+    const float *px = src + offset;
+    float *py = dest + offset;
+    float m[ROW_BLOCK_SIZE], s[ROW_BLOCK_SIZE];
+    for (unsigned k = 0; k < width; ++k) m[k] = px[k], s[k] = 0;
+    for (unsigned j = 1; j < n; ++j) {
+      const float *pj = px + j * skip1;
+      for (unsigned k = 0; k < width; ++k) m[k] = std::max(m[k], pj[k]);
+    }
+    for (unsigned j = 0; j < n; ++j) {
+      const float *pj = px + j * skip1;
+      float *qj = py + j * skip1;
+      for (unsigned k = 0; k < width; ++k) {
+        qj[k] = std::exp(pj[k] - m[k]);
+        s[k] += qj[k];
+      }
+    }
+    for (unsigned k = 0; k < width; ++k) s[k] = 1 / s[k];
+    for (unsigned j = 0; j < n; ++j) {
+      float *qj = py + j * skip1;
+      for (unsigned k = 0; k < width; ++k) qj[k] *= s[k];
+    }
+  });
+}
+
+void Naive::log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned skip1 = x.shape().lower_volume(dim);
+  const unsigned repeat = x.shape().size() / n;
+  float *dest = DATA(y);
+  const float *src = CDATA(x);
+  parallel_for_rows(pool_, repeat, n, skip1,
+      [&](unsigned, unsigned offset, unsigned width) {
+    const float *px = src + offset;
+    float *py = dest + offset;
+    float m[ROW_BLOCK_SIZE], s[ROW_BLOCK_SIZE];
+    for (unsigned k = 0; k < width; ++k) m[k] = px[k], s[k] = 0;
+    for (unsigned j = 1; j < n; ++j) {
+      const float *pj = px + j * skip1;
+      for (unsigned k = 0; k < width; ++k) m[k] = std::max(m[k], pj[k]);
+    }
+    for (unsigned j = 0; j < n; ++j) {
+      const float *pj = px + j * skip1;
+      for (unsigned k = 0; k < width; ++k) s[k] += std::exp(pj[k] - m[k]);
+    }
+    for (unsigned k = 0; k < width; ++k) s[k] = std::log(s[k]);
+    for (unsigned j = 0; j < n; ++j) {
+      const float *pj = px + j * skip1;
+      float *qj = py + j * skip1;
+      for (unsigned k = 0; k < width; ++k) qj[k] = (pj[k] - m[k]) - s[k];
+    }
+  });
+}
+
+void Naive::softmax_bw_impl(
+    const Tensor &, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  const unsigned n = y.shape()[dim];
+  const unsigned skip1 = y.shape().lower_volume(dim);
+  const unsigned repeat = y.shape().size() / n;
+  const float *py = CDATA(y);
+  const float *pgy = CDATA(gy);
+  float *pgx = DATA(gx);
+  parallel_for_rows(pool_, repeat, n, skip1,
+      [&](unsigned, unsigned offset, unsigned width) {
+    float s[ROW_BLOCK_SIZE];
+    for (unsigned k = 0; k < width; ++k) s[k] = 0;
+    for (unsigned j = 0; j < n; ++j) {
+      const unsigned o = offset + j * skip1;
+      for (unsigned k = 0; k < width; ++k) s[k] += pgy[o + k] * py[o + k];
+    }
+    for (unsigned j = 0; j < n; ++j) {
+      const unsigned o = offset + j * skip1;
+      for (unsigned k = 0; k < width; ++k) {
+        pgx[o + k] += py[o + k] * (pgy[o + k] - s[k]);
+      }
+    }
+  });
+}
+
+void Naive::log_softmax_bw_impl(
+    const Tensor &, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  const unsigned n = y.shape()[dim];
+  const unsigned skip1 = y.shape().lower_volume(dim);
+  const unsigned repeat = y.shape().size() / n;
+  const float *py = CDATA(y);
+  const float *pgy = CDATA(gy);
+  float *pgx = DATA(gx);
+  parallel_for_rows(pool_, repeat, n, skip1,
+      [&](unsigned, unsigned offset, unsigned width) {
+    float s[ROW_BLOCK_SIZE];
+    for (unsigned k = 0; k < width; ++k) s[k] = 0;
+    for (unsigned j = 0; j < n; ++j) {
+      const unsigned o = offset + j * skip1;
+      for (unsigned k = 0; k < width; ++k) s[k] += pgy[o + k];
+    }
+    for (unsigned j = 0; j < n; ++j) {
+      const unsigned o = offset + j * skip1;
+      for (unsigned k = 0; k < width; ++k) {
+        pgx[o + k] += pgy[o + k] - std::exp(py[o + k]) * s[k];
+      }
+    }
+  });
+}
+
+void Naive::sparse_softmax_cross_entropy_fw_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &lse, Tensor &y) {
+  logsumexp_fw_impl(x, dim, lse);
+  const unsigned n = x.shape()[dim];
+  const unsigned skip1 = x.shape().lower_volume(dim);
+  const unsigned size = y.shape().volume();
+  const unsigned skip_x = x.shape().has_batch() * x.shape().volume();
+  const unsigned skip_l = x.shape().has_batch() * size;
+  const unsigned skip_i = ids.size() > 1;
+  const float *px = CDATA(x);
+  const float *pl = CDATA(lse);
+  float *py = DATA(y);
+  const unsigned total = y.shape().size();
+  pool_.parallel_for(total, GRAIN_SIZE, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      const unsigned b = i / size;
+      const unsigned r = i % size;
+      py[i] = pl[b * skip_l + r] - px[
+        b * skip_x + r % skip1 + (r / skip1 * n + ids[b * skip_i]) * skip1];
+    }
+  });
+}
+
+void Naive::sparse_softmax_cross_entropy_bw_impl(
+    const Tensor &x, const Tensor &lse, const std::vector<unsigned> &ids,
+    const Tensor &gy, unsigned dim, Tensor &gx) {
+  const unsigned n = x.shape()[dim];
+  const unsigned skip1 = x.shape().lower_volume(dim);
+  const unsigned size = gy.shape().volume();
+  const unsigned repeat = x.shape().size() / n;
+  const unsigned bs = gy.shape().batch();
+  const bool has_batch = x.shape().has_batch();
+  const unsigned skip_i = ids.size() > 1;
+  const float *px = CDATA(x);
+  const float *pl = CDATA(lse);
+  const float *pgy = CDATA(gy);
+  float *pgx = DATA(gx);
+  parallel_for_rows(pool_, repeat, n, skip1,
+      [&](unsigned i, unsigned offset, unsigned width) {
+    // If `x` has no minibatch, every minibatch of `gy` is accumulated into
+    // the same rows of `gx`.
+    const unsigned r = i % size;
+    const unsigned b_begin = has_batch ? i / size : 0;
+    const unsigned b_end = has_batch ? b_begin + 1 : bs;
+    float g[ROW_BLOCK_SIZE];
+    for (unsigned k = 0; k < width; ++k) g[k] = 0;
+    for (unsigned b = b_begin; b < b_end; ++b) {
+      const float *pg = pgy + b * size + r;
+      for (unsigned k = 0; k < width; ++k) g[k] += pg[k];
+    }
+    for (unsigned j = 0; j < n; ++j) {
+      const unsigned o = offset + j * skip1;
+      for (unsigned k = 0; k < width; ++k) {
+        pgx[o + k] += std::exp(px[o + k] - pl[i + k]) * g[k];
+      }
+    }
+    for (unsigned b = b_begin; b < b_end; ++b) {
+      const float *pg = pgy + b * size + r;
+      float *q = pgx + offset + ids[b * skip_i] * skip1;
+      for (unsigned k = 0; k < width; ++k) q[k] -= pg[k];
+    }
+  });
+}
+
+void Naive::lstm_cell_fw_impl(
+    const Tensor &u, const Tensor &c, Tensor &gates, Tensor &y) {
+  const unsigned n = c.shape()[0];
+  const unsigned size = c.shape().volume();
+  const unsigned skip_u = u.shape().has_batch() * 4 * size;
+  const unsigned skip_c = c.shape().has_batch() * size;
+  const float *pu = CDATA(u);
+  const float *pc = CDATA(c);
+  float *pg = DATA(gates);
+  float *py = DATA(y);
+  const unsigned total = y.shape().size() / 2;
+  pool_.parallel_for(total, GRAIN_SIZE, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      const unsigned b = i / size;
+      const unsigned r = i % size;
+      const unsigned ou = b * skip_u + 3 * (r - r % n) + r;
+      const float vi = .5 + .5 * std::tanh(.5 * pu[ou]);
+      const float vf = .5 + .5 * std::tanh(.5 * pu[ou + n]);
+      const float vo = .5 + .5 * std::tanh(.5 * pu[ou + 2 * n]);
+      const float vj = std::tanh(pu[ou + 3 * n]);
+      const float vc = vi * vj + vf * pc[b * skip_c + r];
+      // If `u` has no minibatch, its gates are written only by the first
+      // minibatch to avoid data races.
+      if (skip_u || !b) {
+        pg[ou] = vi;
+        pg[ou + n] = vf;
+        pg[ou + 2 * n] = vo;
+        pg[ou + 3 * n] = vj;
+      }
+      const unsigned oy = b * 2 * size + r + (r - r % n);
+      py[oy] = vo * std::tanh(vc);
+      py[oy + n] = vc;
+    }
+  });
+}
+
+void Naive::lstm_cell_bw_impl(
+    const Tensor &c, const Tensor &gates, const Tensor &y, const Tensor &gy,
+    Tensor &gu, Tensor &gc) {
+  const unsigned n = c.shape()[0];
+  const unsigned size = c.shape().volume();
+  const unsigned bs = y.shape().batch();
+  const unsigned skip_u = gates.shape().has_batch() * 4 * size;
+  const unsigned skip_c = c.shape().has_batch() * size;
+  const float *pc = CDATA(c);
+  const float *pg = CDATA(gates);
+  const float *py = CDATA(y);
+  const float *pgy = CDATA(gy);
+  float *pgu = DATA(gu);
+  float *pgc = DATA(gc);
+  // Each thread processes all minibatches of the same element so that the
+  // gradients of the broadcasted arguments are accumulated without races.
+  pool_.parallel_for(size, grain_of(10 * bs), [&](unsigned begin, unsigned end) {
+    for (unsigned r = begin; r < end; ++r) {
+      for (unsigned b = 0; b < bs; ++b) {
+        const unsigned ou = b * skip_u + 3 * (r - r % n) + r;
+        const unsigned oc = b * skip_c + r;
+        const unsigned oy = b * 2 * size + r + (r - r % n);
+        const float vi = pg[ou];
+        const float vf = pg[ou + n];
+        const float vo = pg[ou + 2 * n];
+        const float vj = pg[ou + 3 * n];
+        const float tc = std::tanh(py[oy + n]);
+        const float gh = pgy[oy];
+        const float dc = pgy[oy + n] + gh * vo * (1. - tc * tc);
+        pgu[ou] += dc * vj * vi * (1. - vi);
+        pgu[ou + n] += dc * pc[oc] * vf * (1. - vf);
+        pgu[ou + 2 * n] += gh * tc * vo * (1. - vo);
+        pgu[ou + 3 * n] += dc * vi * (1. - vj * vj);
+        pgc[oc] += dc * vf;
+      }
+    }
+  });
 }
 
 void Naive::inplace_multiply_const_impl(float k, Tensor &x) {
   const unsigned size = x.shape().size();
   float *dest = DATA(x);
-  REPEAT_OP(i, size, dest[i] *= k);
+  PARALLEL_REPEAT_OP(i, size, dest[i] *= k);
 }
 
 void Naive::inplace_add_impl(const Tensor &x, Tensor &y) {
@@ -637,13 +1083,17 @@ void Naive::inplace_add_impl(const Tensor &x, Tensor &y) {
   const unsigned bs = std::max(sx.batch(), sy.batch());
   const unsigned b_skip_d = sy.has_batch() * size;
   const unsigned b_skip_s = sx.has_batch() * size;
-  float *dest = DATA(y);
-  const float *src = CDATA(x);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    REPEAT_OP(i, size, dest[i] += src[i]);
-    dest += b_skip_d;
-    src += b_skip_s;
-  }
+  float *dest_base = DATA(y);
+  const float *src_base = CDATA(x);
+  pool_.parallel_for(size, grain_of(bs), [&](unsigned begin, unsigned end) {
+    float *dest = dest_base;
+    const float *src = src_base;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) { dest[i] += src[i]; }
+      dest += b_skip_d;
+      src += b_skip_s;
+    }
+  });
 }
 
 void Naive::inplace_subtract_impl(const Tensor &x, Tensor &y) {
@@ -653,14 +1103,192 @@ void Naive::inplace_subtract_impl(const Tensor &x, Tensor &y) {
   const unsigned bs = std::max(sx.batch(), sy.batch());
   const unsigned b_skip_d = sy.has_batch() * size;
   const unsigned b_skip_s = sx.has_batch() * size;
+  float *dest_base = DATA(y);
+  const float *src_base = CDATA(x);
+  pool_.parallel_for(size, grain_of(bs), [&](unsigned begin, unsigned end) {
+    float *dest = dest_base;
+    const float *src = src_base;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) { dest[i] -= src[i]; }
+      dest += b_skip_d;
+      src += b_skip_s;
+    }
+  });
+}
+
+void Naive::inplace_matmul_add_impl(
+    const Tensor &a, const Tensor &b, Tensor &y) {
+  const unsigned d1 = a.shape()[0];
+  const unsigned d2 = a.shape()[1];
+  const unsigned d3 = b.shape()[1];
+  const unsigned bs = y.shape().batch();
   float *dest = DATA(y);
+  const float *src_a = CDATA(a);
+  const float *src_b = CDATA(b);
+
+  if (a.shape().has_batch()) {
+    const unsigned b_skip = b.shape().has_batch() * d2 * d3;
+    gemm(
+        false, false, d1, d3, d2, src_a, src_b, true, dest,
+        bs, d1 * d2, b_skip, d1 * d3);
+  } else {
+    gemm(false, false, d1, d3 * bs, d2, src_a, src_b, true, dest);
+  }
+}
+
+void Naive::inplace_pick_assign_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  const unsigned bs = x.shape().batch();
+  const unsigned skip_y = y.shape().has_batch() * y.shape().volume();
+  const unsigned skip_i = ids.size() > 1;
+  const unsigned base = x.shape().lower_volume(dim);
+  const unsigned skip = base * y.shape()[dim];
+  const unsigned repeat = x.shape().volume() / base;
   const float *src = CDATA(x);
   for (unsigned batch = 0; batch < bs; ++batch) {
-    REPEAT_OP(i, size, dest[i] -= src[i]);
-    dest += b_skip_d;
-    src += b_skip_s;
+    float *dest = DATA(y) + batch * skip_y + base * ids[batch * skip_i];
+    for (unsigned i = 0; i < repeat; ++i) {
+      float *dp = dest;
+      REPEAT_OP(j, base, *dp++ = *src++);
+      dest += skip;
+    }
   }
 }
 
+void Naive::inplace_pick_reset_impl(
+    float k, const std::vector<unsigned> &ids, unsigned dim, Tensor &x) {
+  const unsigned bs = std::max<unsigned>(x.shape().batch(), ids.size());
+  const unsigned skip_x = x.shape().has_batch() * x.shape().volume();
+  const unsigned skip_i = ids.size() > 1;
+  const unsigned base = x.shape().lower_volume(dim);
+  const unsigned skip = base * x.shape()[dim];
+  const unsigned repeat = x.shape().volume() / skip;
+  for (unsigned batch = 0; batch < bs; ++batch) {
+    float *dest = DATA(x) + batch * skip_x + base * ids[batch * skip_i];
+    for (unsigned i = 0; i < repeat; ++i) {
+      float *dp = dest;
+      REPEAT_OP(j, base, *dp++ = k);
+      dest += skip;
+    }
+  }
+}
+
+float Naive::squared_norm_impl(const std::vector<const Tensor *> &xs) {
+  // Partial sums are calculated for each fixed-size chunk so that the result
+  // does not depend on the number of threads.
+  double ret = 0;
+  for (const Tensor *x : xs) {
+    const unsigned size = x->shape().size();
+    const unsigned num_chunks = (size + GRAIN_SIZE - 1) / GRAIN_SIZE;
+    const float *src = CDATA(*x);
+    std::vector<double> sums(num_chunks);
+    pool_.parallel_for(num_chunks, 1, [&](unsigned begin, unsigned end) {
+      for (unsigned c = begin; c < end; ++c) {
+        const unsigned chunk_end = std::min(size, (c + 1) * GRAIN_SIZE);
+        double tmp = 0;
+        for (unsigned i = c * GRAIN_SIZE; i < chunk_end; ++i) {
+          tmp += src[i] * src[i];
+        }
+        sums[c] = tmp;
+      }
+    });
+    for (double s : sums) ret += s;
+  }
+  return ret;
+}
+
+void Naive::sgd_update_impl(float eta, const Tensor &g, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const float *pg = CDATA(g);
+  float *px = DATA(x);
+  PARALLEL_REPEAT_OP(i, size, px[i] -= eta * pg[i]);
+}
+
+void Naive::momentum_sgd_update_impl(
+    float eta, float momentum, const Tensor &g, Tensor &m, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const float *pg = CDATA(g);
+  float *pm = DATA(m);
+  float *px = DATA(x);
+  pool_.parallel_for(size, grain_of(4), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      pm[i] = momentum * pm[i] - eta * pg[i];
+      px[i] += pm[i];
+    }
+  });
+}
+
+void Naive::adagrad_update_impl(
+    float eta, float eps, const Tensor &g, Tensor &m, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const float *pg = CDATA(g);
+  float *pm = DATA(m);
+  float *px = DATA(x);
+  pool_.parallel_for(size, grain_of(8), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      const float gi = pg[i];
+      pm[i] += gi * gi;
+      px[i] -= eta * gi / (std::sqrt(pm[i]) + eps);
+    }
+  });
+}
+
+void Naive::rmsprop_update_impl(
+    float eta, float alpha, float eps, const Tensor &g, Tensor &m, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const float k = 1 - alpha;
+  const float *pg = CDATA(g);
+  float *pm = DATA(m);
+  float *px = DATA(x);
+  pool_.parallel_for(size, grain_of(8), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      const float gi = pg[i];
+      pm[i] = alpha * pm[i] + k * gi * gi;
+      px[i] -= eta * gi / (std::sqrt(pm[i]) + eps);
+    }
+  });
+}
+
+void Naive::adadelta_update_impl(
+    float scale, float rho, float eps, const Tensor &g,
+    Tensor &m1, Tensor &m2, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const float k = 1 - rho;
+  const float *pg = CDATA(g);
+  float *pm1 = DATA(m1);
+  float *pm2 = DATA(m2);
+  float *px = DATA(x);
+  pool_.parallel_for(size, grain_of(16), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      const float gi = pg[i];
+      pm2[i] = rho * pm2[i] + k * gi * gi;
+      const float dx = std::sqrt((pm1[i] + eps) / (pm2[i] + eps)) * gi;
+      pm1[i] = rho * pm1[i] + k * dx * dx;
+      px[i] -= scale * dx;
+    }
+  });
+}
+
+void Naive::adam_update_impl(
+    float alpha, float beta1, float beta2, float eps, float bias1, float bias2,
+    const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) {
+  const unsigned size = x.shape().size();
+  const float k1 = 1 - beta1;
+  const float k2 = 1 - beta2;
+  const float *pg = CDATA(g);
+  float *pm1 = DATA(m1);
+  float *pm2 = DATA(m2);
+  float *px = DATA(x);
+  pool_.parallel_for(size, grain_of(16), [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      const float gi = pg[i];
+      pm1[i] = beta1 * pm1[i] + k1 * gi;
+      pm2[i] = beta2 * pm2[i] + k2 * gi * gi;
+      px[i] -= alpha * (pm1[i] / bias1) / (std::sqrt(pm2[i] / bias2) + eps);
+    }
+  });
+}
+
 }  // namespace devices
 }  // namespace primitiv
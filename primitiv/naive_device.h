@@ -1,8 +1,11 @@
 #ifndef PRIMITIV_NAIVE_DEVICE_H_
 #define PRIMITIV_NAIVE_DEVICE_H_
 
+#include <mutex>
 #include <random>
+#include <primitiv/cpu_memory_pool.h>
 #include <primitiv/device.h>
+#include <primitiv/thread_pool.h>
 
 namespace primitiv {
 namespace devices {
@@ -17,19 +20,48 @@ public:
    * @remarks The internal random number generator is initialized by
    *          `std::random_device`.
    */
-  Naive() : rng_(std::random_device()()) {}
+  Naive() : rng_(std::random_device()()), pool_(1) {}
 
   /**
    * Creates a Naive object.
    * @param rng_seed The seed value of internal random number generator.
    */
-  explicit Naive(unsigned rng_seed) : rng_(rng_seed) {}
+  explicit Naive(unsigned rng_seed) : rng_(rng_seed), pool_(1) {}
+
+  /**
+   * Creates a Naive object which runs large operations on multiple threads.
+   * @param rng_seed The seed value of internal random number generator.
+   * @param num_threads Number of threads used in each operation.
+   * @throw primitiv::Error `num_threads` is 0.
+   * @remarks Random number generators always run on a single thread to keep
+   *          the results reproducible.
+   */
+  Naive(unsigned rng_seed, unsigned num_threads)
+    : rng_(rng_seed), pool_(num_threads) {}
 
   ~Naive() override = default;
 
   void dump_description() const override;
   Device::DeviceType type() const override { return Device::DEVICE_TYPE_CPU; }
 
+  /**
+   * Retrieves the number of threads used in each operation.
+   * @return Number of threads.
+   */
+  unsigned num_threads() const { return pool_.num_threads(); }
+
+  /**
+   * Retrieves the memory pool which holds all tensors on this device.
+   * @return Reference of the memory pool.
+   */
+  CPUMemoryPool &memory_pool() { return mem_pool_; }
+
+  /**
+   * Retrieves the memory pool which holds all tensors on this device.
+   * @return Const reference of the memory pool.
+   */
+  const CPUMemoryPool &memory_pool() const { return mem_pool_; }
+
 private:
   std::shared_ptr<void> new_handle(const Shape &shape) override;
 
@@ -131,13 +163,64 @@ private:
   void broadcast_fw_impl(const Tensor &x, unsigned dim, unsigned size, Tensor &y) override;
   void batch_sum_fw_impl(const Tensor &x, Tensor &y) override;
 
+  void softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+  void log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+
+  void softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+  void log_softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+
+  void sparse_softmax_cross_entropy_fw_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &lse, Tensor &y) override;
+  void sparse_softmax_cross_entropy_bw_impl(const Tensor &x, const Tensor &lse, const std::vector<unsigned> &ids, const Tensor &gy, unsigned dim, Tensor &gx) override;
+
+  void lstm_cell_fw_impl(const Tensor &u, const Tensor &c, Tensor &gates, Tensor &y) override;
+  void lstm_cell_bw_impl(const Tensor &c, const Tensor &gates, const Tensor &y, const Tensor &gy, Tensor &gu, Tensor &gc) override;
+
   void inplace_multiply_const_impl(float k, Tensor &x) override;
 
   void inplace_add_impl(const Tensor &x, Tensor &y) override;
   void inplace_subtract_impl(const Tensor &x, Tensor &y) override;
+  void inplace_matmul_add_impl(const Tensor &a, const Tensor &b, Tensor &y) override;
+  void inplace_pick_assign_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) override;
+  void inplace_pick_reset_impl(float k, const std::vector<unsigned> &ids, unsigned dim, Tensor &x) override;
+
+  float squared_norm_impl(const std::vector<const Tensor *> &xs) override;
+
+  void sgd_update_impl(float eta, const Tensor &g, Tensor &x) override;
+  void momentum_sgd_update_impl(float eta, float momentum, const Tensor &g, Tensor &m, Tensor &x) override;
+  void adagrad_update_impl(float eta, float eps, const Tensor &g, Tensor &m, Tensor &x) override;
+  void rmsprop_update_impl(float eta, float alpha, float eps, const Tensor &g, Tensor &m, Tensor &x) override;
+  void adadelta_update_impl(float scale, float rho, float eps, const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) override;
+  void adam_update_impl(float alpha, float beta1, float beta2, float eps, float bias1, float bias2, const Tensor &g, Tensor &m1, Tensor &m2, Tensor &x) override;
 
 private:
+  /**
+   * Calculates the matrix product `C = op(A) . op(B) (+ C)`.
+   * @param trans_a Whether `op(A)` is `A^T` or `A`.
+   * @param trans_b Whether `op(B)` is `B^T` or `B`.
+   * @param m Number of rows of `op(A)` and `C`.
+   * @param n Number of columns of `op(B)` and `C`.
+   * @param k Number of columns of `op(A)` and rows of `op(B)`.
+   * @param a Pointer to the column-major matrix `A`.
+   * @param b Pointer to the column-major matrix `B`.
+   * @param accumulate Whether the product is added to `C` or overwrites `C`.
+   * @param c Pointer to the column-major matrix `C`.
+   * @param batch Number of products.
+   * @param a_skip Distance between adjacent matrices `A`.
+   * @param b_skip Distance between adjacent matrices `B`.
+   * @param c_skip Distance between adjacent matrices `C`. If this is 0, all
+   *               products are accumulated into the same `C`.
+   * @remarks All columns of all products are calculated in parallel.
+   */
+  void gemm(
+      bool trans_a, bool trans_b, unsigned m, unsigned n, unsigned k,
+      const float *a, const float *b, bool accumulate, float *c,
+      unsigned batch = 1,
+      unsigned a_skip = 0, unsigned b_skip = 0, unsigned c_skip = 0);
+
   std::mt19937 rng_;
+  std::mutex rng_mutex_;
+  CPUMemoryPool mem_pool_;
+  ThreadPool pool_;
 };
 
 }  // namespace devices
@@ -141,6 +141,12 @@ Node concat(const std::vector<const Node *> &xs, unsigned dim) {
   return concat(::ptr_to_obj(xs), dim);
 }
 
+template<>
+std::vector<Node> split(const Node &x, unsigned dim, unsigned n) {
+  return x.graph().add_multivalued_function(
+      std::unique_ptr<Function>(new F::Split(dim, n)), {x});
+}
+
 template<>
 Node reshape(const Node &x, const Shape &shape) {
   return REGX(x, Reshape(shape), x);
@@ -243,12 +249,12 @@ Node logsumexp(const Node &x, unsigned dim) {
 
 template<>
 Node log_softmax(const Node &x, unsigned dim) {
-  return x - broadcast(logsumexp(x, dim), dim, x.shape()[dim]);
+  return REGX(x, LogSoftmax(dim), x);
 }
 
 template<>
 Node softmax(const Node &x, unsigned dim) {
-  return exp(log_softmax(x, dim));
+  return REGX(x, Softmax(dim), x);
 }
 
 template<>
@@ -261,6 +267,36 @@ Node softmax_cross_entropy(const Node &x, const std::vector<unsigned> &ids, unsi
   return REGX(x, SparseSoftmaxCrossEntropy(ids, dim), x);
 }
 
+template<>
+Node chunked_softmax_cross_entropy(
+    const Node &x, const Node &w, const Node &b,
+    const std::vector<unsigned> &ids, unsigned chunk_size) {
+  return REGX(x, ChunkedSoftmaxCrossEntropy(ids, chunk_size), x, w, b);
+}
+
+template<>
+std::pair<Node, Node> lstm_cell(
+    const Node &x, const Node &h, const Node &c,
+    const Node &wx, const Node &wh, const Node &b) {
+  // The new output and cell state are calculated together and separated by
+  // splitting the stacked result. The second value holds the activated gates
+  // required by the backward pass.
+  const Node y = x.graph().add_multivalued_function(
+      std::unique_ptr<Function>(new F::LSTMCell()), {x, h, c, wx, wh, b})[0];
+  const std::vector<Node> ys = split(y, 0, 2);
+  return std::make_pair(ys[0], ys[1]);
+}
+
+template<>
+std::pair<Node, Node> lstm(
+    const Node &x, const Node &h, const Node &c,
+    const Node &wx, const Node &wh, const Node &b) {
+  const Node y = x.graph().add_multivalued_function(
+      std::unique_ptr<Function>(new F::LSTM()), {x, h, c, wx, wh, b})[0];
+  const std::vector<Node> ys = split(y, 0, 2);
+  return std::make_pair(ys[0], ys[1]);
+}
+
 namespace batch {
 
 template<>
@@ -268,6 +304,11 @@ Node sum(const Node &x) {
   return REGX(x, BatchSum(), x);
 }
 
+template<>
+Node to_columns(const Node &x) {
+  return REGX(x, BatchToColumns(), x);
+}
+
 }  // namespace batch
 
 Node constant(const Shape &shape, float k, Device &dev, Graph &g) {
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <initializer_list>
 #include <limits>
+#include <utility>
 #include <vector>
 
 #include <primitiv/device.h>
@@ -57,6 +58,31 @@ type_traits::Identity<Var> operator/(float k, const Var &x);
 template<typename Var>
 type_traits::Identity<Var> operator/(const Var &a, const Var &b);
 
+// Following overloads take temporary tensors and calculate the results in the
+// memory of the arguments if possible. Arguments whose memory is moved to the
+// results become invalid.
+Tensor operator-(Tensor &&x);
+Tensor operator+(Tensor &&x, float k);
+Tensor operator+(float k, Tensor &&x);
+Tensor operator+(Tensor &&a, const Tensor &b);
+Tensor operator+(const Tensor &a, Tensor &&b);
+Tensor operator+(Tensor &&a, Tensor &&b);
+Tensor operator-(Tensor &&x, float k);
+Tensor operator-(float k, Tensor &&x);
+Tensor operator-(Tensor &&a, const Tensor &b);
+Tensor operator-(const Tensor &a, Tensor &&b);
+Tensor operator-(Tensor &&a, Tensor &&b);
+Tensor operator*(Tensor &&x, float k);
+Tensor operator*(float k, Tensor &&x);
+Tensor operator*(Tensor &&a, const Tensor &b);
+Tensor operator*(const Tensor &a, Tensor &&b);
+Tensor operator*(Tensor &&a, Tensor &&b);
+Tensor operator/(Tensor &&x, float k);
+Tensor operator/(float k, Tensor &&x);
+Tensor operator/(Tensor &&a, const Tensor &b);
+Tensor operator/(const Tensor &a, Tensor &&b);
+Tensor operator/(Tensor &&a, Tensor &&b);
+
 namespace operators {
 
 Node input(
@@ -121,6 +147,22 @@ inline type_traits::ReducePtr<Container> concat(
   return concat(std::vector<const Var *>(xs.begin(), xs.end()), dim);
 }
 
+/**
+ * Splits the variable into equal-sized pieces along the given dimension.
+ * @param x Variable to be split.
+ * @param dim Dimension to split.
+ * @param n Number of pieces.
+ * @return `n` variables. The `i`-th variable is equal to
+ *         `slice(x, dim, i * span, (i + 1) * span)` where
+ *         `span == x.shape()[dim] / n`.
+ * @throw primitiv::Error `n` is 0 or `x.shape()[dim]` is not divisible by `n`.
+ * @remarks For Node, all pieces are calculated by one function, and their
+ *          gradients are accumulated into `x` at once.
+ */
+template<typename Var>
+std::vector<type_traits::Identity<Var>> split(
+    const Var &x, unsigned dim, unsigned n);
+
 template<typename Var>
 type_traits::Identity<Var> reshape(const Var &x, const Shape &new_shape);
 
@@ -133,6 +175,23 @@ type_traits::Identity<Var> transpose(const Var &x);
 template<typename Var>
 type_traits::Identity<Var> matmul(const Var &a, const Var &b);
 
+// Following overloads take temporary tensors and calculate the results in the
+// memory of the arguments if possible. Arguments whose memory is moved to the
+// results become invalid.
+Tensor sqrt(Tensor &&x);
+Tensor exp(Tensor &&x);
+Tensor log(Tensor &&x);
+Tensor tanh(Tensor &&x);
+Tensor sigmoid(Tensor &&x);
+Tensor softplus(Tensor &&x);
+Tensor sin(Tensor &&x);
+Tensor cos(Tensor &&x);
+Tensor tan(Tensor &&x);
+Tensor relu(Tensor &&x);
+Tensor lrelu(Tensor &&x);
+Tensor prelu(Tensor &&x, float a);
+Tensor elu(Tensor &&x, float a);
+
 template<typename Var>
 type_traits::Identity<Var> sqrt(const Var &x);
 
@@ -253,6 +312,66 @@ template<typename Var>
 type_traits::Identity<Var> softmax_cross_entropy(
     const Var &x, const std::vector<unsigned> &ids, unsigned dim);
 
+/**
+ * Calculates the softmax cross entropy of the output layer
+ * `matmul(w, x) + b` without storing whole logits at once.
+ * @param x Input values of the output layer.
+ * @param w Weight matrix with the shape `{vocab, x.shape()[0]}`.
+ * @param b Bias vector which is added to `matmul(w, x)`.
+ * @param ids List of label IDs.
+ * @param chunk_size Number of rows of `w` processed at once.
+ * @return Same value as
+ *         `softmax_cross_entropy(matmul(w, x) + b, ids, 0)`.
+ * @throw primitiv::Error `chunk_size` is 0, or shapes are invalid.
+ * @remarks Logits are calculated for every chunk of the vocabulary and
+ *          accumulated by the online logsumexp, and recalculated in the
+ *          backward pass. Temporary memory depends on `chunk_size` rather
+ *          than the vocabulary size.
+ */
+template<typename Var>
+type_traits::Identity<Var> chunked_softmax_cross_entropy(
+    const Var &x, const Var &w, const Var &b,
+    const std::vector<unsigned> &ids, unsigned chunk_size);
+
+/**
+ * Calculates one step of the LSTM.
+ * @param x Input values.
+ * @param h Previous output values.
+ * @param c Previous cell state.
+ * @param wx Weight matrix for `x` with the shape `{4 * n, x.shape()[0]}`.
+ * @param wh Weight matrix for `h` with the shape `{4 * n, n}`.
+ * @param b Bias vector with the shape `{4 * n}`.
+ * @return A pair of the new output values and the new cell state.
+ * @remarks Rows of `wx`, `wh` and `b` are arranged in the order of the input,
+ *          forget, output gates and the candidate value.
+ *          Gates and states are calculated by a fused kernel in both forward
+ *          and backward passes.
+ */
+template<typename Var>
+std::pair<type_traits::Identity<Var>, type_traits::Identity<Var>> lstm_cell(
+    const Var &x, const Var &h, const Var &c,
+    const Var &wx, const Var &wh, const Var &b);
+
+/**
+ * Calculates the LSTM over a whole sequence.
+ * @param x Input values of all steps with the shape `{x_size, length}`.
+ * @param h Initial output values.
+ * @param c Initial cell state.
+ * @param wx Weight matrix for `x` with the shape `{4 * n, x_size}`.
+ * @param wh Weight matrix for `h` with the shape `{4 * n, n}`.
+ * @param b Bias vector with the shape `{4 * n}`.
+ * @return A pair of the output values and the cell states of all steps, both
+ *         with the shape `{n, length}`.
+ * @remarks This function is equivalent to applying `lstm_cell` to each column
+ *          of `x`, but the input projection `matmul(wx, x)` of all steps is
+ *          calculated by one matrix product, and only the recurrent part is
+ *          calculated step by step in both forward and backward passes.
+ */
+template<typename Var>
+std::pair<type_traits::Identity<Var>, type_traits::Identity<Var>> lstm(
+    const Var &x, const Var &h, const Var &c,
+    const Var &wx, const Var &wh, const Var &b);
+
 namespace batch {
 
 template<typename Var>
@@ -263,6 +382,17 @@ inline type_traits::Identity<Var> mean(const Var &x) {
   return sum(x) / x.shape().batch();
 }
 
+/**
+ * Arranges minibatches as columns of a matrix.
+ * @param x A variable.
+ * @return A matrix with the shape `{x.shape().volume(), x.shape().batch()}`
+ *         without minibatch, whose `i`-th column is `flatten(x)` of the `i`-th
+ *         minibatch.
+ * @remarks For Tensor, the result shares the memory of `x`.
+ */
+template<typename Var>
+type_traits::Identity<Var> to_columns(const Var &x);
+
 template<typename Var>
 inline type_traits::Identity<Var> normalize(const Var &x) {
   if (!x.shape().has_batch()) return x;  // No meaning of normalization.
@@ -275,6 +405,82 @@ inline type_traits::Identity<Var> normalize(const Var &x) {
 
 }  // namespace batch
 
+/**
+ * Draws candidate IDs for sampled losses.
+ * @param distribution Sampling weights of all IDs, e.g., unigram frequencies
+ *                     or the log-uniform distribution. Weights are normalized
+ *                     in this function.
+ * @param num_samples Number of draws.
+ * @param dev Device whose random number generator is used.
+ * @return Sorted list of unique IDs which were drawn at least once.
+ * @throw primitiv::Error `distribution` has no positive weight.
+ */
+std::vector<unsigned> sample_candidates(
+    const std::vector<float> &distribution, unsigned num_samples,
+    Device &dev);
+
+/**
+ * Calculates the logarithm of the probability that each ID is drawn at least
+ * once by `sample_candidates`.
+ * @param distribution Sampling weights passed to `sample_candidates`.
+ * @param num_samples Number of draws passed to `sample_candidates`.
+ * @param ids List of IDs.
+ * @return `log(1 - (1 - p[i]) ^ num_samples)` for each ID `i` in `ids`.
+ * @throw primitiv::Error Some IDs are out of range or never drawn.
+ */
+std::vector<float> log_expected_counts(
+    const std::vector<float> &distribution, unsigned num_samples,
+    const std::vector<unsigned> &ids);
+
+/**
+ * Calculates the sampled softmax cross entropy of the output layer
+ * `matmul(w, x) + b`.
+ * @param x Input values of the output layer.
+ * @param w Weight matrix with the shape `{vocab, x.shape()[0]}`.
+ * @param b Bias vector with the shape `{vocab}`.
+ * @param ids List of label IDs.
+ * @param distribution Sampling weights of all IDs.
+ * @param num_samples Number of draws of negative candidates.
+ * @return Softmax cross entropy over the labels and the sampled candidates,
+ *         whose logits are corrected by `log_expected_counts`.
+ * @throw primitiv::Error Some labels have no positive weight in
+ *                        `distribution`, or `num_samples` is 0.
+ * @remarks Only rows of `w` and `b` for the labels and the candidates are
+ *          used, and gradients are propagated only to them. Rows of all
+ *          candidates are gathered by one `pick`. Candidates which are equal
+ *          to the label of the same minibatch are ignored.
+ */
+template<typename Var>
+inline type_traits::Identity<Var> sampled_softmax_cross_entropy(
+    const Var &x, const Var &w, const Var &b,
+    const std::vector<unsigned> &ids,
+    const std::vector<float> &distribution, unsigned num_samples) {
+  Device &dev = x.device();
+  const std::vector<unsigned> cands
+    = sample_candidates(distribution, num_samples, dev);
+  const std::vector<float> cand_log_q
+    = log_expected_counts(distribution, num_samples, cands);
+  const std::vector<float> target_log_q
+    = log_expected_counts(distribution, num_samples, ids);
+  const unsigned k = cands.size();
+  const unsigned bs = ids.size();
+  std::vector<float> cand_adj(k * bs);
+  for (unsigned i = 0; i < bs; ++i) {
+    for (unsigned j = 0; j < k; ++j) {
+      // -1e30 removes accidental hits from the softmax.
+      cand_adj[i * k + j] = cands[j] == ids[i] ? -1e30 : -cand_log_q[j];
+    }
+  }
+  // pick(w, cands, 0) has the row of each candidate as a minibatch.
+  const Var cand_w = transpose(batch::to_columns(pick(w, cands, 0)));
+  const Var cand_b = flatten(batch::to_columns(pick(b, cands, 0)));
+  const Var tz = matmul(pick(w, ids, 0), x) + pick(b, ids, 0)
+    - input<Var>(Shape({1}, bs), target_log_q, dev);
+  const Var cz = matmul(cand_w, x) + cand_b
+    + input<Var>(Shape({k}, bs), cand_adj, dev);
+  return logsumexp(concat(std::vector<Var> {tz, cz}, 0), 0) - tz;
+}
+
 Node constant(const Shape &shape, float k, Device &dev, Graph &g);
 
 inline Node zeros(const Shape &shape, Device &dev, Graph &g) {
@@ -337,6 +543,61 @@ inline type_traits::Identity<Var> ipow(const Var &x, int k) {
   else return 1.0 / ret;
 }
 
+/**
+ * Following functions calculate the same values as the corresponding
+ * operations, and write the results into the existing tensor `y` instead of
+ * allocating a new tensor.
+ * @param y Tensor to store the result. `y` must be on the same device as the
+ *          arguments and have the same shape as the result.
+ * @throw primitiv::Error Shape or device of `y` is mismatched, or `y` is an
+ *                        argument of operations other than elementwise
+ *                        ones.
+ * @remarks `y` can be an argument of elementwise operations to calculate the
+ *          result in place. If `y` shares its memory with other tensors,
+ *          `y` is detached from them and a new memory is allocated.
+ */
+void pick_into(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y);
+void slice_into(
+    const Tensor &x, unsigned dim, unsigned lower, unsigned upper, Tensor &y);
+void concat_into(const std::vector<Tensor> &xs, unsigned dim, Tensor &y);
+void concat_into(
+    const std::vector<const Tensor *> &xs, unsigned dim, Tensor &y);
+void negate_into(const Tensor &x, Tensor &y);
+void add_into(const Tensor &x, float k, Tensor &y);
+void add_into(float k, const Tensor &x, Tensor &y);
+void add_into(const Tensor &a, const Tensor &b, Tensor &y);
+void subtract_into(const Tensor &x, float k, Tensor &y);
+void subtract_into(float k, const Tensor &x, Tensor &y);
+void subtract_into(const Tensor &a, const Tensor &b, Tensor &y);
+void multiply_into(const Tensor &x, float k, Tensor &y);
+void multiply_into(float k, const Tensor &x, Tensor &y);
+void multiply_into(const Tensor &a, const Tensor &b, Tensor &y);
+void divide_into(const Tensor &x, float k, Tensor &y);
+void divide_into(float k, const Tensor &x, Tensor &y);
+void divide_into(const Tensor &a, const Tensor &b, Tensor &y);
+void sqrt_into(const Tensor &x, Tensor &y);
+void exp_into(const Tensor &x, Tensor &y);
+void log_into(const Tensor &x, Tensor &y);
+void tanh_into(const Tensor &x, Tensor &y);
+void sigmoid_into(const Tensor &x, Tensor &y);
+void softplus_into(const Tensor &x, Tensor &y);
+void sin_into(const Tensor &x, Tensor &y);
+void cos_into(const Tensor &x, Tensor &y);
+void tan_into(const Tensor &x, Tensor &y);
+void relu_into(const Tensor &x, Tensor &y);
+void lrelu_into(const Tensor &x, Tensor &y);
+void prelu_into(const Tensor &x, float a, Tensor &y);
+void elu_into(const Tensor &x, float a, Tensor &y);
+void transpose_into(const Tensor &x, Tensor &y);
+void matmul_into(const Tensor &a, const Tensor &b, Tensor &y);
+void softmax_into(const Tensor &x, unsigned dim, Tensor &y);
+void log_softmax_into(const Tensor &x, unsigned dim, Tensor &y);
+void sum_into(const Tensor &x, unsigned dim, Tensor &y);
+void logsumexp_into(const Tensor &x, unsigned dim, Tensor &y);
+void broadcast_into(const Tensor &x, unsigned dim, unsigned size, Tensor &y);
+
 namespace random {
 
 Node bernoulli(
@@ -381,6 +642,18 @@ inline type_traits::Identity<Var> gumbel(
   return mu - beta * log(-log(uniform<Var>(shape, 0, .9999999, dev)));
 }
 
+/**
+ * Following functions overwrite all values of the existing tensor `y` by
+ * random values.
+ * @param y Tensor to store random values. The shape and the device of `y` are
+ *          used as those of the distribution.
+ * @throw primitiv::Error Parameters of the distribution are invalid.
+ */
+void bernoulli_into(float p, Tensor &y);
+void uniform_into(float lower, float upper, Tensor &y);
+void normal_into(float mean, float sd, Tensor &y);
+void log_normal_into(float mean, float sd, Tensor &y);
+
 }  // namespace random
 
 template<typename Var>
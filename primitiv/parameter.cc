@@ -1,5 +1,6 @@
 #include <config.h>
 
+#include <algorithm>
 #include <fstream>
 #include <primitiv/error.h>
 #include <primitiv/initializer.h>
@@ -94,7 +95,9 @@ Parameter::Parameter(
 : shape_(shape)
 , device_(&device)
 , value_(operators::input<Tensor>(shape, value, device))
-, grad_(operators::zeros<Tensor>(shape, device)) {
+, grad_(operators::zeros<Tensor>(shape, device))
+, sparse_(false)
+, grad_dirty_(false) {
   ::check_shape(value_, grad_);
 }
 
@@ -105,7 +108,9 @@ Parameter::Parameter(
 : shape_(shape)
 , device_(&device)
 , value_(operators::zeros<Tensor>(shape, device))
-, grad_(operators::zeros<Tensor>(shape, device)) {
+, grad_(operators::zeros<Tensor>(shape, device))
+, sparse_(false)
+, grad_dirty_(false) {
   ::check_shape(value_, grad_);
   initializer.apply(value_);
 }
@@ -124,6 +129,8 @@ void Parameter::init(
   value_ = std::move(value_temp);
   grad_ = std::move(grad_temp);
   stats_.clear();
+  grad_dirty_ = false;
+  sparse_ids_.clear();
 }
 
 void Parameter::init(
@@ -141,6 +148,8 @@ void Parameter::init(
   value_ = std::move(value_temp);
   grad_ = std::move(grad_temp);
   stats_.clear();
+  grad_dirty_ = false;
+  sparse_ids_.clear();
 }
 
 void Parameter::load(const string &path, bool with_stats, Device &device) {
@@ -178,6 +187,8 @@ void Parameter::load(const string &path, bool with_stats, Device &device) {
   value_ = std::move(value_temp);
   grad_ = std::move(grad_temp);
   stats_ = std::move(stats);
+  grad_dirty_ = false;
+  sparse_ids_.clear();
 }
 
 void Parameter::save(const string &path, bool with_stats) const  {
@@ -204,8 +215,47 @@ void Parameter::save(const string &path, bool with_stats) const  {
 }
 
 void Parameter::reset_gradient() {
+  if (!valid()) THROW_ERROR("Invalid parameter.");
+  if (sparse_ && !grad_dirty_) {
+    if (!sparse_ids_.empty()) {
+      // Only the recorded columns are cleared.
+      device_->inplace_pick_reset(0, sparse_ids(), sparse_dim(), grad_);
+    }
+  } else {
+    grad_.reset(0);
+  }
+  grad_dirty_ = false;
+  sparse_ids_.clear();
+}
+
+void Parameter::set_sparse_gradient(bool enabled) {
   if (!valid()) THROW_ERROR("Invalid parameter.");
   grad_.reset(0);
+  sparse_ = enabled;
+  grad_dirty_ = false;
+  sparse_ids_.clear();
+}
+
+vector<unsigned> Parameter::sparse_ids() const {
+  if (!valid()) THROW_ERROR("Invalid parameter.");
+  return sparse_ids_;
+}
+
+void Parameter::add_sparse_gradient(
+    const vector<unsigned> &ids, const Tensor &gy) {
+  if (!valid()) THROW_ERROR("Invalid parameter.");
+  if (!sparse_) {
+    THROW_ERROR("The sparse gradient of the parameter is not enabled.");
+  }
+  device_->pick_bw(gy, ids, sparse_dim(), grad_);
+  // Keeps the recorded indices sorted and unique so that they do not grow
+  // with the number of lookups.
+  const auto mid = sparse_ids_.insert(
+      sparse_ids_.end(), ids.begin(), ids.end());
+  std::sort(mid, sparse_ids_.end());
+  std::inplace_merge(sparse_ids_.begin(), mid, sparse_ids_.end());
+  sparse_ids_.erase(
+      std::unique(sparse_ids_.begin(), sparse_ids_.end()), sparse_ids_.end());
 }
 
 void Parameter::add_stats(const string &name, const Shape &shape) {
@@ -13,16 +13,21 @@
 namespace primitiv {
 
 class Initializer;
+class Trainer;
 
 /**
  * Class to manage a trainable tensor parameter.
  */
 class Parameter : mixins::Nonmovable<Parameter> {
+  friend Trainer;
+
 public:
   /**
    * Creates an invalid parameter object.
    */
-  Parameter() : shape_(), device_(nullptr), value_(), grad_() {}
+  Parameter()
+    : shape_(), device_(nullptr), value_(), grad_()
+    , sparse_(false), grad_dirty_(false) {}
 
   /**
    * Creates a new Parameter object.
@@ -101,6 +106,68 @@ public:
    */
   void reset_gradient();
 
+  /**
+   * Enables or disables the sparse gradient.
+   * @param enabled Whether the sparse gradient is used or not.
+   * @remarks If enabled, the gradients propagated through `pick()` along the
+   *          last dimension of the parameter (e.g., embedding lookups) are
+   *          accumulated only to the picked columns, and their indices are
+   *          recorded. `reset_gradient()` and trainers which support sparse
+   *          updates then process only the recorded columns.
+   *          Any access to the non-const `gradient()` (including the weight
+   *          decay of trainers) makes the whole gradient dense until the next
+   *          `reset_gradient()`.
+   *          This function resets the gradient.
+   */
+  void set_sparse_gradient(bool enabled);
+
+  /**
+   * Retrieves whether the sparse gradient is enabled or not.
+   * @return true if the sparse gradient is enabled, false otherwise.
+   */
+  bool sparse_gradient() const {
+    if (!valid()) THROW_ERROR("Invalid parameter.");
+    return sparse_;
+  }
+
+  /**
+   * Retrieves whether the current gradient is nonzero only at the columns
+   * returned by `sparse_ids()` or not.
+   * @return true if the sparse gradient is enabled and the gradient was
+   *         updated only by `add_sparse_gradient()`, false otherwise.
+   */
+  bool has_sparse_gradient() const {
+    if (!valid()) THROW_ERROR("Invalid parameter.");
+    return sparse_ && !grad_dirty_;
+  }
+
+  /**
+   * Returns the dimension along which the sparse gradient is recorded.
+   * @return The last dimension of the parameter.
+   */
+  unsigned sparse_dim() const {
+    if (!valid()) THROW_ERROR("Invalid parameter.");
+    const unsigned depth = shape_.depth();
+    return depth > 0 ? depth - 1 : 0;
+  }
+
+  /**
+   * Returns the indices of the columns which have gradients.
+   * @return Sorted list of unique indices along `sparse_dim()`.
+   */
+  std::vector<unsigned> sparse_ids() const;
+
+  /**
+   * Accumulates the gradient of the picked columns.
+   * @param ids Indices of the columns along `sparse_dim()`.
+   * @param gy Gradient of the columns. The shape should be equal to
+   *           `pick(value(), ids, sparse_dim())`.
+   * @throw primitiv::Error The sparse gradient is not enabled, or the shape
+   *                        mismatched.
+   */
+  void add_sparse_gradient(
+      const std::vector<unsigned> &ids, const Tensor &gy);
+
   /**
    * Adds a new optional statistics tensor.
    * @param name Name of the statistics.
@@ -158,6 +225,8 @@ public:
   /**
    * Returns the current gradient of the parameter.
    * @return A tensor representing the gradient of the value.
+   * @remarks This function keeps the sparse gradient. Use this through a
+   *          const reference to read the gradient of a sparse parameter.
    */
   const Tensor &gradient() const {
     if (!valid()) THROW_ERROR("Invalid parameter.");
@@ -167,10 +236,15 @@ public:
   /**
    * Returns the current gradient of the parameter.
    * @return A tensor representing the gradient of the value.
+   * @remarks Because the caller may update any elements of the returned
+   *          tensor, this function makes the whole gradient dense until the
+   *          next `reset_gradient()` even if it is only read.
    */
   Tensor &gradient() {
     if (!valid()) THROW_ERROR("Invalid parameter.");
-    return grad_; }
+    grad_dirty_ = true;
+    return grad_;
+  }
 
   /**
    * Returns the current opotional statistics tensor specified by given name.
@@ -198,6 +272,9 @@ private:
   Tensor value_;
   Tensor grad_;
   std::unordered_map<std::string, Tensor> stats_;
+  bool sparse_;
+  bool grad_dirty_;
+  std::vector<unsigned> sparse_ids_;  // Sorted and unique
 };
 
 }  // namespace primitiv
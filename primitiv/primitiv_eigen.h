@@ -0,0 +1,6 @@
+#ifndef PRIMITIV_PRIMITIV_EIGEN_H_
+#define PRIMITIV_PRIMITIV_EIGEN_H_
+
+#include <primitiv/eigen_device.h>
+
+#endif  // PRIMITIV_PRIMITIV_EIGEN_H_
@@ -21,6 +21,10 @@ Shape flatten(const Shape &x) {
   return Shape({x.volume()}, x.batch());
 }
 
+Shape batch_to_columns(const Shape &x) {
+  return Shape({x.volume(), x.batch()});
+}
+
 Shape scalar_op(const Shape &x, const Shape &k) {
   if (!k.is_scalar() || !x.has_compatible_batch(k)) {
     THROW_ERROR(
@@ -121,5 +125,15 @@ Shape matmul(const Shape &l, const Shape &r) {
   return Shape({l[0], r[1]}, std::max(l.batch(), r.batch()));
 }
 
+Shape lstm_cell(const Shape &u, const Shape &c) {
+  if (!u.is_matrix() || !c.is_matrix() || u[0] != 4 * c[0] || u[1] != c[1] ||
+      !u.has_compatible_batch(c)) {
+    THROW_ERROR(
+        "Invalid shapes to calculate the LSTM cell: "
+        << u.to_string() << ", " << c.to_string());
+  }
+  return Shape({2 * c[0], c[1]}, std::max(u.batch(), c.batch()));
+}
+
 }  // namespace shape_ops
 }  // namespace primitiv
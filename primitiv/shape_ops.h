@@ -22,6 +22,13 @@ Shape reshape(const Shape &before, const Shape &after);
  */
 Shape flatten(const Shape &x);
 
+/**
+ * Calculates the shape which arranges minibatches as columns.
+ * @param x A shape.
+ * @return A matrix shape `{x.volume(), x.batch()}` without minibatch.
+ */
+Shape batch_to_columns(const Shape &x);
+
 /**
  * Calculates the shape after the scalar operation.
  * @param x A shape.
@@ -89,6 +96,16 @@ Shape transpose(const Shape &x);
  */
 Shape matmul(const Shape &l, const Shape &r);
 
+/**
+ * Calculates the shape of the LSTM cell.
+ * @param u Shape of the gate pre-activations.
+ * @param c Shape of the previous cell state.
+ * @return A shape of the concatenation of the new output and cell state.
+ * @remarks `u` should be a matrix with `4 * c[0]` rows and the same number of
+ *          columns as `c`.
+ */
+Shape lstm_cell(const Shape &u, const Shape &c);
+
 }  // namespace shape_ops
 }  // namespace primitiv
 
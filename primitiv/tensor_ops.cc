@@ -1,5 +1,7 @@
 #include <config.h>
 
+#include <algorithm>
+#include <cmath>
 #include <primitiv/device.h>
 #include <primitiv/operators.h>
 #include <primitiv/parameter.h>
@@ -18,6 +20,9 @@ std::vector<const Tensor *> obj_to_ptr(const std::vector<Tensor> &xs) {
 
 }  // namespace
 
+// Calculates `expr` with reusing the memory of the temporary tensor `x`.
+#define REUSE(x, expr) (x).device().reuse_tensor((x), [&]() { return (expr); })
+
 namespace primitiv {
 
 template<>
@@ -98,6 +103,40 @@ Tensor operator/(const Tensor &a, const Tensor &b) {
   else return a.device().divide_fw(a, b);
 }
 
+Tensor operator-(Tensor &&x) { return REUSE(x, -x); }
+
+Tensor operator+(Tensor &&x, float k) { return REUSE(x, x + k); }
+Tensor operator+(float k, Tensor &&x) { return REUSE(x, k + x); }
+Tensor operator+(Tensor &&a, const Tensor &b) { return REUSE(a, a + b); }
+Tensor operator+(const Tensor &a, Tensor &&b) { return REUSE(b, a + b); }
+Tensor operator+(Tensor &&a, Tensor &&b) {
+  return REUSE(a, REUSE(b, a + b));
+}
+
+Tensor operator-(Tensor &&x, float k) { return REUSE(x, x - k); }
+Tensor operator-(float k, Tensor &&x) { return REUSE(x, k - x); }
+Tensor operator-(Tensor &&a, const Tensor &b) { return REUSE(a, a - b); }
+Tensor operator-(const Tensor &a, Tensor &&b) { return REUSE(b, a - b); }
+Tensor operator-(Tensor &&a, Tensor &&b) {
+  return REUSE(a, REUSE(b, a - b));
+}
+
+Tensor operator*(Tensor &&x, float k) { return REUSE(x, x * k); }
+Tensor operator*(float k, Tensor &&x) { return REUSE(x, k * x); }
+Tensor operator*(Tensor &&a, const Tensor &b) { return REUSE(a, a * b); }
+Tensor operator*(const Tensor &a, Tensor &&b) { return REUSE(b, a * b); }
+Tensor operator*(Tensor &&a, Tensor &&b) {
+  return REUSE(a, REUSE(b, a * b));
+}
+
+Tensor operator/(Tensor &&x, float k) { return REUSE(x, x / k); }
+Tensor operator/(float k, Tensor &&x) { return REUSE(x, k / x); }
+Tensor operator/(Tensor &&a, const Tensor &b) { return REUSE(a, a / b); }
+Tensor operator/(const Tensor &a, Tensor &&b) { return REUSE(b, a / b); }
+Tensor operator/(Tensor &&a, Tensor &&b) {
+  return REUSE(a, REUSE(b, a / b));
+}
+
 namespace operators {
 
 template<>
@@ -137,6 +176,22 @@ Tensor concat(const std::vector<Tensor> &xs, unsigned dim) {
   return concat(::obj_to_ptr(xs), dim);
 }
 
+template<>
+std::vector<Tensor> split(const Tensor &x, unsigned dim, unsigned n) {
+  if (n == 0 || x.shape()[dim] % n != 0) {
+    THROW_ERROR(
+        "Invalid split operation. shape: " << x.shape().to_string()
+        << ", dim: " << dim << ", n: " << n);
+  }
+  const unsigned span = x.shape()[dim] / n;
+  std::vector<Tensor> ys;
+  ys.reserve(n);
+  for (unsigned i = 0; i < n; ++i) {
+    ys.emplace_back(slice(x, dim, i * span, (i + 1) * span));
+  }
+  return ys;
+}
+
 template<>
 Tensor reshape(const Tensor &x, const Shape &new_shape) {
   return x.reshape(new_shape);
@@ -222,6 +277,20 @@ Tensor elu(const Tensor &x, float a) {
   return x.device().elu_fw(x, a);
 }
 
+Tensor sqrt(Tensor &&x) { return REUSE(x, sqrt(x)); }
+Tensor exp(Tensor &&x) { return REUSE(x, exp(x)); }
+Tensor log(Tensor &&x) { return REUSE(x, log(x)); }
+Tensor tanh(Tensor &&x) { return REUSE(x, tanh(x)); }
+Tensor sigmoid(Tensor &&x) { return REUSE(x, sigmoid(x)); }
+Tensor softplus(Tensor &&x) { return REUSE(x, softplus(x)); }
+Tensor sin(Tensor &&x) { return REUSE(x, sin(x)); }
+Tensor cos(Tensor &&x) { return REUSE(x, cos(x)); }
+Tensor tan(Tensor &&x) { return REUSE(x, tan(x)); }
+Tensor relu(Tensor &&x) { return REUSE(x, relu(x)); }
+Tensor lrelu(Tensor &&x) { return REUSE(x, lrelu(x)); }
+Tensor prelu(Tensor &&x, float a) { return REUSE(x, prelu(x, a)); }
+Tensor elu(Tensor &&x, float a) { return REUSE(x, elu(x, a)); }
+
 template<>
 Tensor sum(const Tensor &x, unsigned dim) {
   return x.device().sum_fw(x, dim);
@@ -239,12 +308,12 @@ Tensor logsumexp(const Tensor &x, unsigned dim) {
 
 template<>
 Tensor log_softmax(const Tensor &x, unsigned dim) {
-  return x - broadcast(logsumexp(x, dim), dim, x.shape()[dim]);
+  return x.device().log_softmax_fw(x, dim);
 }
 
 template<>
 Tensor softmax(const Tensor &x, unsigned dim) {
-  return exp(log_softmax(x, dim));
+  return x.device().softmax_fw(x, dim);
 }
 
 template<>
@@ -255,7 +324,109 @@ Tensor softmax_cross_entropy(const Tensor &x, const Tensor &t, unsigned dim) {
 template<>
 Tensor softmax_cross_entropy(
     const Tensor &x, const std::vector<unsigned> &ids, unsigned dim) {
-  return pick(-log_softmax(x, dim), ids, dim);
+  Tensor lse;
+  return x.device().sparse_softmax_cross_entropy_fw(x, ids, dim, lse);
+}
+
+template<>
+Tensor chunked_softmax_cross_entropy(
+    const Tensor &x, const Tensor &w, const Tensor &b,
+    const std::vector<unsigned> &ids, unsigned chunk_size) {
+  if (chunk_size == 0) {
+    THROW_ERROR("chunk_size should be greater than 0.");
+  }
+  const unsigned n = w.shape()[0];
+  Tensor lse;
+  for (unsigned lower = 0; lower < n; lower += chunk_size) {
+    const unsigned upper = std::min(n, lower + chunk_size);
+    const Tensor z = logsumexp(
+        matmul(slice(w, 0, lower, upper), x) + slice(b, 0, lower, upper), 0);
+    // logsumexp of all previous chunks and the current chunk is merged as a
+    // 2-element logsumexp to keep the accuracy.
+    lse = lower == 0 ? z : logsumexp(concat({&lse, &z}, 0), 0);
+  }
+  return lse - (matmul(pick(w, ids, 0), x) + pick(b, ids, 0));
+}
+
+template<>
+std::pair<Tensor, Tensor> lstm_cell(
+    const Tensor &x, const Tensor &h, const Tensor &c,
+    const Tensor &wx, const Tensor &wh, const Tensor &b) {
+  Tensor gates;
+  const Tensor y = c.device().lstm_cell_fw(
+      matmul(wx, x) + matmul(wh, h) + b, c, gates);
+  const unsigned n = c.shape()[0];
+  return std::make_pair(slice(y, 0, 0, n), slice(y, 0, n, 2 * n));
+}
+
+template<>
+std::pair<Tensor, Tensor> lstm(
+    const Tensor &x, const Tensor &h, const Tensor &c,
+    const Tensor &wx, const Tensor &wh, const Tensor &b) {
+  const unsigned n = c.shape()[0];
+  const unsigned len = x.shape()[1];
+  if (h.shape()[0] != n) {
+    THROW_ERROR(
+        "Invalid shapes to calculate the LSTM: "
+        << x.shape().to_string() << ", " << h.shape().to_string() << ", "
+        << c.shape().to_string());
+  }
+  const Tensor u = matmul(wx, x) + broadcast(b, 1, len);
+  std::vector<Tensor> ys;
+  Tensor cur_h = h, cur_c = c;
+  for (unsigned t = 0; t < len; ++t) {
+    Tensor gates;
+    ys.emplace_back(c.device().lstm_cell_fw(
+          slice(u, 1, t, t + 1) + matmul(wh, cur_h), cur_c, gates));
+    cur_h = slice(ys.back(), 0, 0, n);
+    cur_c = slice(ys.back(), 0, n, 2 * n);
+  }
+  const Tensor y = concat(ys, 1);
+  return std::make_pair(slice(y, 0, 0, n), slice(y, 0, n, 2 * n));
+}
+
+std::vector<unsigned> sample_candidates(
+    const std::vector<float> &distribution, unsigned num_samples,
+    Device &dev) {
+  std::vector<double> cdf(distribution.size());
+  double total = 0;
+  for (unsigned i = 0; i < distribution.size(); ++i) {
+    if (distribution[i] > 0) total += distribution[i];
+    cdf[i] = total;
+  }
+  if (total <= 0) {
+    THROW_ERROR("distribution has no positive weight.");
+  }
+  std::vector<unsigned> ret;
+  if (num_samples == 0) return ret;
+  for (const float u : dev.random_uniform({num_samples}, 0, 1).to_vector()) {
+    // u is in (0, 1], and IDs with no weight are never drawn.
+    ret.emplace_back(
+        std::lower_bound(cdf.begin(), cdf.end(), u * total) - cdf.begin());
+    if (ret.back() >= cdf.size()) ret.back() = cdf.size() - 1;
+  }
+  std::sort(ret.begin(), ret.end());
+  ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+  return ret;
+}
+
+std::vector<float> log_expected_counts(
+    const std::vector<float> &distribution, unsigned num_samples,
+    const std::vector<unsigned> &ids) {
+  double total = 0;
+  for (const float p : distribution) if (p > 0) total += p;
+  std::vector<float> ret;
+  for (const unsigned id : ids) {
+    if (id >= distribution.size() || !(distribution[id] > 0) ||
+        num_samples == 0) {
+      THROW_ERROR(
+          "ID " << id << " is never drawn. distribution.size(): "
+          << distribution.size() << ", num_samples: " << num_samples);
+    }
+    const double p = distribution[id] / total;
+    ret.emplace_back(std::log(-std::expm1(num_samples * std::log1p(-p))));
+  }
+  return ret;
 }
 
 namespace batch {
@@ -265,6 +436,11 @@ Tensor sum(const Tensor &x) {
   return x.device().batch_sum_fw(x);
 }
 
+template<>
+Tensor to_columns(const Tensor &x) {
+  return x.device().batch_to_columns_fw(x);
+}
+
 }  // namespace batch
 
 template<>
@@ -277,6 +453,146 @@ Tensor identity<Tensor>(unsigned size, Device &dev) {
   return dev.identity(size);
 }
 
+void pick_into(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  x.device().pick_fw_into(x, ids, dim, y);
+}
+
+void slice_into(
+    const Tensor &x, unsigned dim, unsigned lower, unsigned upper, Tensor &y) {
+  x.device().slice_fw_into(x, dim, lower, upper, y);
+}
+
+void concat_into(
+    const std::vector<const Tensor *> &xs, unsigned dim, Tensor &y) {
+  y.device().concat_fw_into(xs, dim, y);
+}
+
+void concat_into(const std::vector<Tensor> &xs, unsigned dim, Tensor &y) {
+  concat_into(::obj_to_ptr(xs), dim, y);
+}
+
+void negate_into(const Tensor &x, Tensor &y) {
+  x.device().negate_fw_into(x, y);
+}
+
+void add_into(const Tensor &x, float k, Tensor &y) {
+  x.device().add_const_fw_into(x, k, y);
+}
+
+void add_into(float k, const Tensor &x, Tensor &y) {
+  x.device().add_const_fw_into(x, k, y);
+}
+
+void add_into(const Tensor &a, const Tensor &b, Tensor &y) {
+  if (a.shape().is_scalar()) a.device().add_scalar_fw_into(b, a, y);
+  else if (b.shape().is_scalar()) a.device().add_scalar_fw_into(a, b, y);
+  else a.device().add_fw_into(a, b, y);
+}
+
+void subtract_into(const Tensor &x, float k, Tensor &y) {
+  x.device().subtract_const_r_fw_into(x, k, y);
+}
+
+void subtract_into(float k, const Tensor &x, Tensor &y) {
+  x.device().subtract_const_l_fw_into(x, k, y);
+}
+
+void subtract_into(const Tensor &a, const Tensor &b, Tensor &y) {
+  if (a.shape().is_scalar()) a.device().subtract_scalar_l_fw_into(b, a, y);
+  else if (b.shape().is_scalar()) a.device().subtract_scalar_r_fw_into(a, b, y);
+  else a.device().subtract_fw_into(a, b, y);
+}
+
+void multiply_into(const Tensor &x, float k, Tensor &y) {
+  x.device().multiply_const_fw_into(x, k, y);
+}
+
+void multiply_into(float k, const Tensor &x, Tensor &y) {
+  x.device().multiply_const_fw_into(x, k, y);
+}
+
+void multiply_into(const Tensor &a, const Tensor &b, Tensor &y) {
+  if (a.shape().is_scalar()) a.device().multiply_scalar_fw_into(b, a, y);
+  else if (b.shape().is_scalar()) a.device().multiply_scalar_fw_into(a, b, y);
+  else a.device().multiply_fw_into(a, b, y);
+}
+
+void divide_into(const Tensor &x, float k, Tensor &y) {
+  x.device().divide_const_r_fw_into(x, k, y);
+}
+
+void divide_into(float k, const Tensor &x, Tensor &y) {
+  x.device().divide_const_l_fw_into(x, k, y);
+}
+
+void divide_into(const Tensor &a, const Tensor &b, Tensor &y) {
+  if (a.shape().is_scalar()) a.device().divide_scalar_l_fw_into(b, a, y);
+  else if (b.shape().is_scalar()) a.device().divide_scalar_r_fw_into(a, b, y);
+  else a.device().divide_fw_into(a, b, y);
+}
+
+void sqrt_into(const Tensor &x, Tensor &y) { x.device().sqrt_fw_into(x, y); }
+void exp_into(const Tensor &x, Tensor &y) { x.device().exp_fw_into(x, y); }
+void log_into(const Tensor &x, Tensor &y) { x.device().log_fw_into(x, y); }
+void tanh_into(const Tensor &x, Tensor &y) { x.device().tanh_fw_into(x, y); }
+void sin_into(const Tensor &x, Tensor &y) { x.device().sin_fw_into(x, y); }
+void cos_into(const Tensor &x, Tensor &y) { x.device().cos_fw_into(x, y); }
+void tan_into(const Tensor &x, Tensor &y) { x.device().tan_fw_into(x, y); }
+
+void sigmoid_into(const Tensor &x, Tensor &y) {
+  x.device().sigmoid_fw_into(x, y);
+}
+
+void softplus_into(const Tensor &x, Tensor &y) {
+  x.device().softplus_fw_into(x, y);
+}
+
+void relu_into(const Tensor &x, Tensor &y) {
+  x.device().prelu_fw_into(x, 0, y);
+}
+
+void lrelu_into(const Tensor &x, Tensor &y) {
+  x.device().prelu_fw_into(x, .01, y);
+}
+
+void prelu_into(const Tensor &x, float a, Tensor &y) {
+  x.device().prelu_fw_into(x, a, y);
+}
+
+void elu_into(const Tensor &x, float a, Tensor &y) {
+  x.device().elu_fw_into(x, a, y);
+}
+
+void transpose_into(const Tensor &x, Tensor &y) {
+  x.device().transpose_fw_into(x, y);
+}
+
+void matmul_into(const Tensor &a, const Tensor &b, Tensor &y) {
+  a.device().matmul_fw_into(a, b, y);
+}
+
+void softmax_into(const Tensor &x, unsigned dim, Tensor &y) {
+  x.device().softmax_fw_into(x, dim, y);
+}
+
+void log_softmax_into(const Tensor &x, unsigned dim, Tensor &y) {
+  x.device().log_softmax_fw_into(x, dim, y);
+}
+
+void sum_into(const Tensor &x, unsigned dim, Tensor &y) {
+  x.device().sum_fw_into(x, dim, y);
+}
+
+void logsumexp_into(const Tensor &x, unsigned dim, Tensor &y) {
+  x.device().logsumexp_fw_into(x, dim, y);
+}
+
+void broadcast_into(const Tensor &x, unsigned dim, unsigned size, Tensor &y) {
+  x.device().broadcast_fw_into(x, dim, size, y);
+}
+
 namespace random {
 
 template<>
@@ -303,6 +619,22 @@ Tensor log_normal<Tensor>(
   return dev.random_log_normal(shape, mean, sd);
 }
 
+void bernoulli_into(float p, Tensor &y) {
+  y.device().random_bernoulli_into(p, y);
+}
+
+void uniform_into(float lower, float upper, Tensor &y) {
+  y.device().random_uniform_into(lower, upper, y);
+}
+
+void normal_into(float mean, float sd, Tensor &y) {
+  y.device().random_normal_into(mean, sd, y);
+}
+
+void log_normal_into(float mean, float sd, Tensor &y) {
+  y.device().random_log_normal_into(mean, sd, y);
+}
+
 }  // namespace random
 
 }  // namespace operators
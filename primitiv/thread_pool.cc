@@ -0,0 +1,131 @@
+#include <config.h>
+
+#include <atomic>
+#include <exception>
+#include <primitiv/error.h>
+#include <primitiv/thread_pool.h>
+
+namespace primitiv {
+
+/**
+ * State of one parallel loop shared by all participating threads.
+ */
+struct ThreadPool::Job {
+  const std::function<void(unsigned, unsigned)> *fn;
+  unsigned size;
+  unsigned chunk;
+  unsigned num_chunks;
+  std::atomic<unsigned> next;
+  std::atomic<unsigned> done;
+  std::mutex error_mutex;
+  std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(unsigned num_threads)
+: generation_(0)
+, stop_(false) {
+  if (num_threads == 0) {
+    THROW_ERROR("Number of threads should be greater than 0.");
+  }
+  workers_.reserve(num_threads - 1);
+  for (unsigned i = 1; i < num_threads; ++i) {
+    workers_.emplace_back(&ThreadPool::worker_loop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (std::thread &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::parallel_for(
+    unsigned size, unsigned grain,
+    const std::function<void(unsigned, unsigned)> &fn) {
+  if (size == 0) return;
+  if (grain == 0) grain = 1;
+  const unsigned max_chunks = (size + grain - 1) / grain;
+  if (workers_.empty() || max_chunks <= 1) {
+    fn(0, size);
+    return;
+  }
+
+  // Nested or concurrent loops fall back to the serial execution to avoid
+  // waiting for the workers occupied by the outer loop.
+  std::unique_lock<std::mutex> call_lock(call_mutex_, std::try_to_lock);
+  if (!call_lock.owns_lock()) {
+    fn(0, size);
+    return;
+  }
+
+  const unsigned nt = num_threads();
+  const unsigned num_chunks = max_chunks < nt ? max_chunks : nt;
+  std::shared_ptr<Job> job = std::make_shared<Job>();
+  job->fn = &fn;
+  job->size = size;
+  job->chunk = (size + num_chunks - 1) / num_chunks;
+  job->num_chunks = (size + job->chunk - 1) / job->chunk;
+  job->next = 0;
+  job->done = 0;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = job;
+    ++generation_;
+  }
+  start_cv_.notify_all();
+
+  run_chunks(*job);
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [&job] { return job->done == job->num_chunks; });
+    job_.reset();
+  }
+
+  if (job->error) std::rethrow_exception(job->error);
+}
+
+void ThreadPool::worker_loop() {
+  unsigned seen = 0;
+  while (true) {
+    std::shared_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock, [this, seen] {
+          return stop_ || generation_ != seen;
+      });
+      if (stop_) return;
+      seen = generation_;
+      job = job_;
+    }
+    if (job) run_chunks(*job);
+  }
+}
+
+void ThreadPool::run_chunks(Job &job) {
+  while (true) {
+    const unsigned c = job.next++;
+    if (c >= job.num_chunks) return;
+    const unsigned begin = c * job.chunk;
+    const unsigned end = begin + job.chunk < job.size
+      ? begin + job.chunk : job.size;
+    try {
+      (*job.fn)(begin, end);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(job.error_mutex);
+      if (!job.error) job.error = std::current_exception();
+    }
+    if (++job.done == job.num_chunks) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_cv_.notify_all();
+    }
+  }
+}
+
+}  // namespace primitiv
@@ -0,0 +1,80 @@
+#ifndef PRIMITIV_THREAD_POOL_H_
+#define PRIMITIV_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <primitiv/mixins.h>
+
+namespace primitiv {
+
+/**
+ * Fixed-size pool of worker threads to run data-parallel loops.
+ */
+class ThreadPool : mixins::Nonmovable<ThreadPool> {
+  ThreadPool() = delete;
+
+public:
+  /**
+   * Creates a thread pool.
+   * @param num_threads Number of threads used in each parallel loop, including
+   *                    the calling thread. 1 disables the parallelism.
+   * @throw primitiv::Error `num_threads` is 0.
+   */
+  explicit ThreadPool(unsigned num_threads);
+
+  ~ThreadPool();
+
+  /**
+   * Retrieves the number of threads.
+   * @return Number of threads including the calling thread.
+   */
+  unsigned num_threads() const { return workers_.size() + 1; }
+
+  /**
+   * Runs `fn` over the range `[0, size)`.
+   * @param size Size of the whole range.
+   * @param grain Minimum size of the range processed by one thread.
+   * @param fn Function to process the sub-range `[begin, end)`.
+   * @remarks The range is processed by the calling thread only if `size` is
+   *          not larger than `grain`, or the pool is already used by another
+   *          loop.
+   *          `fn` should not throw any exceptions for the sub-ranges
+   *          processed by other threads. If it throws, the first exception is
+   *          rethrown by this function after all sub-ranges are processed.
+   */
+  void parallel_for(
+      unsigned size, unsigned grain,
+      const std::function<void(unsigned, unsigned)> &fn);
+
+private:
+  struct Job;
+
+  /**
+   * Main loop of each worker thread.
+   */
+  void worker_loop();
+
+  /**
+   * Processes chunks of the job until no chunk remains.
+   * @param job The job to be processed.
+   */
+  void run_chunks(Job &job);
+
+  std::vector<std::thread> workers_;
+  std::mutex call_mutex_;
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  std::shared_ptr<Job> job_;
+  unsigned generation_;
+  bool stop_;
+};
+
+}  // namespace primitiv
+
+#endif  // PRIMITIV_THREAD_POOL_H_
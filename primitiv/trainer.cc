@@ -1,7 +1,9 @@
 #include <config.h>
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
+#include <primitiv/device.h>
 #include <primitiv/error.h>
 #include <primitiv/messages.pb.h>
 #include <primitiv/operators.h>
@@ -40,10 +42,19 @@ void write_proto(
   }
 }
 
+// Gradient of the columns of a parameter which are updated sparsely.
+struct SparseGradient {
+  primitiv::Parameter *param;
+  std::vector<unsigned> ids;
+  primitiv::Tensor grad;
+};
+
 }  // namespace
 
 namespace primitiv {
 
+Trainer::~Trainer() = default;
+
 void Trainer::load(const std::string &path) {
   messages::Trainer msg;
   ::read_proto(path, msg);
@@ -67,50 +78,263 @@ void Trainer::save(const std::string &path) const {
   ::write_proto(path, msg);
 }
 
+void Trainer::set_flat_arena(bool enabled) {
+  flat_arena_ = enabled;
+  if (!enabled) {
+    // Parameters keep their views, and the memory is released when all views
+    // are disposed.
+    arenas_.clear();
+    arena_params_.clear();
+  }
+}
+
 void Trainer::add_parameter(Parameter &param) {
   if (params_.find(&param) != params_.end()) {
     THROW_ERROR("Parameter '" << &param << "' is already registered.");
   }
   params_.insert(&param);
+  param_list_.emplace_back(&param);
   configure_parameter(param);
 }
 
 void Trainer::reset_gradients() {
-  for (Parameter *param : params_) {
+  for (Parameter *param : targets()) {
     param->reset_gradient();
   }
 }
 
 void Trainer::update() {
+  const std::vector<Parameter *> &params = targets();
+
   if (l2_strength_ > 0) {
     // Weight decay
-    for (Parameter *param : params_) {
+    for (Parameter *param : params) {
       param->gradient() += l2_strength_ * param->value();
     }
   }
 
+  // Gathers the gradients of columns which are updated sparsely.
+  std::vector<Parameter *> dense_params;
+  std::vector<::SparseGradient> sparse_grads;
+  for (Parameter *param : params) {
+    const Parameter &cparam = *param;
+    if (supports_sparse_update() && cparam.has_sparse_gradient()) {
+      std::vector<unsigned> ids = cparam.sparse_ids();
+      // Parameters without any gradients are not updated.
+      if (ids.empty()) continue;
+      Tensor g = cparam.device().pick_fw(
+          cparam.gradient(), ids, cparam.sparse_dim());
+      sparse_grads.emplace_back(
+          ::SparseGradient { param, std::move(ids), std::move(g) });
+    } else {
+      dense_params.emplace_back(param);
+    }
+  }
+
   if (clip_threshold_ > 0) {
     // Gradient clipping
+    // Gradients are gathered for each device to calculate their norm in one
+    // operation.
+    std::vector<std::pair<Device *, std::vector<const Tensor *>>> grads;
+    auto add_grad = [&grads](const Tensor &g) {
+      Device *dev = &g.device();
+      auto it = std::find_if(
+          grads.begin(), grads.end(),
+          [dev](const std::pair<Device *, std::vector<const Tensor *>> &x) {
+            return x.first == dev;
+          });
+      if (it == grads.end()) {
+        grads.emplace_back(dev, std::vector<const Tensor *>());
+        it = grads.end() - 1;
+      }
+      it->second.emplace_back(&g);
+    };
+    for (const Parameter *param : dense_params) add_grad(param->gradient());
+    for (const ::SparseGradient &sg : sparse_grads) add_grad(sg.grad);
     float sq_norm = 0;
-    for (const Parameter *param : params_) {
-      const Tensor &g = param->gradient();
-      sq_norm += operators::sum(operators::flatten(g * g), 0).to_float();
+    for (const auto &kv : grads) {
+      sq_norm += kv.first->squared_norm(kv.second);
     }
     if (sq_norm > clip_threshold_ * clip_threshold_) {
       float clip_scale = clip_threshold_ / std::sqrt(sq_norm);
-      for (Parameter *param : params_) {
+      for (Parameter *param : dense_params) {
         param->gradient() *= clip_scale;
       }
+      for (::SparseGradient &sg : sparse_grads) {
+        sg.grad *= clip_scale;
+      }
     }
   }
 
-  for (Parameter *param : params_) {
+  for (Parameter *param : dense_params) {
     update_parameter(lr_scale_, *param);
   }
+  for (const ::SparseGradient &sg : sparse_grads) {
+    update_sparse_parameter(lr_scale_, sg.ids, sg.grad, *sg.param);
+  }
 
   ++epoch_;
 }
 
+const std::vector<Parameter *> &Trainer::targets() {
+  if (!flat_arena_) return param_list_;
+  if (!check_arenas()) build_arenas();
+  return arena_params_;
+}
+
+bool Trainer::check_arenas() const {
+  unsigned num_members = 0;
+  for (const Arena &arena : arenas_) {
+    const Parameter &whole = *arena.param;
+    const float *values = static_cast<const float *>(whole.value_.data());
+    const float *grads = static_cast<const float *>(whole.grad_.data());
+    std::vector<const float *> stats;
+    for (const std::string &name : arena.stats_names) {
+      stats.emplace_back(
+          static_cast<const float *>(whole.stats_.at(name).data()));
+    }
+    unsigned offset = 0;
+    for (const Parameter *param : arena.members) {
+      // Replaced tensors never point to the arena because the arena memory is
+      // alive while the views exist.
+      // Views shared with other objects (e.g., copies of the values) require
+      // a new arena, because updates of the whole memory bypass the
+      // copy-on-write of each view. The old memory is then held only by the
+      // copies and keeps their values.
+      if (!param->valid() ||
+          param->sparse_ ||
+          param->device_ != whole.device_ ||
+          param->value_.data() != values + offset ||
+          param->grad_.data() != grads + offset ||
+          !Device::has_unique_memory(param->value_) ||
+          !Device::has_unique_memory(param->grad_)) return false;
+      for (unsigned i = 0; i < stats.size(); ++i) {
+        const auto it = param->stats_.find(arena.stats_names[i]);
+        if (it == param->stats_.end() ||
+            it->second.data() != stats[i] + offset ||
+            !Device::has_unique_memory(it->second)) return false;
+      }
+      offset += param->shape_.size();
+    }
+    num_members += arena.members.size();
+  }
+
+  unsigned num_dense = 0;
+  unsigned num_sparse = 0;
+  for (const Parameter *param : param_list_) {
+    if (!param->valid()) continue;
+    if (param->sparse_) ++num_sparse;
+    else ++num_dense;
+  }
+  return num_members == num_dense &&
+    arenas_.size() + num_sparse == arena_params_.size();
+}
+
+void Trainer::build_arenas() {
+  arenas_.clear();
+  arena_params_.clear();
+
+  // Groups parameters by their devices.
+  // Parameters with sparse gradients are updated separately.
+  std::vector<Parameter *> sparse_params;
+  for (Parameter *param : param_list_) {
+    if (!param->valid()) continue;
+    if (param->sparse_) {
+      sparse_params.emplace_back(param);
+      continue;
+    }
+    auto it = std::find_if(
+        arenas_.begin(), arenas_.end(),
+        [param](const Arena &arena) {
+          return arena.members.front()->device_ == param->device_;
+        });
+    if (it == arenas_.end()) {
+      arenas_.emplace_back();
+      it = arenas_.end() - 1;
+    }
+    it->members.emplace_back(param);
+  }
+
+  try {
+    for (Arena &arena : arenas_) build_arena(arena);
+    arena_params_.insert(
+        arena_params_.end(), sparse_params.begin(), sparse_params.end());
+  } catch (...) {
+    arenas_.clear();
+    arena_params_.clear();
+    throw;
+  }
+}
+
+void Trainer::build_arena(Arena &arena) {
+  // Only statistics held by all parameters are moved to the arena.
+  const Parameter &first = *arena.members.front();
+  for (const auto &kv : first.stats_) {
+    const std::string &name = kv.first;
+    const bool shared = std::all_of(
+        arena.members.begin(), arena.members.end(),
+        [&name](const Parameter *param) {
+          const auto it = param->stats_.find(name);
+          return it != param->stats_.end() &&
+            it->second.shape() == param->shape_;
+        });
+    if (shared) arena.stats_names.emplace_back(name);
+  }
+  std::sort(arena.stats_names.begin(), arena.stats_names.end());
+
+  unsigned size = 0;
+  for (const Parameter *param : arena.members) {
+    size += param->shape_.size();
+  }
+
+  // Layout: [values | gradients | stats_names[0] | stats_names[1] | ...]
+  Device &dev = *first.device_;
+  const unsigned num_sections = 2 + arena.stats_names.size();
+  const Tensor storage = dev.new_raw_tensor({num_sections * size});
+
+  unsigned offset = 0;
+  for (Parameter *param : arena.members) {
+    const Shape &shape = param->shape_;
+    param->value_ = make_view(storage, offset, shape, &param->value_);
+    param->grad_ = make_view(storage, size + offset, shape, &param->grad_);
+    for (unsigned i = 0; i < arena.stats_names.size(); ++i) {
+      Tensor &stats = param->stats_.at(arena.stats_names[i]);
+      stats = make_view(storage, (2 + i) * size + offset, shape, &stats);
+    }
+    offset += shape.size();
+  }
+
+  arena.param.reset(new Parameter());
+  Parameter &whole = *arena.param;
+  whole.shape_ = Shape({size});
+  whole.device_ = &dev;
+  whole.value_ = make_view(storage, 0, whole.shape_, nullptr);
+  whole.grad_ = make_view(storage, size, whole.shape_, nullptr);
+  for (unsigned i = 0; i < arena.stats_names.size(); ++i) {
+    whole.stats_.emplace(
+        arena.stats_names[i],
+        make_view(storage, (2 + i) * size, whole.shape_, nullptr));
+  }
+  arena_params_.emplace_back(&whole);
+}
+
+Tensor Trainer::make_view(
+    const Tensor &storage, unsigned offset, const Shape &shape,
+    const Tensor *src) {
+  Device &dev = storage.device();
+  dev.reserve_range(storage, offset, shape.size());
+  try {
+    // The reservation is always used because both functions allocate exactly
+    // one new tensor.
+    Tensor view = src ? dev.copy_tensor(*src) : dev.new_raw_tensor(shape);
+    dev.cancel_reservation();
+    return view;
+  } catch (...) {
+    dev.cancel_reservation();
+    throw;
+  }
+}
+
 void Trainer::get_configs(
     std::unordered_map<std::string, unsigned> &uint_configs,
     std::unordered_map<std::string, float> &float_configs) const {
@@ -2,22 +2,28 @@
 #define PRIMITIV_TRAINER_H_
 
 #include <memory>
+#include <string>
 #include <unordered_set>
+#include <vector>
 #include <primitiv/error.h>
 #include <primitiv/mixins.h>
 
 namespace primitiv {
 
 class Parameter;
+class Shape;
+class Tensor;
 
 /**
  * Abstract class for parameter optimizers.
  */
 class Trainer : mixins::Nonmovable<Trainer> {
 public:
-  Trainer() : epoch_(0), lr_scale_(1), l2_strength_(0), clip_threshold_(0) {}
+  Trainer()
+    : epoch_(0), lr_scale_(1), l2_strength_(0), clip_threshold_(0)
+    , flat_arena_(false) {}
 
-  virtual ~Trainer() = default;
+  virtual ~Trainer();
 
   /**
    * Loads configurations from a file.
@@ -94,6 +100,32 @@ public:
     clip_threshold_ = threshold;
   }
 
+  /**
+   * Enables or disables the flat parameter arena.
+   * @param enabled Whether the arena is used or not.
+   * @remarks If enabled, the trainer allocates one contiguous memory for each
+   *          device, and the values, gradients and statistics of all
+   *          registered parameters are replaced by views of the memory in the
+   *          registration order. `reset_gradients()`, the weight decay, the
+   *          gradient clipping and `update()` then run one operation over the
+   *          whole memory instead of each parameter.
+   *          The arena is rebuilt automatically when a parameter is added or
+   *          the tensors of a parameter are replaced (e.g., by
+   *          `Parameter::init()`), and invalid parameters are ignored.
+   *          If some tensors of a parameter are shared with other objects
+   *          (e.g., copies of `Parameter::value()`), all parameters are moved
+   *          to a new arena before the next operation, and the copies keep
+   *          their values.
+   *          Parameters with sparse gradients are not moved to the arena.
+   */
+  void set_flat_arena(bool enabled);
+
+  /**
+   * Retrieves whether the flat parameter arena is enabled or not.
+   * @return true if the arena is enabled, false otherwise.
+   */
+  bool flat_arena() const { return flat_arena_; }
+
   /**
    * Registers a parameter.
    * @param param Parameter to be optimized.
@@ -107,6 +139,10 @@ public:
 
   /**
    * Updates parameter values.
+   * @remarks If the trainer supports sparse updates, parameters which have
+   *          sparse gradients are updated only at the columns with gradients.
+   *          The gradient clipping of such parameters scales the picked
+   *          gradients, and keeps `Parameter::gradient()` as it is.
    */
   void update();
 
@@ -129,15 +165,64 @@ public:
       const std::unordered_map<std::string, float> &float_configs);
 
 private:
+  /**
+   * Contiguous memory which holds all parameters on one device.
+   */
+  struct Arena {
+    std::unique_ptr<Parameter> param;  // Views of the whole memory.
+    std::vector<Parameter *> members;  // Parameters in the registration order.
+    std::vector<std::string> stats_names;  // Statistics held by the memory.
+  };
+
+  /**
+   * Retrieves the parameters which are actually updated.
+   * @return List of the registered parameters, or the parameters representing
+   *         the whole arenas if the flat arena is enabled.
+   */
+  const std::vector<Parameter *> &targets();
+
+  /**
+   * Checks whether all valid parameters are still held by the arenas.
+   * @return true if the arenas are up to date, false otherwise.
+   */
+  bool check_arenas() const;
+
+  /**
+   * Allocates new arenas and moves all valid parameters into them.
+   */
+  void build_arenas();
+
+  /**
+   * Allocates the memory of one arena and moves its members into it.
+   * @param arena Arena object whose members are already listed.
+   */
+  void build_arena(Arena &arena);
+
+  /**
+   * Makes a view of the arena memory.
+   * @param storage Tensor which owns the whole arena memory.
+   * @param offset Offset of the view in number of elements.
+   * @param shape Shape of the view.
+   * @param src Tensor to be copied into the view, or nullptr.
+   * @return A new tensor which shares the memory with `storage`.
+   */
+  static Tensor make_view(
+      const Tensor &storage, unsigned offset, const Shape &shape,
+      const Tensor *src);
+
   unsigned epoch_;
   float lr_scale_;
   float l2_strength_;
   float clip_threshold_;
+  bool flat_arena_;
 
   // TODO(odashi):
   // This lookup table does not work if a different Parameter object is
   // allocated at the same pointer.
   std::unordered_set<Parameter *> params_;
+  std::vector<Parameter *> param_list_;
+  std::vector<Arena> arenas_;
+  std::vector<Parameter *> arena_params_;
 
   /**
    * Event handler on adding a new parameter.
@@ -151,6 +236,27 @@ private:
    * @param scale Additional learning rate scaling factor.
    */
   virtual void update_parameter(float scale, Parameter &param) = 0;
+
+  /**
+   * Checks whether the trainer supports sparse updates or not.
+   * @return true if `update_sparse_parameter()` is implemented, false
+   *         otherwise.
+   */
+  virtual bool supports_sparse_update() const { return false; }
+
+  /**
+   * Updates only the specified columns of a parameter.
+   * @param scale Additional learning rate scaling factor.
+   * @param ids Sorted indices of the columns along `param.sparse_dim()`.
+   * @param g Gradient of the columns, which is equal to
+   *          `pick(param.gradient(), ids, param.sparse_dim())`.
+   * @param param Parameter to be updated.
+   */
+  virtual void update_sparse_parameter(
+      float scale, const std::vector<unsigned> &ids, const Tensor &g,
+      Parameter &param) {
+    THROW_ERROR("The trainer does not support sparse updates.");
+  }
 };
 
 }  // namespace primitiv
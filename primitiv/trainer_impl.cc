@@ -2,7 +2,7 @@
 
 #include <algorithm>
 #include <cmath>
-#include <primitiv/operators.h>
+#include <primitiv/device.h>
 #include <primitiv/parameter.h>
 #include <primitiv/trainer_impl.h>
 
@@ -20,7 +20,20 @@ namespace trainers {
 void SGD::configure_parameter(Parameter &param) {}
 
 void SGD::update_parameter(float scale, Parameter &param) {
-  param.value() -= (scale * eta_) * param.gradient();
+  Tensor &x = param.value();
+  x.device().sgd_update(scale * eta_, param.gradient(), x);
+}
+
+void SGD::update_sparse_parameter(
+    float scale, const std::vector<unsigned> &ids, const Tensor &g,
+    Parameter &param) {
+  // Update rules never read the current value, and the difference of the
+  // value is calculated from zeros.
+  Tensor &x = param.value();
+  Device &dev = x.device();
+  Tensor dx = dev.new_tensor_by_constant(g.shape(), 0);
+  dev.sgd_update(scale * eta_, g, dx);
+  dev.pick_bw(dx, ids, param.sparse_dim(), x);
 }
 
 void SGD::get_configs(
@@ -45,10 +58,10 @@ void MomentumSGD::configure_parameter(Parameter &param) {
 }
 
 void MomentumSGD::update_parameter(float scale, Parameter &param) {
-  Tensor &m = param.stats("momentumsgd-m");
-  m *= momentum_;
-  m -= (scale * eta_) * param.gradient();
-  param.value() += m;
+  Tensor &x = param.value();
+  x.device().momentum_sgd_update(
+      scale * eta_, momentum_, param.gradient(),
+      param.stats("momentumsgd-m"), x);
 }
 
 void MomentumSGD::get_configs(
@@ -75,10 +88,23 @@ void AdaGrad::configure_parameter(Parameter &param) {
 }
 
 void AdaGrad::update_parameter(float scale, Parameter &param) {
-  const Tensor &g = param.gradient();
+  Tensor &x = param.value();
+  x.device().adagrad_update(
+      scale * eta_, eps_, param.gradient(), param.stats("adagrad-m"), x);
+}
+
+void AdaGrad::update_sparse_parameter(
+    float scale, const std::vector<unsigned> &ids, const Tensor &g,
+    Parameter &param) {
+  Tensor &x = param.value();
   Tensor &m = param.stats("adagrad-m");
-  m += g * g;
-  param.value() -= (scale * eta_) * g / (operators::sqrt(m) + eps_);
+  Device &dev = x.device();
+  const unsigned dim = param.sparse_dim();
+  Tensor mi = dev.pick_fw(m, ids, dim);
+  Tensor dx = dev.new_tensor_by_constant(g.shape(), 0);
+  dev.adagrad_update(scale * eta_, eps_, g, mi, dx);
+  dev.inplace_pick_assign(mi, ids, dim, m);
+  dev.pick_bw(dx, ids, dim, x);
 }
 
 void AdaGrad::get_configs(
@@ -105,10 +131,10 @@ void RMSProp::configure_parameter(Parameter &param) {
 }
 
 void RMSProp::update_parameter(float scale, Parameter &param) {
-  const Tensor &g = param.gradient();
-  Tensor &m = param.stats("rmsprop-m");
-  m = alpha_ * m + (1 - alpha_) * g * g;
-  param.value() -= (scale * eta_) * g / (operators::sqrt(m) + eps_);
+  Tensor &x = param.value();
+  x.device().rmsprop_update(
+      scale * eta_, alpha_, eps_, param.gradient(), param.stats("rmsprop-m"),
+      x);
 }
 
 void RMSProp::get_configs(
@@ -138,15 +164,10 @@ void AdaDelta::configure_parameter(Parameter &param) {
 }
 
 void AdaDelta::update_parameter(float scale, Parameter &param) {
-  const Tensor &g = param.gradient();
-  Tensor &m1 = param.stats("adadelta-m1");
-  Tensor &m2 = param.stats("adadelta-m2");
-  m2 *= rho_;
-  m2 += (1 - rho_) * g * g;
-  const Tensor dx = operators::sqrt((m1 + eps_) / (m2 + eps_)) * g;
-  m1 *= rho_;
-  m1 += (1 - rho_) * dx * dx;
-  param.value() -= scale * dx;
+  Tensor &x = param.value();
+  x.device().adadelta_update(
+      scale, rho_, eps_, param.gradient(),
+      param.stats("adadelta-m1"), param.stats("adadelta-m2"), x);
 }
 
 void AdaDelta::get_configs(
@@ -174,15 +195,59 @@ void Adam::configure_parameter(Parameter &param) {
 }
 
 void Adam::update_parameter(float scale, Parameter &param) {
-  const unsigned epoch = get_epoch() + 1;
-  const Tensor &g = param.gradient();
+  Tensor &x = param.value();
+  x.device().adam_update(
+      scale * alpha_, beta1_, beta2_, eps_, get_epoch() + 1, param.gradient(),
+      param.stats("adam-m1"), param.stats("adam-m2"), x);
+  if (param.has_stats("adam-last-step")) {
+    // All columns are up to date.
+    param.stats("adam-last-step").reset(get_epoch() + 1);
+  }
+}
+
+void Adam::update_sparse_parameter(
+    float scale, const std::vector<unsigned> &ids, const Tensor &g,
+    Parameter &param) {
+  const unsigned step = get_epoch() + 1;
+  const unsigned dim = param.sparse_dim();
+  const std::string name = "adam-last-step";
+  if (!param.has_stats(name)) {
+    // Steps at which each column was updated last time.
+    param.add_stats(name, Shape({param.shape()[dim]}));
+    param.stats(name).reset(get_epoch());
+  }
+
+  Tensor &x = param.value();
   Tensor &m1 = param.stats("adam-m1");
   Tensor &m2 = param.stats("adam-m2");
-  m1 = beta1_ * m1 + (1 - beta1_) * g;
-  m2 = beta2_ * m2 + (1 - beta2_) * g * g;
-  const Tensor mm1 = m1 / (1 - std::pow(beta1_, epoch));
-  const Tensor mm2 = m2 / (1 - std::pow(beta2_, epoch));
-  param.value() -= (scale * alpha_) * mm1 / (operators::sqrt(mm2) + eps_);
+  Tensor &last = param.stats(name);
+  Device &dev = x.device();
+  Tensor m1i = dev.pick_fw(m1, ids, dim);
+  Tensor m2i = dev.pick_fw(m2, ids, dim);
+
+  // Applies the decay of moments skipped while the columns had no gradients.
+  const std::vector<float> last_steps = dev.pick_fw(last, ids, 0).to_vector();
+  const unsigned n = ids.size();
+  std::vector<float> decay1(n), decay2(n);
+  bool skipped = false;
+  for (unsigned i = 0; i < n; ++i) {
+    const float k = step - 1 - last_steps[i];
+    if (k > 0) skipped = true;
+    decay1[i] = std::pow(beta1_, k);
+    decay2[i] = std::pow(beta2_, k);
+  }
+  if (skipped) {
+    const Shape s({}, n);
+    m1i = dev.multiply_scalar_fw(m1i, dev.new_tensor_by_vector(s, decay1));
+    m2i = dev.multiply_scalar_fw(m2i, dev.new_tensor_by_vector(s, decay2));
+  }
+
+  Tensor dx = dev.new_tensor_by_constant(g.shape(), 0);
+  dev.adam_update(scale * alpha_, beta1_, beta2_, eps_, step, g, m1i, m2i, dx);
+  dev.inplace_pick_assign(m1i, ids, dim, m1);
+  dev.inplace_pick_assign(m2i, ids, dim, m2);
+  dev.inplace_pick_reset(step, ids, 0, last);
+  dev.pick_bw(dx, ids, dim, x);
 }
 
 void Adam::get_configs(
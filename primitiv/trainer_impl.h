@@ -18,11 +18,19 @@ private: \
   void configure_parameter(Parameter &param) override; \
   void update_parameter(float scale, Parameter &param) override;
 
+#define DECL_SPARSE_UPDATE \
+private: \
+  bool supports_sparse_update() const override { return true; } \
+  void update_sparse_parameter( \
+      float scale, const std::vector<unsigned> &ids, const Tensor &g, \
+      Parameter &param) override;
+
 /**
  * Simple stochastic gradient descent.
  */
 class SGD : public primitiv::Trainer {
   DECL_DEFAULTS;
+  DECL_SPARSE_UPDATE;
 
 public:
   /**
@@ -78,6 +86,7 @@ private:
  */
 class AdaGrad : public primitiv::Trainer {
   DECL_DEFAULTS;
+  DECL_SPARSE_UPDATE;
 
 public:
   /**
@@ -181,9 +190,13 @@ private:
 /**
  * Adam optimizer.
  * https://arxiv.org/abs/1412.6980
+ * @remarks For parameters with sparse gradients, the moments of each column
+ *          are updated lazily: the decay of moments skipped while the column
+ *          had no gradients is applied at once when the column is updated.
  */
 class Adam : public primitiv::Trainer {
   DECL_DEFAULTS;
+  DECL_SPARSE_UPDATE;
 
 public:
   /**
@@ -230,6 +243,7 @@ private:
 };
 
 #undef DECL_DEFAULTS
+#undef DECL_SPARSE_UPDATE
 
 }  // namespace trainers
 }  // namespace primitiv
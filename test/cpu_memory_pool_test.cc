@@ -0,0 +1,186 @@
+#include <config.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <primitiv/cpu_memory_pool.h>
+#include <primitiv/error.h>
+#include <primitiv/naive_device.h>
+#include <primitiv/tensor.h>
+
+using std::vector;
+
+namespace primitiv {
+
+class CPUMemoryPoolTest : public testing::Test {};
+
+TEST_F(CPUMemoryPoolTest, CheckPoolIDs) {
+  CPUMemoryPool pool0;
+  const std::uint64_t base = pool0.get_pool_id();
+  CPUMemoryPool pool1;
+  EXPECT_EQ(base + 1, pool1.get_pool_id());
+  {
+    CPUMemoryPool pool2;
+    EXPECT_EQ(base + 2, pool2.get_pool_id());
+  }
+  CPUMemoryPool pool3;
+  EXPECT_EQ(base + 3, pool3.get_pool_id());
+}
+
+TEST_F(CPUMemoryPoolTest, CheckAlignment) {
+  CPUMemoryPool pool;
+  for (std::uint64_t size : {1ull, 3ull, 100ull, 1000ull, 12345ull, 3000000ull}) {
+    const auto sp = pool.allocate(size);
+    EXPECT_EQ(
+        0u, reinterpret_cast<std::uintptr_t>(sp.get()) % CPUMemoryPool::ALIGNMENT);
+  }
+}
+
+TEST_F(CPUMemoryPoolTest, CheckAllocate) {
+  CPUMemoryPool pool;
+  const vector<std::uint64_t> sizes {
+    1, 65, 1000, 1 << 16, CPUMemoryPool::MAX_SMALL_SIZE, 1 << 24,
+  };
+  vector<void *> ptrs;
+  {
+    // Allocates new pointers.
+    vector<std::shared_ptr<void>> sps;
+    for (std::uint64_t size : sizes) sps.emplace_back(pool.allocate(size));
+    for (const auto &sp : sps) ptrs.emplace_back(sp.get());
+  }
+  // sps are released at the end of above scope, but the raw pointer is kept
+  // in the pool object.
+  {
+    // Allocates existing pointers.
+    vector<std::shared_ptr<void>> sps;
+    for (std::uint64_t size : sizes) sps.emplace_back(pool.allocate(size));
+    for (unsigned i = 0; i < sizes.size(); ++i) {
+      EXPECT_EQ(ptrs[i], sps[i].get());
+    }
+    // Allocates other pointers.
+    for (unsigned i = 0; i < sizes.size(); ++i) {
+      EXPECT_NE(ptrs[i], pool.allocate(sizes[i]).get());
+    }
+  }
+}
+
+TEST_F(CPUMemoryPoolTest, CheckSizeClasses) {
+  CPUMemoryPool pool;
+  void *p;
+  {
+    const auto sp = pool.allocate(1000);
+    p = sp.get();
+  }
+  // 1000 and 1024 bytes share the same size class.
+  EXPECT_EQ(p, pool.allocate(1024).get());
+  // 900 bytes belong to a different size class.
+  EXPECT_NE(p, pool.allocate(900).get());
+}
+
+TEST_F(CPUMemoryPoolTest, CheckBestFit) {
+  CPUMemoryPool pool;
+  const std::uint64_t size = 1 << 24;
+  void *p1, *p2;
+  {
+    const auto sp1 = pool.allocate(size + (size >> 1));
+    const auto sp2 = pool.allocate(size + (size >> 4));
+    p1 = sp1.get();
+    p2 = sp2.get();
+  }
+  // The smallest block which is large enough is chosen.
+  EXPECT_EQ(p2, pool.allocate(size).get());
+  // Too large blocks are not used.
+  EXPECT_NE(p1, pool.allocate(size).get());
+  EXPECT_EQ(p1, pool.allocate(size + (size >> 1)).get());
+}
+
+TEST_F(CPUMemoryPoolTest, CheckStatistics) {
+  CPUMemoryPool pool;
+  EXPECT_EQ(0u, pool.reserved_size());
+  EXPECT_EQ(0u, pool.in_use_size());
+  EXPECT_EQ(0u, pool.peak_size());
+  {
+    const auto sp1 = pool.allocate(100);  // 128 bytes
+    EXPECT_EQ(128u, pool.reserved_size());
+    EXPECT_EQ(128u, pool.in_use_size());
+    EXPECT_EQ(128u, pool.peak_size());
+    {
+      const auto sp2 = pool.allocate(64);  // 64 bytes
+      EXPECT_EQ(192u, pool.reserved_size());
+      EXPECT_EQ(192u, pool.in_use_size());
+      EXPECT_EQ(192u, pool.peak_size());
+    }
+    EXPECT_EQ(192u, pool.reserved_size());
+    EXPECT_EQ(128u, pool.in_use_size());
+    EXPECT_EQ(192u, pool.peak_size());
+    pool.release_reserved();
+    EXPECT_EQ(128u, pool.reserved_size());
+    EXPECT_EQ(128u, pool.in_use_size());
+    EXPECT_EQ(192u, pool.peak_size());
+  }
+  EXPECT_EQ(128u, pool.reserved_size());
+  EXPECT_EQ(0u, pool.in_use_size());
+  EXPECT_EQ(192u, pool.peak_size());
+  pool.release_reserved();
+  EXPECT_EQ(0u, pool.reserved_size());
+  EXPECT_EQ(0u, pool.in_use_size());
+  EXPECT_EQ(192u, pool.peak_size());
+}
+
+TEST_F(CPUMemoryPoolTest, CheckInvalidAllocate) {
+  CPUMemoryPool pool;
+  EXPECT_THROW(pool.allocate(1ull << 62), Error);
+}
+
+TEST_F(CPUMemoryPoolTest, CheckMultiThreadedAllocate) {
+  CPUMemoryPool pool;
+  vector<std::thread> threads;
+  for (unsigned t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool, t] {
+        for (unsigned i = 0; i < 1000; ++i) {
+          const auto sp = pool.allocate(64 * ((t + i) % 16 + 1));
+          static_cast<char *>(sp.get())[0] = 0;
+        }
+    });
+  }
+  for (std::thread &th : threads) th.join();
+  EXPECT_EQ(0u, pool.in_use_size());
+}
+
+TEST_F(CPUMemoryPoolTest, CheckBlockOutlivesPool) {
+  std::shared_ptr<void> sp;
+  {
+    CPUMemoryPool pool;
+    sp = pool.allocate(100);
+    pool.allocate(200);  // cached by the pool
+  }
+  // The block is still available after destroying the pool.
+  static_cast<char *>(sp.get())[99] = 1;
+  sp.reset();
+  SUCCEED();
+}
+
+TEST_F(CPUMemoryPoolTest, CheckDeviceMemory) {
+  devices::Naive dev;
+  const CPUMemoryPool &pool = dev.memory_pool();
+  {
+    const Tensor x = dev.new_tensor_by_constant({16, 16}, 0);
+    EXPECT_EQ(16u * 16u * sizeof(float), pool.in_use_size());
+  }
+  EXPECT_EQ(0u, pool.in_use_size());
+  EXPECT_EQ(16u * 16u * sizeof(float), pool.reserved_size());
+}
+
+TEST_F(CPUMemoryPoolTest, CheckTensorOutlivesDevice) {
+  Tensor x;
+  {
+    devices::Naive dev;
+    x = dev.new_tensor_by_constant({16, 16}, 0);
+  }
+  // The memory of `x` is returned to the system when `x` is destroyed.
+  SUCCEED();
+}
+
+}  // namespace primitiv
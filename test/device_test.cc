@@ -1,8 +1,14 @@
 #include <config.h>
 
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
+#include <primitiv/error.h>
 #include <primitiv/naive_device.h>
 
+using std::string;
+using std::vector;
+
 namespace primitiv {
 
 class DeviceTest : public testing::Test {};
@@ -26,4 +32,57 @@ TEST_F(DeviceTest, CheckDefault) {
   EXPECT_THROW(Device::get_default(), Error);
 }
 
+TEST_F(DeviceTest, CheckProfileDisabled) {
+  devices::Naive dev;
+  EXPECT_FALSE(dev.profiling());
+  const Tensor a = dev.new_tensor_by_constant({2, 3}, 1);
+  const Tensor b = dev.new_tensor_by_constant({3, 4}, 1);
+  dev.matmul_fw(a, b);
+  EXPECT_TRUE(dev.get_profile().empty());
+}
+
+TEST_F(DeviceTest, CheckProfile) {
+  devices::Naive dev;
+  const Tensor a = dev.new_tensor_by_constant({2, 3}, 1);
+  const Tensor b = dev.new_tensor_by_constant({3, 4}, 1);
+
+  dev.set_profiling(true);
+  EXPECT_TRUE(dev.profiling());
+  dev.matmul_fw(a, b);
+  dev.matmul_fw(a, b);
+  dev.tanh_fw(a);
+  dev.set_profiling(false);
+  dev.tanh_fw(b);
+
+  const vector<Device::ProfileEntry> entries = dev.get_profile();
+  // matmul_fw, tanh_fw, and allocate with 2 shapes.
+  EXPECT_EQ(4u, entries.size());
+  for (unsigned i = 1; i < entries.size(); ++i) {
+    EXPECT_GE(entries[i - 1].total_time, entries[i].total_time);
+  }
+  unsigned num_allocs = 0;
+  for (const Device::ProfileEntry &e : entries) {
+    if (e.name == "matmul_fw") {
+      EXPECT_EQ("[2,3]x1, [3,4]x1", e.shapes);
+      EXPECT_EQ(2u, e.count);
+      EXPECT_EQ(2u * (6 + 12 + 8) * sizeof(float), e.bytes);
+      EXPECT_EQ(2u * 2 * 8 * 3, e.flops);
+    } else if (e.name == "tanh_fw") {
+      EXPECT_EQ("[2,3]x1", e.shapes);
+      EXPECT_EQ(1u, e.count);
+      EXPECT_EQ(12u * sizeof(float), e.bytes);
+      EXPECT_EQ(6u, e.flops);
+    } else if (e.name == "allocate") {
+      num_allocs += e.count;
+    } else {
+      ADD_FAILURE() << "Unexpected entry: " << e.name;
+    }
+  }
+  // 2 results of matmul_fw() and 1 result of tanh_fw().
+  EXPECT_EQ(3u, num_allocs);
+
+  dev.reset_profile();
+  EXPECT_TRUE(dev.get_profile().empty());
+}
+
 }  // namespace primitiv
@@ -0,0 +1,249 @@
+#include <config.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <primitiv/eigen_device.h>
+#include <primitiv/naive_device.h>
+#include <primitiv/shape.h>
+#include <primitiv/tensor.h>
+#include <test_utils.h>
+
+using std::vector;
+using test_utils::vector_match;
+using test_utils::vector_near;
+
+namespace primitiv {
+
+class EigenDeviceTest : public testing::Test {};
+
+TEST_F(EigenDeviceTest, CheckDeviceType) {
+  devices::Eigen dev;
+  EXPECT_EQ(Device::DEVICE_TYPE_CPU, dev.type());
+}
+
+TEST_F(EigenDeviceTest, CheckCompatibilityWithNaive) {
+  devices::Naive naive(12345);
+  devices::Eigen eigen(12345);
+  const vector<float> a_data = naive.random_uniform(
+      Shape({8, 16}, 3), -1, 1).to_vector();
+  const vector<float> b_data = naive.random_uniform(
+      Shape({16, 4}), -1, 1).to_vector();
+  vector<vector<float>> results[2];
+  Device *devs[] {&naive, &eigen};
+  for (unsigned i = 0; i < 2; ++i) {
+    Device &dev = *devs[i];
+    const Tensor a = dev.new_tensor_by_vector(Shape({8, 16}, 3), a_data);
+    const Tensor b = dev.new_tensor_by_vector(Shape({16, 4}), b_data);
+    const Tensor y = dev.matmul_fw(a, b);
+    Tensor ga = dev.new_tensor_by_constant(a.shape(), 0);
+    Tensor gb = dev.new_tensor_by_constant(b.shape(), 0);
+    dev.matmul_bw(a, b, y, y, ga, gb);
+    results[i].emplace_back(y.to_vector());
+    results[i].emplace_back(ga.to_vector());
+    results[i].emplace_back(gb.to_vector());
+    results[i].emplace_back(dev.logsumexp_fw(a, 1).to_vector());
+    results[i].emplace_back(dev.sum_fw(a, 0).to_vector());
+    results[i].emplace_back(dev.batch_sum_fw(a).to_vector());
+    results[i].emplace_back(dev.transpose_fw(a).to_vector());
+  }
+  for (unsigned i = 0; i < results[0].size(); ++i) {
+    EXPECT_TRUE(vector_near(results[0][i], results[1][i], 1e-5)) << "i=" << i;
+  }
+}
+
+TEST_F(EigenDeviceTest, CheckNewDelete) {
+  {
+    devices::Eigen dev;
+    {
+      // 1 value
+      Tensor x1 = dev.new_tensor_by_constant(Shape(), 0);
+      // 256 values
+      Tensor x2 = dev.new_tensor_by_constant(Shape({16, 16}), 0);
+      // 65536 values
+      Tensor x3 = dev.new_tensor_by_constant(Shape({16, 16, 16}, 16), 0);
+    }
+    // All tensors are already deleted before arriving here.
+  }
+  SUCCEED();
+}
+
+TEST_F(EigenDeviceTest, CheckDanglingTensor) {
+  {
+    Tensor x1;
+    {
+      devices::Eigen dev;
+      x1 = dev.new_tensor_by_constant(Shape(), 0);
+    }
+    // x1 still has valid object,
+    // but there is no guarantee that the memory is alive.
+    // Our implementation only guarantees the safety to delete Tensors anytime.
+  }
+  SUCCEED();
+}
+
+#ifdef PRIMITIV_BUILD_TESTS_PROBABILISTIC
+TEST_F(EigenDeviceTest, CheckRandomBernoulli) {
+  vector<vector<float>> history;
+  for (unsigned i = 0; i < 10; ++i) {
+    devices::Eigen dev;
+    const Tensor x = dev.random_bernoulli(Shape({3, 3}, 3), 0.3);
+    const vector<float> x_val = x.to_vector();
+
+    std::cout << "Epoch " << i << ':';
+    for (float x_i : x_val) {
+      std::cout << ' ' << x_i;
+    }
+    std::cout << std::endl;
+
+    for (const vector<float> &h_val : history) {
+      EXPECT_FALSE(vector_match(x_val, h_val));
+    }
+    history.emplace_back(x_val);
+
+    // Wait for updating the device randomizer.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+}
+#endif  // PRIMITIV_BUILD_TESTS_PROBABILISTIC
+
+TEST_F(EigenDeviceTest, CheckRandomBernoulliWithSeed) {
+  const vector<float> expected {
+    0, 1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 0, 0, 0,
+    0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 1, 0, 0, 0,
+  };
+  devices::Eigen dev(12345);
+  const Tensor x = dev.random_bernoulli(Shape({4, 4}, 4), 0.3);
+  EXPECT_TRUE(vector_match(expected, x.to_vector()));
+}
+
+#ifdef PRIMITIV_BUILD_TESTS_PROBABILISTIC
+TEST_F(EigenDeviceTest, CheckRandomUniform) {
+  vector<vector<float>> history;
+  for (unsigned i = 0; i < 10; ++i) {
+    devices::Eigen dev;
+    const Tensor x = dev.random_uniform(Shape({2, 2}, 2), -9, 9);
+    const vector<float> x_val = x.to_vector();
+
+    std::cout << "Epoch " << i << ':';
+    for (float x_i : x_val) {
+      std::cout << ' ' << x_i;
+    }
+    std::cout << std::endl;
+
+    for (const vector<float> &h_val : history) {
+      EXPECT_FALSE(vector_match(x_val, h_val));
+    }
+    history.emplace_back(x_val);
+
+    // Wait for updating the device randomizer.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+}
+#endif  // PRIMITIV_BUILD_TESTS_PROBABILISTIC
+
+TEST_F(EigenDeviceTest, CheckRandomUniformWithSeed) {
+  const vector<float> expected {
+    7.7330894e+00, 7.0227852e+00, -3.3052402e+00, -6.6472688e+00,
+    -5.6894612e+00, -8.2843294e+00, -5.3179150e+00, 5.8758497e+00,
+  };
+  devices::Eigen dev(12345);
+  const Tensor x = dev.random_uniform(Shape({2, 2}, 2), -9, 9);
+  EXPECT_TRUE(vector_match(expected, x.to_vector()));
+}
+
+#ifdef PRIMITIV_BUILD_TESTS_PROBABILISTIC
+TEST_F(EigenDeviceTest, CheckRandomNormal) {
+  vector<vector<float>> history;
+  for (unsigned i = 0; i < 10; ++i) {
+    devices::Eigen dev;
+    const Tensor x = dev.random_normal(Shape({2, 2}, 2), 1, 3);
+    const vector<float> x_val = x.to_vector();
+
+    std::cout << "Epoch " << i << ':';
+    for (float x_i : x_val) {
+      std::cout << ' ' << x_i;
+    }
+    std::cout << std::endl;
+
+    for (const vector<float> &h_val : history) {
+      EXPECT_FALSE(vector_match(x_val, h_val));
+    }
+    history.emplace_back(x_val);
+
+    // Wait for updating the device randomizer.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+}
+#endif  // PRIMITIV_BUILD_TESTS_PROBABILISTIC
+
+TEST_F(EigenDeviceTest, CheckRandomNormalWithSeed) {
+#ifdef __GLIBCXX__
+  const vector<float> expected {
+    -1.3574908e+00, -1.7222166e-01, 2.5865970e+00, -4.3594337e-01,
+    4.5383353e+00, 8.4703674e+00, 2.5535507e+00, 1.3252910e+00,
+  };
+#elif defined _LIBCPP_VERSION
+  const vector<float> expected {
+    -1.7222166e-01, -1.3574908e+00, -4.3594337e-01, 2.5865970e+00,
+    8.4703674e+00, 4.5383353e+00, 1.3252910e+00, 2.5535507e+00,
+  };
+#else
+  const vector<float> expected {};
+  std::cerr << "... Unknown C++ library. Expected results can't be defined." << std::endl;
+#endif
+  devices::Eigen dev(12345);
+  const Tensor x = dev.random_normal(Shape({2, 2}, 2), 1, 3);
+  EXPECT_TRUE(vector_match(expected, x.to_vector()));
+}
+
+#ifdef PRIMITIV_BUILD_TESTS_PROBABILISTIC
+TEST_F(EigenDeviceTest, CheckRandomLogNormal) {
+  vector<vector<float>> history;
+  for (unsigned i = 0; i < 10; ++i) {
+    devices::Eigen dev;
+    const Tensor x = dev.random_log_normal(Shape({2, 2}, 2), 1, 3);
+    const vector<float> x_val = x.to_vector();
+
+    std::cout << "Epoch " << i << ':';
+    for (float x_i : x_val) {
+      std::cout << ' ' << x_i;
+    }
+    std::cout << std::endl;
+
+    for (const vector<float> &h_val : history) {
+      EXPECT_FALSE(vector_match(x_val, h_val));
+    }
+    history.emplace_back(x_val);
+
+    // Wait for updating the device randomizer.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+}
+#endif  // PRIMITIV_BUILD_TESTS_PROBABILISTIC
+
+TEST_F(EigenDeviceTest, CheckRandomLogNormalWithSeed) {
+#ifdef __GLIBCXX__
+  const vector<float> expected {
+    2.5730559e-01, 8.4179258e-01, 1.3284487e+01, 6.4665437e-01,
+    9.3534966e+01, 4.7712681e+03, 1.2852659e+01, 3.7632804e+00,
+  };
+#elif defined _LIBCPP_VERSION
+  const vector<float> expected {
+    8.4179258e-01, 2.5730559e-01, 6.4665437e-01, 1.3284487e+01,
+    4.7712681e+03, 9.3534966e+01, 3.7632804e+00, 1.2852659e+01,
+  };
+#else
+  const vector<float> expected {};
+  std::cerr << "... Unknown C++ library. Expected results can't be defined." << std::endl;
+#endif
+  devices::Eigen dev(12345);
+  const Tensor x = dev.random_log_normal(Shape({2, 2}, 2), 1, 3);
+  EXPECT_TRUE(vector_match(expected, x.to_vector()));
+}
+
+}  // namespace primitiv
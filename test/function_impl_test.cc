@@ -607,6 +607,62 @@ TEST_F(FunctionImplTest, CheckConcat) {
   }
 }
 
+TEST_F(FunctionImplTest, CheckSplit) {
+  struct TestCase {
+    unsigned dim;
+    Shape ret_shape;
+    vector<vector<float>> cur_value_data;
+    vector<float> arg_grad_data;
+  };
+  const vector<TestCase> test_cases {
+    {0, Shape({1, 2}, 3),
+      {{1, 3, 0, 0, -1, -3}, {2, 4, 0, 0, -2, -4}},
+      {1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2}},
+    {1, Shape({2}, 3),
+      {{1, 2, 0, 0, -1, -2}, {3, 4, 0, 0, -3, -4}},
+      {1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2}},
+  };
+  setup_1arg();
+  for (const TestCase &tc : test_cases) {
+    Split node(tc.dim, 2);
+    const vector<Shape> cur_shapes = node.forward_shapes(arg_shapes);
+    const vector<Tensor> cur_values = node.forward_multi(arg_values);
+    const Tensor cur_grad0 = dev->new_tensor_by_constant(tc.ret_shape, 1);
+    const Tensor cur_grad1 = dev->new_tensor_by_constant(tc.ret_shape, 2);
+    reset_gradients();
+    node.backward_multi(
+        {&cur_values[0], &cur_values[1]}, {&cur_grad0, &cur_grad1},
+        arg_values, arg_grads);
+    EXPECT_EQ("Split(" + std::to_string(tc.dim) + ",2)", node.name());
+    EXPECT_EQ(nullptr, node.get_device());
+    EXPECT_EQ(tc.ret_shape, node.forward_shape(arg_shapes));
+    ASSERT_EQ(2u, cur_shapes.size());
+    ASSERT_EQ(2u, cur_values.size());
+    for (unsigned i = 0; i < 2; ++i) {
+      EXPECT_EQ(tc.ret_shape, cur_shapes[i]);
+      EXPECT_TRUE(vector_match(tc.cur_value_data[i], cur_values[i].to_vector()));
+    }
+    EXPECT_TRUE(vector_match(tc.arg_grad_data, arg_grads[0]->to_vector()));
+
+    // Pieces without gradients are skipped.
+    reset_gradients();
+    node.backward_multi(
+        {&cur_values[0], &cur_values[1]}, {nullptr, &cur_grad1},
+        arg_values, arg_grads);
+    vector<float> expected = tc.arg_grad_data;
+    for (float &v : expected) if (v == 1) v = 0;
+    EXPECT_TRUE(vector_match(expected, arg_grads[0]->to_vector()));
+  }
+}
+
+TEST_F(FunctionImplTest, CheckInvalidSplit) {
+  setup_1arg();
+  EXPECT_NO_THROW(Split(2, 1).forward_shapes(arg_shapes));
+  EXPECT_THROW(Split(0, 0).forward_shapes(arg_shapes), Error);
+  EXPECT_THROW(Split(0, 3).forward_shapes(arg_shapes), Error);
+  EXPECT_THROW(Split(2, 2).forward_shapes(arg_shapes), Error);
+}
+
 TEST_F(FunctionImplTest, CheckReshape) {
   // y = reshape(x)
   // dy/dx = 1
@@ -1195,6 +1251,87 @@ TEST_F(FunctionImplTest, CheckLogSumExp) {
   }
 }
 
+TEST_F(FunctionImplTest, CheckSoftmax) {
+  // y = softmax(x, dim)
+  // dy/dx = y * (gy - sum(gy * y, dim))
+  setup_1arg();
+  struct TestCase {
+    unsigned dim;
+    vector<float> ret_data;
+    vector<float> bw_grad;
+  };
+  const vector<TestCase> test_cases {
+    {0,
+      {0.26894142, 0.73105858, 0.26894142, 0.73105858,
+        .5, .5, .5, .5,
+        0.73105858, 0.26894142, 0.73105858, 0.26894142},
+      {-0.19661193, 0.19661193, -0.78644773, 0.78644773,
+        .5, -.5, .75, -.75,
+        -0.19661193, 0.19661193, 0.78644773, -0.78644773}},
+    {1,
+      {0.11920292, 0.11920292, 0.88079708, 0.88079708,
+        .5, .5, .5, .5,
+        0.88079708, 0.88079708, 0.11920292, 0.11920292},
+      {0.20998717, -0.10499359, -0.20998717, 0.10499359,
+        .25, .5, -.25, -.5,
+        -0.31498076, 0.20998717, 0.31498076, -0.20998717}},
+  };
+  for (const TestCase &tc : test_cases) {
+    Softmax node(tc.dim);
+    const Shape cur_shape = node.forward_shape(arg_shapes);
+    const Tensor cur_value = node.forward(arg_values);
+    const Tensor cur_grad = dev->new_tensor_by_vector(
+        *arg_shapes[0], {1, 2, -1, 3, 2, 0, 1, -2, 0, 1, 3, -1});
+    reset_gradients();
+    node.backward(cur_value, cur_grad, arg_values, arg_grads);
+    EXPECT_EQ("Softmax(" + std::to_string(tc.dim) + ')', node.name());
+    EXPECT_EQ(*arg_shapes[0], cur_shape);
+    EXPECT_EQ(nullptr, node.get_device());
+    EXPECT_TRUE(vector_near(tc.ret_data, cur_value.to_vector(), 1e-6));
+    EXPECT_TRUE(vector_near(tc.bw_grad, arg_grads[0]->to_vector(), 1e-6));
+  }
+}
+
+TEST_F(FunctionImplTest, CheckLogSoftmax) {
+  // y = log_softmax(x, dim)
+  // dy/dx = gy - softmax(x, dim) * sum(gy, dim)
+  setup_1arg();
+  struct TestCase {
+    unsigned dim;
+    vector<float> ret_data;
+    vector<float> bw_grad;
+  };
+  const vector<TestCase> test_cases {
+    {0,
+      {-1.31326169, -0.31326169, -1.31326169, -0.31326169,
+        -0.69314718, -0.69314718, -0.69314718, -0.69314718,
+        -0.31326169, -1.31326169, -0.31326169, -1.31326169},
+      {0.46211716, -0.46211716, 0.46211716, -0.46211716,
+        0, 0, 0, 0,
+        -0.46211716, 0.46211716, -0.46211716, 0.46211716}},
+    {1,
+      {-2.12692801, -2.12692801, -0.12692801, -0.12692801,
+        -0.69314718, -0.69314718, -0.69314718, -0.69314718,
+        -0.12692801, -0.12692801, -2.12692801, -2.12692801},
+      {0.76159416, 0.76159416, -0.76159416, -0.76159416,
+        0, 0, 0, 0,
+        -0.76159416, -0.76159416, 0.76159416, 0.76159416}},
+  };
+  for (const TestCase &tc : test_cases) {
+    LogSoftmax node(tc.dim);
+    const Shape cur_shape = node.forward_shape(arg_shapes);
+    const Tensor cur_value = node.forward(arg_values);
+    const Tensor cur_grad = operators::ones<Tensor>(*arg_shapes[0], *dev);
+    reset_gradients();
+    node.backward(cur_value, cur_grad, arg_values, arg_grads);
+    EXPECT_EQ("LogSoftmax(" + std::to_string(tc.dim) + ')', node.name());
+    EXPECT_EQ(*arg_shapes[0], cur_shape);
+    EXPECT_EQ(nullptr, node.get_device());
+    EXPECT_TRUE(vector_near(tc.ret_data, cur_value.to_vector(), 1e-6));
+    EXPECT_TRUE(vector_near(tc.bw_grad, arg_grads[0]->to_vector(), 1e-6));
+  }
+}
+
 TEST_F(FunctionImplTest, CheckBroadcast) {
   // y = broadcast(x, dim, size)
   // dy/dx = sum(1, dim)
@@ -1246,6 +1383,16 @@ TEST_F(FunctionImplTest, CheckBatchSum) {
   TEST_1ARG(BatchSum);
 }
 
+TEST_F(FunctionImplTest, CheckBatchToColumns) {
+  // y = [vec(x[0]), vec(x[1]), ...]
+  // dy/dx = 1 for every element.
+  setup_1arg();
+  const Shape ret_shape {4, 3};
+  const vector<float> ret_data {1, 2, 3, 4, 0, 0, 0, 0, -1, -2, -3, -4};
+  const vector<float> bw_grad(12, 1);
+  TEST_1ARG(BatchToColumns);
+}
+
 TEST_F(FunctionImplTest, CheckSoftmaxCrossEntropy) {
   // y = softmax_cross_entropy(x, t, dim)
   // dy/dx = softmax(x) - t
@@ -1327,5 +1474,338 @@ TEST_F(FunctionImplTest, CheckSparseSoftmaxCrossEntropy) {
   }
 }
 
+TEST_F(FunctionImplTest, CheckChunkedSoftmaxCrossEntropy) {
+  // y = softmax_cross_entropy(matmul(w, x) + b, ids, 0)
+  // dy/dz = softmax(z) - delta(z, i), z = matmul(w, x) + b
+  using namespace operators;
+  struct TestCase {
+    Shape x_shape;
+    vector<unsigned> ids;
+    unsigned chunk_size;
+  };
+  const vector<TestCase> test_cases {
+    {Shape({3}, 2), {4, 0}, 1},
+    {Shape({3}, 2), {1, 3}, 2},
+    {Shape({3}, 2), {2}, 5},
+    {Shape({3}), {3, 0, 4}, 2},
+    {Shape({3}), {2}, 7},
+  };
+  const Tensor w = dev->new_tensor_by_vector(
+      {5, 3}, {1, -1, 2, 0, .5, -2, 1, 0, 3, -1, .5, .5, -1, 2, 1});
+  const Tensor b = dev->new_tensor_by_vector({5}, {.1, -.2, .3, 0, -.5});
+  for (const TestCase &tc : test_cases) {
+    vector<float> x_data(tc.x_shape.size());
+    for (unsigned i = 0; i < x_data.size(); ++i) x_data[i] = .3 * i - .5;
+    const Tensor x = dev->new_tensor_by_vector(tc.x_shape, x_data);
+
+    // Reference values calculated by the whole logits.
+    const Tensor z = matmul(w, x) + b;
+    const Tensor ref_y = softmax_cross_entropy(z, tc.ids, 0);
+    const float gy_data[] {1, 2, 3};
+    const Tensor gy = dev->new_tensor_by_array(ref_y.shape(), gy_data);
+    Tensor gz = softmax(z, 0) * broadcast(gy, 0, 5);
+    dev->pick_bw(-gy, tc.ids, 0, gz);
+    const Tensor ref_gx = tc.x_shape.has_batch()
+      ? matmul(transpose(w), gz) : batch::sum(matmul(transpose(w), gz));
+    const Tensor ref_gw = batch::sum(matmul(gz, transpose(x)));
+    const Tensor ref_gb = batch::sum(gz);
+
+    const vector<const Shape *> shapes {&x.shape(), &w.shape(), &b.shape()};
+    const vector<const Tensor *> values {&x, &w, &b};
+    Tensor gx = zeros<Tensor>(x.shape(), *dev);
+    Tensor gw = zeros<Tensor>(w.shape(), *dev);
+    Tensor gb = zeros<Tensor>(b.shape(), *dev);
+    const vector<Tensor *> grads {&gx, &gw, &gb};
+    ChunkedSoftmaxCrossEntropy node(tc.ids, tc.chunk_size);
+    const Shape cur_shape = node.forward_shape(shapes);
+    const Tensor cur_value = node.forward(values);
+    node.backward(cur_value, gy, values, grads);
+    EXPECT_EQ(
+        "ChunkedSoftmaxCrossEntropy(" + std::to_string(tc.chunk_size) + ')',
+        node.name());
+    EXPECT_EQ(ref_y.shape(), cur_shape);
+    EXPECT_EQ(nullptr, node.get_device());
+    EXPECT_TRUE(vector_near(ref_y.to_vector(), cur_value.to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gx.to_vector(), gx.to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gw.to_vector(), gw.to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gb.to_vector(), gb.to_vector(), 1e-5));
+  }
+}
+
+TEST_F(FunctionImplTest, CheckInvalidChunkedSoftmaxCrossEntropy) {
+  const Shape x({3}, 2), w({5, 3}), b({5}), bad_w({5, 4});
+  EXPECT_THROW(
+      ChunkedSoftmaxCrossEntropy({0, 1}, 0).forward_shape({&x, &w, &b}),
+      Error);
+  EXPECT_THROW(
+      ChunkedSoftmaxCrossEntropy({0, 1}, 2).forward_shape({&x, &bad_w, &b}),
+      Error);
+  EXPECT_THROW(
+      ChunkedSoftmaxCrossEntropy({0, 5}, 2).forward_shape({&x, &w, &b}),
+      Error);
+  EXPECT_THROW(
+      ChunkedSoftmaxCrossEntropy({0, 1, 2}, 2).forward_shape({&x, &w, &b}),
+      Error);
+}
+
+TEST_F(FunctionImplTest, CheckLSTMCell) {
+  // u = matmul(wx, x) + matmul(wh, h) + b
+  // c' = i * j + f * c, h' = o * tanh(c')
+  using namespace operators;
+  struct TestCase {
+    Shape x_shape, h_shape, c_shape;
+  };
+  const vector<TestCase> test_cases {
+    {Shape({3}), Shape({2}), Shape({2})},
+    {Shape({3}, 2), Shape({2}, 2), Shape({2}, 2)},
+    {Shape({3}, 2), Shape({2}), Shape({2})},
+    {Shape({3}), Shape({2}), Shape({2}, 2)},
+  };
+  const Tensor wx = dev->new_tensor_by_vector(
+      {8, 3}, {1, -1, 2, 0, .5, -2, 1, 0, 3, -1, .5, .5,
+               -1, 2, 1, 0, .2, -.3, .4, 1, -1, .5, 0, 2});
+  const Tensor wh = dev->new_tensor_by_vector(
+      {8, 2}, {.5, 0, -1, 1, 2, -.5, 0, 1, -1, .5, 1, 0, -2, 1, .5, -1});
+  const Tensor b = dev->new_tensor_by_vector(
+      {8}, {.1, -.2, .3, 0, -.5, .2, .4, -.1});
+  for (const TestCase &tc : test_cases) {
+    vector<float> x_data(tc.x_shape.size());
+    vector<float> h_data(tc.h_shape.size());
+    vector<float> c_data(tc.c_shape.size());
+    for (unsigned i = 0; i < x_data.size(); ++i) x_data[i] = .3 * i - .5;
+    for (unsigned i = 0; i < h_data.size(); ++i) h_data[i] = .8 - .4 * i;
+    for (unsigned i = 0; i < c_data.size(); ++i) c_data[i] = .7 * i - 1;
+    const Tensor x = dev->new_tensor_by_vector(tc.x_shape, x_data);
+    const Tensor h = dev->new_tensor_by_vector(tc.h_shape, h_data);
+    const Tensor c = dev->new_tensor_by_vector(tc.c_shape, c_data);
+
+    // Reference values calculated by separated operations.
+    const Tensor u = matmul(wx, x) + matmul(wh, h) + b;
+    const Tensor i = sigmoid(slice(u, 0, 0, 2));
+    const Tensor f = sigmoid(slice(u, 0, 2, 4));
+    const Tensor o = sigmoid(slice(u, 0, 4, 6));
+    const Tensor j = tanh(slice(u, 0, 6, 8));
+    const Tensor ref_c = i * j + f * c;
+    const Tensor ref_h = o * tanh(ref_c);
+    const Tensor ref_y = concat({ref_h, ref_c}, 0);
+    vector<float> gy_data(ref_y.shape().size());
+    for (unsigned k = 0; k < gy_data.size(); ++k) gy_data[k] = .5 * k - 1;
+    const Tensor gy = dev->new_tensor_by_vector(ref_y.shape(), gy_data);
+    const Tensor gh = slice(gy, 0, 0, 2);
+    const Tensor tc_ = tanh(ref_c);
+    const Tensor dc = slice(gy, 0, 2, 4) + gh * o * (1 - tc_ * tc_);
+    const Tensor gu = concat({
+        dc * j * i * (1 - i), dc * c * f * (1 - f),
+        gh * tc_ * o * (1 - o), dc * i * (1 - j * j)}, 0);
+    const auto bsum = [](const Tensor &g, const Shape &s) {
+      return s.has_batch() ? g : batch::sum(g);
+    };
+    const Tensor ref_gx = bsum(matmul(transpose(wx), gu), tc.x_shape);
+    const Tensor ref_gh = bsum(matmul(transpose(wh), gu), tc.h_shape);
+    const Tensor ref_gc = bsum(dc * f, tc.c_shape);
+    const Tensor ref_gwx = batch::sum(matmul(gu, transpose(x)));
+    const Tensor ref_gwh = batch::sum(matmul(gu, transpose(h)));
+    const Tensor ref_gb = batch::sum(sum(gu, 1));
+
+    const vector<const Shape *> shapes {
+      &x.shape(), &h.shape(), &c.shape(), &wx.shape(), &wh.shape(), &b.shape(),
+    };
+    const vector<const Tensor *> values {&x, &h, &c, &wx, &wh, &b};
+    vector<Tensor> grads_data;
+    for (const Tensor *v : values) {
+      grads_data.emplace_back(zeros<Tensor>(v->shape(), *dev));
+    }
+    vector<Tensor *> grads;
+    for (Tensor &g : grads_data) grads.emplace_back(&g);
+    LSTMCell node;
+    const Shape cur_shape = node.forward_shape(shapes);
+    const Tensor cur_value = node.forward(values);
+    node.backward(cur_value, gy, values, grads);
+    EXPECT_EQ("LSTMCell", node.name());
+    EXPECT_EQ(ref_y.shape(), cur_shape);
+    EXPECT_EQ(nullptr, node.get_device());
+    EXPECT_TRUE(vector_near(ref_y.to_vector(), cur_value.to_vector(), 1e-6));
+    EXPECT_TRUE(vector_near(ref_gx.to_vector(), grads[0]->to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gh.to_vector(), grads[1]->to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gc.to_vector(), grads[2]->to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gwx.to_vector(), grads[3]->to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gwh.to_vector(), grads[4]->to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gb.to_vector(), grads[5]->to_vector(), 1e-5));
+
+    // The activated gates are returned as the second value and used by
+    // `backward_multi()` instead of being recalculated.
+    const Tensor ref_gates = concat({i, f, o, j}, 0);
+    vector<Tensor> multi_grads_data;
+    for (const Tensor *v : values) {
+      multi_grads_data.emplace_back(zeros<Tensor>(v->shape(), *dev));
+    }
+    vector<Tensor *> multi_grads;
+    for (Tensor &g : multi_grads_data) multi_grads.emplace_back(&g);
+    const vector<Shape> cur_shapes = node.forward_shapes(shapes);
+    const vector<Tensor> cur_values = node.forward_multi(values);
+    node.backward_multi(
+        {&cur_values[0], &cur_values[1]}, {&gy, nullptr}, values, multi_grads);
+    ASSERT_EQ(2u, cur_shapes.size());
+    ASSERT_EQ(2u, cur_values.size());
+    EXPECT_EQ(ref_y.shape(), cur_shapes[0]);
+    EXPECT_EQ(ref_gates.shape(), cur_shapes[1]);
+    EXPECT_TRUE(vector_near(
+          ref_y.to_vector(), cur_values[0].to_vector(), 1e-6));
+    EXPECT_TRUE(vector_near(
+          ref_gates.to_vector(), cur_values[1].to_vector(), 1e-6));
+    for (unsigned k = 0; k < grads.size(); ++k) {
+      EXPECT_TRUE(vector_near(
+            grads[k]->to_vector(), multi_grads[k]->to_vector(), 1e-6));
+    }
+  }
+}
+
+TEST_F(FunctionImplTest, CheckInvalidLSTMCell) {
+  const Shape x({3}), h({2}), c({2}), wx({8, 3}), wh({8, 2}), b({8});
+  const Shape bad_c({3}), bad_wh({6, 2}), bad_b({8}, 3), bad_x({3}, 2);
+  EXPECT_THROW(
+      LSTMCell().forward_shape({&x, &h, &c, &wx, &wh}), Error);
+  EXPECT_THROW(
+      LSTMCell().forward_shape({&x, &h, &bad_c, &wx, &wh, &b}), Error);
+  EXPECT_THROW(
+      LSTMCell().forward_shape({&x, &h, &c, &wx, &bad_wh, &b}), Error);
+  EXPECT_THROW(
+      LSTMCell().forward_shape({&bad_x, &h, &c, &wx, &wh, &bad_b}), Error);
+}
+
+TEST_F(FunctionImplTest, CheckLSTM) {
+  // Compares with the LSTMCell applied to each step.
+  using namespace operators;
+  struct TestCase {
+    Shape x_shape, h_shape, c_shape;
+  };
+  const vector<TestCase> test_cases {
+    {Shape({3, 4}), Shape({2}), Shape({2})},
+    {Shape({3, 4}, 2), Shape({2}, 2), Shape({2}, 2)},
+    {Shape({3, 3}, 2), Shape({2}), Shape({2})},
+    {Shape({3, 2}), Shape({2}, 2), Shape({2})},
+    {Shape({3}), Shape({2}), Shape({2}, 2)},
+  };
+  const Tensor wx = dev->new_tensor_by_vector(
+      {8, 3}, {1, -1, 2, 0, .5, -2, 1, 0, 3, -1, .5, .5,
+               -1, 2, 1, 0, .2, -.3, .4, 1, -1, .5, 0, 2});
+  const Tensor wh = dev->new_tensor_by_vector(
+      {8, 2}, {.5, 0, -1, 1, 2, -.5, 0, 1, -1, .5, 1, 0, -2, 1, .5, -1});
+  const Tensor b = dev->new_tensor_by_vector(
+      {8}, {.1, -.2, .3, 0, -.5, .2, .4, -.1});
+  for (const TestCase &tc : test_cases) {
+    vector<float> x_data(tc.x_shape.size());
+    vector<float> h_data(tc.h_shape.size());
+    vector<float> c_data(tc.c_shape.size());
+    for (unsigned i = 0; i < x_data.size(); ++i) x_data[i] = .3 * i - .5;
+    for (unsigned i = 0; i < h_data.size(); ++i) h_data[i] = .8 - .4 * i;
+    for (unsigned i = 0; i < c_data.size(); ++i) c_data[i] = .7 * i - 1;
+    const Tensor x = dev->new_tensor_by_vector(tc.x_shape, x_data);
+    const Tensor h = dev->new_tensor_by_vector(tc.h_shape, h_data);
+    const Tensor c = dev->new_tensor_by_vector(tc.c_shape, c_data);
+    const unsigned len = tc.x_shape[1];
+
+    // Reference values calculated by LSTMCell.
+    vector<LSTMCell> cells(len);
+    vector<Tensor> xs, hs {h}, cs {c}, ys;
+    for (unsigned t = 0; t < len; ++t) {
+      xs.emplace_back(slice(x, 1, t, t + 1));
+      ys.emplace_back(cells[t].forward({&xs[t], &hs[t], &cs[t], &wx, &wh, &b}));
+      hs.emplace_back(slice(ys[t], 0, 0, 2));
+      cs.emplace_back(slice(ys[t], 0, 2, 4));
+    }
+    const Tensor ref_y = concat(ys, 1);
+    vector<float> gy_data(ref_y.shape().size());
+    for (unsigned k = 0; k < gy_data.size(); ++k) gy_data[k] = .5 - .1 * k;
+    const Tensor gy = dev->new_tensor_by_vector(ref_y.shape(), gy_data);
+    Tensor ref_gx = zeros<Tensor>(x.shape(), *dev);
+    Tensor ref_gwx = zeros<Tensor>(wx.shape(), *dev);
+    Tensor ref_gwh = zeros<Tensor>(wh.shape(), *dev);
+    Tensor ref_gb = zeros<Tensor>(b.shape(), *dev);
+    Tensor gh = zeros<Tensor>(ys[len - 1].shape(), *dev);
+    Tensor ref_gh, ref_gc;
+    for (unsigned t = len; t-- > 0; ) {
+      const Tensor gyt = slice(gy, 1, t, t + 1) + gh;
+      Tensor gxt = zeros<Tensor>(xs[t].shape(), *dev);
+      Tensor ght = zeros<Tensor>(hs[t].shape(), *dev);
+      Tensor gct = zeros<Tensor>(cs[t].shape(), *dev);
+      cells[t].backward(
+          ys[t], gyt, {&xs[t], &hs[t], &cs[t], &wx, &wh, &b},
+          {&gxt, &ght, &gct, &ref_gwx, &ref_gwh, &ref_gb});
+      dev->slice_bw(gxt, 1, t, ref_gx);
+      if (t > 0) gh = concat({ght, gct}, 0);
+      ref_gh = ght;
+      ref_gc = gct;
+    }
+
+    const vector<const Shape *> shapes {
+      &x.shape(), &h.shape(), &c.shape(), &wx.shape(), &wh.shape(), &b.shape(),
+    };
+    const vector<const Tensor *> values {&x, &h, &c, &wx, &wh, &b};
+    vector<Tensor> grads_data;
+    for (const Tensor *v : values) {
+      grads_data.emplace_back(zeros<Tensor>(v->shape(), *dev));
+    }
+    vector<Tensor *> grads;
+    for (Tensor &g : grads_data) grads.emplace_back(&g);
+    LSTM node;
+    const Shape cur_shape = node.forward_shape(shapes);
+    const Tensor cur_value = node.forward(values);
+    node.backward(cur_value, gy, values, grads);
+    EXPECT_EQ("LSTM", node.name());
+    EXPECT_EQ(ref_y.shape(), cur_shape);
+    EXPECT_EQ(nullptr, node.get_device());
+    EXPECT_TRUE(vector_near(ref_y.to_vector(), cur_value.to_vector(), 1e-6));
+    EXPECT_TRUE(vector_near(ref_gx.to_vector(), grads[0]->to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gh.to_vector(), grads[1]->to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gc.to_vector(), grads[2]->to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gwx.to_vector(), grads[3]->to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gwh.to_vector(), grads[4]->to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(ref_gb.to_vector(), grads[5]->to_vector(), 1e-5));
+
+    // The activated gates of all steps are returned as the second value.
+    vector<Tensor> gates;
+    for (unsigned t = 0; t < len; ++t) {
+      gates.emplace_back(
+          cells[t].forward_multi({&xs[t], &hs[t], &cs[t], &wx, &wh, &b})[1]);
+    }
+    const Tensor ref_gates = concat(gates, 1);
+    vector<Tensor> multi_grads_data;
+    for (const Tensor *v : values) {
+      multi_grads_data.emplace_back(zeros<Tensor>(v->shape(), *dev));
+    }
+    vector<Tensor *> multi_grads;
+    for (Tensor &g : multi_grads_data) multi_grads.emplace_back(&g);
+    const vector<Shape> cur_shapes = node.forward_shapes(shapes);
+    const vector<Tensor> cur_values = node.forward_multi(values);
+    node.backward_multi(
+        {&cur_values[0], &cur_values[1]}, {&gy, nullptr}, values, multi_grads);
+    ASSERT_EQ(2u, cur_shapes.size());
+    ASSERT_EQ(2u, cur_values.size());
+    EXPECT_EQ(ref_y.shape(), cur_shapes[0]);
+    EXPECT_EQ(ref_gates.shape(), cur_shapes[1]);
+    EXPECT_TRUE(vector_near(
+          ref_y.to_vector(), cur_values[0].to_vector(), 1e-6));
+    EXPECT_TRUE(vector_near(
+          ref_gates.to_vector(), cur_values[1].to_vector(), 1e-6));
+    for (unsigned k = 0; k < grads.size(); ++k) {
+      EXPECT_TRUE(vector_near(
+            grads[k]->to_vector(), multi_grads[k]->to_vector(), 1e-6));
+    }
+  }
+}
+
+TEST_F(FunctionImplTest, CheckInvalidLSTM) {
+  const Shape x({3, 4}), h({2}), c({2}), wx({8, 3}), wh({8, 2}), b({8});
+  const Shape bad_x({3, 4, 2}), bad_h({3}), bad_wh({8, 3}), bad_c({2, 4});
+  EXPECT_THROW(LSTM().forward_shape({&x, &h, &c, &wx, &wh}), Error);
+  EXPECT_THROW(
+      LSTM().forward_shape({&bad_x, &h, &c, &wx, &wh, &b}), Error);
+  EXPECT_THROW(
+      LSTM().forward_shape({&x, &bad_h, &c, &wx, &bad_wh, &b}), Error);
+  EXPECT_THROW(
+      LSTM().forward_shape({&x, &h, &bad_c, &wx, &wh, &b}), Error);
+}
+
 }  // namespace functions
 }  // namespace primitiv
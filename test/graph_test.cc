@@ -1,6 +1,10 @@
 #include <config.h>
 
+#include <cstdio>
+#include <fstream>
 #include <sstream>
+#include <string>
+#include <tuple>
 #include <vector>
 #include <gtest/gtest.h>
 #include <primitiv/error.h>
@@ -246,6 +250,471 @@ TEST_F(GraphTest, CheckForwardBackward) {
 #endif
 }
 
+TEST_F(GraphTest, CheckForwardWithoutRetain) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+
+  const CPUMemoryPool &pool = dev.memory_pool();
+  // Each value occupies the smallest memory block.
+  const std::uint64_t value_size = CPUMemoryPool::ALIGNMENT;
+  const Node x = operators::input<Node>({2, 2}, {1, 2, 3, 4});
+  const Node y1 = x + 1;
+  const Node y2 = y1 * 2;
+  const Node y3 = y2 - x;
+  const Node y4 = y3 * y3;
+  EXPECT_EQ(0u, pool.in_use_size());
+
+  // Only the target value is retained.
+  const vector<float> y4_val {9, 16, 25, 36};
+  EXPECT_TRUE(vector_match(y4_val, g.forward(y4, false).to_vector()));
+  EXPECT_EQ(value_size, pool.in_use_size());
+  EXPECT_GE(3 * value_size, pool.peak_size());
+
+  // Discarded values are calculated again.
+  const vector<float> y2_val {4, 6, 8, 10};
+  EXPECT_TRUE(vector_match(y2_val, g.forward(y2, false).to_vector()));
+  EXPECT_EQ(2 * value_size, pool.in_use_size());
+
+  // Discarded values can not be used in the backward calculation.
+  EXPECT_THROW(g.backward(y4), Error);
+}
+
+TEST_F(GraphTest, CheckForwardWithoutRetainKeepsPreviousValues) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+
+  const CPUMemoryPool &pool = dev.memory_pool();
+  // Each value occupies the smallest memory block.
+  const std::uint64_t value_size = CPUMemoryPool::ALIGNMENT;
+  const Node x = operators::input<Node>({2, 2}, {1, 2, 3, 4});
+  const Node h = operators::tanh(x);
+  const Node y1 = h * 2;
+  const Node y2 = h + y1;
+
+  // The value of `h` calculated by the retaining call is kept.
+  g.forward(h);
+  EXPECT_EQ(2 * value_size, pool.in_use_size());
+  g.forward(y2, false);
+  EXPECT_EQ(3 * value_size, pool.in_use_size());
+  const vector<float> h_val = g.forward(h).to_vector();
+  const vector<float> y2_val = g.forward(y2).to_vector();
+  for (unsigned i = 0; i < h_val.size(); ++i) {
+    EXPECT_FLOAT_EQ(3 * h_val[i], y2_val[i]);
+  }
+}
+
+TEST_F(GraphTest, CheckForwardMultipleNodes) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+
+  const Node x = operators::input<Node>({2, 2}, {1, 2, 3, 4});
+  const Node y1 = x + 1;
+  const Node y2 = y1 * 2;
+  const Node y3 = y1 - x;
+  const Node w = operators::input<Node>({2, 2}, {1, 1, 1, 1});
+
+  const vector<const Tensor *> values = g.forward({y2, y3, x, y2});
+  ASSERT_EQ(4u, values.size());
+  EXPECT_TRUE(vector_match(vector<float> {4, 6, 8, 10}, values[0]->to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {1, 1, 1, 1}, values[1]->to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {1, 2, 3, 4}, values[2]->to_vector()));
+  EXPECT_EQ(values[0], values[3]);
+
+  // Each value is stored to the graph.
+  EXPECT_EQ(values[0], &g.forward(y2));
+  EXPECT_EQ(values[1], &g.forward(y3));
+
+  // Only targets are stored.
+  const Node z1 = w + y3;
+  const Node z2 = z1 * 3;
+  const Node z3 = z1 * 4;
+  const Node z4 = z2 + z3;
+  const vector<const Tensor *> values2 = g.forward({z2, z4}, false);
+  EXPECT_TRUE(vector_match(vector<float> {6, 6, 6, 6}, values2[0]->to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {14, 14, 14, 14}, values2[1]->to_vector()));
+  EXPECT_THROW(g.backward(z4), Error);
+}
+
+TEST_F(GraphTest, CheckLongChain) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+
+  // The graph is calculated without any recursive calls.
+  const unsigned n = 100000;
+  const Node x = operators::input<Node>({}, {0});
+  Node y = x;
+  for (unsigned i = 0; i < n; ++i) {
+    y = y + 1;
+  }
+  EXPECT_EQ(n + 1, g.num_functions());
+  EXPECT_FLOAT_EQ(n, y.to_float());
+  EXPECT_NO_THROW(g.backward(y));
+}
+
+TEST_F(GraphTest, CheckInvalidNumThreads) {
+  Graph g;
+  EXPECT_EQ(1u, g.num_threads());
+  EXPECT_THROW(g.set_num_threads(0), Error);
+  g.set_num_threads(4);
+  EXPECT_EQ(4u, g.num_threads());
+  g.set_num_threads(1);
+  EXPECT_EQ(1u, g.num_threads());
+}
+
+TEST_F(GraphTest, CheckParallelForwardBackward) {
+  Device::set_default(dev);
+
+  vector<float> w_data(16), x_data(4 * 16);
+  for (unsigned i = 0; i < w_data.size(); ++i) w_data[i] = .1 * (i % 7) - .3;
+  for (unsigned i = 0; i < x_data.size(); ++i) x_data[i] = .2 * (i % 5) - .4;
+  Parameter w({4, 4}, w_data);
+  Parameter b({4}, {.1, -.2, .3, -.4});
+
+  vector<float> losses;
+  vector<vector<float>> w_grads, b_grads;
+  for (unsigned num_threads : {1u, 2u, 4u}) {
+    Graph g;
+    Graph::set_default(g);
+    g.set_num_threads(num_threads);
+    w.reset_gradient();
+    b.reset_gradient();
+
+    // Independent recurrent chains sharing parameters.
+    const Node pw = operators::parameter<Node>(w);
+    const Node pb = operators::parameter<Node>(b);
+    vector<Node> chain_losses;
+    for (unsigned c = 0; c < 4; ++c) {
+      Node h = operators::zeros<Node>({4});
+      for (unsigned t = 0; t < 4; ++t) {
+        const unsigned offset = 4 * (4 * c + t);
+        const Node x = operators::input<Node>(
+            {4}, vector<float>(&x_data[offset], &x_data[offset + 4]));
+        h = operators::tanh(operators::matmul(pw, h) + x + pb);
+      }
+      chain_losses.emplace_back(operators::sum(h * h, 0));
+    }
+    Node loss = chain_losses[0];
+    for (unsigned c = 1; c < chain_losses.size(); ++c) {
+      loss = loss + chain_losses[c];
+    }
+
+    losses.emplace_back(loss.to_float());
+    loss.backward();
+    w_grads.emplace_back(w.gradient().to_vector());
+    b_grads.emplace_back(b.gradient().to_vector());
+  }
+
+  for (unsigned i = 1; i < losses.size(); ++i) {
+    EXPECT_FLOAT_EQ(losses[0], losses[i]);
+    EXPECT_TRUE(vector_near(w_grads[0], w_grads[i], 1e-6));
+    EXPECT_TRUE(vector_near(b_grads[0], b_grads[i], 1e-6));
+  }
+}
+
+TEST_F(GraphTest, CheckParallelForwardWithoutRetain) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+  g.set_num_threads(4);
+
+  const Node x = operators::input<Node>({2, 2}, {1, 2, 3, 4});
+  vector<Node> ys;
+  for (unsigned i = 0; i < 16; ++i) {
+    ys.emplace_back((x + i) * 2);
+  }
+  Node y = ys[0];
+  for (unsigned i = 1; i < ys.size(); ++i) y = y + ys[i];
+
+  const vector<float> y_val {272, 304, 336, 368};
+  EXPECT_TRUE(vector_match(y_val, g.forward(y, false).to_vector()));
+  EXPECT_EQ(CPUMemoryPool::ALIGNMENT, dev.memory_pool().in_use_size());
+}
+
+TEST_F(GraphTest, CheckFreeze) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+
+  const Node x = operators::input<Node>({2}, {1, 2});
+  const Node y = x + 1;
+  EXPECT_FALSE(g.frozen());
+  g.freeze();
+  EXPECT_TRUE(g.frozen());
+  EXPECT_THROW(y * 2, Error);
+  EXPECT_EQ(2u, g.num_functions());
+
+  g.clear();
+  EXPECT_FALSE(g.frozen());
+  EXPECT_NO_THROW(operators::input<Node>({2}, {1, 2}) + 1);
+}
+
+TEST_F(GraphTest, CheckRewind) {
+  Device::set_default(dev);
+
+  for (const bool freeze : {false, true}) {
+    Graph g;
+    Graph::set_default(g);
+
+    const Node x = operators::input<Node>({2}, {1, 2});
+    const Node y = x * 2;
+    const Node z = y + 1;
+    if (freeze) g.freeze();
+    EXPECT_TRUE(vector_match(vector<float> {3, 5}, g.forward(z).to_vector()));
+    EXPECT_NE(0u, dev.memory_pool().in_use_size());
+
+    g.rewind();
+    EXPECT_EQ(0u, dev.memory_pool().in_use_size());
+    EXPECT_TRUE(vector_match(vector<float> {2, 4}, g.forward(y).to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {3, 5}, g.forward(z).to_vector()));
+  }
+}
+
+TEST_F(GraphTest, CheckInvalidSetDataAndIds) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+
+  const Node x = operators::input<Node>(Shape({2}, 2), {1, 2, 3, 4});
+  const Node y = operators::pick(x, {0, 1}, 0);
+  const Node z = operators::softmax_cross_entropy(x, {0, 1}, 0);
+  EXPECT_THROW(g.set_data(x, {1, 2}), Error);
+  EXPECT_THROW(g.set_data(y, {1, 2}), Error);
+  EXPECT_THROW(g.set_ids(x, {1, 0}), Error);
+  EXPECT_THROW(g.set_ids(y, {1}), Error);
+  EXPECT_THROW(g.set_ids(z, {1, 0, 1}), Error);
+  EXPECT_NO_THROW(g.set_ids(y, {1, 0}));
+  EXPECT_NO_THROW(g.set_ids(z, {1, 0}));
+}
+
+TEST_F(GraphTest, CheckReplay) {
+  Device::set_default(dev);
+
+  const vector<vector<float>> inputs {
+    {1, 2, 3, 4, 5, 6}, {-1, 0, 1, 0, 2, -2}, {.5, .5, -.5, -.5, 1, 1},
+  };
+  const vector<vector<unsigned>> labels {{0, 1, 2}, {2, 2, 0}, {1, 0, 1}};
+  Parameter w({3, 2}, {1, -1, 2, 0, 1, -2});
+  Parameter b({3}, {.1, .2, .3});
+
+  // Builds the graph only once and replays it with different data.
+  Graph g;
+  Graph::set_default(g);
+  const Node x = operators::input<Node>(Shape({2}, 3), inputs[0]);
+  const Node y = operators::matmul(operators::parameter<Node>(w), x)
+    + operators::parameter<Node>(b);
+  const Node t = operators::softmax_cross_entropy(y, labels[0], 0);
+  const Node p = operators::pick(y, labels[0], 0);
+  const Node loss = operators::batch::sum(t - p);
+  g.freeze();
+
+  for (unsigned i = 0; i < inputs.size(); ++i) {
+    // Expected results.
+    Graph g2;
+    Graph::set_default(g2);
+    const Node x2 = operators::input<Node>(Shape({2}, 3), inputs[i]);
+    const Node y2 = operators::matmul(operators::parameter<Node>(w), x2)
+      + operators::parameter<Node>(b);
+    const Node loss2 = operators::batch::sum(
+        operators::softmax_cross_entropy(y2, labels[i], 0)
+        - operators::pick(y2, labels[i], 0));
+    w.reset_gradient();
+    const float loss_val = loss2.to_float();
+    loss2.backward();
+    const vector<float> w_grad = w.gradient().to_vector();
+
+    // Replays the frozen graph.
+    g.set_data(x, inputs[i]);
+    g.set_ids(t, labels[i]);
+    g.set_ids(p, labels[i]);
+    w.reset_gradient();
+    EXPECT_FLOAT_EQ(loss_val, g.forward(loss).to_float());
+    g.backward(loss);
+    EXPECT_TRUE(vector_match(w_grad, w.gradient().to_vector()));
+  }
+}
+
+TEST_F(GraphTest, CheckPlanMemory) {
+  Device::set_default(dev);
+
+  // x (64 elements) -> h1 -> h2 -> h3 -> h4
+  Graph g;
+  Graph::set_default(g);
+  const Node x = operators::input<Node>({64}, vector<float>(64, .5));
+  const Node h1 = operators::tanh(x);
+  const Node h2 = operators::tanh(h1);
+  const Node h3 = operators::tanh(h2);
+  const Node h4 = operators::tanh(h3);
+  g.freeze();
+
+  const vector<float> y_val = h4.to_vector();
+  g.backward(h4);
+  g.rewind();
+
+  const std::uint64_t arena_size = 7 * 256;
+  g.plan_memory(h4);
+  EXPECT_EQ(arena_size, g.planned_memory_size());
+  EXPECT_EQ(10u * 256u, g.naive_memory_size());
+  EXPECT_EQ(arena_size, dev.memory_pool().in_use_size());
+
+  for (unsigned i = 0; i < 3; ++i) {
+    EXPECT_TRUE(vector_match(y_val, h4.to_vector()));
+    EXPECT_EQ(arena_size, dev.memory_pool().in_use_size());
+    g.backward(h4);
+    EXPECT_EQ(arena_size, dev.memory_pool().in_use_size());
+    g.rewind();
+  }
+}
+
+TEST_F(GraphTest, CheckPlanMemoryReplay) {
+  Device::set_default(dev);
+
+  const vector<vector<float>> inputs {
+    {1, 2, 3, 4, 5, 6}, {-1, 0, 1, 0, 2, -2}, {.5, .5, -.5, -.5, 1, 1},
+  };
+  const vector<vector<unsigned>> labels {{0, 1, 2}, {2, 2, 0}, {1, 0, 1}};
+  Parameter w({3, 2}, {1, -1, 2, 0, 1, -2});
+  Parameter b({3}, {.1, .2, .3});
+
+  Graph g;
+  Graph::set_default(g);
+  const Node x = operators::input<Node>(Shape({2}, 3), inputs[0]);
+  const Node h = operators::tanh(
+      operators::matmul(operators::parameter<Node>(w), x)
+      + operators::parameter<Node>(b));
+  const Node y = operators::reshape(h, Shape({1, 3}, 3));
+  const Node t = operators::softmax_cross_entropy(y, labels[0], 1);
+  const Node loss = operators::batch::sum(t * t);
+  g.freeze();
+  g.plan_memory(loss);
+  EXPECT_LE(g.planned_memory_size(), g.naive_memory_size());
+
+  for (unsigned i = 0; i < inputs.size(); ++i) {
+    // Expected results.
+    Graph g2;
+    Graph::set_default(g2);
+    const Node x2 = operators::input<Node>(Shape({2}, 3), inputs[i]);
+    const Node h2 = operators::tanh(
+        operators::matmul(operators::parameter<Node>(w), x2)
+        + operators::parameter<Node>(b));
+    const Node y2 = operators::reshape(h2, Shape({1, 3}, 3));
+    const Node t2 = operators::softmax_cross_entropy(y2, labels[i], 1);
+    const Node loss2 = operators::batch::sum(t2 * t2);
+    w.reset_gradient();
+    b.reset_gradient();
+    const float loss_val = loss2.to_float();
+    loss2.backward();
+    const vector<float> w_grad = w.gradient().to_vector();
+    const vector<float> b_grad = b.gradient().to_vector();
+
+    // Replays the planned graph.
+    g.set_data(x, inputs[i]);
+    g.set_ids(t, labels[i]);
+    w.reset_gradient();
+    b.reset_gradient();
+    EXPECT_FLOAT_EQ(loss_val, g.forward(loss).to_float());
+    g.backward(loss);
+    EXPECT_TRUE(vector_match(w_grad, w.gradient().to_vector()));
+    EXPECT_TRUE(vector_match(b_grad, b.gradient().to_vector()));
+  }
+}
+
+TEST_F(GraphTest, CheckInvalidPlanMemory) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  const Node x = operators::input<Node>({2}, {1, 2});
+  const Node y = operators::tanh(x);
+  EXPECT_THROW(g.plan_memory(y), Error);
+  EXPECT_THROW(g.planned_memory_size(), Error);
+  EXPECT_THROW(g.naive_memory_size(), Error);
+
+  g.freeze();
+  g.set_num_threads(2);
+  EXPECT_THROW(g.plan_memory(y), Error);
+  g.set_num_threads(1);
+  EXPECT_NO_THROW(g.plan_memory(y));
+  EXPECT_NO_THROW(g.planned_memory_size());
+
+  // The plan is discarded by multiple threads.
+  g.set_num_threads(2);
+  EXPECT_THROW(g.planned_memory_size(), Error);
+  g.set_num_threads(1);
+
+  // The plan is discarded by clear().
+  g.plan_memory(y);
+  g.clear();
+  EXPECT_THROW(g.planned_memory_size(), Error);
+}
+
+TEST_F(GraphTest, CheckTrace) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  EXPECT_FALSE(g.tracing());
+
+  const Node x = operators::input<Node>({2}, {1, 2});
+  const Node y = operators::tanh(x);
+  const Node z = operators::sum(y, 0);
+  g.forward(y);
+  EXPECT_EQ("{\"traceEvents\":[\n],\"displayTimeUnit\":\"ms\"}\n",
+      g.dump_trace());
+
+  g.set_tracing(true);
+  EXPECT_TRUE(g.tracing());
+  g.backward(z);
+  g.set_tracing(false);
+  g.forward(operators::exp(x));
+
+  const std::string trace = g.dump_trace();
+  auto count = [&](const std::string &pattern) {
+    unsigned ret = 0;
+    for (std::size_t pos = trace.find(pattern);
+        pos != std::string::npos; pos = trace.find(pattern, pos + 1)) ++ret;
+    return ret;
+  };
+  // forward: Sum, backward: Sum, Tanh, Input
+  EXPECT_EQ(1u, count("\"ph\":\"M\""));
+  EXPECT_EQ(4u, count("\"ph\":\"X\""));
+  EXPECT_EQ(1u, count("\"cat\":\"forward\""));
+  EXPECT_EQ(3u, count("\"cat\":\"backward\""));
+  EXPECT_EQ(0u, count("\"name\":\"Exp\""));
+  EXPECT_EQ(2u, count(
+        "\"args\":{\"fid\":2,\"args\":\"[2]x1\",\"shape\":\"[]x1\""));
+
+  g.clear_trace();
+  EXPECT_EQ("{\"traceEvents\":[\n],\"displayTimeUnit\":\"ms\"}\n",
+      g.dump_trace());
+}
+
+TEST_F(GraphTest, CheckSaveTrace) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  g.set_tracing(true);
+  operators::tanh(operators::input<Node>({2}, {1, 2})).to_vector();
+
+  const std::string path = "/tmp/primitiv_GraphTest_CheckSaveTrace.json";
+  g.save_trace(path);
+  std::ifstream ifs(path);
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  std::remove(path.c_str());
+  EXPECT_EQ(g.dump_trace(), ss.str());
+
+  EXPECT_THROW(g.save_trace("/not_exist/trace.json"), Error);
+}
+
 TEST_F(GraphTest, CheckXor) {
   Device::set_default(dev);
 
@@ -532,4 +1001,226 @@ TEST_F(GraphTest, CheckConcatLSTM) {
 #endif
 }
 
+TEST_F(GraphTest, CheckSparseGradient) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+
+  Parameter w({2, 3}, {1, 2, 3, 4, 5, 6});
+  const Parameter &cw = w;
+  w.set_sparse_gradient(true);
+  const Node pw = operators::parameter<Node>(w);
+  const Node y1 = operators::pick(pw, {2, 0, 2}, 1);
+  const Node y2 = operators::pick(operators::parameter<Node>(w), {1}, 1);
+  const Node z = operators::batch::sum(y1) + 2 * y2;
+  const Node loss = operators::sum(z, 0);
+  loss.backward();
+  EXPECT_TRUE(cw.has_sparse_gradient());
+  EXPECT_EQ(vector<unsigned>({0, 1, 2}), cw.sparse_ids());
+  EXPECT_TRUE(vector_match(
+        vector<float> {1, 1, 2, 2, 2, 2}, cw.gradient().to_vector()));
+
+  // Other functions require the dense gradient.
+  w.reset_gradient();
+  const Node loss2 = operators::sum(
+      operators::sum(pw, 1) + operators::batch::sum(y1), 0);
+  loss2.backward();
+  EXPECT_FALSE(cw.has_sparse_gradient());
+  EXPECT_TRUE(vector_match(
+        vector<float> {2, 2, 1, 1, 3, 3}, cw.gradient().to_vector()));
+}
+
+TEST_F(GraphTest, CheckParallelSparseGradient) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  g.set_num_threads(2);
+
+  Parameter w({2, 3}, {1, 2, 3, 4, 5, 6});
+  const Parameter &cw = w;
+  w.set_sparse_gradient(true);
+  w.reset_gradient();
+  const Node y = operators::pick(operators::parameter<Node>(w), {0, 2}, 1);
+  const Node loss = operators::sum(operators::batch::sum(y), 0);
+  loss.backward();
+  EXPECT_TRUE(cw.has_sparse_gradient());
+  EXPECT_EQ(vector<unsigned>({0, 2}), cw.sparse_ids());
+  EXPECT_TRUE(vector_match(
+        vector<float> {1, 1, 0, 0, 1, 1}, cw.gradient().to_vector()));
+}
+
+TEST_F(GraphTest, CheckSampledSoftmaxCrossEntropy) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+
+  Parameter w({5, 2}, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+  Parameter b({5}, {1, 2, 3, 4, 5});
+  const Parameter &cw = w, &cb = b;
+  w.reset_gradient();
+  b.reset_gradient();
+  const Node x = operators::input<Node>(Shape({2}, 2), {1, -1, -1, 1});
+  const Node loss = operators::sampled_softmax_cross_entropy(
+      x, operators::parameter<Node>(w), operators::parameter<Node>(b),
+      {1, 3}, {0, 1, 0, 1, 0}, 100);
+  operators::batch::sum(loss).backward();
+  const vector<float> gw = cw.gradient().to_vector();
+  const vector<float> gb = cb.gradient().to_vector();
+  for (const unsigned i : {0u, 2u, 4u}) {
+    EXPECT_EQ(0, gw[i]);
+    EXPECT_EQ(0, gw[i + 5]);
+    EXPECT_EQ(0, gb[i]);
+  }
+  EXPECT_NE(0, gb[1]);
+  EXPECT_NE(0, gb[3]);
+  EXPECT_NEAR(0, gb[1] + gb[3], 1e-6);
+}
+
+TEST_F(GraphTest, CheckLSTMCell) {
+  namespace F = operators;
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+
+  Parameter px({3}, {.5, -1, .2});
+  Parameter ph({2}, {.3, -.6});
+  Parameter pc({2}, {1, -2});
+  Parameter pwx({8, 3}, initializers::Uniform(-1, 1));
+  Parameter pwh({8, 2}, initializers::Uniform(-1, 1));
+  Parameter pb({8}, initializers::Uniform(-1, 1));
+  const vector<Parameter *> params {&px, &ph, &pc, &pwx, &pwh, &pb};
+
+  vector<vector<float>> grads[2];
+  for (unsigned fused = 0; fused < 2; ++fused) {
+    g.clear();
+    for (Parameter *p : params) p->reset_gradient();
+    const Node x = F::parameter<Node>(px);
+    const Node h = F::parameter<Node>(ph);
+    const Node c = F::parameter<Node>(pc);
+    const Node wx = F::parameter<Node>(pwx);
+    const Node wh = F::parameter<Node>(pwh);
+    const Node b = F::parameter<Node>(pb);
+    Node h2, c2;
+    if (fused) {
+      std::tie(h2, c2) = F::lstm_cell(x, h, c, wx, wh, b);
+    } else {
+      const Node u = F::matmul(wx, x) + F::matmul(wh, h) + b;
+      const Node i = F::sigmoid(F::slice(u, 0, 0, 2));
+      const Node f = F::sigmoid(F::slice(u, 0, 2, 4));
+      const Node o = F::sigmoid(F::slice(u, 0, 4, 6));
+      const Node j = F::tanh(F::slice(u, 0, 6, 8));
+      c2 = i * j + f * c;
+      h2 = o * F::tanh(c2);
+    }
+    const Node w = F::input<Node>({2}, {2, -1});
+    const Node loss = F::sum(h2 * w, 0) + F::sum(c2 * c2, 0);
+    loss.backward();
+    for (Parameter *p : params) {
+      grads[fused].emplace_back(p->gradient().to_vector());
+    }
+  }
+  for (unsigned i = 0; i < params.size(); ++i) {
+    EXPECT_TRUE(vector_near(grads[0][i], grads[1][i], 1e-5)) << "i=" << i;
+  }
+}
+
+TEST_F(GraphTest, CheckSplit) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+
+  Parameter px({2, 3}, {1, 2, 3, 4, 5, 6});
+  const Node x = operators::parameter<Node>(px);
+  const vector<Node> ys = operators::split(x, 1, 3);
+  ASSERT_EQ(3u, ys.size());
+  // All pieces are calculated by one function.
+  EXPECT_EQ(2u, g.num_functions());
+
+  const vector<vector<float>> y_vals {{1, 2}, {3, 4}, {5, 6}};
+  for (unsigned i = 0; i < 3; ++i) {
+    EXPECT_EQ(Shape({2}), ys[i].shape());
+    EXPECT_TRUE(vector_match(y_vals[i], ys[i].to_vector()));
+  }
+
+  // Unused pieces have zero gradients.
+  px.reset_gradient();
+  const Node loss = operators::sum(ys[1] * ys[1], 0);
+  loss.backward();
+  EXPECT_TRUE(vector_match(
+        vector<float> {0, 0, 6, 8, 0, 0}, px.gradient().to_vector()));
+
+  // Gradients of all used pieces are accumulated.
+  px.reset_gradient();
+  const Node loss2 = operators::sum(ys[0] + 2 * ys[2] - ys[0] * ys[1], 0);
+  loss2.backward();
+  EXPECT_TRUE(vector_match(
+        vector<float> {-2, -3, -1, -2, 2, 2}, px.gradient().to_vector()));
+}
+
+TEST_F(GraphTest, CheckSplitWithoutRetain) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+
+  const Node x = operators::input<Node>({4}, {1, 2, 3, 4});
+  const vector<Node> ys = operators::split(x * 2, 0, 2);
+  const Node y = ys[0] * ys[1];
+  EXPECT_TRUE(vector_match(
+        vector<float> {12, 32}, g.forward(y, false).to_vector()));
+  // All pieces were discarded together.
+  EXPECT_EQ(CPUMemoryPool::ALIGNMENT, dev.memory_pool().in_use_size());
+}
+
+TEST_F(GraphTest, CheckParallelSplit) {
+  Device::set_default(dev);
+
+  Parameter px({4, 2}, {1, 2, 3, 4, 5, 6, 7, 8});
+  vector<vector<float>> grads;
+  for (unsigned num_threads : {1u, 4u}) {
+    Graph g;
+    Graph::set_default(g);
+    g.set_num_threads(num_threads);
+    px.reset_gradient();
+
+    const vector<Node> ys = operators::split(
+        operators::parameter<Node>(px), 0, 4);
+    Node loss = operators::sum(ys[0] * ys[3], 1);
+    for (unsigned i = 1; i < 3; ++i) loss = loss + operators::sum(ys[i], 1);
+    EXPECT_TRUE(vector_match(vector<float> {62}, loss.to_vector()));
+    loss.backward();
+    grads.emplace_back(px.gradient().to_vector());
+  }
+  const vector<float> expected {4, 1, 1, 1, 8, 1, 1, 5};
+  for (const vector<float> &grad : grads) {
+    EXPECT_TRUE(vector_match(expected, grad));
+  }
+}
+
+TEST_F(GraphTest, CheckPlanMemorySplit) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+
+  Parameter px({4}, {1, 2, 3, 4});
+  const vector<Node> ys = operators::split(
+      operators::tanh(operators::parameter<Node>(px)), 0, 2);
+  const Node y = operators::sum(ys[0] * ys[1], 0);
+  g.freeze();
+
+  const vector<float> y_val = y.to_vector();
+  px.reset_gradient();
+  g.backward(y);
+  const vector<float> grad = px.gradient().to_vector();
+  g.rewind();
+
+  g.plan_memory(y);
+  for (unsigned i = 0; i < 3; ++i) {
+    px.reset_gradient();
+    EXPECT_TRUE(vector_match(y_val, y.to_vector()));
+    g.backward(y);
+    EXPECT_TRUE(vector_match(grad, px.gradient().to_vector()));
+    g.rewind();
+  }
+}
+
 }  // namespace primitiv
@@ -5,6 +5,7 @@
 #include <thread>
 #include <vector>
 #include <gtest/gtest.h>
+#include <primitiv/error.h>
 #include <primitiv/naive_device.h>
 #include <primitiv/shape.h>
 #include <primitiv/tensor.h>
@@ -22,6 +23,112 @@ TEST_F(NaiveDeviceTest, CheckDeviceType) {
   EXPECT_EQ(Device::DEVICE_TYPE_CPU, dev.type());
 }
 
+TEST_F(NaiveDeviceTest, CheckNumThreads) {
+  devices::Naive dev1;
+  devices::Naive dev2(12345);
+  devices::Naive dev3(12345, 4);
+  EXPECT_EQ(1u, dev1.num_threads());
+  EXPECT_EQ(1u, dev2.num_threads());
+  EXPECT_EQ(4u, dev3.num_threads());
+  EXPECT_THROW(devices::Naive(12345, 0), Error);
+}
+
+TEST_F(NaiveDeviceTest, CheckMultiThreadedOperations) {
+  devices::Naive dev1(12345);
+  devices::Naive dev4(12345, 4);
+  const Shape sa({64, 96}, 3);
+  const Shape sb({96, 200}, 3);
+  const vector<float> a_data = dev1.random_uniform(sa, -1, 1).to_vector();
+  const vector<float> b_data = dev1.random_uniform(sb, -1, 1).to_vector();
+  const vector<float> c_data = dev1.random_uniform(sb, -1, 1).to_vector();
+  const vector<unsigned> ids {3, 0, 95};
+
+  vector<vector<float>> results[2];
+  devices::Naive *devs[] {&dev1, &dev4};
+  for (unsigned i = 0; i < 2; ++i) {
+    Device &dev = *devs[i];
+    vector<vector<float>> &r = results[i];
+    const Tensor a = dev.new_tensor_by_vector(sa, a_data);
+    const Tensor b = dev.new_tensor_by_vector(sb, b_data);
+    const Tensor c = dev.new_tensor_by_vector(sb, c_data);
+    const Tensor w = dev.new_tensor_by_vector(
+        Shape({96, 200}),
+        vector<float>(b_data.begin(), b_data.begin() + 96 * 200));
+    const Tensor y = dev.matmul_fw(a, b);
+    r.emplace_back(y.to_vector());
+    r.emplace_back(dev.matmul_fw(a, w).to_vector());
+    r.emplace_back(dev.exp_fw(b).to_vector());
+    r.emplace_back(dev.multiply_const_fw(b, 3).to_vector());
+    r.emplace_back(dev.add_fw(b, c).to_vector());
+    r.emplace_back(dev.add_fw(b, w).to_vector());
+    r.emplace_back(
+        dev.multiply_scalar_fw(
+          b, dev.new_tensor_by_constant(Shape({}, 3), 2)).to_vector());
+    r.emplace_back(dev.transpose_fw(b).to_vector());
+    r.emplace_back(dev.sum_fw(b, 0).to_vector());
+    r.emplace_back(dev.sum_fw(b, 1).to_vector());
+    r.emplace_back(dev.logsumexp_fw(b, 1).to_vector());
+    r.emplace_back(dev.softmax_fw(b, 0).to_vector());
+    r.emplace_back(dev.softmax_fw(b, 1).to_vector());
+    r.emplace_back(dev.log_softmax_fw(b, 1).to_vector());
+    r.emplace_back(dev.broadcast_fw(dev.sum_fw(b, 1), 1, 200).to_vector());
+    r.emplace_back(dev.batch_sum_fw(b).to_vector());
+    r.emplace_back(dev.slice_fw(b, 1, 10, 150).to_vector());
+    r.emplace_back(dev.concat_fw({&b, &c, &w}, 1).to_vector());
+    r.emplace_back(dev.pick_fw(b, ids, 0).to_vector());
+
+    Tensor ga = dev.new_tensor_by_constant(sa, 1);
+    Tensor gb = dev.new_tensor_by_constant(Shape({96, 200}), 1);
+    dev.matmul_bw(a, w, y, dev.new_tensor_by_constant(y.shape(), 1), ga, gb);
+    r.emplace_back(ga.to_vector());
+    r.emplace_back(gb.to_vector());
+
+    // Batched matrix-vector products.
+    const Tensor v = dev.slice_fw(b, 1, 0, 1);
+    const Tensor av = dev.matmul_fw(a, v);
+    r.emplace_back(av.to_vector());
+    Tensor gav = dev.new_tensor_by_constant(sa, 1);
+    Tensor gv = dev.new_tensor_by_constant(v.shape(), 1);
+    dev.matmul_bw(a, v, av, av, gav, gv);
+    r.emplace_back(gav.to_vector());
+    r.emplace_back(gv.to_vector());
+
+    Tensor gw = dev.new_tensor_by_constant(Shape({96, 200}), 1);
+    Tensor gc = dev.new_tensor_by_constant(sb, 1);
+    dev.multiply_bw(w, b, c, c, gw, gc);
+    r.emplace_back(gw.to_vector());
+    r.emplace_back(gc.to_vector());
+
+    Tensor gs = dev.new_tensor_by_constant(Shape({96, 200}), 0);
+    dev.slice_bw(dev.slice_fw(b, 1, 10, 150), 1, 10, gs);
+    dev.inplace_add(c, gs);
+    dev.inplace_multiply_const(.5, gs);
+    r.emplace_back(gs.to_vector());
+
+    const Tensor sm = dev.softmax_fw(b, 1);
+    Tensor gsm = dev.new_tensor_by_constant(sb, 0);
+    dev.softmax_bw(b, sm, c, 1, gsm);
+    r.emplace_back(gsm.to_vector());
+
+    const Tensor u = dev.concat_fw({&b, &c, &c, &b}, 0);
+    Tensor gates;
+    const Tensor lstm = dev.lstm_cell_fw(u, w, gates);
+    r.emplace_back(gates.to_vector());
+    r.emplace_back(lstm.to_vector());
+    Tensor gu = dev.new_tensor_by_constant(u.shape(), 0);
+    Tensor glc = dev.new_tensor_by_constant(w.shape(), 0);
+    dev.lstm_cell_bw(
+        w, gates, lstm, dev.concat_fw({&c, &b}, 0), gu, glc);
+    r.emplace_back(gu.to_vector());
+    r.emplace_back(glc.to_vector());
+  }
+
+  ASSERT_EQ(results[0].size(), results[1].size());
+  for (unsigned i = 0; i < results[0].size(); ++i) {
+    EXPECT_TRUE(vector_match(results[0][i], results[1][i])) << "i=" << i;
+  }
+}
+
 TEST_F(NaiveDeviceTest, CheckNewDelete) {
   {
     devices::Naive dev;
@@ -364,4 +364,52 @@ TEST_F(ParameterTest, CheckInvalidSave) {
   EXPECT_THROW(invalid.save("/tmp/not_generated"), Error);
 }
 
+TEST_F(ParameterTest, CheckSparseGradient) {
+  Parameter p({2, 3}, {1, 2, 3, 4, 5, 6}, dev);
+  const Parameter &cp = p;
+  EXPECT_FALSE(cp.sparse_gradient());
+  EXPECT_FALSE(cp.has_sparse_gradient());
+  EXPECT_THROW(
+      p.add_sparse_gradient({0}, dev.new_tensor_by_constant({2}, 1)), Error);
+
+  p.set_sparse_gradient(true);
+  EXPECT_TRUE(cp.sparse_gradient());
+  EXPECT_TRUE(cp.has_sparse_gradient());
+  EXPECT_EQ(1u, cp.sparse_dim());
+  EXPECT_TRUE(cp.sparse_ids().empty());
+
+  p.add_sparse_gradient(
+      {2, 0}, dev.new_tensor_by_vector(Shape({2}, 2), {1, 2, 3, 4}));
+  p.add_sparse_gradient({2}, dev.new_tensor_by_constant({2}, 1));
+  EXPECT_TRUE(cp.has_sparse_gradient());
+  EXPECT_EQ(vector<unsigned>({0, 2}), cp.sparse_ids());
+  EXPECT_TRUE(vector_match(
+        vector<float> {3, 4, 0, 0, 2, 3}, cp.gradient().to_vector()));
+  // Const accesses keep the sparse gradient.
+  EXPECT_TRUE(cp.has_sparse_gradient());
+  EXPECT_EQ(vector<unsigned>({0, 2}), cp.sparse_ids());
+  EXPECT_THROW(
+      p.add_sparse_gradient({3}, dev.new_tensor_by_constant({2}, 1)), Error);
+
+  p.reset_gradient();
+  EXPECT_TRUE(cp.has_sparse_gradient());
+  EXPECT_TRUE(cp.sparse_ids().empty());
+  EXPECT_TRUE(vector_match(vector<float>(6, 0), cp.gradient().to_vector()));
+
+  // Mutable accesses make the gradient dense.
+  p.add_sparse_gradient({1}, dev.new_tensor_by_constant({2}, 1));
+  p.gradient() += dev.new_tensor_by_constant({2, 3}, 1);
+  EXPECT_TRUE(cp.sparse_gradient());
+  EXPECT_FALSE(cp.has_sparse_gradient());
+  EXPECT_TRUE(vector_match(
+        vector<float> {1, 1, 2, 2, 1, 1}, cp.gradient().to_vector()));
+  p.reset_gradient();
+  EXPECT_TRUE(cp.has_sparse_gradient());
+  EXPECT_TRUE(vector_match(vector<float>(6, 0), cp.gradient().to_vector()));
+
+  p.set_sparse_gradient(false);
+  EXPECT_FALSE(cp.sparse_gradient());
+  EXPECT_FALSE(cp.has_sparse_gradient());
+}
+
 }  // namespace primitiv
@@ -332,5 +332,23 @@ TEST_F(ShapeOpsTest, CheckInvalidMatMul) {
   EXPECT_THROW(matmul(Shape({}, 2), Shape({}, 3)), Error);
 }
 
+TEST_F(ShapeOpsTest, CheckLSTMCell) {
+  EXPECT_EQ(Shape({2}), lstm_cell({4}, {}));
+  EXPECT_EQ(Shape({6}), lstm_cell({12}, {3}));
+  EXPECT_EQ(Shape({6}, 5), lstm_cell(Shape({12}, 5), {3}));
+  EXPECT_EQ(Shape({6}, 5), lstm_cell({12}, Shape({3}, 5)));
+  EXPECT_EQ(Shape({6}, 5), lstm_cell(Shape({12}, 5), Shape({3}, 5)));
+  EXPECT_EQ(Shape({6, 7}), lstm_cell({12, 7}, {3, 7}));
+  EXPECT_EQ(Shape({6, 7}, 5), lstm_cell(Shape({12, 7}, 5), {3, 7}));
+}
+
+TEST_F(ShapeOpsTest, CheckInvalidLSTMCell) {
+  EXPECT_THROW(lstm_cell({3}, {}), Error);
+  EXPECT_THROW(lstm_cell({12}, {4}), Error);
+  EXPECT_THROW(lstm_cell({12, 2}, {3}), Error);
+  EXPECT_THROW(lstm_cell({12, 1, 2}, {3, 1, 2}), Error);
+  EXPECT_THROW(lstm_cell(Shape({12}, 2), Shape({3}, 3)), Error);
+}
+
 }  // namespace shape_ops
 }  // namespace primitiv
@@ -11,6 +11,10 @@
 #include <primitiv/cuda_device.h>
 #endif  // PRIMITIV_USE_CUDA
 
+#ifdef PRIMITIV_USE_EIGEN
+#include <primitiv/eigen_device.h>
+#endif  // PRIMITIV_USE_EIGEN
+
 using std::vector;
 using test_utils::vector_match;
 using test_utils::vector_near;
@@ -31,6 +35,10 @@ protected:
       devices.emplace_back(new devices::CUDA(1));
     }
 #endif  // PRIMITIV_USE_CUDA
+#ifdef PRIMITIV_USE_EIGEN
+    devices.emplace_back(new devices::Eigen());
+    devices.emplace_back(new devices::Eigen()); // other device on the same hardware
+#endif  // PRIMITIV_USE_EIGEN
   }
 
   void TearDown() override {
@@ -403,6 +411,117 @@ TEST_F(TensorBackwardTest, CheckExp) {
   }
 }
 
+TEST_F(TensorBackwardTest, CheckSoftmax) {
+  const vector<vector<float>> gx_data {
+    {-.19661193, .19661193, -.78644773, .78644773,
+      .39322387, -.39322387, .58983580, -.58983580},
+    {.20998717, -.10499359, -.20998717, .10499359,
+      .10499359, .20998717, -.10499359, -.20998717},
+  };
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector(
+        Shape({2, 2}, 2), {0, 1, 2, 3, 0, -1, -2, -3});
+    const Tensor gy = dev->new_tensor_by_vector(
+        x.shape(), {1, 2, -1, 3, 2, 0, 1, -2});
+    for (unsigned dim = 0; dim < 2; ++dim) {
+      const Tensor y = dev->softmax_fw(x, dim);
+      Tensor gx = dev->new_tensor_by_constant(x.shape(), 0);
+      dev->softmax_bw(x, y, gy, dim, gx);
+      EXPECT_TRUE(vector_near(gx_data[dim], gx.to_vector(), 1e-6));
+    }
+  }
+}
+
+TEST_F(TensorBackwardTest, CheckLogSoftmax) {
+  const vector<vector<float>> gx_data {
+    {.19317574, -.19317574, -1.5378828, 1.5378828,
+      .53788284, -.53788284, 1.7310586, -1.7310586},
+    {1, 1.4039854, -1, -1.4039854,
+      -.64239123, 1.7615942, .64239123, -1.7615942},
+  };
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector(
+        Shape({2, 2}, 2), {0, 1, 2, 3, 0, -1, -2, -3});
+    const Tensor gy = dev->new_tensor_by_vector(
+        x.shape(), {1, 2, -1, 3, 2, 0, 1, -2});
+    for (unsigned dim = 0; dim < 2; ++dim) {
+      const Tensor y = dev->log_softmax_fw(x, dim);
+      Tensor gx = dev->new_tensor_by_constant(x.shape(), 0);
+      dev->log_softmax_bw(x, y, gy, dim, gx);
+      EXPECT_TRUE(vector_near(gx_data[dim], gx.to_vector(), 1e-6));
+    }
+  }
+}
+
+TEST_F(TensorBackwardTest, CheckInvalidSoftmax) {
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_constant({2, 2}, 0);
+    const Tensor y = dev->softmax_fw(x, 0);
+    const Tensor gy = dev->new_tensor_by_constant({2, 3}, 0);
+    Tensor gx = dev->new_tensor_by_constant({2, 2}, 0);
+    EXPECT_THROW(dev->softmax_bw(x, y, gy, 0, gx), Error);
+    EXPECT_THROW(dev->log_softmax_bw(x, y, gy, 0, gx), Error);
+  }
+}
+
+TEST_F(TensorBackwardTest, CheckSparseSoftmaxCrossEntropy) {
+  struct TestCase {
+    Shape x_shape;
+    unsigned dim;
+    vector<unsigned> ids;
+  };
+  const vector<TestCase> test_cases {
+    {Shape({3, 2}, 2), 0, {2, 0}},
+    {Shape({3, 2}, 2), 1, {1}},
+    {Shape({3, 2}), 0, {0, 2, 1}},
+    {Shape({2, 3, 2}), 1, {2, 1}},
+    {Shape({3, 2}, 2), 2, {0}},
+  };
+  for (Device *dev : devices) {
+    for (const TestCase &tc : test_cases) {
+      const unsigned n = tc.x_shape[tc.dim];
+      vector<float> x_data(tc.x_shape.size());
+      for (unsigned i = 0; i < x_data.size(); ++i) x_data[i] = .5 * i - 2;
+      const Tensor x = dev->new_tensor_by_vector(tc.x_shape, x_data);
+      Tensor lse;
+      const Tensor y = dev->sparse_softmax_cross_entropy_fw(
+          x, tc.ids, tc.dim, lse);
+      vector<float> gy_data(y.shape().size());
+      for (unsigned i = 0; i < gy_data.size(); ++i) gy_data[i] = i + 1;
+      const Tensor gy = dev->new_tensor_by_vector(y.shape(), gy_data);
+      Tensor gx = dev->new_tensor_by_constant(tc.x_shape, 1);
+      dev->sparse_softmax_cross_entropy_bw(x, lse, tc.ids, gy, tc.dim, gx);
+
+      const Tensor ly = dev->pick_fw(
+          dev->negate_fw(dev->log_softmax_fw(x, tc.dim)), tc.ids, tc.dim);
+      Tensor ref = dev->multiply_fw(
+          dev->softmax_fw(x, tc.dim), dev->broadcast_fw(gy, tc.dim, n));
+      if (!tc.x_shape.has_batch()) ref = dev->batch_sum_fw(ref);
+      dev->inplace_add(dev->new_tensor_by_constant(tc.x_shape, 1), ref);
+      dev->pick_bw(dev->negate_fw(gy), tc.ids, tc.dim, ref);
+      EXPECT_TRUE(vector_near(ly.to_vector(), y.to_vector(), 1e-5));
+      EXPECT_TRUE(vector_near(ref.to_vector(), gx.to_vector(), 1e-5));
+    }
+  }
+}
+
+TEST_F(TensorBackwardTest, CheckInvalidSparseSoftmaxCrossEntropy) {
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_constant(Shape({3, 2}, 2), 0);
+    Tensor lse;
+    EXPECT_THROW(
+        dev->sparse_softmax_cross_entropy_fw(x, {3, 0}, 0, lse), Error);
+    EXPECT_THROW(
+        dev->sparse_softmax_cross_entropy_fw(x, {0, 1, 2}, 0, lse), Error);
+    const Tensor y = dev->sparse_softmax_cross_entropy_fw(x, {1, 0}, 0, lse);
+    Tensor gx = dev->new_tensor_by_constant(Shape({3, 2}, 2), 0);
+    EXPECT_THROW(
+        dev->sparse_softmax_cross_entropy_bw(x, lse, {1, 0}, y, 1, gx), Error);
+    EXPECT_THROW(
+        dev->sparse_softmax_cross_entropy_bw(x, lse, {1, 0}, x, 0, gx), Error);
+  }
+}
+
 TEST_F(TensorBackwardTest, CheckLog) {
   for (Device *dev : devices) {
     const Tensor x = dev->new_tensor_by_vector(
@@ -1018,4 +1137,44 @@ TEST_F(TensorBackwardTest, CheckMatMulN1) {
   }
 }
 
+TEST_F(TensorBackwardTest, CheckMatMulRectangular) {
+  struct TestCase {
+    Shape a_shape, b_shape, y_shape;
+    vector<float> a_data, b_data, gy_data, ga_val, gb_val;
+  };
+  const vector<TestCase> test_cases {
+    {{2, 3}, {3, 2}, {2, 2},
+      {1, 2, 3, 4, 5, 6}, {1, -1, 2, -2, 0, 1}, {1, 2, -1, -2},
+      {3, 6, -1, -2, 1, 2}, {5, 11, 17, -5, -11, -17}},
+    {Shape({2, 3}, 2), {3, 2}, Shape({2, 2}, 2),
+      {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}, {1, -1, 2, -2, 0, 1},
+      {1, 2, -1, -2, 1, 0, 0, 1},
+      {3, 6, -1, -2, 1, 2, 1, -2, -1, 0, 2, 1}, {12, 20, 28, 3, -1, -5}},
+    {{2, 3}, Shape({3, 2}, 2), Shape({2, 2}, 2),
+      {1, 2, 3, 4, 5, 6}, {1, -1, 2, -2, 0, 1, 3, -3, 1, 1, 2, -1},
+      {1, 2, -1, -2, 1, 0, 0, 1},
+      {6, 7, -4, 0, 2, 1}, {5, 11, 17, -5, -11, -17, 1, 3, 5, 2, 4, 6}},
+    {Shape({2, 3}, 2), Shape({3, 2}, 2), Shape({2, 2}, 2),
+      {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12},
+      {1, -1, 2, -2, 0, 1, 3, -3, 1, 1, 2, -1},
+      {1, 2, -1, -2, 1, 0, 0, 1},
+      {3, 6, -1, -2, 1, 2, 3, 1, -3, 2, 1, -1},
+      {5, 11, 17, -5, -11, -17, 7, 9, 11, 8, 10, 12}},
+  };
+  for (Device *dev : devices) {
+    for (const TestCase &tc : test_cases) {
+      const Tensor a = dev->new_tensor_by_vector(tc.a_shape, tc.a_data);
+      const Tensor b = dev->new_tensor_by_vector(tc.b_shape, tc.b_data);
+      const Tensor y = dev->matmul_fw(a, b);
+      EXPECT_EQ(tc.y_shape, y.shape());
+      const Tensor gy = dev->new_tensor_by_vector(tc.y_shape, tc.gy_data);
+      Tensor ga = dev->new_tensor_by_constant(a.shape(), 0);
+      Tensor gb = dev->new_tensor_by_constant(b.shape(), 0);
+      dev->matmul_bw(a, b, y, gy, ga, gb);
+      EXPECT_TRUE(vector_match(tc.ga_val, ga.to_vector()));
+      EXPECT_TRUE(vector_match(tc.gb_val, gb.to_vector()));
+    }
+  }
+}
+
 }  // namespace primitiv
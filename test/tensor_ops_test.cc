@@ -16,6 +16,10 @@
 #include <primitiv/cuda_device.h>
 #endif  // PRIMITIV_USE_CUDA
 
+#ifdef PRIMITIV_USE_EIGEN
+#include <primitiv/eigen_device.h>
+#endif  // PRIMITIV_USE_EIGEN
+
 using std::vector;
 using test_utils::vector_match;
 using test_utils::vector_near;
@@ -37,6 +41,10 @@ protected:
       devices.emplace_back(new devices::CUDA(1));
     }
 #endif  // PRIMITIV_USE_CUDA
+#ifdef PRIMITIV_USE_EIGEN
+    devices.emplace_back(new devices::Eigen());
+    devices.emplace_back(new devices::Eigen()); // other device on the same hardware
+#endif  // PRIMITIV_USE_EIGEN
   }
 
   void TearDown() override {
@@ -190,6 +198,26 @@ TEST_F(TensorOpsTest, CheckInvalidPick) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckPickView) {
+  const vector<float> x_data {1, 2, 3, 4, 5, 6};
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector({2, 3}, x_data);
+    const float *base = static_cast<const float *>(x.data());
+
+    // Picking one column shares the memory.
+    const Tensor y = pick(x, {2}, 1);
+    EXPECT_EQ(Shape({2}), y.shape());
+    EXPECT_EQ(base + 4, y.data());
+    EXPECT_TRUE(vector_match(vector<float> {5, 6}, y.to_vector()));
+
+    // Other cases make new tensors.
+    const Tensor y2 = pick(x, {0}, 0);
+    const Tensor y3 = pick(x, {0, 1}, 1);
+    EXPECT_NE(base, y2.data());
+    EXPECT_NE(base, y3.data());
+  }
+}
+
 TEST_F(TensorOpsTest, CheckSlice) {
   vector<float> x_data(3 * 3 * 2 * 4);
   std::iota(x_data.begin(), x_data.end(), 0);
@@ -257,6 +285,48 @@ TEST_F(TensorOpsTest, CheckSlice) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckSliceView) {
+  const vector<float> x_data {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector({2, 3, 2}, x_data);
+    const float *base = static_cast<const float *>(x.data());
+
+    // Slicing along the last dimension shares the memory.
+    Tensor y = slice(x, 2, 1, 2);
+    EXPECT_EQ(Shape({2, 3}), y.shape());
+    EXPECT_EQ(base + 6, static_cast<const Tensor &>(y).data());
+    EXPECT_TRUE(vector_match(
+          vector<float> {7, 8, 9, 10, 11, 12}, y.to_vector()));
+    const Tensor z = slice(y, 1, 1, 3);
+    EXPECT_EQ(base + 8, z.data());
+
+    // Slicing along lower dimensions makes a new tensor.
+    const Tensor w = slice(x, 1, 0, 1);
+    EXPECT_NE(base, w.data());
+
+    // Modifying the view does not affect the original tensor.
+    y *= 2;
+    EXPECT_NE(base + 6, static_cast<const Tensor &>(y).data());
+    EXPECT_TRUE(vector_match(
+          vector<float> {14, 16, 18, 20, 22, 24}, y.to_vector()));
+    EXPECT_TRUE(vector_match(x_data, x.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {9, 10, 11, 12}, z.to_vector()));
+  }
+}
+
+TEST_F(TensorOpsTest, CheckSliceViewMinibatch) {
+  const vector<float> x_data {1, 2, 3, 4, 5, 6, 7, 8};
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector(Shape({2, 2}, 2), x_data);
+    const void *base = x.data();
+    // Only the whole range of each sample is contiguous.
+    const Tensor y1 = slice(x, 1, 0, 2);
+    const Tensor y2 = slice(x, 1, 0, 1);
+    EXPECT_EQ(base, y1.data());
+    EXPECT_NE(base, y2.data());
+  }
+}
+
 TEST_F(TensorOpsTest, CheckInvalidSlice) {
   struct TestCase { unsigned dim, lower, upper; };
   const vector<TestCase> test_cases {
@@ -400,6 +470,32 @@ TEST_F(TensorOpsTest, CheckConcatBatchBroadcast) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckSplit) {
+  const vector<float> x_data {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector(Shape({2, 3}, 2), x_data);
+    const vector<Tensor> ys = split(x, 1, 3);
+    ASSERT_EQ(3u, ys.size());
+    for (unsigned i = 0; i < 3; ++i) {
+      EXPECT_EQ(Shape({2}, 2), ys[i].shape());
+      EXPECT_TRUE(vector_match(
+            slice(x, 1, i, i + 1).to_vector(), ys[i].to_vector()));
+    }
+    const vector<Tensor> zs = split(x, 0, 1);
+    ASSERT_EQ(1u, zs.size());
+    EXPECT_TRUE(vector_match(x_data, zs[0].to_vector()));
+  }
+}
+
+TEST_F(TensorOpsTest, CheckInvalidSplit) {
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_constant(Shape({2, 3}, 2), 0);
+    EXPECT_THROW(split(x, 0, 0), Error);
+    EXPECT_THROW(split(x, 1, 2), Error);
+    EXPECT_THROW(split(x, 2, 2), Error);
+  }
+}
+
 TEST_F(TensorOpsTest, CheckInvalidConcat) {
   for (Device *dev : devices) {
     const Tensor a = dev->new_tensor_by_constant(Shape({1, 42}, 2), 0);
@@ -507,6 +603,167 @@ TEST_F(TensorOpsTest, CheckNegate) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckReuseTemporaries) {
+  devices::Naive dev;
+  const CPUMemoryPool &pool = dev.memory_pool();
+  // Each tensor occupies the smallest memory block.
+  const std::uint64_t value_size = CPUMemoryPool::ALIGNMENT;
+  const vector<float> x_data {1, 2, 3, 4};
+  const Tensor x = dev.new_tensor_by_vector({4}, x_data);
+  const Tensor y = dev.new_tensor_by_vector({4}, {.5, .5, -.5, -.5});
+  EXPECT_EQ(2 * value_size, pool.peak_size());
+
+  // All intermediate results are calculated in the same memory.
+  const Tensor z = exp(-(2 * x + 1) * y / 4 - y);
+  EXPECT_EQ(3 * value_size, pool.peak_size());
+  EXPECT_TRUE(vector_near(
+        vector<float> {.41686202, .32465247, 3.9550767, 5.0784190},
+        z.to_vector(), 1e-6));
+
+  // Temporaries which share the memory with other tensors are not modified.
+  Tensor w = x;
+  const Tensor w2 = std::move(w) * 2;
+  const Tensor w3 = slice(x, 0, 0, 2) + 1;
+  EXPECT_TRUE(vector_match(vector<float> {2, 4, 6, 8}, w2.to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {2, 3}, w3.to_vector()));
+  EXPECT_TRUE(vector_match(x_data, x.to_vector()));
+
+  // Moved temporaries do not alias the results which reuse their memory.
+  Tensor v = dev.new_tensor_by_vector({4}, x_data);
+  Tensor v2 = std::move(v) * 2;
+  v2 *= 3;
+  EXPECT_TRUE(vector_match(vector<float> {6, 12, 18, 24}, v2.to_vector()));
+  EXPECT_FALSE(v.valid());
+}
+
+TEST_F(TensorOpsTest, CheckIntoOperations) {
+  devices::Naive dev;
+  const CPUMemoryPool &pool = dev.memory_pool();
+  const Tensor a = dev.new_tensor_by_vector({2, 2}, {1, 2, 3, 4});
+  const Tensor b = dev.new_tensor_by_vector({2, 2}, {-1, 0, .5, 2});
+  const Tensor k = dev.new_tensor_by_vector({}, {3});
+  Tensor y = dev.new_tensor_by_constant({2, 2}, 0);
+  Tensor y2 = dev.new_tensor_by_constant({2, 2}, 0);
+  const std::uint64_t in_use = pool.in_use_size();
+
+  // Results are written into `y` without allocating new memories.
+  add_into(a, b, y);
+  EXPECT_TRUE(vector_match((a + b).to_vector(), y.to_vector()));
+  subtract_into(k, a, y);
+  EXPECT_TRUE(vector_match((k - a).to_vector(), y.to_vector()));
+  multiply_into(a, 2, y);
+  EXPECT_TRUE(vector_match((a * 2).to_vector(), y.to_vector()));
+  divide_into(1, a, y);
+  EXPECT_TRUE(vector_match((1 / a).to_vector(), y.to_vector()));
+  exp_into(b, y);
+  EXPECT_TRUE(vector_match(exp(b).to_vector(), y.to_vector()));
+  relu_into(b, y);
+  EXPECT_TRUE(vector_match(relu(b).to_vector(), y.to_vector()));
+  transpose_into(a, y);
+  EXPECT_TRUE(vector_match(transpose(a).to_vector(), y.to_vector()));
+  matmul_into(a, b, y);
+  EXPECT_TRUE(vector_match(matmul(a, b).to_vector(), y.to_vector()));
+  softmax_into(a, 0, y);
+  EXPECT_TRUE(vector_match(softmax(a, 0).to_vector(), y.to_vector()));
+
+  // Elementwise operations can be calculated in place.
+  tanh_into(y, y);
+  multiply_into(y, b, y);
+  EXPECT_TRUE(vector_match(
+        (tanh(softmax(a, 0)) * b).to_vector(), y.to_vector()));
+
+  // Double-buffered updates.
+  for (unsigned i = 0; i < 3; ++i) {
+    add_into(y, a, y2);
+    std::swap(y, y2);
+  }
+  EXPECT_TRUE(vector_match(
+        (tanh(softmax(a, 0)) * b + 3 * a).to_vector(), y.to_vector()));
+  EXPECT_EQ(in_use, pool.in_use_size());
+}
+
+TEST_F(TensorOpsTest, CheckIntoManipulations) {
+  devices::Naive dev;
+  const CPUMemoryPool &pool = dev.memory_pool();
+  const Tensor a = dev.new_tensor_by_vector({2, 2}, {1, 2, 3, 4});
+  const Tensor b = dev.new_tensor_by_vector({2}, {-1, 0});
+  const Tensor u = dev.new_tensor_by_vector(
+      {8}, {1, -1, 2, -2, .5, -.5, 0, 3});
+  Tensor row = dev.new_tensor_by_constant({1, 2}, 0);
+  Tensor col = dev.new_tensor_by_constant({2}, 0);
+  Tensor mat = dev.new_tensor_by_constant({2, 2}, 0);
+  Tensor wide = dev.new_tensor_by_constant({2, 4}, 0);
+  Tensor gates = dev.new_tensor_by_constant({8}, 0);
+  Tensor state = dev.new_tensor_by_constant({4}, 0);
+  const std::uint64_t in_use = pool.in_use_size();
+
+  pick_into(a, {1}, 0, row);
+  EXPECT_TRUE(vector_match(pick(a, {1}, 0).to_vector(), row.to_vector()));
+  slice_into(a, 1, 1, 2, col);
+  EXPECT_TRUE(vector_match(slice(a, 1, 1, 2).to_vector(), col.to_vector()));
+  concat_into({a, a}, 1, wide);
+  EXPECT_TRUE(vector_match(concat({a, a}, 1).to_vector(), wide.to_vector()));
+  sum_into(a, 0, row);
+  EXPECT_TRUE(vector_match(sum(a, 0).to_vector(), row.to_vector()));
+  logsumexp_into(a, 1, col);
+  EXPECT_TRUE(vector_near(
+        logsumexp(a, 1).to_vector(), col.to_vector(), 1e-6));
+  broadcast_into(b, 1, 2, mat);
+  EXPECT_TRUE(vector_match(broadcast(b, 1, 2).to_vector(), mat.to_vector()));
+
+  dev.lstm_cell_fw_into(u, b, gates, state);
+  {
+    Tensor expected_gates;
+    const Tensor expected = dev.lstm_cell_fw(u, b, expected_gates);
+    EXPECT_TRUE(vector_match(expected.to_vector(), state.to_vector()));
+    EXPECT_TRUE(vector_match(expected_gates.to_vector(), gates.to_vector()));
+  }
+  EXPECT_EQ(in_use, pool.in_use_size());
+}
+
+TEST_F(TensorOpsTest, CheckInvalidInto) {
+  devices::Naive dev;
+  devices::Naive dev2;
+  const Tensor a = dev.new_tensor_by_constant({2, 2}, 1);
+  const Tensor b = dev.new_tensor_by_constant({2, 3}, 1);
+  Tensor y = dev.new_tensor_by_constant({2, 2}, 0);
+  Tensor y2 = dev2.new_tensor_by_constant({2, 2}, 0);
+  EXPECT_THROW(exp_into(b, y), Error);
+  EXPECT_THROW(matmul_into(a, b, y), Error);
+  EXPECT_THROW(transpose_into(b, y), Error);
+  EXPECT_THROW(exp_into(a, y2), Error);
+  EXPECT_THROW(random::bernoulli_into(2, y), Error);
+
+  // Non-elementwise operations can not be calculated in place.
+  Tensor z = dev.new_tensor_by_constant({2, 2}, 1);
+  EXPECT_THROW(matmul_into(z, a, z), Error);
+  EXPECT_THROW(matmul_into(a, z, z), Error);
+  EXPECT_THROW(transpose_into(z, z), Error);
+  EXPECT_THROW(softmax_into(z, 0, z), Error);
+  EXPECT_THROW(log_softmax_into(z, 0, z), Error);
+  EXPECT_THROW(pick_into(z, {0, 1}, 1, z), Error);
+  EXPECT_THROW(sum_into(a, 0, z), Error);
+  EXPECT_THROW(concat_into({&a, &z}, 1, z), Error);
+}
+
+TEST_F(TensorOpsTest, CheckRandomInto) {
+  devices::Naive dev;
+  const CPUMemoryPool &pool = dev.memory_pool();
+  Tensor y = dev.new_tensor_by_constant(Shape({3, 3}, 2), -1);
+  const std::uint64_t in_use = pool.in_use_size();
+  random::bernoulli_into(1, y);
+  EXPECT_TRUE(vector_match(vector<float>(18, 1), y.to_vector()));
+  random::uniform_into(1, 2, y);
+  for (float v : y.to_vector()) {
+    EXPECT_LT(1, v);
+    EXPECT_GE(2, v);
+  }
+  random::log_normal_into(0, 1, y);
+  for (float v : y.to_vector()) EXPECT_LT(0, v);
+  EXPECT_EQ(Shape({3, 3}, 2), y.shape());
+  EXPECT_EQ(in_use, pool.in_use_size());
+}
+
 TEST_F(TensorOpsTest, CheckAddConst) {
   const vector<float> x_data {1000, 100, 10, 1, 0.1, 0.01, 0.001, 0.0001};
   const float k = 1;
@@ -961,6 +1218,20 @@ TEST_F(TensorOpsTest, CheckTranspose1N) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckTransposeView) {
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_constant(Shape({3}, 2), 1);
+    const Tensor y1 = transpose(x);
+    const Tensor y2 = transpose(y1);
+    EXPECT_EQ(Shape({1, 3}, 2), y1.shape());
+    EXPECT_EQ(x.data(), y1.data());
+    EXPECT_EQ(x.data(), y2.data());
+    const Tensor z1 = dev->new_tensor_by_constant({2, 3}, 1);
+    const Tensor z2 = transpose(z1);
+    EXPECT_NE(z1.data(), z2.data());
+  }
+}
+
 TEST_F(TensorOpsTest, CheckTransposeNN) {
   const vector<float> x_data {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
   const vector<float> y_data {1, 3, 2, 4, 5, 7, 6, 8, 9, 11, 10, 12};
@@ -1566,14 +1837,25 @@ TEST_F(TensorOpsTest, CheckLogSoftmax2) {
         const Tensor x = dev->new_tensor_by_constant({n}, k);
         const Tensor y = log_softmax(x, 0);
         EXPECT_EQ(Shape({n}), y.shape());
-        // TODO(odashi): 1e-3 might not be enough precision.
         EXPECT_TRUE(
-            vector_near(vector<float>(n, -std::log(n)), y.to_vector(), 1e-3));
+            vector_near(vector<float>(n, -std::log(n)), y.to_vector(), 1e-6));
       }
     }
   }
 }
 
+TEST_F(TensorOpsTest, CheckLogSoftmaxLargeValues) {
+  const vector<float> x_data {1000, 1001, -1000, -1001, 1e30, -1e30};
+  const vector<float> y_data {
+    -1.31326169, -.31326169, -.31326169, -1.31326169, 0, -2e30,
+  };
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector(Shape({2}, 3), x_data);
+    const Tensor y = log_softmax(x, 0);
+    EXPECT_TRUE(vector_near(y_data, y.to_vector(), 1e-6));
+  }
+}
+
 TEST_F(TensorOpsTest, CheckSoftmax) {
   const vector<float> x_data {
     1, 2, 3, 4, 5, 6, 7, 8, -1, -2, -3, -4, -5, -6, -7, -8,
@@ -1620,6 +1902,18 @@ TEST_F(TensorOpsTest, CheckSoftmax2) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckSoftmaxLargeValues) {
+  const vector<float> x_data {1000, 1001, -1000, -1001, 1e30, -1e30};
+  const vector<float> y_data {
+    .26894142, .73105858, .73105858, .26894142, 1, 0,
+  };
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector(Shape({2}, 3), x_data);
+    const Tensor y = softmax(x, 0);
+    EXPECT_TRUE(vector_near(y_data, y.to_vector(), 1e-6));
+  }
+}
+
 TEST_F(TensorOpsTest, CheckBroadcast) {
   struct TestCase {
     unsigned dim, size;
@@ -1722,6 +2016,20 @@ TEST_F(TensorOpsTest, CheckBatchSum) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckBatchToColumns) {
+  const vector<float> x_data {
+    1, 2, 3, 4, 5, 6, 7, 8,
+    -2, -4, -6, -8, -10, -12, -14, -16,
+  };
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector(Shape({2, 2, 2}, 2), x_data);
+    const Tensor y = batch::to_columns(x);
+    EXPECT_EQ(Shape({8, 2}), y.shape());
+    EXPECT_EQ(x.data(), y.data());
+    EXPECT_TRUE(vector_match(x_data, y.to_vector()));
+  }
+}
+
 TEST_F(TensorOpsTest, CheckSoftmaxCrossEntropy) {
   const vector<vector<float>> x_data {
     {-1, 0, 1, 1, 0, 0, 0, 0, 1},
@@ -1837,6 +2145,153 @@ TEST_F(TensorOpsTest, CheckSparseSoftmaxCrossEntropy) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckChunkedSoftmaxCrossEntropy) {
+  const vector<float> w_data {
+    1, -1, 2, 0, .5, -2, 1, 0, 3, -1, .5, .5, -1, 2, 1,
+  };
+  const vector<float> b_data {.1, -.2, .3, 0, -.5};
+  const vector<float> x_data {-.5, -.2, .1, .4, .7, 1};
+  for (Device *dev : devices) {
+    const Tensor w = dev->new_tensor_by_vector({5, 3}, w_data);
+    const Tensor b = dev->new_tensor_by_vector({5}, b_data);
+    const Tensor x = dev->new_tensor_by_vector(Shape({3}, 2), x_data);
+    const vector<float> y_data = softmax_cross_entropy(
+        matmul(w, x) + b, {3, 1}, 0).to_vector();
+    for (const unsigned chunk_size : {1, 2, 4, 5, 100}) {
+      const Tensor y = chunked_softmax_cross_entropy(
+          x, w, b, {3, 1}, chunk_size);
+      EXPECT_EQ(Shape({}, 2), y.shape());
+      EXPECT_TRUE(vector_near(y_data, y.to_vector(), 1e-5));
+    }
+    EXPECT_THROW(chunked_softmax_cross_entropy(x, w, b, {3, 1}, 0), Error);
+    EXPECT_THROW(chunked_softmax_cross_entropy(x, w, b, {5, 1}, 2), Error);
+  }
+}
+
+TEST_F(TensorOpsTest, CheckLSTMCell) {
+  const vector<float> wx_data {
+    1, -1, 2, 0, .5, -2, 1, 0, 3, -1, .5, .5, -1, 2, 1, 0,
+  };
+  const vector<float> wh_data {
+    .5, 0, -1, 1, 2, -.5, 0, 1, -1, .5, 1, 0, -2, 1, .5, -1,
+  };
+  const vector<float> b_data {.1, -.2, .3, 0, -.5, .2, .4, -.1};
+  const vector<float> x_data {-.5, -.2, .1, .4};
+  const vector<float> h_data {.3, -.6, .2, .8};
+  const vector<float> c_data {1, -2, .5, 3};
+  for (Device *dev : devices) {
+    const Tensor wx = dev->new_tensor_by_vector({8, 2}, wx_data);
+    const Tensor wh = dev->new_tensor_by_vector({8, 2}, wh_data);
+    const Tensor b = dev->new_tensor_by_vector({8}, b_data);
+    const Tensor x = dev->new_tensor_by_vector(Shape({2}, 2), x_data);
+    const Tensor h = dev->new_tensor_by_vector(Shape({2}, 2), h_data);
+    const Tensor c = dev->new_tensor_by_vector(Shape({2}, 2), c_data);
+    const Tensor u = matmul(wx, x) + matmul(wh, h) + b;
+    const Tensor ref_c
+      = sigmoid(slice(u, 0, 0, 2)) * tanh(slice(u, 0, 6, 8))
+      + sigmoid(slice(u, 0, 2, 4)) * c;
+    const Tensor ref_h = sigmoid(slice(u, 0, 4, 6)) * tanh(ref_c);
+    const std::pair<Tensor, Tensor> y = lstm_cell(x, h, c, wx, wh, b);
+    EXPECT_EQ(Shape({2}, 2), y.first.shape());
+    EXPECT_EQ(Shape({2}, 2), y.second.shape());
+    EXPECT_TRUE(vector_near(ref_h.to_vector(), y.first.to_vector(), 1e-6));
+    EXPECT_TRUE(vector_near(ref_c.to_vector(), y.second.to_vector(), 1e-6));
+    EXPECT_THROW(lstm_cell(x, h, c, wh, wx, slice(b, 0, 0, 4)), Error);
+    EXPECT_THROW(lstm_cell(x, h, slice(c, 0, 0, 1), wx, wh, b), Error);
+  }
+}
+
+TEST_F(TensorOpsTest, CheckLSTM) {
+  const vector<float> wx_data {
+    1, -1, 2, 0, .5, -2, 1, 0, 3, -1, .5, .5, -1, 2, 1, 0,
+  };
+  const vector<float> wh_data {
+    .5, 0, -1, 1, 2, -.5, 0, 1, -1, .5, 1, 0, -2, 1, .5, -1,
+  };
+  const vector<float> b_data {.1, -.2, .3, 0, -.5, .2, .4, -.1};
+  const vector<float> x_data {-.5, -.2, .1, .4, .7, 1, 1.3, 1.6, 1.9, 2.2, 2.5, 2.8};
+  const vector<float> h_data {.3, -.6, .2, .8};
+  const vector<float> c_data {1, -2, .5, 3};
+  for (Device *dev : devices) {
+    const Tensor wx = dev->new_tensor_by_vector({8, 2}, wx_data);
+    const Tensor wh = dev->new_tensor_by_vector({8, 2}, wh_data);
+    const Tensor b = dev->new_tensor_by_vector({8}, b_data);
+    const Tensor x = dev->new_tensor_by_vector(Shape({2, 3}, 2), x_data);
+    const Tensor h = dev->new_tensor_by_vector(Shape({2}, 2), h_data);
+    const Tensor c = dev->new_tensor_by_vector(Shape({2}, 2), c_data);
+    std::pair<Tensor, Tensor> ref {h, c};
+    vector<Tensor> ref_hs, ref_cs;
+    for (unsigned t = 0; t < 3; ++t) {
+      ref = lstm_cell(slice(x, 1, t, t + 1), ref.first, ref.second, wx, wh, b);
+      ref_hs.emplace_back(ref.first);
+      ref_cs.emplace_back(ref.second);
+    }
+    const std::pair<Tensor, Tensor> y = lstm(x, h, c, wx, wh, b);
+    EXPECT_EQ(Shape({2, 3}, 2), y.first.shape());
+    EXPECT_EQ(Shape({2, 3}, 2), y.second.shape());
+    EXPECT_TRUE(vector_near(
+          concat(ref_hs, 1).to_vector(), y.first.to_vector(), 1e-6));
+    EXPECT_TRUE(vector_near(
+          concat(ref_cs, 1).to_vector(), y.second.to_vector(), 1e-6));
+    EXPECT_THROW(lstm(x, slice(h, 0, 0, 1), c, wx, wh, b), Error);
+    EXPECT_THROW(lstm(x, h, c, wh, wx, slice(b, 0, 0, 4)), Error);
+  }
+}
+
+TEST_F(TensorOpsTest, CheckSampleCandidates) {
+  const vector<float> distribution {0, 3, 0, 1, 0};
+  for (Device *dev : devices) {
+    EXPECT_EQ(
+        vector<unsigned>({1, 3}),
+        sample_candidates(distribution, 100, *dev));
+    EXPECT_EQ(vector<unsigned>({1}), sample_candidates({0, 1}, 10, *dev));
+    EXPECT_TRUE(sample_candidates(distribution, 0, *dev).empty());
+    EXPECT_THROW(sample_candidates({0, 0, 0}, 10, *dev), Error);
+    EXPECT_THROW(sample_candidates({}, 10, *dev), Error);
+  }
+}
+
+TEST_F(TensorOpsTest, CheckLogExpectedCounts) {
+  const vector<float> distribution {0, 3, 0, 1, 0};
+  EXPECT_TRUE(vector_near(
+        vector<float> {
+          std::log(1.f - std::pow(.25f, 2)),
+          std::log(1.f - std::pow(.75f, 2)),
+        },
+        log_expected_counts(distribution, 2, {1, 3}), 1e-6));
+  EXPECT_TRUE(vector_near(
+        vector<float> {0}, log_expected_counts({0, 1}, 3, {1}), 1e-6));
+  EXPECT_THROW(log_expected_counts(distribution, 2, {0}), Error);
+  EXPECT_THROW(log_expected_counts(distribution, 2, {5}), Error);
+  EXPECT_THROW(log_expected_counts(distribution, 0, {1}), Error);
+}
+
+TEST_F(TensorOpsTest, CheckSampledSoftmaxCrossEntropy) {
+  const vector<float> w_data {
+    1, -1, 2, 0, .5, -2, 1, 0, 3, -1, .5, .5, -1, 2, 1,
+  };
+  const vector<float> b_data {.1, -.2, .3, 0, -.5};
+  const vector<float> x_data {-.5, -.2, .1, .4, .7, 1, 0, .3, -.3};
+  // Candidates are always {1, 2, 4}, and their expected counts are almost 1.
+  const vector<float> distribution {0, 1, 1, 0, 1};
+  for (Device *dev : devices) {
+    const Tensor w = dev->new_tensor_by_vector({5, 3}, w_data);
+    const Tensor b = dev->new_tensor_by_vector({5}, b_data);
+    const Tensor x = dev->new_tensor_by_vector(Shape({3}, 3), x_data);
+    const Tensor y = sampled_softmax_cross_entropy(
+        x, w, b, {1, 4, 2}, distribution, 200);
+    // The label of each minibatch is also a candidate, and it is used only
+    // once in the softmax.
+    const Tensor z = matmul(w, x) + b;
+    const Tensor zs = concat({
+        slice(z, 0, 1, 3), slice(z, 0, 4, 5)}, 0);
+    const vector<float> y_data
+      = softmax_cross_entropy(zs, {0, 2, 1}, 0).to_vector();
+    EXPECT_EQ(Shape({}, 3), y.shape());
+    EXPECT_TRUE(vector_near(y_data, y.to_vector(), 1e-5));
+  }
+}
+
 TEST_F(TensorOpsTest, CheckInvalidSparseSoftmaxCrossEntropy) {
   for (Device *dev : devices) {
     {
@@ -1856,5 +2311,177 @@ TEST_F(TensorOpsTest, CheckInvalidSparseSoftmaxCrossEntropy) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckOptimizerUpdates) {
+  const vector<float> g {1, -2, .5, 0, 3, -1};
+  const vector<float> m1 {.1, .2, .3, .4, .5, .6};
+  const vector<float> m2 {1, 2, 3, 4, 5, 6};
+  const vector<float> x {-1, 1, -2, 2, -3, 3};
+  const unsigned n = x.size();
+  const Shape shape({2, 3});
+
+  // Reference calculations.
+  vector<float> sgd_x(x), msgd_m(m1), msgd_x(x), adagrad_m(m2), adagrad_x(x);
+  vector<float> rmsprop_m(m2), rmsprop_x(x);
+  vector<float> adadelta_m1(m1), adadelta_m2(m2), adadelta_x(x);
+  vector<float> adam_m1(m1), adam_m2(m2), adam_x(x);
+  const float bias1 = 1 - std::pow(.9f, 3), bias2 = 1 - std::pow(.999f, 3);
+  for (unsigned i = 0; i < n; ++i) {
+    sgd_x[i] -= .1f * g[i];
+    msgd_m[i] = .9f * msgd_m[i] - .1f * g[i];
+    msgd_x[i] += msgd_m[i];
+    adagrad_m[i] += g[i] * g[i];
+    adagrad_x[i] -= .1f * g[i] / (std::sqrt(adagrad_m[i]) + 1e-8f);
+    rmsprop_m[i] = .9f * rmsprop_m[i] + (1 - .9f) * g[i] * g[i];
+    rmsprop_x[i] -= .1f * g[i] / (std::sqrt(rmsprop_m[i]) + 1e-8f);
+    adadelta_m2[i] = .95f * adadelta_m2[i] + (1 - .95f) * g[i] * g[i];
+    const float dx = std::sqrt(
+        (adadelta_m1[i] + 1e-6f) / (adadelta_m2[i] + 1e-6f)) * g[i];
+    adadelta_m1[i] = .95f * adadelta_m1[i] + (1 - .95f) * dx * dx;
+    adadelta_x[i] -= .5f * dx;
+    adam_m1[i] = .9f * adam_m1[i] + (1 - .9f) * g[i];
+    adam_m2[i] = .999f * adam_m2[i] + (1 - .999f) * g[i] * g[i];
+    adam_x[i] -= .1f * (adam_m1[i] / bias1)
+      / (std::sqrt(adam_m2[i] / bias2) + 1e-8f);
+  }
+
+  for (Device *dev : devices) {
+    const Tensor tg = dev->new_tensor_by_vector(shape, g);
+    {
+      Tensor tx = dev->new_tensor_by_vector(shape, x);
+      dev->sgd_update(.1, tg, tx);
+      EXPECT_TRUE(vector_match(sgd_x, tx.to_vector()));
+    }
+    {
+      Tensor tm = dev->new_tensor_by_vector(shape, m1);
+      Tensor tx = dev->new_tensor_by_vector(shape, x);
+      dev->momentum_sgd_update(.1, .9, tg, tm, tx);
+      EXPECT_TRUE(vector_match(msgd_m, tm.to_vector()));
+      EXPECT_TRUE(vector_match(msgd_x, tx.to_vector()));
+    }
+    {
+      Tensor tm = dev->new_tensor_by_vector(shape, m2);
+      Tensor tx = dev->new_tensor_by_vector(shape, x);
+      dev->adagrad_update(.1, 1e-8, tg, tm, tx);
+      EXPECT_TRUE(vector_match(adagrad_m, tm.to_vector()));
+      EXPECT_TRUE(vector_match(adagrad_x, tx.to_vector()));
+    }
+    {
+      Tensor tm = dev->new_tensor_by_vector(shape, m2);
+      Tensor tx = dev->new_tensor_by_vector(shape, x);
+      dev->rmsprop_update(.1, .9, 1e-8, tg, tm, tx);
+      EXPECT_TRUE(vector_match(rmsprop_m, tm.to_vector()));
+      EXPECT_TRUE(vector_match(rmsprop_x, tx.to_vector()));
+    }
+    {
+      Tensor tm1 = dev->new_tensor_by_vector(shape, m1);
+      Tensor tm2 = dev->new_tensor_by_vector(shape, m2);
+      Tensor tx = dev->new_tensor_by_vector(shape, x);
+      dev->adadelta_update(.5, .95, 1e-6, tg, tm1, tm2, tx);
+      EXPECT_TRUE(vector_match(adadelta_m1, tm1.to_vector()));
+      EXPECT_TRUE(vector_match(adadelta_m2, tm2.to_vector()));
+      EXPECT_TRUE(vector_match(adadelta_x, tx.to_vector()));
+    }
+    {
+      Tensor tm1 = dev->new_tensor_by_vector(shape, m1);
+      Tensor tm2 = dev->new_tensor_by_vector(shape, m2);
+      Tensor tx = dev->new_tensor_by_vector(shape, x);
+      dev->adam_update(.1, .9, .999, 1e-8, 3, tg, tm1, tm2, tx);
+      EXPECT_TRUE(vector_match(adam_m1, tm1.to_vector()));
+      EXPECT_TRUE(vector_match(adam_m2, tm2.to_vector()));
+      EXPECT_TRUE(vector_match(adam_x, tx.to_vector()));
+    }
+  }
+}
+
+TEST_F(TensorOpsTest, CheckInvalidOptimizerUpdates) {
+  for (Device *dev : devices) {
+    const Tensor g = dev->new_tensor_by_constant({2, 2}, 1);
+    Tensor m1 = dev->new_tensor_by_constant({2, 2}, 0);
+    Tensor m2 = dev->new_tensor_by_constant({2, 2}, 0);
+    Tensor x = dev->new_tensor_by_constant({2, 2}, 0);
+    Tensor y = dev->new_tensor_by_constant({4}, 0);
+    EXPECT_THROW(dev->sgd_update(.1, g, y), Error);
+    EXPECT_THROW(dev->momentum_sgd_update(.1, .9, g, y, x), Error);
+    EXPECT_THROW(dev->adagrad_update(.1, 1e-8, g, m1, y), Error);
+    EXPECT_THROW(dev->rmsprop_update(.1, .9, 1e-8, y, m1, x), Error);
+    EXPECT_THROW(dev->adadelta_update(1, .95, 1e-6, g, m1, y, x), Error);
+    EXPECT_THROW(dev->adam_update(.1, .9, .999, 1e-8, 1, g, m1, m2, y), Error);
+    EXPECT_THROW(dev->adam_update(.1, .9, .999, 1e-8, 0, g, m1, m2, x), Error);
+  }
+}
+
+TEST_F(TensorOpsTest, CheckInplaceMatmulAdd) {
+  for (Device *dev : devices) {
+    const Tensor a = dev->new_tensor_by_vector(
+        Shape({2, 3}, 2), {1, 2, 3, 4, 5, 6, -1, -2, -3, -4, -5, -6});
+    const Tensor b = dev->new_tensor_by_vector({3, 2}, {1, 0, 1, 0, 1, 0});
+    const Tensor w = dev->new_tensor_by_vector({2, 3}, {1, 2, 3, 4, 5, 6});
+    const Tensor v = dev->new_tensor_by_vector(
+        Shape({3, 2}, 2), {1, 0, 1, 0, 1, 0, 0, 0, 0, 1, 1, 1});
+    Tensor y = dev->new_tensor_by_constant(Shape({2, 2}, 2), 1);
+    dev->inplace_matmul_add(a, b, y);
+    EXPECT_TRUE(vector_match(
+          vector<float> {7, 9, 4, 5, -5, -7, -2, -3}, y.to_vector()));
+    dev->inplace_matmul_add(w, v, y);
+    EXPECT_TRUE(vector_match(
+          vector<float> {13, 17, 7, 9, -5, -7, 7, 9}, y.to_vector()));
+    Tensor z = dev->new_tensor_by_constant({2, 2}, 0);
+    dev->inplace_matmul_add(w, b, z);
+    EXPECT_TRUE(vector_match(vector<float> {6, 8, 3, 4}, z.to_vector()));
+    EXPECT_THROW(dev->inplace_matmul_add(a, b, z), Error);
+    EXPECT_THROW(dev->inplace_matmul_add(w, w, z), Error);
+  }
+}
+
+TEST_F(TensorOpsTest, CheckInplacePickAssign) {
+  for (Device *dev : devices) {
+    Tensor x = dev->new_tensor_by_vector({2, 3}, {1, 2, 3, 4, 5, 6});
+    const Tensor y = dev->new_tensor_by_vector(
+        Shape({2, 1}, 2), {-1, -2, -3, -4});
+    dev->inplace_pick_assign(y, {2, 0}, 1, x);
+    EXPECT_TRUE(vector_match(
+          vector<float> {-3, -4, 3, 4, -1, -2}, x.to_vector()));
+    dev->inplace_pick_reset(0, {1}, 0, x);
+    EXPECT_TRUE(vector_match(
+          vector<float> {-3, 0, 3, 0, -1, 0}, x.to_vector()));
+    dev->inplace_pick_reset(7, {1, 2}, 1, x);
+    EXPECT_TRUE(vector_match(
+          vector<float> {-3, 0, 7, 7, 7, 7}, x.to_vector()));
+  }
+}
+
+TEST_F(TensorOpsTest, CheckInvalidInplacePickAssign) {
+  for (Device *dev : devices) {
+    Tensor x = dev->new_tensor_by_constant({2, 3}, 0);
+    const Tensor y = dev->new_tensor_by_constant({2}, 1);
+    EXPECT_THROW(dev->inplace_pick_assign(y, {0, 1}, 1, x), Error);
+    EXPECT_THROW(dev->inplace_pick_assign(y, {3}, 1, x), Error);
+    EXPECT_THROW(dev->inplace_pick_reset(0, {3}, 1, x), Error);
+    EXPECT_THROW(dev->inplace_pick_reset(0, {}, 1, x), Error);
+  }
+}
+
+TEST_F(TensorOpsTest, CheckSquaredNorm) {
+  for (Device *dev : devices) {
+    const Tensor a = dev->new_tensor_by_vector({2, 2}, {1, -2, 3, -4});
+    const Tensor b = dev->new_tensor_by_vector({3}, {.5, 0, -1});
+    const Tensor c = dev->new_tensor_by_vector(Shape({2}, 2), {1, 1, 1, 1});
+    const Tensor d = dev->new_tensor_by_constant({100, 1000}, .5);
+    EXPECT_FLOAT_EQ(0, dev->squared_norm({}));
+    EXPECT_FLOAT_EQ(30, dev->squared_norm({&a}));
+    EXPECT_FLOAT_EQ(35.25, dev->squared_norm({&a, &b, &c}));
+    EXPECT_FLOAT_EQ(25035.25, dev->squared_norm({&a, &d, &b, &c}));
+  }
+}
+
+TEST_F(TensorOpsTest, CheckInvalidSquaredNorm) {
+  devices::Naive dev2;
+  for (Device *dev : devices) {
+    const Tensor a = dev->new_tensor_by_constant({2}, 1);
+    const Tensor b = dev2.new_tensor_by_constant({2}, 1);
+    EXPECT_THROW(dev->squared_norm({&a, &b}), Error);
+  }
+}
+
 }  // namespace operators
 }  // namespace primitiv
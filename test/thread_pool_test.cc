@@ -0,0 +1,84 @@
+#include <config.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+#include <primitiv/error.h>
+#include <primitiv/thread_pool.h>
+
+using std::vector;
+
+namespace primitiv {
+
+class ThreadPoolTest : public testing::Test {};
+
+TEST_F(ThreadPoolTest, CheckNumThreads) {
+  for (unsigned n : {1u, 2u, 4u}) {
+    ThreadPool pool(n);
+    EXPECT_EQ(n, pool.num_threads());
+  }
+}
+
+TEST_F(ThreadPoolTest, CheckInvalidNumThreads) {
+  EXPECT_THROW(ThreadPool(0), Error);
+}
+
+TEST_F(ThreadPoolTest, CheckParallelFor) {
+  for (unsigned n : {1u, 2u, 3u, 8u}) {
+    ThreadPool pool(n);
+    for (unsigned size : {0u, 1u, 7u, 100u, 1000u, 12345u}) {
+      for (unsigned grain : {0u, 1u, 10u, 1000u}) {
+        vector<unsigned> counts(size, 0);
+        pool.parallel_for(size, grain, [&](unsigned begin, unsigned end) {
+            EXPECT_LT(begin, end);
+            EXPECT_LE(end, size);
+            for (unsigned i = begin; i < end; ++i) ++counts[i];
+        });
+        for (unsigned i = 0; i < size; ++i) {
+          EXPECT_EQ(1u, counts[i]);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(ThreadPoolTest, CheckSerialExecution) {
+  ThreadPool pool(4);
+  unsigned num_calls = 0;
+  pool.parallel_for(100, 100, [&](unsigned begin, unsigned end) {
+      EXPECT_EQ(0u, begin);
+      EXPECT_EQ(100u, end);
+      ++num_calls;
+  });
+  EXPECT_EQ(1u, num_calls);
+}
+
+TEST_F(ThreadPoolTest, CheckNestedParallelFor) {
+  ThreadPool pool(4);
+  std::atomic<unsigned> total(0);
+  pool.parallel_for(16, 1, [&](unsigned begin, unsigned end) {
+      for (unsigned i = begin; i < end; ++i) {
+        pool.parallel_for(100, 1, [&](unsigned b, unsigned e) {
+            total += e - b;
+        });
+      }
+  });
+  EXPECT_EQ(1600u, total);
+}
+
+TEST_F(ThreadPoolTest, CheckException) {
+  ThreadPool pool(4);
+  EXPECT_THROW(
+      pool.parallel_for(1000, 1, [](unsigned begin, unsigned) {
+          if (begin > 0) throw std::runtime_error("error");
+      }), std::runtime_error);
+  // The pool is still available.
+  std::atomic<unsigned> total(0);
+  pool.parallel_for(1000, 1, [&](unsigned begin, unsigned end) {
+      total += end - begin;
+  });
+  EXPECT_EQ(1000u, total);
+}
+
+}  // namespace primitiv
@@ -1,6 +1,8 @@
 #include <config.h>
 
+#include <algorithm>
 #include <cstdio>
+#include <utility>
 #include <gtest/gtest.h>
 #include <primitiv/error.h>
 #include <primitiv/naive_device.h>
@@ -780,5 +782,67 @@ TEST_F(TrainerImplTest, CheckAdamUpdate) {
   }
 }
 
+TEST_F(TrainerImplTest, CheckSparseUpdate) {
+  const vector<float> init {1, 2, 3, 4, 5, 6};
+  const vector<vector<unsigned>> ids_list {{0, 2}, {2, 2}, {1}, {0, 1, 2}};
+  SGD sgd(.1), sgd_ref(.1);
+  AdaGrad adagrad(.1), adagrad_ref(.1);
+  Adam adam(.1), adam_ref(.1);
+  const vector<std::pair<Trainer *, Trainer *>> trainers {
+    {&sgd, &sgd_ref}, {&adagrad, &adagrad_ref}, {&adam, &adam_ref},
+  };
+
+  for (const auto &tt : trainers) {
+    Parameter param({2, 3}, init, dev);
+    Parameter ref_param({2, 3}, init, dev);
+    param.set_sparse_gradient(true);
+    tt.first->add_parameter(param);
+    tt.second->add_parameter(ref_param);
+    const Parameter &cparam = param;
+
+    for (unsigned step = 0; step < ids_list.size(); ++step) {
+      const vector<unsigned> &ids = ids_list[step];
+      vector<float> gy_data(2 * ids.size());
+      for (unsigned i = 0; i < gy_data.size(); ++i) {
+        gy_data[i] = (i % 3 ? 1. : -1.) * (i + step + 1);
+      }
+      const Tensor gy = dev.new_tensor_by_vector(
+          Shape({2}, ids.size()), gy_data);
+
+      tt.first->reset_gradients();
+      tt.second->reset_gradients();
+      param.add_sparse_gradient(ids, gy);
+      dev.pick_bw(gy, ids, 1, ref_param.gradient());
+      const vector<float> prev_value = cparam.value().to_vector();
+      tt.first->update();
+      tt.second->update();
+      ASSERT_TRUE(cparam.has_sparse_gradient());
+
+      // Columns without gradients are never updated.
+      const vector<float> value = cparam.value().to_vector();
+      for (unsigned col = 0; col < 3; ++col) {
+        if (std::find(ids.begin(), ids.end(), col) != ids.end()) continue;
+        EXPECT_FLOAT_EQ(prev_value[2 * col], value[2 * col]);
+        EXPECT_FLOAT_EQ(prev_value[2 * col + 1], value[2 * col + 1]);
+      }
+
+      if (tt.first == &adam) {
+        // Moments of updated columns are lazily decayed.
+        for (const char *name : {"adam-m1", "adam-m2"}) {
+          const vector<float> m = param.stats(name).to_vector();
+          const vector<float> ref_m = ref_param.stats(name).to_vector();
+          for (unsigned col : ids) {
+            EXPECT_NEAR(ref_m[2 * col], m[2 * col], 1e-6);
+            EXPECT_NEAR(ref_m[2 * col + 1], m[2 * col + 1], 1e-6);
+          }
+        }
+      } else {
+        // Zero gradients never change SGD and AdaGrad.
+        EXPECT_TRUE(vector_match(ref_param.value().to_vector(), value));
+      }
+    }
+  }
+}
+
 }  // namespace trainers
 }  // namespace primitiv
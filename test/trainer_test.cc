@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 #include <primitiv/error.h>
 #include <primitiv/naive_device.h>
+#include <primitiv/operators.h>
 #include <primitiv/parameter.h>
 #include <primitiv/trainer_impl.h>
 #include <test_utils.h>
@@ -139,4 +140,135 @@ TEST_F(TrainerTest, CheckGradientClipping) {
   EXPECT_THROW(trainer.set_gradient_clipping(-1), Error);
 }
 
+TEST_F(TrainerTest, CheckFlatArena) {
+  Device::set_default(dev);
+  trainers::MomentumSGD trainer(.1, .5);
+  trainers::MomentumSGD ref_trainer(.1, .5);
+  ASSERT_FALSE(trainer.flat_arena());
+
+  Parameter param1({2, 2}, {1, 2, 3, 4});
+  Parameter param2({3}, {5, 6, 7});
+  Parameter ref_param1({2, 2}, {1, 2, 3, 4});
+  Parameter ref_param2({3}, {5, 6, 7});
+  trainer.add_parameter(param1);
+  trainer.add_parameter(param2);
+  ref_trainer.add_parameter(ref_param1);
+  ref_trainer.add_parameter(ref_param2);
+  trainer.set_flat_arena(true);
+  EXPECT_TRUE(trainer.flat_arena());
+  trainer.set_weight_decay(.1);
+  ref_trainer.set_weight_decay(.1);
+  trainer.set_gradient_clipping(4);
+  ref_trainer.set_gradient_clipping(4);
+
+  for (unsigned i = 0; i < 3; ++i) {
+    trainer.reset_gradients();
+    ref_trainer.reset_gradients();
+    EXPECT_TRUE(vector_match(vector<float>(4, 0), param1.gradient().to_vector()));
+    EXPECT_TRUE(vector_match(vector<float>(3, 0), param2.gradient().to_vector()));
+    param1.gradient() += dev.new_tensor_by_vector({2, 2}, {1, -1, 2, -2});
+    param2.gradient() += dev.new_tensor_by_vector({3}, {3, -3, 1});
+    ref_param1.gradient() += dev.new_tensor_by_vector({2, 2}, {1, -1, 2, -2});
+    ref_param2.gradient() += dev.new_tensor_by_vector({3}, {3, -3, 1});
+    trainer.update();
+    ref_trainer.update();
+    EXPECT_TRUE(vector_match(
+          ref_param1.value().to_vector(), param1.value().to_vector()));
+    EXPECT_TRUE(vector_match(
+          ref_param2.value().to_vector(), param2.value().to_vector()));
+    EXPECT_TRUE(vector_match(
+          ref_param1.stats("momentumsgd-m").to_vector(),
+          param1.stats("momentumsgd-m").to_vector()));
+    EXPECT_TRUE(vector_match(
+          ref_param2.stats("momentumsgd-m").to_vector(),
+          param2.stats("momentumsgd-m").to_vector()));
+  }
+
+  // All tensors are placed in the registration order.
+  const float *values = static_cast<const float *>(param1.value().data());
+  EXPECT_EQ(values + 4, param2.value().data());
+  EXPECT_EQ(values + 7, param1.gradient().data());
+  EXPECT_EQ(values + 11, param2.gradient().data());
+  EXPECT_EQ(values + 14, param1.stats("momentumsgd-m").data());
+  EXPECT_EQ(values + 18, param2.stats("momentumsgd-m").data());
+
+  // Parameters keep their values after disabling the arena.
+  trainer.set_flat_arena(false);
+  EXPECT_FALSE(trainer.flat_arena());
+  trainer.update();
+  ref_trainer.update();
+  EXPECT_TRUE(vector_match(
+        ref_param1.value().to_vector(), param1.value().to_vector()));
+  EXPECT_TRUE(vector_match(
+        ref_param2.value().to_vector(), param2.value().to_vector()));
+}
+
+TEST_F(TrainerTest, CheckFlatArenaRebuild) {
+  Device::set_default(dev);
+  trainers::SGD trainer(.1);
+  trainer.set_flat_arena(true);
+
+  Parameter param1({2}, {1, 2});
+  Parameter param2;
+  trainer.add_parameter(param1);
+  trainer.add_parameter(param2);
+  trainer.reset_gradients();
+  param1.gradient() += dev.new_tensor_by_vector({2}, {1, 1});
+  trainer.update();
+  EXPECT_TRUE(vector_match(vector<float> {.9, 1.9}, param1.value().to_vector()));
+
+  // Replaced parameters are moved to a new arena.
+  param1.init({3}, {1, 2, 3});
+  param2.init({1}, {4});
+  trainer.reset_gradients();
+  param1.gradient() += dev.new_tensor_by_vector({3}, {1, 1, 1});
+  param2.gradient() += dev.new_tensor_by_vector({1}, {2});
+  trainer.update();
+  EXPECT_TRUE(vector_match(
+        vector<float> {.9, 1.9, 2.9}, param1.value().to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {3.8}, param2.value().to_vector()));
+  const float *values = static_cast<const float *>(param1.value().data());
+  EXPECT_EQ(values + 3, param2.value().data());
+  EXPECT_EQ(values + 4, param1.gradient().data());
+  EXPECT_EQ(values + 7, param2.gradient().data());
+
+  // Added parameters are also moved to a new arena.
+  Parameter param3({1}, {5});
+  trainer.add_parameter(param3);
+  trainer.reset_gradients();
+  EXPECT_TRUE(vector_match(vector<float> {0}, param3.gradient().to_vector()));
+  values = static_cast<const float *>(param1.value().data());
+  EXPECT_EQ(values + 4, param3.value().data());
+  EXPECT_TRUE(vector_match(vector<float> {5}, param3.value().to_vector()));
+}
+
+TEST_F(TrainerTest, CheckFlatArenaKeepsCopies) {
+  Device::set_default(dev);
+  trainers::SGD trainer(.1);
+  trainer.set_flat_arena(true);
+
+  Parameter param1({2}, {1, 2});
+  Parameter param2({1}, {3});
+  trainer.add_parameter(param1);
+  trainer.add_parameter(param2);
+  trainer.reset_gradients();
+
+  // Copies of the values are not modified by the update.
+  const Tensor copied = param1.value();
+  const Tensor sliced = operators::slice(param2.value(), 0, 0, 1);
+  param1.gradient() += dev.new_tensor_by_vector({2}, {1, 1});
+  param2.gradient() += dev.new_tensor_by_vector({1}, {1});
+  trainer.update();
+  EXPECT_TRUE(vector_match(vector<float> {1, 2}, copied.to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {3}, sliced.to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {.9, 1.9}, param1.value().to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {2.9}, param2.value().to_vector()));
+
+  // Parameters are still placed in one arena.
+  const float *values = static_cast<const float *>(param1.value().data());
+  EXPECT_NE(copied.data(), values);
+  EXPECT_EQ(values + 2, param2.value().data());
+  EXPECT_EQ(values + 3, param1.gradient().data());
+}
+
 }  // namespace primitiv